@@ -402,6 +402,30 @@ create_empty_message (GFile *file,
   return message;
 }
 
+static void
+invalidate_info_cache (GFile *file)
+{
+  GDaemonFile *daemon_file = G_DAEMON_FILE (file);
+
+  _g_daemon_vfs_info_cache_invalidate (daemon_file->mount_spec,
+				       daemon_file->path);
+}
+
+/* Whether the path call changes the file, so that its cached
+   info must be dropped */
+static gboolean
+op_changes_file (const char *op)
+{
+  return
+    strcmp (op, G_VFS_DBUS_MOUNT_OP_OPEN_FOR_WRITE) == 0 ||
+    strcmp (op, G_VFS_DBUS_MOUNT_OP_SET_DISPLAY_NAME) == 0 ||
+    strcmp (op, G_VFS_DBUS_MOUNT_OP_DELETE) == 0 ||
+    strcmp (op, G_VFS_DBUS_MOUNT_OP_TRASH) == 0 ||
+    strcmp (op, G_VFS_DBUS_MOUNT_OP_MAKE_DIRECTORY) == 0 ||
+    strcmp (op, G_VFS_DBUS_MOUNT_OP_MAKE_SYMBOLIC_LINK) == 0 ||
+    strcmp (op, G_VFS_DBUS_MOUNT_OP_SET_ATTRIBUTE) == 0;
+}
+
 static DBusMessage *
 do_sync_path_call (GFile *file,
 		   const char *op,
@@ -436,6 +460,9 @@ do_sync_path_call (GFile *file,
 				   cancellable, &my_error);
   dbus_message_unref (message);
 
+  if (op_changes_file (op))
+    invalidate_info_cache (file);
+
   if (reply == NULL)
     {
       if (g_error_matches (my_error, G_VFS_ERROR, G_VFS_ERROR_RETRY))
@@ -597,6 +624,9 @@ async_path_call_done (DBusMessage *reply,
   AsyncPathCall *data = _data;
   GSimpleAsyncResult *result;
 
+  if (op_changes_file (data->op))
+    invalidate_info_cache (data->file);
+
   if (io_error != NULL)
     {
       g_simple_async_result_set_from_error (data->result, io_error);
@@ -727,13 +757,15 @@ g_daemon_file_enumerate_children (GFile      *file,
 				  GError **error)
 {
   DBusMessage *reply;
-  dbus_uint32_t flags_dbus;
+  dbus_uint32_t flags_dbus, credit, enumerate_flags;
+  guint32 fd_id;
   char *obj_path;
   GDaemonFileEnumerator *enumerator;
   DBusConnection *connection;
   char *uri;
+  int fd;
 
-  enumerator = g_daemon_file_enumerator_new (file, attributes);
+  enumerator = g_daemon_file_enumerator_new (file, attributes, flags);
   obj_path = g_daemon_file_enumerator_get_object_path (enumerator);
 
 
@@ -742,6 +774,8 @@ g_daemon_file_enumerate_children (GFile      *file,
   if (attributes == NULL)
     attributes = "";
   flags_dbus = flags;
+  credit = G_VFS_ENUMERATOR_DEFAULT_CREDIT;
+  enumerate_flags = G_VFS_ENUMERATE_FLAG_SOCKET;
   reply = do_sync_path_call (file, 
 			     G_VFS_DBUS_MOUNT_OP_ENUMERATE,
 			     NULL, &connection,
@@ -750,6 +784,8 @@ g_daemon_file_enumerate_children (GFile      *file,
 			     DBUS_TYPE_STRING, &attributes,
 			     DBUS_TYPE_UINT32, &flags_dbus,
 			     DBUS_TYPE_STRING, &uri,
+			     DBUS_TYPE_UINT32, &credit,
+			     DBUS_TYPE_UINT32, &enumerate_flags,
 			     0);
   g_free (uri);
   g_free (obj_path);
@@ -757,6 +793,21 @@ g_daemon_file_enumerate_children (GFile      *file,
   if (reply == NULL)
     goto error;
 
+  /* Older daemons don't send a socket, the infos come over D-Bus then */
+  if (dbus_message_get_args (reply, NULL,
+			     DBUS_TYPE_UINT32, &fd_id,
+			     DBUS_TYPE_INVALID))
+    {
+      fd = _g_dbus_connection_get_fd_sync (connection, fd_id);
+      if (fd == -1)
+	{
+	  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+			       _("Didn't get stream file descriptor"));
+	  goto error;
+	}
+      g_daemon_file_enumerator_set_socket (enumerator, fd);
+    }
+
   dbus_message_unref (reply);
 
   g_daemon_file_enumerator_set_sync_connection (enumerator, connection);
@@ -765,11 +816,76 @@ g_daemon_file_enumerate_children (GFile      *file,
 
  error:
   if (reply)
-    dbus_message_unref (reply);
+    {
+      _g_dbus_connection_release (connection);
+      dbus_message_unref (reply);
+    }
   g_object_unref (enumerator);
   return NULL;
 }
 
+/* Lists the whole tree below file, max_depth levels deep (0 for no
+ * limit) with the walk done in the daemon. The name of each info is
+ * the path relative to file. Registered as a GVfsClientOps for the
+ * gvfs tools. */
+GFileEnumerator *
+g_daemon_file_enumerate_recursive (GFile               *file,
+				   const char          *attributes,
+				   GFileQueryInfoFlags  flags,
+				   guint                max_depth,
+				   GCancellable        *cancellable,
+				   GError             **error)
+{
+  DBusMessage *reply;
+  dbus_uint32_t flags_dbus, max_depth_dbus, credit;
+  char *obj_path;
+  GDaemonFileEnumerator *enumerator;
+  DBusConnection *connection;
+  char *uri;
+
+  if (!G_IS_DAEMON_FILE (file))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			   _("Operation not supported"));
+      return NULL;
+    }
+
+  enumerator = g_daemon_file_enumerator_new (file, attributes, flags);
+  obj_path = g_daemon_file_enumerator_get_object_path (enumerator);
+
+  uri = g_file_get_uri (file);
+  
+  if (attributes == NULL)
+    attributes = "";
+  flags_dbus = flags;
+  max_depth_dbus = max_depth;
+  credit = G_VFS_ENUMERATOR_DEFAULT_CREDIT;
+  reply = do_sync_path_call (file, 
+			     G_VFS_DBUS_MOUNT_OP_ENUMERATE_RECURSIVE,
+			     NULL, &connection,
+			     cancellable, error,
+			     DBUS_TYPE_STRING, &obj_path,
+			     DBUS_TYPE_STRING, &attributes,
+			     DBUS_TYPE_UINT32, &flags_dbus,
+			     DBUS_TYPE_STRING, &uri,
+			     DBUS_TYPE_UINT32, &max_depth_dbus,
+			     DBUS_TYPE_UINT32, &credit,
+			     0);
+  g_free (uri);
+  g_free (obj_path);
+
+  if (reply == NULL)
+    {
+      g_object_unref (enumerator);
+      return NULL;
+    }
+  dbus_message_unref (reply);
+
+  g_daemon_file_enumerator_set_sync_connection (enumerator, connection);
+  
+  return G_FILE_ENUMERATOR (enumerator);
+}
+
 
 static gboolean
 enumerate_keys_callback (const char *key,
@@ -841,16 +957,32 @@ g_daemon_file_query_info (GFile                *file,
 			  GCancellable         *cancellable,
 			  GError              **error)
 {
+  GDaemonFile *daemon_file = G_DAEMON_FILE (file);
   DBusMessage *reply;
   dbus_uint32_t flags_dbus;
   DBusMessageIter iter;
   GFileInfo *info;
+  guint generation;
   char *uri;
 
-  uri = g_file_get_uri (file);
-
   if (attributes == NULL)
     attributes = "";
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return NULL;
+
+  info = _g_daemon_vfs_info_cache_lookup (daemon_file->mount_spec,
+					  daemon_file->path,
+					  attributes, flags);
+  if (info)
+    {
+      add_metadata (file, attributes, info);
+      return info;
+    }
+  generation = _g_daemon_vfs_info_cache_get_generation (daemon_file->mount_spec);
+
+  uri = g_file_get_uri (file);
+
   flags_dbus = flags;
   reply = do_sync_path_call (file, 
 			     G_VFS_DBUS_MOUNT_OP_QUERY_INFO,
@@ -880,13 +1012,256 @@ g_daemon_file_query_info (GFile                *file,
   info = _g_dbus_get_file_info (&iter, error);
 
   if (info)
-    add_metadata (file, attributes, info);
+    {
+      _g_daemon_vfs_info_cache_insert (daemon_file->mount_spec, generation,
+				       daemon_file->path, attributes, flags,
+				       info);
+      add_metadata (file, attributes, info);
+    }
 
  out:
   dbus_message_unref (reply);
   return info;
 }
 
+/* Paths sent in one QueryInfoMulti, keeps the messages small */
+#define QUERY_INFO_MULTI_MAX_FILES 256
+
+/* Sends one QueryInfoMulti for the files at indexes, which are all on
+   mount_info. Returns FALSE if the call as a whole failed. */
+static gboolean
+query_info_multi_call (GFile              **files,
+		       const guint         *indexes,
+		       guint                n_indexes,
+		       GMountInfo          *mount_info,
+		       const char          *attributes,
+		       GFileQueryInfoFlags  flags,
+		       GFileInfo          **infos,
+		       GError             **errors,
+		       GCancellable        *cancellable,
+		       GError             **error)
+{
+  DBusMessage *message, *reply;
+  DBusMessageIter iter, array_iter, struct_iter;
+  dbus_uint32_t flags_dbus;
+  dbus_bool_t ok;
+  dbus_uint32_t code;
+  const char *path, *error_message;
+  char *uri;
+  guint i, j;
+
+  message =
+    dbus_message_new_method_call (mount_info->dbus_id,
+				  mount_info->object_path,
+				  G_VFS_DBUS_MOUNT_INTERFACE,
+				  G_VFS_DBUS_MOUNT_OP_QUERY_INFO_MULTI);
+
+  dbus_message_iter_init_append (message, &iter);
+  if (!dbus_message_iter_open_container (&iter,
+					 DBUS_TYPE_ARRAY,
+					 G_VFS_QUERY_INFO_MULTI_PATH_TYPE_AS_STRING,
+					 &array_iter))
+    _g_dbus_oom ();
+
+  for (i = 0; i < n_indexes; i++)
+    {
+      j = indexes[i];
+
+      if (!dbus_message_iter_open_container (&array_iter,
+					     DBUS_TYPE_STRUCT,
+					     NULL,
+					     &struct_iter))
+	_g_dbus_oom ();
+
+      path = g_mount_info_resolve_path (mount_info,
+					G_DAEMON_FILE (files[j])->path);
+      uri = g_file_get_uri (files[j]);
+      _g_dbus_message_iter_append_cstring (&struct_iter, path);
+      if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_STRING, &uri))
+	_g_dbus_oom ();
+      g_free (uri);
+
+      if (!dbus_message_iter_close_container (&array_iter, &struct_iter))
+	_g_dbus_oom ();
+    }
+
+  if (!dbus_message_iter_close_container (&iter, &array_iter))
+    _g_dbus_oom ();
+
+  flags_dbus = flags;
+  _g_dbus_message_append_args (message,
+			       DBUS_TYPE_STRING, &attributes,
+			       DBUS_TYPE_UINT32, &flags_dbus,
+			       0);
+
+  reply = _g_vfs_daemon_call_sync (message,
+				   NULL,
+				   NULL, NULL, NULL,
+				   cancellable, error);
+  dbus_message_unref (message);
+
+  if (reply == NULL)
+    return FALSE;
+
+  if (!dbus_message_iter_init (reply, &iter) ||
+      dbus_message_iter_get_arg_type (&iter) != DBUS_TYPE_ARRAY ||
+      dbus_message_iter_get_element_type (&iter) != DBUS_TYPE_STRUCT)
+    goto invalid;
+
+  dbus_message_iter_recurse (&iter, &array_iter);
+  for (i = 0; i < n_indexes; i++)
+    {
+      j = indexes[i];
+
+      if (dbus_message_iter_get_arg_type (&array_iter) != DBUS_TYPE_STRUCT)
+	goto invalid;
+
+      dbus_message_iter_recurse (&array_iter, &struct_iter);
+      if (!_g_dbus_message_iter_get_args (&struct_iter, NULL,
+					  DBUS_TYPE_BOOLEAN, &ok,
+					  DBUS_TYPE_UINT32, &code,
+					  DBUS_TYPE_STRING, &error_message,
+					  0))
+	goto invalid;
+
+      if (ok)
+	{
+	  infos[j] = _g_dbus_get_file_info (&struct_iter, &errors[j]);
+	  if (infos[j])
+	    add_metadata (files[j], attributes, infos[j]);
+	}
+      else
+	g_set_error_literal (&errors[j], G_IO_ERROR, code, error_message);
+
+      dbus_message_iter_next (&array_iter);
+    }
+
+  dbus_message_unref (reply);
+  return TRUE;
+
+ invalid:
+  for (i = 0; i < n_indexes; i++)
+    {
+      j = indexes[i];
+      if (infos[j])
+	g_object_unref (infos[j]);
+      infos[j] = NULL;
+      g_clear_error (&errors[j]);
+    }
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+	       _("Invalid return value from %s"), "query_info_multi");
+  dbus_message_unref (reply);
+  return FALSE;
+}
+
+/* Queries the same attributes of many files with one round trip per
+ * mount, or a few for many files. Afterwards infos[i] or errors[i] is
+ * set for each file. Files that are not on a daemon mount, or whose
+ * daemon doesn't have QueryInfoMulti, are queried one by one.
+ * Registered as a GVfsClientOps for the gvfs tools. */
+void
+g_daemon_file_query_info_multi (GFile               **files,
+				guint                 n_files,
+				const char           *attributes,
+				GFileQueryInfoFlags   flags,
+				GFileInfo           **infos,
+				GError              **errors,
+				GCancellable         *cancellable)
+{
+  GMountInfo **mount_infos, *mount_info;
+  GDaemonFile *daemon_file;
+  gboolean *done;
+  GError *my_error;
+  guint *indexes;
+  guint i, j, k, n_indexes;
+
+  if (attributes == NULL)
+    attributes = "";
+
+  mount_infos = g_new0 (GMountInfo *, n_files);
+  done = g_new0 (gboolean, n_files);
+  indexes = g_new (guint, MIN (n_files, QUERY_INFO_MULTI_MAX_FILES));
+  for (i = 0; i < n_files; i++)
+    {
+      infos[i] = NULL;
+      errors[i] = NULL;
+      if (G_IS_DAEMON_FILE (files[i]))
+	{
+	  daemon_file = G_DAEMON_FILE (files[i]);
+	  mount_infos[i] = _g_daemon_vfs_get_mount_info_sync (daemon_file->mount_spec,
+							      daemon_file->path,
+							      NULL);
+	}
+    }
+
+  for (i = 0; i < n_files; i++)
+    {
+      if (mount_infos[i] == NULL || done[i])
+	continue;
+
+      /* This file and the following ones on the same mount */
+      mount_info = mount_infos[i];
+      n_indexes = 0;
+      for (j = i; j < n_files && n_indexes < QUERY_INFO_MULTI_MAX_FILES; j++)
+	if (mount_infos[j] == mount_info && !done[j])
+	  indexes[n_indexes++] = j;
+
+      my_error = NULL;
+      if (query_info_multi_call (files, indexes, n_indexes, mount_info,
+				 attributes, flags, infos, errors,
+				 cancellable, &my_error))
+	{
+	  for (k = 0; k < n_indexes; k++)
+	    done[indexes[k]] = TRUE;
+	}
+      else if (g_error_matches (my_error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+	{
+	  /* Old daemon, query all its files one by one below */
+	  for (j = i; j < n_files; j++)
+	    if (mount_infos[j] == mount_info)
+	      {
+		mount_infos[j] = NULL;
+		g_mount_info_unref (mount_info);
+	      }
+	  g_error_free (my_error);
+	}
+      else
+	{
+	  for (k = 0; k < n_indexes; k++)
+	    {
+	      errors[indexes[k]] = g_error_copy (my_error);
+	      done[indexes[k]] = TRUE;
+	    }
+	  g_error_free (my_error);
+	}
+    }
+
+  for (i = 0; i < n_files; i++)
+    {
+      if (mount_infos[i] != NULL)
+	g_mount_info_unref (mount_infos[i]);
+      if (!done[i])
+	infos[i] = g_file_query_info (files[i], attributes, flags,
+				      cancellable, &errors[i]);
+    }
+  g_free (indexes);
+  g_free (done);
+  g_free (mount_infos);
+}
+
+typedef struct {
+  char *attributes;
+  GFileQueryInfoFlags flags;
+  guint generation;
+} QueryInfoData;
+
+static void
+query_info_data_free (QueryInfoData *data)
+{
+  g_free (data->attributes);
+  g_free (data);
+}
+
 static void
 query_info_async_cb (DBusMessage *reply,
 		     DBusConnection *connection,
@@ -895,7 +1270,7 @@ query_info_async_cb (DBusMessage *reply,
 		     GCancellable *cancellable,
 		     gpointer callback_data)
 {
-  const char *attributes = callback_data;
+  QueryInfoData *data = callback_data;
   DBusMessageIter iter;
   GFileInfo *info;
   GError *error;
@@ -924,7 +1299,11 @@ query_info_async_cb (DBusMessage *reply,
     }
 
   file = G_FILE (g_async_result_get_source_object (G_ASYNC_RESULT (result)));
-  add_metadata (file, attributes, info);
+  _g_daemon_vfs_info_cache_insert (G_DAEMON_FILE (file)->mount_spec,
+				   data->generation,
+				   G_DAEMON_FILE (file)->path,
+				   data->attributes, data->flags, info);
+  add_metadata (file, data->attributes, info);
   g_object_unref (file);
 
   g_simple_async_result_set_op_res_gpointer (result, info, g_object_unref);
@@ -940,9 +1319,36 @@ g_daemon_file_query_info_async (GFile                      *file,
 				GAsyncReadyCallback         callback,
 				gpointer                    user_data)
 {
+  GDaemonFile *daemon_file = G_DAEMON_FILE (file);
+  GSimpleAsyncResult *res;
+  QueryInfoData *data;
+  GFileInfo *info;
   guint32 dbus_flags;
   char *uri;
 
+  /* Cancelled calls fail below, like without the cache */
+  info = NULL;
+  if (!g_cancellable_is_cancelled (cancellable))
+    info = _g_daemon_vfs_info_cache_lookup (daemon_file->mount_spec,
+					    daemon_file->path,
+					    attributes, flags);
+  if (info)
+    {
+      add_metadata (file, attributes, info);
+      res = g_simple_async_result_new (G_OBJECT (file),
+				       callback, user_data,
+				       g_daemon_file_query_info_async);
+      g_simple_async_result_set_op_res_gpointer (res, info, g_object_unref);
+      g_simple_async_result_complete_in_idle (res);
+      g_object_unref (res);
+      return;
+    }
+
+  data = g_new0 (QueryInfoData, 1);
+  data->attributes = g_strdup (attributes);
+  data->flags = flags;
+  data->generation = _g_daemon_vfs_info_cache_get_generation (daemon_file->mount_spec);
+
   uri = g_file_get_uri (file);
 
   dbus_flags = flags;
@@ -950,7 +1356,8 @@ g_daemon_file_query_info_async (GFile                      *file,
 		      G_VFS_DBUS_MOUNT_OP_QUERY_INFO,
 		      cancellable,
 		      callback, user_data,
-		      query_info_async_cb, g_strdup (attributes), g_free,
+		      query_info_async_cb, data,
+		      (GDestroyNotify)query_info_data_free,
 		      DBUS_TYPE_STRING, &attributes,
 		      DBUS_TYPE_UINT32, &dbus_flags,
 		      DBUS_TYPE_STRING, &uri,
@@ -978,14 +1385,43 @@ typedef struct {
   GSimpleAsyncResult *result;
   GCancellable *cancellable;
   gboolean can_seek;
+  DBusConnection *connection;
+  guint32 shm_fd_id;
+  guint32 shm_size;
+  GFileInputStream *stream;
 } GetFDData;
 
+static void
+read_async_done (GetFDData *data)
+{
+  if (data->stream)
+    g_simple_async_result_set_op_res_gpointer (data->result, data->stream, g_object_unref);
+
+  _g_simple_async_result_complete_with_cancellable (data->result, data->cancellable);
+
+  dbus_connection_unref (data->connection);
+  g_object_unref (data->result);
+  g_free (data);
+}
+
+static void
+read_async_get_shm_fd_cb (int fd,
+			  gpointer callback_data)
+{
+  GetFDData *data = callback_data;
+
+  /* Without the ring all data comes over the socket */
+  if (fd != -1)
+    g_daemon_file_input_stream_set_shared_memory (data->stream, fd, data->shm_size, NULL);
+
+  read_async_done (data);
+}
+
 static void
 read_async_get_fd_cb (int fd,
 		      gpointer callback_data)
 {
   GetFDData *data = callback_data;
-  GFileInputStream *stream;
   
   if (fd == -1)
     {
@@ -995,14 +1431,17 @@ read_async_get_fd_cb (int fd,
     }
   else
     {
-      stream = g_daemon_file_input_stream_new (fd, data->can_seek);
-      g_simple_async_result_set_op_res_gpointer (data->result, stream, g_object_unref);
-    }
+      data->stream = g_daemon_file_input_stream_new (fd, data->can_seek);
 
-  _g_simple_async_result_complete_with_cancellable (data->result, data->cancellable);
+      if (data->shm_size != 0)
+	{
+	  _g_dbus_connection_get_fd_async (data->connection, data->shm_fd_id,
+					   read_async_get_shm_fd_cb, data);
+	  return;
+	}
+    }
 
-  g_object_unref (data->result);
-  g_free (data);
+  read_async_done (data);
 }
 
 static void
@@ -1013,14 +1452,12 @@ read_async_cb (DBusMessage *reply,
 	       GCancellable *cancellable,
 	       gpointer callback_data)
 {
-  guint32 fd_id;
+  guint32 fd_id, shm_fd_id, shm_size;
   dbus_bool_t can_seek;
   GetFDData *get_fd_data;
   
-  if (!dbus_message_get_args (reply, NULL,
-			      DBUS_TYPE_UINT32, &fd_id,
-			      DBUS_TYPE_BOOLEAN, &can_seek,
-			      DBUS_TYPE_INVALID))
+  if (!get_open_for_read_reply (reply, &fd_id, &can_seek,
+				&shm_fd_id, &shm_size))
     {
       g_simple_async_result_set_error (result,
 				       G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -1032,6 +1469,9 @@ read_async_cb (DBusMessage *reply,
   get_fd_data = g_new0 (GetFDData, 1);
   get_fd_data->result = g_object_ref (result);
   get_fd_data->can_seek = can_seek;
+  get_fd_data->connection = dbus_connection_ref (connection);
+  get_fd_data->shm_fd_id = shm_fd_id;
+  get_fd_data->shm_size = shm_size;
   
   _g_dbus_connection_get_fd_async (connection, fd_id,
 				   read_async_get_fd_cb, get_fd_data);
@@ -1045,8 +1485,10 @@ g_daemon_file_read_async (GFile *file,
 			  gpointer callback_data)
 {
   guint32 pid;
+  guint32 flags;
 
   pid = get_pid_for_file (file);
+  flags = G_VFS_DAEMON_OPEN_FLAG_SHM;
 
   do_async_path_call (file,
 		      G_VFS_DBUS_MOUNT_OP_OPEN_FOR_READ,
@@ -1054,6 +1496,7 @@ g_daemon_file_read_async (GFile *file,
 		      callback, callback_data,
 		      read_async_cb, NULL, NULL,
                       DBUS_TYPE_UINT32, &pid,
+                      DBUS_TYPE_UINT32, &flags,
 		      0);
 }
 
@@ -1073,34 +1516,71 @@ g_daemon_file_read_finish (GFile                  *file,
 }
 
 
+/* The shared memory arguments are only there if the daemon
+   supports it, shm_size is 0 otherwise */
+static gboolean
+get_open_for_read_reply (DBusMessage *reply,
+			 guint32 *fd_id,
+			 dbus_bool_t *can_seek,
+			 guint32 *shm_fd_id,
+			 guint32 *shm_size)
+{
+  DBusMessageIter iter;
+
+  *shm_fd_id = 0;
+  *shm_size = 0;
+  
+  if (!dbus_message_get_args (reply, NULL,
+			      DBUS_TYPE_UINT32, fd_id,
+			      DBUS_TYPE_BOOLEAN, can_seek,
+			      DBUS_TYPE_INVALID))
+    return FALSE;
+
+  dbus_message_iter_init (reply, &iter);
+  if (dbus_message_iter_next (&iter) &&
+      dbus_message_iter_next (&iter) &&
+      dbus_message_iter_get_arg_type (&iter) == DBUS_TYPE_UINT32)
+    {
+      dbus_message_iter_get_basic (&iter, shm_fd_id);
+      if (dbus_message_iter_next (&iter) &&
+	  dbus_message_iter_get_arg_type (&iter) == DBUS_TYPE_UINT32)
+	dbus_message_iter_get_basic (&iter, shm_size);
+    }
+
+  return TRUE;
+}
+
 static GFileInputStream *
 g_daemon_file_read (GFile *file,
 		    GCancellable *cancellable,
 		    GError **error)
 {
   DBusConnection *connection;
-  int fd;
+  int fd, shm_fd;
   DBusMessage *reply;
-  guint32 fd_id;
+  guint32 fd_id, shm_fd_id, shm_size;
   dbus_bool_t can_seek;
   guint32 pid;
+  guint32 flags;
+  GFileInputStream *stream;
 
   pid = get_pid_for_file (file);
+  flags = G_VFS_DAEMON_OPEN_FLAG_SHM;
 
   reply = do_sync_path_call (file, 
 			     G_VFS_DBUS_MOUNT_OP_OPEN_FOR_READ,
 			     NULL, &connection,
 			     cancellable, error,
                              DBUS_TYPE_UINT32, &pid,
+                             DBUS_TYPE_UINT32, &flags,
 			     0);
   if (reply == NULL)
     return NULL;
 
-  if (!dbus_message_get_args (reply, NULL,
-			      DBUS_TYPE_UINT32, &fd_id,
-			      DBUS_TYPE_BOOLEAN, &can_seek,
-			      DBUS_TYPE_INVALID))
+  if (!get_open_for_read_reply (reply, &fd_id, &can_seek,
+				&shm_fd_id, &shm_size))
     {
+      _g_dbus_connection_release (connection);
       dbus_message_unref (reply);
       g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			   _("Invalid return value from %s"), "open");
@@ -1110,6 +1590,12 @@ g_daemon_file_read (GFile *file,
   dbus_message_unref (reply);
 
   fd = _g_dbus_connection_get_fd_sync (connection, fd_id);
+  /* Without the ring all data comes over the socket */
+  shm_fd = -1;
+  if (fd != -1 && shm_size != 0)
+    shm_fd = _g_dbus_connection_get_fd_sync (connection, shm_fd_id);
+  _g_dbus_connection_release (connection);
+
   if (fd == -1)
     {
       g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -1117,7 +1603,12 @@ g_daemon_file_read (GFile *file,
       return NULL;
     }
   
-  return g_daemon_file_input_stream_new (fd, can_seek);
+  stream = g_daemon_file_input_stream_new (fd, can_seek);
+
+  if (shm_fd != -1)
+    g_daemon_file_input_stream_set_shared_memory (stream, shm_fd, shm_size, NULL);
+
+  return stream;
 }
 
 static GFileOutputStream *
@@ -1164,6 +1655,7 @@ g_daemon_file_append_to (GFile *file,
 			      DBUS_TYPE_UINT64, &initial_offset,
 			      DBUS_TYPE_INVALID))
     {
+      _g_dbus_connection_release (connection);
       dbus_message_unref (reply);
       g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			   _("Invalid return value from %s"), "open");
@@ -1173,6 +1665,7 @@ g_daemon_file_append_to (GFile *file,
   dbus_message_unref (reply);
 
   fd = _g_dbus_connection_get_fd_sync (connection, fd_id);
+  _g_dbus_connection_release (connection);
   if (fd == -1)
     {
       g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -1180,7 +1673,7 @@ g_daemon_file_append_to (GFile *file,
       return NULL;
     }
   
-  return g_daemon_file_output_stream_new (fd, can_seek, initial_offset);
+  return g_daemon_file_output_stream_new (file, fd, can_seek, initial_offset);
 }
 
 static GFileOutputStream *
@@ -1227,6 +1720,7 @@ g_daemon_file_create (GFile *file,
 			      DBUS_TYPE_UINT64, &initial_offset,
 			      DBUS_TYPE_INVALID))
     {
+      _g_dbus_connection_release (connection);
       dbus_message_unref (reply);
       g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			   _("Invalid return value from %s"), "open");
@@ -1236,6 +1730,7 @@ g_daemon_file_create (GFile *file,
   dbus_message_unref (reply);
 
   fd = _g_dbus_connection_get_fd_sync (connection, fd_id);
+  _g_dbus_connection_release (connection);
   if (fd == -1)
     {
       g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -1243,7 +1738,7 @@ g_daemon_file_create (GFile *file,
       return NULL;
     }
   
-  return g_daemon_file_output_stream_new (fd, can_seek, initial_offset);
+  return g_daemon_file_output_stream_new (file, fd, can_seek, initial_offset);
 }
 
 static GFileOutputStream *
@@ -1293,6 +1788,7 @@ g_daemon_file_replace (GFile *file,
 			      DBUS_TYPE_UINT64, &initial_offset,
 			      DBUS_TYPE_INVALID))
     {
+      _g_dbus_connection_release (connection);
       dbus_message_unref (reply);
       g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			   _("Invalid return value from %s"), "open");
@@ -1302,6 +1798,7 @@ g_daemon_file_replace (GFile *file,
   dbus_message_unref (reply);
 
   fd = _g_dbus_connection_get_fd_sync (connection, fd_id);
+  _g_dbus_connection_release (connection);
   if (fd == -1)
     {
       g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -1309,7 +1806,7 @@ g_daemon_file_replace (GFile *file,
       return NULL;
     }
   
-  return g_daemon_file_output_stream_new (fd, can_seek, initial_offset);
+  return g_daemon_file_output_stream_new (file, fd, can_seek, initial_offset);
 }
 
 static void
@@ -2353,6 +2850,160 @@ progress_callback_message (DBusConnection  *connection,
   return DBUS_HANDLER_RESULT_HANDLED;
 }
 
+/* Copies a regular file between two mounts with the read stream of
+ * the source daemon handed to the destination daemon, so the data
+ * doesn't pass through this process. Anything else fails with
+ * G_IO_ERROR_NOT_SUPPORTED for the generic copy to handle. */
+static gboolean
+transfer_between_daemons (GFile                  *source,
+			  GFile                  *destination,
+			  GFileCopyFlags          flags,
+			  GCancellable           *cancellable,
+			  GFileProgressCallback   progress_callback,
+			  gpointer                progress_callback_data,
+			  GError                **error)
+{
+  GDaemonFile *daemon_destination = G_DAEMON_FILE (destination);
+  DBusConnection *connection;
+  DBusMessage *reply;
+  GMountInfo *mount_info;
+  GFileInfo *info;
+  GError *my_error;
+  char *obj_path, *dbus_obj_path;
+  dbus_uint32_t fd_id, flags_dbus, pid, open_flags;
+  dbus_uint64_t total_size;
+  dbus_bool_t can_seek;
+  guint32 shm_fd_id, shm_size;
+  struct ProgressCallbackData data;
+  int fd;
+
+  info = g_file_query_info (source,
+			    G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+			    G_FILE_ATTRIBUTE_STANDARD_SIZE,
+			    (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS) ?
+			    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS : 0,
+			    cancellable, error);
+  if (info == NULL)
+    return FALSE;
+
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_REGULAR)
+    {
+      g_object_unref (info);
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "Operation not supported");
+      return FALSE;
+    }
+  total_size = g_file_info_get_size (info);
+  g_object_unref (info);
+
+  /* No shared memory, the stream goes to another daemon */
+  pid = get_pid_for_file (source);
+  open_flags = 0;
+  reply = do_sync_path_call (source,
+			     G_VFS_DBUS_MOUNT_OP_OPEN_FOR_READ,
+			     NULL, &connection,
+			     cancellable, error,
+                             DBUS_TYPE_UINT32, &pid,
+                             DBUS_TYPE_UINT32, &open_flags,
+			     0);
+  if (reply == NULL)
+    return FALSE;
+
+  if (!get_open_for_read_reply (reply, &fd_id, &can_seek,
+				&shm_fd_id, &shm_size))
+    {
+      _g_dbus_connection_release (connection);
+      dbus_message_unref (reply);
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		   _("Invalid return value from %s"), "open");
+      return FALSE;
+    }
+  dbus_message_unref (reply);
+
+  fd = _g_dbus_connection_get_fd_sync (connection, fd_id);
+  _g_dbus_connection_release (connection);
+  if (fd == -1)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+			   _("Didn't get stream file descriptor"));
+      return FALSE;
+    }
+
+  /* Hand it to the destination daemon on the connection the call
+     goes out on */
+  mount_info = _g_daemon_vfs_get_mount_info_sync (daemon_destination->mount_spec,
+						  daemon_destination->path,
+						  error);
+  if (mount_info == NULL)
+    {
+      close (fd);
+      return FALSE;
+    }
+  connection = _g_dbus_connection_get_sync (mount_info->dbus_id, error);
+  g_mount_info_unref (mount_info);
+  if (connection == NULL)
+    {
+      close (fd);
+      return FALSE;
+    }
+  if (!_g_dbus_connection_send_fd_sync (connection, fd, &fd_id, NULL))
+    {
+      _g_dbus_connection_release (connection);
+      close (fd);
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "Operation not supported");
+      return FALSE;
+    }
+  close (fd);
+
+  if (progress_callback)
+    {
+      obj_path = g_strdup_printf ("/org/gtk/vfs/callback/%p", &obj_path);
+      dbus_obj_path = obj_path;
+    }
+  else
+    {
+      obj_path = NULL;
+      /* Can't pass NULL obj path as arg */
+      dbus_obj_path = "/org/gtk/vfs/void";
+    }
+
+  data.progress_callback = progress_callback;
+  data.progress_callback_data = progress_callback_data;
+
+  flags_dbus = flags;
+  pid = get_pid_for_file (destination);
+  my_error = NULL;
+  reply = do_sync_2_path_call (destination, NULL,
+			       G_VFS_DBUS_MOUNT_OP_PUSH_FROM_CHANNEL,
+			       obj_path, progress_callback_message, &data,
+			       NULL, cancellable, &my_error,
+			       DBUS_TYPE_UINT32, &fd_id,
+			       DBUS_TYPE_UINT64, &total_size,
+			       DBUS_TYPE_UINT32, &flags_dbus,
+			       DBUS_TYPE_OBJECT_PATH, &dbus_obj_path,
+			       DBUS_TYPE_UINT32, &pid,
+			       0);
+  /* Held until now so the call goes out on it */
+  _g_dbus_connection_release (connection);
+  g_free (obj_path);
+  invalidate_info_cache (destination);
+
+  /* Daemons from before PushFromChannel fail with NOT_SUPPORTED,
+     which makes the caller fall back to a plain copy */
+  if (reply == NULL)
+    {
+      g_propagate_error (error, my_error);
+      return FALSE;
+    }
+  dbus_message_unref (reply);
+
+  /* Like the generic copy, ignoring errors */
+  g_file_copy_attributes (source, destination, flags, cancellable, NULL);
+
+  return TRUE;
+}
+
 static gboolean
 file_transfer (GFile                  *source,
                GFile                  *destination,
@@ -2373,6 +3024,7 @@ file_transfer (GFile                  *source,
   gboolean dest_is_daemon;
   gboolean native_transfer;
   gboolean send_progress;
+  GError *my_error;
 
   native_transfer  = FALSE;
   source_is_daemon = G_IS_DAEMON_FILE (source);
@@ -2424,18 +3076,39 @@ file_transfer (GFile                  *source,
     {
       const char *method_string;
 
+      /* Only push and pull can resume */
+      flags &= ~G_VFS_TRANSFER_FLAG_RESUME;
+      flags_dbus = flags;
+
       if (remove_source == FALSE)
         method_string = G_VFS_DBUS_MOUNT_OP_COPY;
       else
         method_string = G_VFS_DBUS_MOUNT_OP_MOVE;
 
+      my_error = NULL;
       reply = do_sync_2_path_call (source, destination,
                                    method_string,
                                    obj_path, progress_callback_message, &data,
-                                   NULL, cancellable, error,
+                                   NULL, cancellable, &my_error,
                                    DBUS_TYPE_UINT32, &flags_dbus,
                                    DBUS_TYPE_OBJECT_PATH, &dbus_obj_path,
                                    0);
+
+      /* Files on different mounts, or a backend without copy. A move
+         falls back to copy and delete, which ends up here too. */
+      if (reply == NULL && remove_source == FALSE &&
+          g_error_matches (my_error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+        {
+          g_error_free (my_error);
+          g_free (obj_path);
+          return transfer_between_daemons (source, destination, flags,
+                                           cancellable,
+                                           progress_callback,
+                                           progress_callback_data,
+                                           error);
+        }
+      if (reply == NULL)
+        g_propagate_error (error, my_error);
     }
   else if (dest_is_daemon == TRUE)
     {
@@ -2465,6 +3138,11 @@ file_transfer (GFile                  *source,
 
     }
 
+  if (dest_is_daemon)
+    invalidate_info_cache (destination);
+  if (source_is_daemon && remove_source)
+    invalidate_info_cache (source);
+
   g_free (local_path);
   g_free (obj_path);
 
@@ -2475,6 +3153,139 @@ file_transfer (GFile                  *source,
   return TRUE;
 }
 
+struct DiskUsageProgressData {
+  GDaemonFileDiskUsageProgressCallback progress_callback;
+  gpointer progress_callback_data;
+};
+
+static DBusHandlerResult
+disk_usage_progress_message (DBusConnection  *connection,
+			     DBusMessage     *message,
+			     void            *user_data)
+{
+  struct DiskUsageProgressData *data = user_data;
+  dbus_uint64_t size, allocated_size, n_dirs, n_files;
+
+  if (dbus_message_is_method_call (message,
+				   G_VFS_DBUS_PROGRESS_INTERFACE,
+				   G_VFS_DBUS_PROGRESS_OP_DISK_USAGE))
+    {
+      if (dbus_message_get_args (message, NULL,
+				 DBUS_TYPE_UINT64, &size,
+				 DBUS_TYPE_UINT64, &allocated_size,
+				 DBUS_TYPE_UINT64, &n_dirs,
+				 DBUS_TYPE_UINT64, &n_files,
+				 0))
+	data->progress_callback (size, allocated_size, n_dirs, n_files,
+				 data->progress_callback_data);
+    }
+  else
+    g_warning ("Unknown progress callback message type\n");
+
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* Adds up the sizes of file and everything below it, with the walk
+ * done in the daemon, or by the backend if it knows a faster way.
+ * Symlinks are not followed. Unreadable directories are skipped
+ * unless flags has G_VFS_DISK_USAGE_FLAG_REPORT_ANY_ERROR. */
+gboolean
+g_daemon_file_query_disk_usage (GFile                                 *file,
+				guint32                                flags,
+				guint64                               *size,
+				guint64                               *allocated_size,
+				guint64                               *n_dirs,
+				guint64                               *n_files,
+				GDaemonFileDiskUsageProgressCallback   progress_callback,
+				gpointer                               progress_callback_data,
+				GCancellable                          *cancellable,
+				GError                               **error)
+{
+  DBusMessage *reply;
+  char *obj_path, *dbus_obj_path;
+  dbus_uint32_t flags_dbus;
+  dbus_uint64_t size_dbus, allocated_size_dbus, n_dirs_dbus, n_files_dbus;
+  struct DiskUsageProgressData data;
+
+  if (progress_callback)
+    {
+      obj_path = g_strdup_printf ("/org/gtk/vfs/callback/%p", &obj_path);
+      dbus_obj_path = obj_path;
+    }
+  else
+    {
+      obj_path = NULL;
+      /* Can't pass NULL obj path as arg */
+      dbus_obj_path = "/org/gtk/vfs/void";
+    }
+
+  data.progress_callback = progress_callback;
+  data.progress_callback_data = progress_callback_data;
+
+  flags_dbus = flags;
+  reply = do_sync_2_path_call (file, NULL,
+			       G_VFS_DBUS_MOUNT_OP_QUERY_DISK_USAGE,
+			       obj_path, disk_usage_progress_message, &data,
+			       NULL, cancellable, error,
+			       DBUS_TYPE_UINT32, &flags_dbus,
+			       DBUS_TYPE_OBJECT_PATH, &dbus_obj_path,
+			       0);
+  g_free (obj_path);
+
+  if (reply == NULL)
+    return FALSE;
+
+  if (!dbus_message_get_args (reply, NULL,
+			      DBUS_TYPE_UINT64, &size_dbus,
+			      DBUS_TYPE_UINT64, &allocated_size_dbus,
+			      DBUS_TYPE_UINT64, &n_dirs_dbus,
+			      DBUS_TYPE_UINT64, &n_files_dbus,
+			      0))
+    {
+      dbus_message_unref (reply);
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+		   _("Invalid return value from %s"), "QueryDiskUsage");
+      return FALSE;
+    }
+  dbus_message_unref (reply);
+
+  if (size)
+    *size = size_dbus;
+  if (allocated_size)
+    *allocated_size = allocated_size_dbus;
+  if (n_dirs)
+    *n_dirs = n_dirs_dbus;
+  if (n_files)
+    *n_files = n_files_dbus;
+
+  return TRUE;
+}
+
+/* Like g_file_copy() between a daemon mount and a local file, but
+ * the daemon keeps checkpoints so that when the copy is interrupted,
+ * running it again continues where it stopped. Only the part that is
+ * still missing is transferred, provided neither side changed in the
+ * meantime. Fails with G_IO_ERROR_NOT_SUPPORTED where g_file_copy()
+ * has to be used instead. */
+gboolean
+g_daemon_file_copy_resumable (GFile                  *source,
+			      GFile                  *destination,
+			      GFileCopyFlags          flags,
+			      GCancellable           *cancellable,
+			      GFileProgressCallback   progress_callback,
+			      gpointer                progress_callback_data,
+			      GError                **error)
+{
+  return file_transfer (source,
+                        destination,
+                        flags | G_VFS_TRANSFER_FLAG_RESUME,
+                        FALSE,
+                        cancellable,
+                        progress_callback,
+                        progress_callback_data,
+                        error);
+}
+
 static gboolean
 g_daemon_file_copy (GFile                  *source,
 		    GFile                  *destination,
@@ -2632,6 +3443,7 @@ static void
 stream_open_cb (gint fd, StreamOpenParams *params)
 {
   GFileOutputStream *output_stream;
+  GFile *file;
 
   if (fd == -1)
     {
@@ -2640,7 +3452,9 @@ stream_open_cb (gint fd, StreamOpenParams *params)
       goto out;
     }
 
-  output_stream = g_daemon_file_output_stream_new (fd, params->can_seek, params->initial_offset);
+  file = G_FILE (g_async_result_get_source_object (G_ASYNC_RESULT (params->result)));
+  output_stream = g_daemon_file_output_stream_new (file, fd, params->can_seek, params->initial_offset);
+  g_object_unref (file);
   g_simple_async_result_set_op_res_gpointer (params->result, output_stream, g_object_unref);
 
 out:
@@ -2819,6 +3633,38 @@ g_daemon_file_create_finish (GFile                      *file,
   return NULL;
 }
 
+typedef struct {
+  GSimpleAsyncResult *result;
+  GCancellable *cancellable;
+  GDaemonFileEnumerator *enumerator;
+} EnumerateGetFdData;
+
+static void
+enumerate_children_async_get_fd_cb (int fd,
+                                    gpointer callback_data)
+{
+  EnumerateGetFdData *data = callback_data;
+
+  if (fd == -1)
+    g_simple_async_result_set_error (data->result, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                     _("Couldn't get stream file descriptor"));
+  else
+    {
+      g_daemon_file_enumerator_set_socket (data->enumerator, fd);
+      g_simple_async_result_set_op_res_gpointer (data->result,
+                                                 g_object_ref (data->enumerator),
+                                                 g_object_unref);
+    }
+
+  _g_simple_async_result_complete_with_cancellable (data->result, data->cancellable);
+
+  g_object_unref (data->result);
+  if (data->cancellable)
+    g_object_unref (data->cancellable);
+  g_object_unref (data->enumerator);
+  g_free (data);
+}
+
 static void
 enumerate_children_async_cb (DBusMessage *reply,
                              DBusConnection *connection,
@@ -2828,6 +3674,8 @@ enumerate_children_async_cb (DBusMessage *reply,
                              gpointer callback_data)
 {
   GDaemonFileEnumerator *enumerator = callback_data;
+  EnumerateGetFdData *data;
+  guint32 fd_id;
 
   if (reply == NULL || connection == NULL)
   {
@@ -2836,6 +3684,23 @@ enumerate_children_async_cb (DBusMessage *reply,
     goto out;
   }
 
+  g_daemon_file_enumerator_set_async_connection (enumerator, connection);
+
+  /* Older daemons don't send a socket, the infos come over D-Bus then */
+  if (dbus_message_get_args (reply, NULL,
+                             DBUS_TYPE_UINT32, &fd_id,
+                             DBUS_TYPE_INVALID))
+    {
+      data = g_new0 (EnumerateGetFdData, 1);
+      data->result = g_object_ref (result);
+      if (cancellable)
+        data->cancellable = g_object_ref (cancellable);
+      data->enumerator = g_object_ref (enumerator);
+      _g_dbus_connection_get_fd_async (connection, fd_id,
+                                       enumerate_children_async_get_fd_cb, data);
+      return;
+    }
+
   g_object_ref (enumerator);
 
   g_simple_async_result_set_op_res_gpointer (result, enumerator, g_object_unref);
@@ -2853,12 +3718,12 @@ g_daemon_file_enumerate_children_async (GFile                      *file,
                                         GAsyncReadyCallback         callback,
                                         gpointer                    user_data)
 {
-  dbus_uint32_t flags_dbus;
+  dbus_uint32_t flags_dbus, credit, enumerate_flags;
   char *obj_path;
   GDaemonFileEnumerator *enumerator;
   char *uri;
 
-  enumerator = g_daemon_file_enumerator_new (file, attributes);
+  enumerator = g_daemon_file_enumerator_new (file, attributes, flags);
   obj_path = g_daemon_file_enumerator_get_object_path (enumerator);
 
   uri = g_file_get_uri (file);
@@ -2866,6 +3731,8 @@ g_daemon_file_enumerate_children_async (GFile                      *file,
   if (attributes == NULL)
     attributes = "";
   flags_dbus = flags;
+  credit = G_VFS_ENUMERATOR_DEFAULT_CREDIT;
+  enumerate_flags = G_VFS_ENUMERATE_FLAG_SOCKET;
   do_async_path_call (file, 
                       G_VFS_DBUS_MOUNT_OP_ENUMERATE,
                       cancellable,
@@ -2875,6 +3742,8 @@ g_daemon_file_enumerate_children_async (GFile                      *file,
                       DBUS_TYPE_STRING, &attributes,
                       DBUS_TYPE_UINT32, &flags_dbus,
                       DBUS_TYPE_STRING, &uri,
+                      DBUS_TYPE_UINT32, &credit,
+                      DBUS_TYPE_UINT32, &enumerate_flags,
                       0);
   g_free (uri);
   g_free (obj_path);
@@ -52,10 +52,46 @@ struct _GDaemonFile
   char *path;
 };
 
+typedef void (*GDaemonFileDiskUsageProgressCallback) (guint64  size,
+						      guint64  allocated_size,
+						      guint64  n_dirs,
+						      guint64  n_files,
+						      gpointer user_data);
+
 GType g_daemon_file_get_type (void) G_GNUC_CONST;
   
 GFile * g_daemon_file_new (GMountSpec *mount_spec,
 			   const char *path);
+GFileEnumerator *g_daemon_file_enumerate_recursive (GFile               *file,
+						    const char          *attributes,
+						    GFileQueryInfoFlags  flags,
+						    guint                max_depth,
+						    GCancellable        *cancellable,
+						    GError             **error);
+void    g_daemon_file_query_info_multi (GFile               **files,
+					guint                 n_files,
+					const char           *attributes,
+					GFileQueryInfoFlags   flags,
+					GFileInfo           **infos,
+					GError              **errors,
+					GCancellable         *cancellable);
+gboolean g_daemon_file_query_disk_usage (GFile                                 *file,
+					 guint32                                flags,
+					 guint64                               *size,
+					 guint64                               *allocated_size,
+					 guint64                               *n_dirs,
+					 guint64                               *n_files,
+					 GDaemonFileDiskUsageProgressCallback   progress_callback,
+					 gpointer                               progress_callback_data,
+					 GCancellable                          *cancellable,
+					 GError                               **error);
+gboolean g_daemon_file_copy_resumable   (GFile                                 *source,
+					 GFile                                 *destination,
+					 GFileCopyFlags                         flags,
+					 GCancellable                          *cancellable,
+					 GFileProgressCallback                  progress_callback,
+					 gpointer                               progress_callback_data,
+					 GError                               **error);
 
 G_END_DECLS
 
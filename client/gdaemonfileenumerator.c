@@ -28,13 +28,21 @@
 #include <glib/gi18n-lib.h>
 #include <gdaemonfileenumerator.h>
 #include <gio/gio.h>
+#include <gio/gunixinputstream.h>
 #include <gvfsdaemondbus.h>
 #include <gvfsdaemonprotocol.h>
+#include <gvfsfileinfo.h>
 #include "gdaemonfile.h"
 #include "metatree.h"
 
 #define OBJ_PATH_PREFIX "/org/gtk/vfs/client/enumerator/"
 
+/* Give back credit in chunks, to keep the messages few */
+#define CREDIT_CHUNK (G_VFS_ENUMERATOR_DEFAULT_CREDIT / 4)
+
+/* Larger records on the socket are treated as corrupt */
+#define MAX_SOCKET_RECORD_SIZE (16*1024*1024)
+
 /* atomic */
 static volatile gint path_counter = 1;
 
@@ -51,6 +59,17 @@ struct _GDaemonFileEnumerator
   GList *infos;
   gboolean done;
 
+  /* Flow control, also protected by infos lock */
+  DBusConnection *credit_connection; /* the connection the infos come on */
+  guint n_consumed;
+  gboolean credit_unlimited;
+
+  /* Set if the daemon streams the infos over a socket, see
+     G_VFS_ENUMERATE_FLAG_SOCKET. Then only one thread at a time
+     reads it and infos/done are not used. */
+  GInputStream *socket_stream;
+  GVfsFileInfoDict *dict;
+
   /* For async ops, also protected by infos lock */
   int async_requested_files;
   gulong cancelled_tag;
@@ -59,6 +78,12 @@ struct _GDaemonFileEnumerator
 
   GFileAttributeMatcher *matcher;
   MetaTree *metadata_tree;
+
+  /* For filling the client info cache */
+  gboolean cache_infos;
+  char *attributes;
+  GFileQueryInfoFlags flags;
+  guint cache_generation;
 };
 
 G_DEFINE_TYPE (GDaemonFileEnumerator, g_daemon_file_enumerator, G_TYPE_FILE_ENUMERATOR)
@@ -112,11 +137,21 @@ g_daemon_file_enumerator_finalize (GObject *object)
   free_info_list (daemon->infos);
 
   g_file_attribute_matcher_unref (daemon->matcher);
+  g_free (daemon->attributes);
   if (daemon->metadata_tree)
     meta_tree_unref (daemon->metadata_tree);
 
   if (daemon->sync_connection)
-    dbus_connection_unref (daemon->sync_connection);
+    {
+      _g_dbus_connection_release (daemon->sync_connection);
+      dbus_connection_unref (daemon->sync_connection);
+    }
+  if (daemon->credit_connection)
+    dbus_connection_unref (daemon->credit_connection);
+  if (daemon->socket_stream)
+    g_object_unref (daemon->socket_stream);
+  if (daemon->dict)
+    gvfs_file_info_dict_free (daemon->dict);
   
   if (G_OBJECT_CLASS (g_daemon_file_enumerator_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_daemon_file_enumerator_parent_class)->finalize) (object);
@@ -154,7 +189,8 @@ g_daemon_file_enumerator_init (GDaemonFileEnumerator *daemon)
 
 GDaemonFileEnumerator *
 g_daemon_file_enumerator_new (GFile *file,
-			      const char *attributes)
+			      const char *attributes,
+			      GFileQueryInfoFlags flags)
 {
   GDaemonFileEnumerator *daemon;
   char *treename;
@@ -163,6 +199,13 @@ g_daemon_file_enumerator_new (GFile *file,
                          "container", file,
                          NULL);
 
+  daemon->attributes = g_strdup (attributes);
+  daemon->flags = flags;
+  daemon->cache_infos = _g_daemon_vfs_info_cache_use_listings ();
+  if (daemon->cache_infos)
+    daemon->cache_generation =
+      _g_daemon_vfs_info_cache_get_generation (G_DAEMON_FILE (file)->mount_spec);
+
   daemon->matcher = g_file_attribute_matcher_new (attributes);
   if (g_file_attribute_matcher_enumerate_namespace (daemon->matcher, "metadata") ||
       g_file_attribute_matcher_enumerate_next (daemon->matcher) != NULL)
@@ -196,6 +239,34 @@ enumerate_keys_callback (const char *key,
   return TRUE;
 }
 
+/* Lets later queries of a child reuse its info. Only when asked
+   for, many backends list less than a query_info on the child
+   returns, e.g. ftp parses LIST output, smb share lists have no
+   sizes and content types may be guessed from the name only. */
+static void
+cache_info (GFileInfo *info,
+	    GDaemonFileEnumerator *daemon)
+{
+  GDaemonFile *container;
+  const char *name;
+  char *path;
+
+  if (!daemon->cache_infos)
+    return;
+
+  name = g_file_info_get_name (info);
+  if (name == NULL)
+    return;
+
+  container = G_DAEMON_FILE (g_file_enumerator_get_container (G_FILE_ENUMERATOR (daemon)));
+  path = g_build_filename (container->path, name, NULL);
+  _g_daemon_vfs_info_cache_insert (container->mount_spec,
+				   daemon->cache_generation,
+				   path, daemon->attributes, daemon->flags,
+				   info);
+  g_free (path);
+}
+
 static void
 add_metadata (GFileInfo *info,
 	      GDaemonFileEnumerator *daemon)
@@ -238,6 +309,51 @@ simple_async_result_set_cancellable (GSimpleAsyncResult *res,
                           g_object_unref);
 }
 
+/* Called with infos lock held */
+static void
+send_credit (GDaemonFileEnumerator *daemon,
+	     guint32 credit)
+{
+  DBusMessage *message;
+  char *path;
+
+  if (daemon->credit_connection == NULL || daemon->credit_unlimited)
+    return;
+
+  path = g_daemon_file_enumerator_get_object_path (daemon);
+  message = dbus_message_new_method_call (NULL,
+					  G_VFS_DBUS_DAEMON_PATH,
+					  G_VFS_DBUS_DAEMON_INTERFACE,
+					  G_VFS_DBUS_OP_ENUMERATOR_CREDIT);
+  if (message != NULL)
+    {
+      dbus_message_set_no_reply (message, TRUE);
+      if (dbus_message_append_args (message,
+				    DBUS_TYPE_STRING, &path,
+				    DBUS_TYPE_UINT32, &credit,
+				    DBUS_TYPE_INVALID))
+	dbus_connection_send (daemon->credit_connection, message, NULL);
+      dbus_message_unref (message);
+    }
+  g_free (path);
+
+  if (credit == G_VFS_ENUMERATOR_CREDIT_UNLIMITED)
+    daemon->credit_unlimited = TRUE;
+}
+
+/* Called with infos lock held */
+static void
+consumed_infos (GDaemonFileEnumerator *daemon,
+		guint n_infos)
+{
+  daemon->n_consumed += n_infos;
+  if (daemon->n_consumed >= CREDIT_CHUNK)
+    {
+      send_credit (daemon, daemon->n_consumed);
+      daemon->n_consumed = 0;
+    }
+}
+
 /* Called with infos lock held */
 static void
 trigger_async_done (GDaemonFileEnumerator *daemon, gboolean ok)
@@ -288,7 +404,9 @@ trigger_async_done (GDaemonFileEnumerator *daemon, gboolean ok)
 	}
       daemon->infos = rest;
 
+      g_list_foreach (l, (GFunc)cache_info, daemon);
       g_list_foreach (l, (GFunc)add_metadata, daemon);
+      consumed_infos (daemon, g_list_length (l));
 
       g_simple_async_result_set_op_res_gpointer (daemon->async_res,
 						 l,
@@ -357,6 +475,8 @@ g_daemon_file_enumerator_dbus_filter (DBusConnection     *connection,
       infos = g_list_reverse (infos);
       
       G_LOCK (infos);
+      if (enumerator->credit_connection == NULL)
+	enumerator->credit_connection = dbus_connection_ref (connection);
       enumerator->infos = g_list_concat (enumerator->infos, infos);
       if (enumerator->async_requested_files > 0 &&
 	  g_list_length (enumerator->infos) >= enumerator->async_requested_files)
@@ -374,11 +494,98 @@ g_daemon_file_enumerator_get_object_path (GDaemonFileEnumerator *enumerator)
   return g_strdup_printf (OBJ_PATH_PREFIX"%d", enumerator->id);
 }
 
+/* Takes over the caller's use of the connection, it is released
+   with the enumerator */
 void
 g_daemon_file_enumerator_set_sync_connection (GDaemonFileEnumerator *enumerator,
 					      DBusConnection        *connection)
 {
   enumerator->sync_connection = dbus_connection_ref (connection);
+  g_daemon_file_enumerator_set_async_connection (enumerator, connection);
+}
+
+/* The connection the enumerate call was made on, credits for the
+   daemon are sent there */
+void
+g_daemon_file_enumerator_set_async_connection (GDaemonFileEnumerator *enumerator,
+					       DBusConnection        *connection)
+{
+  G_LOCK (infos);
+  if (enumerator->credit_connection == NULL)
+    enumerator->credit_connection = dbus_connection_ref (connection);
+  G_UNLOCK (infos);
+}
+
+/* The daemon streams the infos over fd instead of sending GotInfo
+   and Done, takes over fd */
+void
+g_daemon_file_enumerator_set_socket (GDaemonFileEnumerator *enumerator,
+				     int                    fd)
+{
+  enumerator->socket_stream = g_unix_input_stream_new (fd, TRUE);
+  enumerator->dict = gvfs_file_info_dict_new ();
+}
+
+/* Reads the next record from the socket. Returns NULL at the end or
+   on errors. Only the empty record ends the enumeration, the daemon
+   closes the socket without it when it gave up on sending. */
+static GFileInfo *
+read_socket_info (GDaemonFileEnumerator *daemon,
+		  GCancellable          *cancellable,
+		  GError               **error)
+{
+  GFileInfo *info;
+  guint32 header;
+  gsize size, bytes_read;
+  char *data;
+
+  if (daemon->done)
+    return NULL;
+
+  if (!g_input_stream_read_all (daemon->socket_stream,
+				&header, sizeof (header), &bytes_read,
+				cancellable, error))
+    return NULL;
+
+  size = g_ntohl (header);
+  if (bytes_read == sizeof (header) && size == 0)
+    {
+      daemon->done = TRUE;
+      return NULL;
+    }
+
+  if (bytes_read != sizeof (header) ||
+      size > MAX_SOCKET_RECORD_SIZE)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		   _("Error in stream protocol: %s"), _("End of stream"));
+      return NULL;
+    }
+
+  data = g_malloc (size);
+  if (!g_input_stream_read_all (daemon->socket_stream,
+				data, size, &bytes_read,
+				cancellable, error))
+    {
+      g_free (data);
+      return NULL;
+    }
+
+  if (bytes_read != size)
+    {
+      g_free (data);
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		   _("Error in stream protocol: %s"), _("End of stream"));
+      return NULL;
+    }
+
+  info = gvfs_file_info_demarshal_with_dict (data, size, daemon->dict);
+  g_free (data);
+
+  cache_info (info, daemon);
+  add_metadata (info, daemon);
+
+  return info;
 }
 
 static GFileInfo *
@@ -390,6 +597,9 @@ g_daemon_file_enumerator_next_file (GFileEnumerator *enumerator,
   GFileInfo *info;
   gboolean done;
   int count;
+
+  if (daemon->socket_stream != NULL)
+    return read_socket_info (daemon, cancellable, error);
   
   info = NULL;
   done = FALSE;
@@ -404,9 +614,11 @@ g_daemon_file_enumerator_next_file (GFileEnumerator *enumerator,
 	  if (info)
 	    {
 	      g_assert (G_IS_FILE_INFO (info));
+	      cache_info (G_FILE_INFO (info), daemon);
 	      add_metadata (G_FILE_INFO (info), daemon);
 	    }
 	  daemon->infos = g_list_delete_link (daemon->infos, daemon->infos);
+	  consumed_infos (daemon, 1);
 	}
       else if (daemon->done)
 	done = TRUE;
@@ -480,6 +692,42 @@ async_timeout (gpointer data)
   return FALSE;
 }
 
+static void
+next_files_socket_thread (GSimpleAsyncResult *res,
+			  GObject            *object,
+			  GCancellable       *cancellable)
+{
+  GDaemonFileEnumerator *daemon = G_DAEMON_FILE_ENUMERATOR (object);
+  GFileInfo *info;
+  GError *error;
+  GList *infos;
+  int num_files;
+
+  num_files = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (res),
+						  "file-enumerator-num-files"));
+  infos = NULL;
+  error = NULL;
+  while (num_files-- > 0)
+    {
+      info = read_socket_info (daemon, cancellable, &error);
+      if (info == NULL)
+	break;
+      infos = g_list_prepend (infos, info);
+    }
+
+  /* Like next_files(), report an error only if nothing was read */
+  if (error != NULL)
+    {
+      if (infos == NULL)
+	g_simple_async_result_set_from_error (res, error);
+      g_error_free (error);
+    }
+
+  g_simple_async_result_set_op_res_gpointer (res,
+					     g_list_reverse (infos),
+					     (GDestroyNotify)free_info_list);
+}
+
 static void
 g_daemon_file_enumerator_next_files_async (GFileEnumerator     *enumerator,
 					   int                  num_files,
@@ -489,6 +737,22 @@ g_daemon_file_enumerator_next_files_async (GFileEnumerator     *enumerator,
 					   gpointer             user_data)
 {
   GDaemonFileEnumerator *daemon = G_DAEMON_FILE_ENUMERATOR (enumerator);
+  GSimpleAsyncResult *res;
+
+  if (daemon->socket_stream != NULL)
+    {
+      /* Reading the socket blocks, so it works however the enumerator
+	 was created */
+      res = g_simple_async_result_new (G_OBJECT (enumerator), callback, user_data,
+				       g_daemon_file_enumerator_next_files_async);
+      simple_async_result_set_cancellable (res, cancellable);
+      g_object_set_data (G_OBJECT (res), "file-enumerator-num-files",
+			 GINT_TO_POINTER (num_files));
+      g_simple_async_result_run_in_thread (res, next_files_socket_thread,
+					   io_priority, cancellable);
+      g_object_unref (res);
+      return;
+    }
 
   if (daemon->sync_connection != NULL)
     {
@@ -555,12 +819,32 @@ g_daemon_file_enumerator_next_files_finish (GFileEnumerator  *enumerator,
   return g_list_copy (l);
 }
 
+/* Lets the daemon send the rest without waiting for us, so it doesn't
+   hold on to them */
+static void
+stop_flow_control (GDaemonFileEnumerator *daemon)
+{
+  /* With the socket the daemon just notices that it is closed */
+  if (daemon->socket_stream != NULL)
+    {
+      g_input_stream_close (daemon->socket_stream, NULL, NULL);
+      return;
+    }
+
+  G_LOCK (infos);
+  if (!daemon->done)
+    send_credit (daemon, G_VFS_ENUMERATOR_CREDIT_UNLIMITED);
+  G_UNLOCK (infos);
+}
+
 static gboolean
 g_daemon_file_enumerator_close (GFileEnumerator *enumerator,
 				GCancellable     *cancellable,
 				GError          **error)
 {
-  /*GDaemonFileEnumerator *daemon = G_DAEMON_FILE_ENUMERATOR (enumerator); */
+  GDaemonFileEnumerator *daemon = G_DAEMON_FILE_ENUMERATOR (enumerator);
+
+  stop_flow_control (daemon);
 
   return TRUE;
 }
@@ -577,6 +861,8 @@ g_daemon_file_enumerator_close_async (GFileEnumerator      *enumerator,
 {
   GSimpleAsyncResult *res;
 
+  stop_flow_control (G_DAEMON_FILE_ENUMERATOR (enumerator));
+
   res = g_simple_async_result_new (G_OBJECT (enumerator), callback, user_data,
 				   g_daemon_file_enumerator_close_async);
   simple_async_result_set_cancellable (res, cancellable);
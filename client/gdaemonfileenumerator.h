@@ -47,10 +47,15 @@ struct _GDaemonFileEnumeratorClass
 GType g_daemon_file_enumerator_get_type (void) G_GNUC_CONST;
 
 GDaemonFileEnumerator *g_daemon_file_enumerator_new                 (GFile *file,
-								     const char *attributes);
+								     const char *attributes,
+								     GFileQueryInfoFlags flags);
 char  *                g_daemon_file_enumerator_get_object_path     (GDaemonFileEnumerator *enumerator);
 void                   g_daemon_file_enumerator_set_sync_connection (GDaemonFileEnumerator *enumerator,
 								     DBusConnection        *connection);
+void                   g_daemon_file_enumerator_set_async_connection (GDaemonFileEnumerator *enumerator,
+								      DBusConnection        *connection);
+void                   g_daemon_file_enumerator_set_socket          (GDaemonFileEnumerator *enumerator,
+								     int                    fd);
 
 
 G_END_DECLS
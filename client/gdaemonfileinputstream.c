@@ -52,6 +52,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -66,6 +67,12 @@
 
 #define MAX_READ_SIZE (4*1024*1024)
 
+/* While the stream is read sequentially, up to this many READ requests
+   are kept in flight ahead of the reader, asking for at most this many
+   bytes together. The replies wait in the socket until read. */
+#define READ_AHEAD_MAX_REQUESTS 4
+#define READ_AHEAD_MAX_BYTES (1024*1024)
+
 typedef enum {
   INPUT_STATE_IN_REPLY_HEADER,
   INPUT_STATE_IN_BLOCK
@@ -99,6 +106,14 @@ typedef struct {
   GError *ret_error;
   
   gboolean sent_cancel;
+  /* Positioning for a deferred seek */
+  gboolean seeking;
+  gboolean sent_seek;
+  gboolean pread;
+  /* Reads sent to keep the read-ahead window filled */
+  gboolean topped_up;
+  guint32 first_ahead_seq_nr;
+  guint n_ahead;
   
   guint32 seq_nr;
 } ReadOperation;
@@ -210,12 +225,33 @@ struct _GDaemonFileInputStream {
   guint32 seq_nr;
   goffset current_offset;
 
+  /* Seeks are sent with the next read, see
+     G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_PREAD */
+  gboolean has_pending_seek;
+  gboolean pread_not_supported;
+
   GList *pre_reads;
+
+  /* Seq nrs of the READ requests of this seek generation whose
+     reply hasn't come yet, oldest first. Each gets one DATA or
+     ERROR reply, in order. */
+  GQueue reads_in_flight;
+  guint sequential_reads;
+
+  /* A read failed with later reads in flight and we can't seek back
+     over the hole, all further reads fail with this */
+  GError *read_error;
   
   InputState input_state;
   gsize input_block_size;
   int input_block_seek_generation;
+  gboolean input_block_in_shm;
   GString *input_buffer;
+
+  /* Shared memory data ring, see G_VFS_DAEMON_OPEN_FLAG_SHM */
+  char *shm;
+  gsize shm_ring_size;
+  guint32 shm_read_pos;
   
   GString *output_buffer;
 };
@@ -322,9 +358,15 @@ g_daemon_file_input_stream_finalize (GObject *object)
 					    file->pre_reads);
       pre_read_free (pre);
     }
+  g_queue_clear (&file->reads_in_flight);
+  if (file->read_error)
+    g_error_free (file->read_error);
   
   g_string_free (file->input_buffer, TRUE);
   g_string_free (file->output_buffer, TRUE);
+
+  if (file->shm)
+    munmap (file->shm, G_VFS_DAEMON_SHM_HEADER_SIZE + file->shm_ring_size);
   
   if (G_OBJECT_CLASS (g_daemon_file_input_stream_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_daemon_file_input_stream_parent_class)->finalize) (object);
@@ -368,6 +410,7 @@ g_daemon_file_input_stream_init (GDaemonFileInputStream *info)
   info->output_buffer = g_string_new ("");
   info->input_buffer = g_string_new ("");
   info->seq_nr = 1;
+  g_queue_init (&info->reads_in_flight);
 }
 
 GFileInputStream *
@@ -385,6 +428,107 @@ g_daemon_file_input_stream_new (int fd,
   return G_FILE_INPUT_STREAM (stream);
 }
 
+/* Maps the shared memory ring the daemon offered at open time,
+   takes ownership of shm_fd. On failure the stream keeps working,
+   the daemon sends all data over the socket then. */
+gboolean
+g_daemon_file_input_stream_set_shared_memory (GFileInputStream *stream,
+					      int shm_fd,
+					      gsize ring_size,
+					      GError **error)
+{
+  GDaemonFileInputStream *file;
+  void *shm;
+  int errsv;
+
+  file = G_DAEMON_FILE_INPUT_STREAM (stream);
+
+  shm = mmap (NULL, G_VFS_DAEMON_SHM_HEADER_SIZE + ring_size,
+	      PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+  errsv = errno;
+  close (shm_fd);
+  
+  if (shm == MAP_FAILED)
+    {
+      g_set_error (error, G_IO_ERROR,
+		   g_io_error_from_errno (errsv),
+		   _("Error in stream protocol: %s"), g_strerror (errsv));
+      return FALSE;
+    }
+
+  file->shm = shm;
+  file->shm_ring_size = ring_size;
+  file->shm_read_pos = 0;
+
+  /* Only now the daemon starts using the ring */
+  g_atomic_int_set ((gint *)&((GVfsDaemonShmHeader *)shm)->mapped, 1);
+  
+  return TRUE;
+}
+
+/* Copies (or with a NULL buffer, skips) data of a shm data block
+   out of the ring and tells the daemon the space is free again */
+static void
+shm_read (GDaemonFileInputStream *file,
+	  char *buffer,
+	  gsize count)
+{
+  GVfsDaemonShmHeader *header;
+  char *ring;
+  guint32 pos;
+  gsize first;
+
+  header = (GVfsDaemonShmHeader *)file->shm;
+  ring = file->shm + G_VFS_DAEMON_SHM_HEADER_SIZE;
+
+  if (buffer)
+    {
+      pos = file->shm_read_pos % file->shm_ring_size;
+      first = MIN (count, file->shm_ring_size - pos);
+      memcpy (buffer, ring + pos, first);
+      memcpy (buffer + first, ring, count - first);
+    }
+  
+  file->shm_read_pos += count;
+  g_atomic_int_set ((gint *)&header->read_pos, file->shm_read_pos);
+}
+
+/* If the current block is in shared memory, do the read or skip the
+   state machine asked for right away instead of socket i/o */
+static gboolean
+shm_block_io (GDaemonFileInputStream *file,
+	      IOOperationData *io_op)
+{
+  if (!file->input_block_in_shm)
+    return FALSE;
+
+  shm_read (file, io_op->io_buffer, io_op->io_size);
+  io_op->io_res = io_op->io_size;
+  io_op->io_cancelled = FALSE;
+  
+  return TRUE;
+}
+
+/* Returns TRUE if the reply starts a data block */
+static gboolean
+start_input_block (GDaemonFileInputStream *file,
+		   GVfsDaemonSocketProtocolReply *reply)
+{
+  if (reply->type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA &&
+      (reply->type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SHM_DATA ||
+       file->shm == NULL))
+    return FALSE;
+  
+  g_string_truncate (file->input_buffer, 0);
+  file->input_state = INPUT_STATE_IN_BLOCK;
+  file->input_block_size = reply->arg1;
+  file->input_block_seek_generation = reply->arg2;
+  file->input_block_in_shm =
+    reply->type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SHM_DATA;
+  
+  return TRUE;
+}
+
 static gboolean
 error_is_cancel (GError *error)
 {
@@ -439,16 +583,60 @@ get_reply_header_missing_bytes (GString *buffer)
 }
 
 static char *
-decode_reply (GString *buffer, GVfsDaemonSocketProtocolReply *reply_out)
+decode_reply (GDaemonFileInputStream *file, GVfsDaemonSocketProtocolReply *reply_out)
 {
   GVfsDaemonSocketProtocolReply *reply;
-  reply = (GVfsDaemonSocketProtocolReply *)buffer->str;
+  reply = (GVfsDaemonSocketProtocolReply *)file->input_buffer->str;
   reply_out->type = g_ntohl (reply->type);
   reply_out->seq_nr = g_ntohl (reply->seq_nr);
   reply_out->arg1 = g_ntohl (reply->arg1);
   reply_out->arg2 = g_ntohl (reply->arg2);
+
+  /* Replies come in request order, so one for a read in
+     flight is always for the oldest */
+  if ((reply_out->type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA ||
+       reply_out->type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SHM_DATA ||
+       reply_out->type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_ERROR) &&
+      !g_queue_is_empty (&file->reads_in_flight) &&
+      GPOINTER_TO_UINT (g_queue_peek_head (&file->reads_in_flight)) == reply_out->seq_nr)
+    g_queue_pop_head (&file->reads_in_flight);
   
-  return buffer->str + G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SIZE;
+  return file->input_buffer->str + G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SIZE;
+}
+
+/* The position changed, reads in flight are for data we skip now */
+static void
+forget_reads_in_flight (GDaemonFileInputStream *file)
+{
+  g_queue_clear (&file->reads_in_flight);
+  file->sequential_reads = 0;
+}
+
+/* Appends READ requests until the window for the current run of
+   sequential reads is full, but at least min_reads while nothing is
+   in flight. Returns TRUE if it appended any. */
+static gboolean
+append_read_ahead (GDaemonFileInputStream *file,
+		   ReadOperation *op,
+		   guint min_reads)
+{
+  guint window, i;
+
+  window = MIN (file->sequential_reads, READ_AHEAD_MAX_REQUESTS);
+  window = MIN (window, READ_AHEAD_MAX_BYTES / op->buffer_size);
+  window = MAX (window, min_reads);
+  file->sequential_reads++;
+
+  op->n_ahead = 0;
+  for (i = g_queue_get_length (&file->reads_in_flight); i < window; i++)
+    {
+      append_request (file, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_READ,
+		      op->buffer_size, 0, 0,
+		      op->n_ahead == 0 ? &op->first_ahead_seq_nr : NULL);
+      op->n_ahead++;
+    }
+
+  return op->n_ahead > 0;
 }
 
 static void
@@ -460,6 +648,19 @@ decode_error (GVfsDaemonSocketProtocolReply *reply, char *data, GError **error)
         	       data + strlen (data) + 1);
 }
 
+/* Backends without read_at refuse PREAD with NOT_SUPPORTED, daemons
+   that predate it answer with the error for unknown commands */
+static gboolean
+pread_refused (GError *error)
+{
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+    return TRUE;
+
+  return
+    g_error_matches (error, G_IO_ERROR, G_IO_ERROR_FAILED) &&
+    g_str_has_prefix (error->message, "Unknown stream command");
+}
+
 
 static gboolean
 run_sync_state_machine (GDaemonFileInputStream *file,
@@ -566,6 +767,44 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	  /* Initial state for read op */
 	case READ_STATE_INIT:
 
+	  /* Position and read with one request if the daemon can,
+	     otherwise seek first */
+	  if (file->has_pending_seek)
+	    {
+	      op->seeking = TRUE;
+	      op->sent_seek = FALSE;
+	      op->pread = !file->pread_not_supported;
+	      if (op->pread)
+		{
+		  guint32 size = g_htonl (op->buffer_size);
+
+		  append_request (file, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_PREAD,
+				  file->current_offset & 0xffffffff,
+				  file->current_offset >> 32,
+				  sizeof (size), &op->seq_nr);
+		  g_string_append_len (file->output_buffer,
+				       (char *)&size, sizeof (size));
+		}
+	      else
+		append_request (file, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SEEK_SET,
+				file->current_offset & 0xffffffff,
+				file->current_offset >> 32,
+				0, &op->seq_nr);
+	      op->state = READ_STATE_WROTE_COMMAND;
+	      io_op->io_buffer = file->output_buffer->str;
+	      io_op->io_size = file->output_buffer->len;
+	      io_op->io_allow_cancel = TRUE; /* Allow cancel before first byte of request sent */
+	      return STATE_OP_WRITE;
+	    }
+
+	  /* Anything that arrives after the failed read is past the hole */
+	  if (file->read_error)
+	    {
+	      op->ret_val = -1;
+	      op->ret_error = g_error_copy (file->read_error);
+	      return STATE_OP_DONE;
+	    }
+
 	  while (file->pre_reads)
 	    {
 	      pre = file->pre_reads->data;
@@ -597,7 +836,29 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 		  return STATE_OP_DONE;
 		}
 	    }
-	  
+
+	  /* Keep the daemon busy with the next reads while we consume
+	     this one. Unless data is coming already we need at least
+	     one read. */
+	  if (!op->topped_up)
+	    {
+	      gboolean have_data;
+
+	      have_data =
+		!g_queue_is_empty (&file->reads_in_flight) ||
+		(file->input_state == INPUT_STATE_IN_BLOCK &&
+		 file->seek_generation == file->input_block_seek_generation);
+
+	      op->topped_up = TRUE;
+	      if (append_read_ahead (file, op, have_data ? 0 : 1))
+		{
+		  op->state = READ_STATE_WROTE_COMMAND;
+		  io_op->io_buffer = file->output_buffer->str;
+		  io_op->io_size = file->output_buffer->len;
+		  io_op->io_allow_cancel = TRUE; /* Allow cancel before first byte of request sent */
+		  return STATE_OP_WRITE;
+		}
+	    }
 	  
 	  /* If we're already reading some data, but we didn't read all, just use that
 	     and don't even send a request */
@@ -608,21 +869,25 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	      io_op->io_buffer = op->buffer;
 	      io_op->io_size = MIN (op->buffer_size, file->input_block_size);
 	      io_op->io_allow_cancel = TRUE; /* Allow cancel before we sent request */
+	      if (shm_block_io (file, io_op))
+	        continue; /* Already done, go to the next state */
 	      return STATE_OP_READ;
 	    }
 
-	  append_request (file, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_READ,
-			  op->buffer_size, 0, 0, &op->seq_nr);
-	  op->state = READ_STATE_WROTE_COMMAND;
-	  io_op->io_buffer = file->output_buffer->str;
-	  io_op->io_size = file->output_buffer->len;
-	  io_op->io_allow_cancel = TRUE; /* Allow cancel before first byte of request sent */
-	  return STATE_OP_WRITE;
+	  /* Wait for the oldest read in flight, that is also
+	     what a cancel or an error is about */
+	  op->seq_nr = GPOINTER_TO_UINT (g_queue_peek_head (&file->reads_in_flight));
+	  op->state = READ_STATE_HANDLE_INPUT;
+	  break;
 
 	  /* wrote parts of output_buffer */
 	case READ_STATE_WROTE_COMMAND:
 	  if (io_op->io_cancelled)
 	    {
+	      /* A positioning request sent later would confuse
+		 the seek generations, the next read sends it again */
+	      if ((op->seeking && !op->sent_seek) || op->n_ahead > 0)
+		g_string_truncate (file->output_buffer, 0);
 	      op->ret_val = -1;
 	      g_set_error_literal (&op->ret_error,
 				   G_IO_ERROR,
@@ -630,6 +895,24 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 				   _("Operation was cancelled"));
 	      return STATE_OP_DONE;
 	    }
+
+	  /* Like for a seek, the request is going out so
+	     anything read before is stale now */
+	  if (op->seeking && !op->sent_seek)
+	    {
+	      file->seek_generation++;
+	      file->has_pending_seek = FALSE;
+	      op->sent_seek = TRUE;
+	      forget_reads_in_flight (file);
+
+	      while (file->pre_reads)
+		{
+		  PreRead *pre = file->pre_reads->data;
+		  file->pre_reads = g_list_delete_link (file->pre_reads,
+							file->pre_reads);
+		  pre_read_free (pre);
+		}
+	    }
 	  
 	  if (io_op->io_res < file->output_buffer->len)
 	    {
@@ -642,6 +925,18 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	    }
 	  g_string_truncate (file->output_buffer, 0);
 
+	  if (op->n_ahead > 0)
+	    {
+	      guint i;
+
+	      for (i = 0; i < op->n_ahead; i++)
+		g_queue_push_tail (&file->reads_in_flight,
+				   GUINT_TO_POINTER (op->first_ahead_seq_nr + i));
+	      op->n_ahead = 0;
+	      op->state = READ_STATE_INIT;
+	      break;
+	    }
+
 	  op->state = READ_STATE_HANDLE_INPUT;
 	  break;
 
@@ -683,6 +978,8 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	      io_op->io_buffer = op->buffer;
 	      io_op->io_size = MIN (op->buffer_size, file->input_block_size);
 	      io_op->io_allow_cancel = FALSE;
+	      if (shm_block_io (file, io_op))
+	        continue; /* Already done, go to the next state */
 	      return STATE_OP_READ;
 	    }
 	  else
@@ -691,6 +988,8 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	      io_op->io_buffer = NULL;
 	      io_op->io_size = file->input_block_size;
 	      io_op->io_allow_cancel = !op->sent_cancel;
+	      if (shm_block_io (file, io_op))
+	        continue; /* Already done, go to the next state */
 	      return STATE_OP_SKIP;
 	    }
 	  break;
@@ -744,7 +1043,7 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	  {
 	    GVfsDaemonSocketProtocolReply reply;
 	    char *data;
-	    data = decode_reply (file->input_buffer, &reply);
+	    data = decode_reply (file, &reply);
 
 	    if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_ERROR &&
 		reply.seq_nr == op->seq_nr)
@@ -752,17 +1051,50 @@ iterate_read_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 		op->ret_val = -1;
 		decode_error (&reply, data, &op->ret_error);
 		g_string_truncate (file->input_buffer, 0);
+
+		if (op->seeking)
+		  {
+		    if (op->pread && pread_refused (op->ret_error))
+		      {
+			/* The daemon refused it without touching its
+			   seek generation, seek separately from now on */
+			g_clear_error (&op->ret_error);
+			file->pread_not_supported = TRUE;
+			file->seek_generation--;
+			file->has_pending_seek = TRUE;
+			op->sent_cancel = FALSE;
+			op->state = READ_STATE_INIT;
+			break;
+		      }
+
+		    /* Position again on the next read */
+		    file->has_pending_seek = TRUE;
+		  }
+		else if (!g_queue_is_empty (&file->reads_in_flight))
+		  {
+		    /* Data of the later reads would leave a hole */
+		    if (file->can_seek)
+		      file->has_pending_seek = TRUE;
+		    else if (file->read_error == NULL)
+		      file->read_error = g_error_copy (op->ret_error);
+		  }
 		return STATE_OP_DONE;
 	      }
-	    else if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA)
+	    else if (start_input_block (file, &reply))
 	      {
-		g_string_truncate (file->input_buffer, 0);
-		file->input_state = INPUT_STATE_IN_BLOCK;
-		file->input_block_size = reply.arg1;
-		file->input_block_seek_generation = reply.arg2;
 		op->state = READ_STATE_HANDLE_INPUT_BLOCK;
 		break;
 	      }
+	    else if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SEEK_POS &&
+		     reply.seq_nr == op->seq_nr && op->seeking)
+	      {
+		/* Positioned, now do the actual read */
+		op->seeking = FALSE;
+		file->current_offset = ((goffset)reply.arg2) << 32 | (goffset)reply.arg1;
+		g_string_truncate (file->input_buffer, 0);
+		op->state = READ_STATE_INIT;
+		break;
+	      }
 	    /* Ignore other reply types */
 	  }
 
@@ -951,6 +1283,8 @@ iterate_close_state_machine (GDaemonFileInputStream *file, IOOperationData *io_o
 	  io_op->io_buffer = NULL;
 	  io_op->io_size = file->input_block_size;
 	  io_op->io_allow_cancel = !op->sent_cancel;
+	  if (shm_block_io (file, io_op))
+	    continue; /* Already done, go to the next state */
 	  return STATE_OP_SKIP;
 
 	  /* Read block data */
@@ -1002,7 +1336,7 @@ iterate_close_state_machine (GDaemonFileInputStream *file, IOOperationData *io_o
 	  {
 	    GVfsDaemonSocketProtocolReply reply;
 	    char *data;
-	    data = decode_reply (file->input_buffer, &reply);
+	    data = decode_reply (file, &reply);
 
 	    if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_ERROR &&
 		reply.seq_nr == op->seq_nr)
@@ -1012,12 +1346,8 @@ iterate_close_state_machine (GDaemonFileInputStream *file, IOOperationData *io_o
 		g_string_truncate (file->input_buffer, 0);
 		return STATE_OP_DONE;
 	      }
-	    else if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA)
+	    else if (start_input_block (file, &reply))
 	      {
-		g_string_truncate (file->input_buffer, 0);
-		file->input_state = INPUT_STATE_IN_BLOCK;
-		file->input_block_size = reply.arg1;
-		file->input_block_seek_generation = reply.arg2;
 		op->state = CLOSE_STATE_HANDLE_INPUT_BLOCK;
 		break;
 	      }
@@ -1153,7 +1483,10 @@ iterate_seek_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	  /* We weren't cancelled before first byte sent, so now we will send
 	   * the seek request. Increase the seek generation now. */
 	  if (!op->sent_seek)
-	    file->seek_generation++;
+	    {
+	      file->seek_generation++;
+	      forget_reads_in_flight (file);
+	    }
 	  op->sent_seek = TRUE;
 	  
 	  /* Clear any pre-read data blocks */
@@ -1215,6 +1548,8 @@ iterate_seek_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	  io_op->io_buffer = NULL;
 	  io_op->io_size = file->input_block_size;
 	  io_op->io_allow_cancel = !op->sent_cancel;
+	  if (shm_block_io (file, io_op))
+	    continue; /* Already done, go to the next state */
 	  return STATE_OP_SKIP;
 
 	  /* Read block data */
@@ -1266,7 +1601,7 @@ iterate_seek_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 	  {
 	    GVfsDaemonSocketProtocolReply reply;
 	    char *data;
-	    data = decode_reply (file->input_buffer, &reply);
+	    data = decode_reply (file, &reply);
 
 	    if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_ERROR &&
 		reply.seq_nr == op->seq_nr)
@@ -1276,12 +1611,8 @@ iterate_seek_state_machine (GDaemonFileInputStream *file, IOOperationData *io_op
 		g_string_truncate (file->input_buffer, 0);
 		return STATE_OP_DONE;
 	      }
-	    else if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA)
+	    else if (start_input_block (file, &reply))
 	      {
-		g_string_truncate (file->input_buffer, 0);
-		file->input_state = INPUT_STATE_IN_BLOCK;
-		file->input_block_size = reply.arg1;
-		file->input_block_seek_generation = reply.arg2;
 		op->state = SEEK_STATE_HANDLE_INPUT_BLOCK;
 		break;
 	      }
@@ -1333,6 +1664,28 @@ g_daemon_file_input_stream_seek (GFileInputStream *stream,
   
   if (g_cancellable_set_error_if_cancelled (cancellable, error))
     return FALSE;
+
+  /* Defer the seek to the next read, which then positions and reads
+     with a single request. Like lseek() this succeeds for offsets
+     the backend would reject, the next read reports that. */
+  if (type != G_SEEK_END && !file->pread_not_supported)
+    {
+      if (type == G_SEEK_CUR)
+	offset += file->current_offset;
+
+      if (offset < 0)
+	{
+	  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+			       _("Invalid seek offset"));
+	  return FALSE;
+	}
+
+      file->has_pending_seek = TRUE;
+      file->current_offset = offset;
+      return TRUE;
+    }
+  
+  file->has_pending_seek = FALSE;
   
   memset (&op, 0, sizeof (op));
   op.state = SEEK_STATE_INIT;
@@ -1451,6 +1804,8 @@ iterate_query_state_machine (GDaemonFileInputStream *file,
 	      io_op->io_buffer = g_malloc (file->input_block_size); 
 	      io_op->io_size = file->input_block_size;
 	      io_op->io_allow_cancel = FALSE;
+	      if (shm_block_io (file, io_op))
+	        continue; /* Already done, go to the next state */
 	      return STATE_OP_READ;
 	    }
 	  else
@@ -1459,6 +1814,8 @@ iterate_query_state_machine (GDaemonFileInputStream *file,
 	      io_op->io_buffer = NULL;
 	      io_op->io_size = file->input_block_size;
 	      io_op->io_allow_cancel = !op->sent_cancel;
+	      if (shm_block_io (file, io_op))
+	        continue; /* Already done, go to the next state */
 	      return STATE_OP_SKIP;
 	    }
 	  break;
@@ -1543,7 +1900,7 @@ iterate_query_state_machine (GDaemonFileInputStream *file,
 	  {
 	    GVfsDaemonSocketProtocolReply reply;
 	    char *data;
-	    data = decode_reply (file->input_buffer, &reply);
+	    data = decode_reply (file, &reply);
 
 	    if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_ERROR &&
 		reply.seq_nr == op->seq_nr)
@@ -1553,12 +1910,8 @@ iterate_query_state_machine (GDaemonFileInputStream *file,
 		g_string_truncate (file->input_buffer, 0);
 		return STATE_OP_DONE;
 	      }
-	    else if (reply.type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA)
+	    else if (start_input_block (file, &reply))
 	      {
-		g_string_truncate (file->input_buffer, 0);
-		file->input_state = INPUT_STATE_IN_BLOCK;
-		file->input_block_size = reply.arg1;
-		file->input_block_seek_generation = reply.arg2;
 		op->state = QUERY_STATE_HANDLE_INPUT_BLOCK;
 		break;
 	      }
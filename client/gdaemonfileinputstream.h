@@ -46,6 +46,10 @@ GType g_daemon_file_input_stream_get_type (void) G_GNUC_CONST;
 
 GFileInputStream *g_daemon_file_input_stream_new (int fd,
 						  gboolean can_seek);
+gboolean          g_daemon_file_input_stream_set_shared_memory (GFileInputStream  *stream,
+								int                shm_fd,
+								gsize              ring_size,
+								GError           **error);
 
 G_END_DECLS
 
@@ -158,6 +158,7 @@ g_daemon_file_monitor_dbus_filter (DBusConnection     *connection,
 	  return DBUS_HANDLER_RESULT_HANDLED;
 	}
 
+      _g_daemon_vfs_info_cache_invalidate (spec1, path1);
       file1 = g_daemon_file_new (spec1, path1);
       
       g_mount_spec_unref (spec1);
@@ -171,6 +172,7 @@ g_daemon_file_monitor_dbus_filter (DBusConnection     *connection,
 					   G_DBUS_TYPE_CSTRING, &path2,
 					   0))
 	  {
+	    _g_daemon_vfs_info_cache_invalidate (spec2, path2);
 	    file2 = g_daemon_file_new (spec2, path2);
 
 	    g_free (path2);
@@ -38,6 +38,7 @@
 #include <gio/gunixinputstream.h>
 #include <gio/gunixoutputstream.h>
 #include "gdaemonfileoutputstream.h"
+#include "gdaemonfile.h"
 #include "gvfsdaemondbus.h"
 #include <gvfsdaemonprotocol.h>
 #include <gvfsfileinfo.h>
@@ -168,7 +169,10 @@ struct _GDaemonFileOutputStream {
   GString *output_buffer;
 
   char *etag;
-  
+
+  /* The written file, its cached info is stale after close */
+  GMountSpec *mount_spec;
+  char *path;
 };
 
 static gssize     g_daemon_file_output_stream_write             (GOutputStream        *stream,
@@ -251,6 +255,8 @@ g_daemon_file_output_stream_finalize (GObject *object)
   g_string_free (file->output_buffer, TRUE);
 
   g_free (file->etag);
+  g_mount_spec_unref (file->mount_spec);
+  g_free (file->path);
   
   if (G_OBJECT_CLASS (g_daemon_file_output_stream_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_daemon_file_output_stream_parent_class)->finalize) (object);
@@ -291,7 +297,8 @@ g_daemon_file_output_stream_init (GDaemonFileOutputStream *info)
 }
 
 GFileOutputStream *
-g_daemon_file_output_stream_new (int fd,
+g_daemon_file_output_stream_new (GFile *file,
+				 int fd,
 				 gboolean can_seek,
 				 goffset initial_offset)
 {
@@ -299,6 +306,9 @@ g_daemon_file_output_stream_new (int fd,
 
   stream = g_object_new (G_TYPE_DAEMON_FILE_OUTPUT_STREAM, NULL);
 
+  stream->mount_spec = g_mount_spec_ref (G_DAEMON_FILE (file)->mount_spec);
+  stream->path = g_strdup (G_DAEMON_FILE (file)->path);
+
   stream->command_stream = g_unix_output_stream_new (fd, FALSE);
   stream->data_stream = g_unix_input_stream_new (fd, TRUE);
   stream->can_seek = can_seek;
@@ -800,6 +810,8 @@ g_daemon_file_output_stream_close (GOutputStream *stream,
       res = op.ret_val;
     }
 
+  _g_daemon_vfs_info_cache_invalidate (file->mount_spec, file->path);
+
   /* Return the first error, but close all streams */
   if (res)
     res = g_output_stream_close (file->command_stream, cancellable, error);
@@ -1498,6 +1510,8 @@ async_close_done (GOutputStream *stream,
       error = op->ret_error;
     }
 
+  _g_daemon_vfs_info_cache_invalidate (file->mount_spec, file->path);
+
   if (result)
     result = g_output_stream_close (file->command_stream, cancellable, &error);
   else
@@ -44,7 +44,8 @@ struct _GDaemonFileOutputStreamClass
 
 GType g_daemon_file_output_stream_get_type (void) G_GNUC_CONST;
 
-GFileOutputStream *g_daemon_file_output_stream_new (int fd,
+GFileOutputStream *g_daemon_file_output_stream_new (GFile *file,
+						    int fd,
 						    gboolean can_seek,
 						    goffset initial_offset);
 
@@ -39,6 +39,8 @@
 #include "gdaemonvolumemonitor.h"
 #include "gvfsicon.h"
 #include "gvfsiconloadable.h"
+#include "gvfsinfocache.h"
+#include "gvfsclientops.h"
 #include <glib/gi18n-lib.h>
 #include <glib/gstdio.h>
 
@@ -50,6 +52,13 @@ typedef struct  {
   gboolean host_is_inet;
 } MountableInfo; 
 
+/* Read-only view of the mount cache, so that lookups don't scan
+   the list. It is rebuilt and swapped when the cache changes. */
+typedef struct {
+  GHashTable *by_spec;            /* items only -> GList of GMountInfo, longest prefix first */
+  GHashTable *by_fuse_mountpoint; /* fuse mountpoint -> GMountInfo */
+} MountIndex;
+
 struct _GDaemonVfs
 {
   GVfs parent;
@@ -57,7 +66,8 @@ struct _GDaemonVfs
   DBusConnection *async_bus;
   
   GVfs *wrapped_vfs;
-  GList *mount_cache;
+  GList *mount_cache; /* protected by mount_cache lock */
+  MountIndex *mount_index; /* protected by mount_index_lock */
 
   GFile *fuse_root;
   
@@ -66,6 +76,11 @@ struct _GDaemonVfs
 
   MountableInfo **mountable_info;
   char **supported_uri_schemes;
+
+  /* GMountSpec -> GVfsInfoCache, protected by info_caches lock */
+  GHashTable *info_caches;
+  guint info_cache_ttl_msecs;
+  gboolean info_cache_listings;
 };
 
 struct _GDaemonVfsClass
@@ -78,9 +93,20 @@ G_DEFINE_DYNAMIC_TYPE (GDaemonVfs, g_daemon_vfs, G_TYPE_VFS)
 static GDaemonVfs *the_vfs = NULL;
 
 G_LOCK_DEFINE_STATIC(mount_cache);
+/* Lookups take it for reading, so they only wait for the swap of
+   the index and never for each other */
+static GRWLock mount_index_lock;
+G_LOCK_DEFINE_STATIC(info_caches);
+
+/* The client side info cache is off unless GVFS_CLIENT_INFO_CACHE_TTL
+   is set, as other processes changing a file are only seen through
+   file monitors. Listings only fill it with GVFS_CLIENT_INFO_CACHE_LISTINGS
+   also set, as backends may list less than a query_info returns. */
+#define INFO_CACHE_MAX_BYTES (1024*1024)
 
 
 static void fill_mountable_info (GDaemonVfs *vfs);
+static void mount_index_free (MountIndex *index);
 
 static void
 g_daemon_vfs_finalize (GObject *object)
@@ -97,6 +123,11 @@ g_daemon_vfs_finalize (GObject *object)
 
   g_strfreev (vfs->supported_uri_schemes);
 
+  if (vfs->info_caches)
+    g_hash_table_destroy (vfs->info_caches);
+
+  mount_index_free (vfs->mount_index);
+
   if (vfs->async_bus)
     {
       dbus_connection_close (vfs->async_bus);
@@ -293,6 +324,7 @@ g_daemon_vfs_init (GDaemonVfs *vfs)
   const char * const *schemes, * const *mount_types;
   GVfsUriMapper *mapper;
   GList *modules;
+  const char *env;
   char *file;
   int i;
 
@@ -322,6 +354,15 @@ g_daemon_vfs_init (GDaemonVfs *vfs)
   signal (SIGPIPE, SIG_IGN);
 
   fill_mountable_info (vfs);
+
+  env = g_getenv ("GVFS_CLIENT_INFO_CACHE_TTL");
+  if (env != NULL)
+    vfs->info_cache_ttl_msecs = strtoul (env, NULL, 10);
+  vfs->info_cache_listings = g_getenv ("GVFS_CLIENT_INFO_CACHE_LISTINGS") != NULL;
+  vfs->info_caches = g_hash_table_new_full ((GHashFunc)g_mount_spec_hash,
+					    (GEqualFunc)g_mount_spec_equal,
+					    (GDestroyNotify)g_mount_spec_unref,
+					    (GDestroyNotify)g_vfs_info_cache_free);
   
   vfs->wrapped_vfs = g_vfs_get_local ();
 
@@ -714,26 +755,87 @@ g_daemon_vfs_get_supported_uri_schemes (GVfs *vfs)
   return (const gchar * const *) G_DAEMON_VFS (vfs)->supported_uri_schemes;
 }
 
-static GMountInfo *
-lookup_mount_info_in_cache_locked (GMountSpec *spec,
-				   const char *path)
+static gint
+compare_prefix_length (gconstpointer a,
+		       gconstpointer b)
+{
+  const GMountInfo *info_a = a, *info_b = b;
+  const char *prefix_a = info_a->mount_spec->mount_prefix;
+  const char *prefix_b = info_b->mount_spec->mount_prefix;
+
+  return (prefix_b ? strlen (prefix_b) : 0) - (prefix_a ? strlen (prefix_a) : 0);
+}
+
+static void
+free_mount_info_list (GList *infos)
+{
+  g_list_free_full (infos, (GDestroyNotify)g_mount_info_unref);
+}
+
+static MountIndex *
+mount_index_new (GList *mount_cache)
 {
+  MountIndex *index;
   GMountInfo *info;
-  GList *l;
+  GList *l, *infos;
 
-  info = NULL;
-  for (l = the_vfs->mount_cache; l != NULL; l = l->next)
-    {
-      GMountInfo *mount_info = l->data;
+  index = g_new0 (MountIndex, 1);
+  index->by_spec = g_hash_table_new_full (g_mount_spec_hash_items,
+					  (GEqualFunc)g_mount_spec_equal_items,
+					  NULL, (GDestroyNotify)free_mount_info_list);
+  index->by_fuse_mountpoint = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     NULL, (GDestroyNotify)g_mount_info_unref);
 
-      if (g_mount_spec_match_with_path (mount_info->mount_spec, spec, path))
-	{
-	  info = g_mount_info_ref (mount_info);
-	  break;
-	}
+  for (l = mount_cache; l != NULL; l = l->next)
+    {
+      info = l->data;
+
+      /* The list keys the table, so it must be stolen before it
+	 is changed */
+      infos = NULL;
+      g_hash_table_lookup_extended (index->by_spec, info->mount_spec,
+				    NULL, (gpointer *)&infos);
+      g_hash_table_steal (index->by_spec, info->mount_spec);
+      infos = g_list_insert_sorted (infos, g_mount_info_ref (info),
+				    compare_prefix_length);
+      g_hash_table_insert (index->by_spec,
+			   ((GMountInfo *)infos->data)->mount_spec, infos);
+
+      if (info->fuse_mountpoint != NULL &&
+	  !g_hash_table_lookup (index->by_fuse_mountpoint, info->fuse_mountpoint))
+	g_hash_table_insert (index->by_fuse_mountpoint,
+			     info->fuse_mountpoint, g_mount_info_ref (info));
     }
-  
-  return info;
+
+  return index;
+}
+
+static void
+mount_index_free (MountIndex *index)
+{
+  if (index == NULL)
+    return;
+
+  g_hash_table_destroy (index->by_spec);
+  g_hash_table_destroy (index->by_fuse_mountpoint);
+  g_free (index);
+}
+
+/* Called with the mount_cache lock held, after mount_cache changed */
+static void
+update_mount_index_locked (void)
+{
+  MountIndex *index, *old;
+
+  index = mount_index_new (the_vfs->mount_cache);
+
+  g_rw_lock_writer_lock (&mount_index_lock);
+  old = the_vfs->mount_index;
+  the_vfs->mount_index = index;
+  g_rw_lock_writer_unlock (&mount_index_lock);
+
+  /* No reader can see the old index anymore */
+  mount_index_free (old);
 }
 
 static GMountInfo *
@@ -741,10 +843,27 @@ lookup_mount_info_in_cache (GMountSpec *spec,
 			   const char *path)
 {
   GMountInfo *info;
+  GList *l;
 
-  G_LOCK (mount_cache);
-  info = lookup_mount_info_in_cache_locked (spec, path);
-  G_UNLOCK (mount_cache);
+  info = NULL;
+
+  g_rw_lock_reader_lock (&mount_index_lock);
+  if (the_vfs->mount_index != NULL)
+    {
+      /* Sorted by prefix length, so the deepest mount wins */
+      l = g_hash_table_lookup (the_vfs->mount_index->by_spec, spec);
+      for (; l != NULL; l = l->next)
+	{
+	  GMountInfo *mount_info = l->data;
+
+	  if (g_mount_spec_match_with_path (mount_info->mount_spec, spec, path))
+	    {
+	      info = g_mount_info_ref (mount_info);
+	      break;
+	    }
+	}
+    }
+  g_rw_lock_reader_unlock (&mount_index_lock);
 
   return info;
 }
@@ -754,31 +873,42 @@ lookup_mount_info_by_fuse_path_in_cache (const char *fuse_path,
 					 char **mount_path)
 {
   GMountInfo *info;
-  GList *l;
+  char *prefix, *slash;
 
-  G_LOCK (mount_cache);
   info = NULL;
-  for (l = the_vfs->mount_cache; l != NULL; l = l->next)
-    {
-      GMountInfo *mount_info = l->data;
+  prefix = g_strdup (fuse_path);
 
-      if (mount_info->fuse_mountpoint != NULL &&
-	  g_str_has_prefix (fuse_path, mount_info->fuse_mountpoint))
+  g_rw_lock_reader_lock (&mount_index_lock);
+  if (the_vfs->mount_index != NULL)
+    {
+      /* Try fuse_path and then each of its parents */
+      do
 	{
-	  int len = strlen (mount_info->fuse_mountpoint);
-	  if (fuse_path[len] == 0 ||
-	      fuse_path[len] == '/')
+	  info = g_hash_table_lookup (the_vfs->mount_index->by_fuse_mountpoint,
+				      prefix);
+	  if (info != NULL)
 	    {
-	      if (fuse_path[len] == 0)
-		*mount_path = g_strdup ("/");
-	      else
-		*mount_path = g_strdup (fuse_path + len);
-	      info = g_mount_info_ref (mount_info);
+	      info = g_mount_info_ref (info);
 	      break;
 	    }
+
+	  slash = strrchr (prefix, '/');
+	  if (slash != NULL)
+	    *slash = 0;
 	}
+      while (slash != NULL && *prefix != 0);
     }
-  G_UNLOCK (mount_cache);
+  g_rw_lock_reader_unlock (&mount_index_lock);
+
+  if (info != NULL)
+    {
+      if (fuse_path[strlen (prefix)] == 0)
+	*mount_path = g_strdup ("/");
+      else
+	*mount_path = g_strdup (fuse_path + strlen (prefix));
+    }
+
+  g_free (prefix);
 
   return info;
 }
@@ -788,6 +918,9 @@ void
 _g_daemon_vfs_invalidate_dbus_id (const char *dbus_id)
 {
   GList *l, *next;
+  gboolean changed;
+
+  changed = FALSE;
 
   G_LOCK (mount_cache);
   for (l = the_vfs->mount_cache; l != NULL; l = next)
@@ -799,12 +932,136 @@ _g_daemon_vfs_invalidate_dbus_id (const char *dbus_id)
 	{
 	  the_vfs->mount_cache = g_list_delete_link (the_vfs->mount_cache, l);
 	  g_mount_info_unref (mount_info);
+	  changed = TRUE;
 	}
     }
+
+  if (changed)
+    update_mount_index_locked ();
   
   G_UNLOCK (mount_cache);
 }
 
+/* The caches are only freed with the vfs, so the returned
+   cache stays valid without holding the lock */
+static GVfsInfoCache *
+get_info_cache (GMountSpec *spec,
+		gboolean    create)
+{
+  GVfsInfoCache *cache;
+
+  if (the_vfs == NULL || the_vfs->info_cache_ttl_msecs == 0)
+    return NULL;
+
+  G_LOCK (info_caches);
+  cache = g_hash_table_lookup (the_vfs->info_caches, spec);
+  if (cache == NULL && create)
+    {
+      cache = g_vfs_info_cache_new ();
+      g_vfs_info_cache_set_limits (cache,
+				   the_vfs->info_cache_ttl_msecs,
+				   INFO_CACHE_MAX_BYTES);
+      g_hash_table_insert (the_vfs->info_caches,
+			   g_mount_spec_ref (spec), cache);
+    }
+  G_UNLOCK (info_caches);
+
+  return cache;
+}
+
+/**
+ * _g_daemon_vfs_info_cache_lookup:
+ *
+ * Returns a copy of a recently read info of @path with exactly the
+ * same @attributes and @flags, or %NULL. May be called from any thread.
+ **/
+GFileInfo *
+_g_daemon_vfs_info_cache_lookup (GMountSpec          *spec,
+				 const char          *path,
+				 const char          *attributes,
+				 GFileQueryInfoFlags  flags)
+{
+  GVfsInfoCache *cache;
+
+  if (attributes == NULL)
+    return NULL;
+
+  cache = get_info_cache (spec, FALSE);
+  if (cache == NULL)
+    return NULL;
+
+  return g_vfs_info_cache_lookup (cache, path, attributes, flags);
+}
+
+/**
+ * _g_daemon_vfs_info_cache_get_generation:
+ *
+ * Call this before asking the daemon for an info, and pass the
+ * result to _g_daemon_vfs_info_cache_insert(), so that an info
+ * that raced with an invalidation is not cached.
+ **/
+guint
+_g_daemon_vfs_info_cache_get_generation (GMountSpec *spec)
+{
+  GVfsInfoCache *cache;
+
+  cache = get_info_cache (spec, TRUE);
+  if (cache == NULL)
+    return 0;
+
+  return g_vfs_info_cache_get_generation (cache);
+}
+
+void
+_g_daemon_vfs_info_cache_insert (GMountSpec          *spec,
+				 guint                generation,
+				 const char          *path,
+				 const char          *attributes,
+				 GFileQueryInfoFlags  flags,
+				 GFileInfo           *info)
+{
+  GVfsInfoCache *cache;
+
+  if (attributes == NULL)
+    return;
+
+  cache = get_info_cache (spec, TRUE);
+  if (cache != NULL)
+    g_vfs_info_cache_insert (cache, generation, path, attributes, flags, info);
+}
+
+/**
+ * _g_daemon_vfs_info_cache_use_listings:
+ *
+ * Returns whether enumerators may fill the info cache with the
+ * infos of the children.
+ **/
+gboolean
+_g_daemon_vfs_info_cache_use_listings (void)
+{
+  return
+    the_vfs != NULL &&
+    the_vfs->info_cache_ttl_msecs != 0 &&
+    the_vfs->info_cache_listings;
+}
+
+/**
+ * _g_daemon_vfs_info_cache_invalidate:
+ *
+ * Drops the cached infos of @path, its children and its parent.
+ * Called for file monitor events and after operations of this
+ * process that change @path.
+ **/
+void
+_g_daemon_vfs_info_cache_invalidate (GMountSpec *spec,
+				     const char *path)
+{
+  GVfsInfoCache *cache;
+
+  cache = get_info_cache (spec, FALSE);
+  if (cache != NULL)
+    g_vfs_info_cache_invalidate (cache, path);
+}
 
 static GMountInfo *
 handler_lookup_mount_reply (DBusMessage *reply,
@@ -851,7 +1108,10 @@ handler_lookup_mount_reply (DBusMessage *reply,
 
   /* No, lets add it to the cache */
   if (!in_cache)
-    the_vfs->mount_cache = g_list_prepend (the_vfs->mount_cache, g_mount_info_ref (info));
+    {
+      the_vfs->mount_cache = g_list_prepend (the_vfs->mount_cache, g_mount_info_ref (info));
+      update_mount_index_locked ();
+    }
 
   G_UNLOCK (mount_cache);
   
@@ -1559,6 +1819,11 @@ void g_vfs_uri_mapper_http_register (GIOModule *module);
 void g_vfs_uri_mapper_sftp_register (GIOModule *module);
 void g_vfs_uri_mapper_afp_register (GIOModule *module);
 
+static const GVfsClientOps client_ops = {
+  g_daemon_file_query_info_multi,
+  g_daemon_file_enumerate_recursive
+};
+
 void
 g_io_module_load (GIOModule *module)
 {
@@ -1584,6 +1849,9 @@ g_io_module_load (GIOModule *module)
      see comment in common/giconvfs.c */
   _g_vfs_icon_add_loadable_interface ();
 
+  /* For the gvfs tools, see common/gvfsclientops.c */
+  g_vfs_client_ops_register (&client_ops);
+
   g_io_extension_point_implement (G_VFS_EXTENSION_POINT_NAME,
 				  G_TYPE_DAEMON_VFS,
 				  "gvfs",
@@ -77,6 +77,20 @@ int             _g_daemon_vfs_append_metadata_for_set  (DBusMessage *message,
 							const char *attribute,
 							GFileAttributeType type,
 							gpointer   value);
+GFileInfo *     _g_daemon_vfs_info_cache_lookup        (GMountSpec               *spec,
+							const char               *path,
+							const char               *attributes,
+							GFileQueryInfoFlags       flags);
+guint           _g_daemon_vfs_info_cache_get_generation (GMountSpec              *spec);
+void            _g_daemon_vfs_info_cache_insert        (GMountSpec               *spec,
+							guint                     generation,
+							const char               *path,
+							const char               *attributes,
+							GFileQueryInfoFlags       flags,
+							GFileInfo                *info);
+gboolean        _g_daemon_vfs_info_cache_use_listings  (void);
+void            _g_daemon_vfs_info_cache_invalidate    (GMountSpec               *spec,
+							const char               *path);
 
 
 
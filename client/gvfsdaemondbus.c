@@ -39,21 +39,30 @@
 #include "gvfsdbusutils.h"
 #include "gsysutils.h"
 
+typedef struct _ThreadLocalConnections ThreadLocalConnections;
+
 /* Extra vfs-specific data for DBusConnections */
 typedef struct {
   int extra_fd;
   int extra_fd_count;
+  int extra_fd_sent_count;
   char *async_dbus_id;
   
   /* Only used for async connections */
   GHashTable *outstanding_fds;
   GSource *extra_fd_source;
+
+  /* Only used for sync mount connections, the rest is protected
+     by the connection_pool lock */
+  char *dbus_id;
+  ThreadLocalConnections *owner;
+  int users;
+  gboolean orphaned;
 } VfsConnectionData;
 
 static gint32 vfs_data_slot = -1;
 static GOnce once_init_dbus = G_ONCE_INIT;
 
-typedef struct _ThreadLocalConnections ThreadLocalConnections;
 static void free_local_connections (ThreadLocalConnections *local);
 
 static GPrivate local_connections = G_PRIVATE_INIT((GDestroyNotify)free_local_connections);
@@ -69,6 +78,12 @@ G_LOCK_DEFINE_STATIC(obj_path_map);
 static void setup_async_fd_receive (VfsConnectionData *connection_data);
 static void invalidate_local_connection (const char *dbus_id,
 					 GError **error);
+static gboolean has_local_connection (const char *dbus_id);
+static DBusConnection *checkout_connection (const char *dbus_id,
+					    GError **error);
+static void checkin_connection (const char *dbus_id,
+				DBusConnection *connection);
+static void free_mount_connection (DBusConnection *conn);
   
 
 GQuark
@@ -203,6 +218,7 @@ connection_data_free (gpointer p)
     g_hash_table_destroy (data->outstanding_fds);
 
   g_free (data->async_dbus_id);
+  g_free (data->dbus_id);
   
   g_free (data);
 }
@@ -334,6 +350,42 @@ _g_dbus_connection_get_fd_sync (DBusConnection *connection,
   return fd;
 }
 
+/* Hands fd to the daemon at the other end, which takes it by the
+   returned id. The caller still owns fd. */
+gboolean
+_g_dbus_connection_send_fd_sync (DBusConnection *connection,
+				 int fd,
+				 guint32 *fd_id,
+				 GError **error)
+{
+  VfsConnectionData *data;
+  int errsv;
+
+  data = dbus_connection_get_data (connection, vfs_data_slot);
+  g_assert (data != NULL);
+
+  if (data->extra_fd == -1)
+    {
+      g_set_error (error, G_IO_ERROR,
+		   G_IO_ERROR_FAILED,
+		   _("Internal Error (%s)"), "No fd passing socket available");
+      return FALSE;
+    }
+
+  if (_g_socket_send_fd (data->extra_fd, fd) == -1)
+    {
+      errsv = errno;
+      g_set_error (error, G_IO_ERROR,
+		   g_io_error_from_errno (errsv),
+		   _("Error sending file descriptor: %s"),
+		   g_strerror (errsv));
+      return FALSE;
+    }
+
+  *fd_id = data->extra_fd_sent_count++;
+  return TRUE;
+}
+
 void
 _g_dbus_connection_get_fd_async (DBusConnection *connection,
 				 int fd_id,
@@ -697,17 +749,33 @@ _g_vfs_daemon_call_sync (DBusMessage *message,
   DBusMessage *cancel_message;
   dbus_uint32_t serial;
   gboolean handle_callbacks;
+  gboolean pooled;
   const char *dbus_id = dbus_message_get_destination (message);
 
   if (g_cancellable_set_error_if_cancelled (cancellable, error))
     return NULL;
-	    
-  connection = _g_dbus_connection_get_sync (dbus_id, error);
+
+  /* If the caller doesn't need the connection afterwards, e.g. to
+     receive fds on it, it is only borrowed from the pool for the call.
+     Otherwise the caller gets a use of the thread's local connection
+     and gives it back with _g_dbus_connection_release() */
+  pooled = connection_out == NULL && dbus_id != NULL &&
+    !has_local_connection (dbus_id);
+  if (pooled)
+    connection = checkout_connection (dbus_id, error);
+  else
+    connection = _g_dbus_connection_get_sync (dbus_id, error);
   if (connection == NULL)
     return NULL;
 
   if (g_cancellable_set_error_if_cancelled (cancellable, error))
-    return NULL;
+    {
+      if (pooled)
+	checkin_connection (dbus_id, connection);
+      else
+	_g_dbus_connection_release (connection);
+      return NULL;
+    }
 
   handle_callbacks = FALSE;
   if (callback_obj_path != NULL && callback != NULL)
@@ -844,19 +912,33 @@ _g_vfs_daemon_call_sync (DBusMessage *message,
 	}
     }
 
-  if (connection_out)
-    *connection_out = connection;
-
  out:  
   
   if (handle_callbacks)
     dbus_connection_unregister_object_path (connection, callback_obj_path);
 
+  if (pooled)
+    {
+      /* Without a reply the connection may be dead or get a late
+	 reply, so it is not reused */
+      if (reply != NULL)
+	checkin_connection (dbus_id, connection);
+      else
+	free_mount_connection (connection);
+    }
+  else if (reply == NULL || connection_out == NULL)
+    _g_dbus_connection_release (connection);
+
   if (reply != NULL && _g_error_from_message (reply, error))
     {
+      if (!pooled && connection_out != NULL)
+	_g_dbus_connection_release (connection);
       dbus_message_unref (reply);
       return NULL;
     }
+
+  if (connection_out)
+    *connection_out = connection;
   
   return reply;
 }
@@ -865,6 +947,29 @@ _g_vfs_daemon_call_sync (DBusMessage *message,
  *               get per-thread synchronous dbus connections             *
  *************************************************************************/
 
+/* Idle peer-to-peer connections are shared by all threads. A thread
+ * takes one out of the pool for a call and puts it back afterwards,
+ * or keeps it in its local connections if the caller needs the
+ * connection after the call, e.g. for receiving fds. Local connections
+ * count their users, like a sync enumerator, and go back to the pool
+ * when the last one releases it. If the thread exits first the last
+ * user returns it.
+ */
+
+/* Idle connections kept per daemon, the rest is closed */
+#define MAX_IDLE_CONNECTIONS 4
+/* Idle connections unused for this long are closed */
+#define IDLE_CONNECTION_TIMEOUT_SECS 30
+
+typedef struct {
+  DBusConnection *connection;
+  gint64 idle_since;
+} IdleConnection;
+
+/* dbus id -> GQueue of IdleConnection, most recently used first */
+static GHashTable *connection_pool = NULL;
+G_LOCK_DEFINE_STATIC(connection_pool);
+
 struct _ThreadLocalConnections {
   GHashTable *connections;
   DBusConnection *session_bus;
@@ -877,26 +982,246 @@ free_mount_connection (DBusConnection *conn)
   dbus_connection_unref (conn);
 }
 
+static void
+idle_connection_free (IdleConnection *idle)
+{
+  free_mount_connection (idle->connection);
+  g_slice_free (IdleConnection, idle);
+}
+
+static void
+idle_connections_free (GQueue *queue)
+{
+  g_queue_free_full (queue, (GDestroyNotify)idle_connection_free);
+}
+
+/* Called with the connection_pool lock held */
+static void
+reap_idle_connections_unlocked (GQueue *queue,
+				GList **to_free)
+{
+  IdleConnection *idle;
+  gint64 now;
+
+  now = g_get_monotonic_time ();
+  while ((idle = g_queue_peek_tail (queue)) != NULL &&
+	 now - idle->idle_since > (gint64)IDLE_CONNECTION_TIMEOUT_SECS * G_USEC_PER_SEC)
+    *to_free = g_list_prepend (*to_free, g_queue_pop_tail (queue));
+}
+
+/* Sets dead if a pooled connection was found disconnected,
+   then the daemon is probably gone */
+static DBusConnection *
+take_idle_connection (const char *dbus_id,
+		      gboolean *dead)
+{
+  DBusConnection *connection;
+  IdleConnection *idle;
+  GList *to_free;
+  GQueue *queue;
+
+  connection = NULL;
+  to_free = NULL;
+  *dead = FALSE;
+
+  G_LOCK (connection_pool);
+  queue = connection_pool ? g_hash_table_lookup (connection_pool, dbus_id) : NULL;
+  if (queue != NULL)
+    {
+      reap_idle_connections_unlocked (queue, &to_free);
+      while (connection == NULL && !*dead &&
+	     (idle = g_queue_pop_head (queue)) != NULL)
+	{
+	  if (dbus_connection_get_is_connected (idle->connection))
+	    {
+	      connection = idle->connection;
+	      g_slice_free (IdleConnection, idle);
+	    }
+	  else
+	    {
+	      to_free = g_list_prepend (to_free, idle);
+	      *dead = TRUE;
+	    }
+	}
+    }
+  G_UNLOCK (connection_pool);
+
+  /* Closing may block, so do it without the lock */
+  g_list_free_full (to_free, (GDestroyNotify)idle_connection_free);
+
+  return connection;
+}
+
+static void
+checkin_connection (const char *dbus_id,
+		    DBusConnection *connection)
+{
+  IdleConnection *idle;
+  GList *to_free;
+  GQueue *queue;
+
+  if (!dbus_connection_get_is_connected (connection))
+    {
+      free_mount_connection (connection);
+      return;
+    }
+
+  idle = g_slice_new (IdleConnection);
+  idle->connection = connection;
+  idle->idle_since = g_get_monotonic_time ();
+
+  to_free = NULL;
+
+  G_LOCK (connection_pool);
+  if (connection_pool == NULL)
+    connection_pool = g_hash_table_new_full (g_str_hash, g_str_equal,
+					     g_free, (GDestroyNotify)idle_connections_free);
+  queue = g_hash_table_lookup (connection_pool, dbus_id);
+  if (queue == NULL)
+    {
+      queue = g_queue_new ();
+      g_hash_table_insert (connection_pool, g_strdup (dbus_id), queue);
+    }
+
+  reap_idle_connections_unlocked (queue, &to_free);
+  g_queue_push_head (queue, idle);
+  if (g_queue_get_length (queue) > MAX_IDLE_CONNECTIONS)
+    to_free = g_list_prepend (to_free, g_queue_pop_tail (queue));
+  G_UNLOCK (connection_pool);
+
+  g_list_free_full (to_free, (GDestroyNotify)idle_connection_free);
+}
+
+static void
+invalidate_pooled_connections (const char *dbus_id)
+{
+  gpointer key, queue;
+
+  key = queue = NULL;
+
+  G_LOCK (connection_pool);
+  if (connection_pool != NULL &&
+      g_hash_table_lookup_extended (connection_pool, dbus_id, &key, &queue))
+    g_hash_table_steal (connection_pool, dbus_id);
+  G_UNLOCK (connection_pool);
+
+  /* Closing may block, so do it without the lock */
+  if (queue != NULL)
+    {
+      g_free (key);
+      idle_connections_free (queue);
+    }
+}
+
 static void
 free_local_connections (ThreadLocalConnections *local)
 {
+  VfsConnectionData *data;
+  GHashTableIter iter;
+  gpointer connection;
+  GList *unused, *l;
+
+  unused = NULL;
+
+  G_LOCK (connection_pool);
+  g_hash_table_iter_init (&iter, local->connections);
+  while (g_hash_table_iter_next (&iter, NULL, &connection))
+    {
+      data = dbus_connection_get_data (connection, vfs_data_slot);
+      data->owner = NULL;
+      if (data->users > 0)
+	data->orphaned = TRUE;
+      else
+	unused = g_list_prepend (unused, connection);
+    }
+  G_UNLOCK (connection_pool);
+
+  for (l = unused; l != NULL; l = l->next)
+    {
+      data = dbus_connection_get_data (l->data, vfs_data_slot);
+      checkin_connection (data->dbus_id, l->data);
+    }
+  g_list_free (unused);
+
   g_hash_table_destroy (local->connections);
   if (local->session_bus)
     free_mount_connection (local->session_bus);
   g_free (local);
 }
 
+static ThreadLocalConnections *
+get_local_connections (void)
+{
+  ThreadLocalConnections *local;
+
+  local = g_private_get (&local_connections);
+  if (local == NULL)
+    {
+      local = g_new0 (ThreadLocalConnections, 1);
+      local->connections = g_hash_table_new_full (g_str_hash, g_str_equal,
+						  g_free, NULL);
+      g_private_set (&local_connections, local);
+    }
+
+  return local;
+}
+
+static gboolean
+has_local_connection (const char *dbus_id)
+{
+  ThreadLocalConnections *local;
+  gboolean res;
+
+  local = g_private_get (&local_connections);
+  if (local == NULL)
+    return FALSE;
+
+  G_LOCK (connection_pool);
+  res = g_hash_table_lookup (local->connections, dbus_id) != NULL;
+  G_UNLOCK (connection_pool);
+
+  return res;
+}
+
 static void
 invalidate_local_connection (const char *dbus_id,
 			     GError **error)
 {
   ThreadLocalConnections *local;
+  DBusConnection *connection;
+  VfsConnectionData *data;
+  gboolean in_use;
   
   _g_daemon_vfs_invalidate_dbus_id (dbus_id);
 
   local = g_private_get (&local_connections);
+  connection = NULL;
+  in_use = FALSE;
   if (local)
-    g_hash_table_remove (local->connections, dbus_id);
+    {
+      G_LOCK (connection_pool);
+      connection = g_hash_table_lookup (local->connections, dbus_id);
+      if (connection != NULL)
+	{
+	  g_hash_table_remove (local->connections, dbus_id);
+	  data = dbus_connection_get_data (connection, vfs_data_slot);
+	  data->owner = NULL;
+	  in_use = data->users > 0;
+	  data->orphaned = in_use;
+	}
+      G_UNLOCK (connection_pool);
+    }
+
+  /* The last user frees it once it is released */
+  if (connection != NULL)
+    {
+      if (in_use)
+	dbus_connection_close (connection);
+      else
+	free_mount_connection (connection);
+    }
+
+  invalidate_pooled_connections (dbus_id);
   
   g_set_error_literal (error,
 		       G_VFS_ERROR,
@@ -904,90 +1229,64 @@ invalidate_local_connection (const char *dbus_id,
 		       "Cache invalid, retry (internally handled)");
 }
 
-DBusConnection *
-_g_dbus_connection_get_sync (const char *dbus_id,
-			     GError **error)
+static DBusConnection *
+get_session_bus (ThreadLocalConnections *local,
+		 GError **error)
 {
   DBusConnection *bus;
-  ThreadLocalConnections *local;
-  GError *local_error;
-  DBusConnection *connection;
-  DBusMessage *message, *reply;
   DBusError derror;
-  char *address1, *address2;
-  int extra_fd;
 
-  g_once (&once_init_dbus, vfs_dbus_init, NULL);
-
-  local = g_private_get (&local_connections);
-  if (local == NULL)
+  if (local->session_bus)
     {
-      local = g_new0 (ThreadLocalConnections, 1);
-      local->connections = g_hash_table_new_full (g_str_hash, g_str_equal,
-						  g_free, (GDestroyNotify)free_mount_connection);
-      g_private_set (&local_connections, local);
+      if (dbus_connection_get_is_connected (local->session_bus))
+	return local->session_bus;
+
+      /* Session bus was disconnected, re-connect */
+      dbus_connection_unref (local->session_bus);
+      local->session_bus = NULL;
     }
 
-  if (dbus_id == NULL)
+  dbus_error_init (&derror);
+  bus = dbus_bus_get_private (DBUS_BUS_SESSION, &derror);
+  if (bus == NULL)
     {
-      /* Session bus */
-      
-      if (local->session_bus)
-	{
-	  if (dbus_connection_get_is_connected (local->session_bus))
-	    return local->session_bus;
-
-	  /* Session bus was disconnected, re-connect */
-	  dbus_connection_unref (local->session_bus);
-	  local->session_bus = NULL;
-	}
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		   "Couldn't get main dbus connection: %s",
+		   derror.message);
+      dbus_error_free (&derror);
+      return NULL;
     }
-  else
-    {
-      /* Mount daemon connection */
-      
-      connection = g_hash_table_lookup (local->connections, dbus_id);
-      if (connection != NULL)
-	{
-	  if (!dbus_connection_get_is_connected (connection))
-	    {
-	      /* The mount for this connection died, we invalidate
-	       * the caches, and then caller needs to retry.
-	       */
 
-	      invalidate_local_connection (dbus_id, error);
-	      return NULL;
-	    }
-	  
-	  return connection;
-	}
-    }
+  local->session_bus = bus;
 
-  dbus_error_init (&derror);
+  return bus;
+}
 
-  if (local->session_bus == NULL)
-    {
-      bus = dbus_bus_get_private (DBUS_BUS_SESSION, &derror);
-      if (bus == NULL)
-	{
-	  g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
-		       "Couldn't get main dbus connection: %s",
-		       derror.message);
-	  dbus_error_free (&derror);
-	  return NULL;
-	}
-      
-      local->session_bus = bus;
+/* Opens a new peer-to-peer connection to the daemon */
+static DBusConnection *
+open_connection (const char *dbus_id,
+		 GError **error)
+{
+  DBusConnection *bus;
+  GError *local_error;
+  DBusConnection *connection;
+  DBusMessage *message, *reply;
+  DBusError derror;
+  char *address1, *address2;
+  int extra_fd;
+  VfsConnectionData *connection_data;
 
-      if (dbus_id == NULL)
-	return bus; /* We actually wanted the session bus, so done */
-    }
+  bus = get_session_bus (get_local_connections (), error);
+  if (bus == NULL)
+    return NULL;
+
+  dbus_error_init (&derror);
   
   message = dbus_message_new_method_call (dbus_id,
 					  G_VFS_DBUS_DAEMON_PATH,
 					  G_VFS_DBUS_DAEMON_INTERFACE,
 					  G_VFS_DBUS_OP_GET_CONNECTION);
-  reply = dbus_connection_send_with_reply_and_block (local->session_bus, message, -1,
+  reply = dbus_connection_send_with_reply_and_block (bus, message, -1,
 						     &derror);
   dbus_message_unref (message);
 
@@ -1034,12 +1333,136 @@ _g_dbus_connection_get_sync (const char *dbus_id,
   dbus_message_unref (reply);
 
   vfs_connection_setup (connection, extra_fd, FALSE);
+  connection_data = dbus_connection_get_data (connection, vfs_data_slot);
+  connection_data->dbus_id = g_strdup (dbus_id);
+
+  return connection;
+}
+
+/* Gets a connection for exclusive use by the caller, which must
+   give it back with checkin_connection() */
+static DBusConnection *
+checkout_connection (const char *dbus_id,
+		     GError **error)
+{
+  DBusConnection *connection;
+  gboolean dead;
+
+  g_once (&once_init_dbus, vfs_dbus_init, NULL);
+
+  connection = take_idle_connection (dbus_id, &dead);
+  if (dead)
+    {
+      /* Asking the bus for a new one would fail the same way, have
+	 the caller look up the mount again */
+      invalidate_local_connection (dbus_id, error);
+      return NULL;
+    }
+
+  if (connection == NULL)
+    connection = open_connection (dbus_id, error);
+
+  return connection;
+}
+
+/* For a mount daemon this returns the thread's local connection with
+   a use taken for the caller, which must give it back with
+   _g_dbus_connection_release() */
+DBusConnection *
+_g_dbus_connection_get_sync (const char *dbus_id,
+			     GError **error)
+{
+  ThreadLocalConnections *local;
+  DBusConnection *connection;
+  VfsConnectionData *data;
+
+  g_once (&once_init_dbus, vfs_dbus_init, NULL);
 
+  local = get_local_connections ();
+
+  /* Session bus */
+  if (dbus_id == NULL)
+    return get_session_bus (local, error);
+
+  /* Mount daemon connection */
+  G_LOCK (connection_pool);
+  connection = g_hash_table_lookup (local->connections, dbus_id);
+  if (connection != NULL)
+    {
+      data = dbus_connection_get_data (connection, vfs_data_slot);
+      data->users++;
+    }
+  G_UNLOCK (connection_pool);
+
+  if (connection != NULL)
+    {
+      if (!dbus_connection_get_is_connected (connection))
+	{
+	  /* The mount for this connection died, we invalidate
+	   * the caches, and then caller needs to retry.
+	   */
+
+	  _g_dbus_connection_release (connection);
+	  invalidate_local_connection (dbus_id, error);
+	  return NULL;
+	}
+      
+      return connection;
+    }
+
+  connection = checkout_connection (dbus_id, error);
+  if (connection == NULL)
+    return NULL;
+
+  data = dbus_connection_get_data (connection, vfs_data_slot);
+
+  G_LOCK (connection_pool);
+  data->owner = local;
+  data->users = 1;
   g_hash_table_insert (local->connections, g_strdup (dbus_id), connection);
+  G_UNLOCK (connection_pool);
 
   return connection;
 }
 
+/* Gives back a use of a local connection, from any thread. When
+   nobody uses it anymore it goes back to the pool. */
+void
+_g_dbus_connection_release (DBusConnection *connection)
+{
+  VfsConnectionData *data;
+  ThreadLocalConnections *owner;
+  gboolean unused;
+
+  data = dbus_connection_get_data (connection, vfs_data_slot);
+  /* The session bus */
+  if (data == NULL || data->dbus_id == NULL)
+    return;
+
+  unused = FALSE;
+
+  G_LOCK (connection_pool);
+  g_assert (data->users > 0);
+  if (--data->users == 0)
+    {
+      owner = data->owner;
+      if (owner != NULL &&
+	  g_hash_table_lookup (owner->connections, data->dbus_id) == connection)
+	{
+	  g_hash_table_remove (owner->connections, data->dbus_id);
+	  unused = TRUE;
+	}
+      else if (data->orphaned)
+	unused = TRUE;
+      data->owner = NULL;
+      data->orphaned = FALSE;
+    }
+  G_UNLOCK (connection_pool);
+
+  if (unused)
+    checkin_connection (data->dbus_id, connection);
+}
+
 /**
  * _g_simple_async_result_complete_with_cancellable:
  * @result: the result
@@ -55,8 +55,13 @@ GList *         _g_dbus_bus_list_names_with_prefix_sync (DBusConnection
 							 DBusError                      *error);
 DBusConnection *_g_dbus_connection_get_sync             (const char                     *dbus_id,
 							 GError                        **error);
+void            _g_dbus_connection_release              (DBusConnection                 *connection);
 int             _g_dbus_connection_get_fd_sync          (DBusConnection                 *conn,
 							 int                             fd_id);
+gboolean        _g_dbus_connection_send_fd_sync         (DBusConnection                 *connection,
+							 int                             fd,
+							 guint32                        *fd_id,
+							 GError                        **error);
 void            _g_dbus_connection_get_fd_async         (DBusConnection                 *connection,
 							 int                             fd_id,
 							 GetFdAsyncCallback              callback,
@@ -1183,7 +1183,8 @@ read_stream (FileHandle *fh, gchar *output_buf, size_t output_buf_size, off_t of
     {
       if (g_seekable_can_seek (G_SEEKABLE (input_stream)))
         {
-          /* Can seek */
+          /* Can seek. For daemon streams this costs no round trip, the
+           * new position goes out together with the read below. */
 
           debug_print ("read_stream: seeking to offset %d.\n", offset);
 
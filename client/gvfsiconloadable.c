@@ -143,12 +143,14 @@ g_vfs_icon_load (GLoadableIcon  *icon,
       dbus_message_unref (reply);
       g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			   _("Invalid return value from %s"), "open_icon_for_read");
+      _g_dbus_connection_release (connection);
       return NULL;
     }
 
   dbus_message_unref (reply);
 
   fd = _g_dbus_connection_get_fd_sync (connection, fd_id);
+  _g_dbus_connection_release (connection);
   if (fd == -1)
     {
       g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -384,12 +384,23 @@ g_mount_spec_hash (gconstpointer _mount)
 {
   GMountSpec *mount = (GMountSpec *) _mount;
   guint hash;
-  int i;
 
-  hash = 0;
+  hash = g_mount_spec_hash_items (mount);
   if (mount->mount_prefix)
     hash ^= g_str_hash (mount->mount_prefix);
   
+  return hash;
+}
+
+/* Like g_mount_spec_hash(), but ignores the mount prefix */
+guint
+g_mount_spec_hash_items (gconstpointer _mount)
+{
+  GMountSpec *mount = (GMountSpec *) _mount;
+  guint hash;
+  int i;
+
+  hash = 0;
   for (i = 0; i < mount->items->len; i++)
     {
       GMountSpecItem *item = &g_array_index (mount->items, GMountSpecItem, i);
@@ -399,6 +410,13 @@ g_mount_spec_hash (gconstpointer _mount)
   return hash;
 }
 
+gboolean
+g_mount_spec_equal_items (GMountSpec      *mount1,
+			  GMountSpec      *mount2)
+{
+  return items_equal (mount1->items, mount2->items);
+}
+
 gboolean
 g_mount_spec_equal (GMountSpec      *mount1,
 		    GMountSpec      *mount2)
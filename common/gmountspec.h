@@ -83,6 +83,9 @@ void        g_mount_spec_set_with_len      (GMountSpec      *spec,
 guint       g_mount_spec_hash              (gconstpointer    mount);
 gboolean    g_mount_spec_equal             (GMountSpec      *mount1,
 					    GMountSpec      *mount2);
+guint       g_mount_spec_hash_items        (gconstpointer    mount);
+gboolean    g_mount_spec_equal_items       (GMountSpec      *mount1,
+					    GMountSpec      *mount2);
 gboolean    g_mount_spec_match             (GMountSpec      *mount,
 					    GMountSpec      *path);
 gboolean    g_mount_spec_match_with_path   (GMountSpec      *mount,
@@ -0,0 +1,118 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "gvfsclientops.h"
+
+/* Set once by the client module, which stays loaded */
+static const GVfsClientOps *client_ops = NULL;
+
+void
+g_vfs_client_ops_register (const GVfsClientOps *ops)
+{
+  client_ops = ops;
+}
+
+/**
+ * g_vfs_query_info_multi:
+ * @files: the files to query
+ * @n_files: number of @files
+ * @attributes: an attribute query string
+ * @flags: a set of #GFileQueryInfoFlags
+ * @infos: returns the info for each file, or %NULL on errors
+ * @errors: returns the error for each file that failed
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ *
+ * Like g_file_query_info() on each of @files, but files on the same
+ * gvfs mount are queried with one call. Without the client module
+ * they are queried one by one.
+ **/
+void
+g_vfs_query_info_multi (GFile               **files,
+			guint                 n_files,
+			const char           *attributes,
+			GFileQueryInfoFlags   flags,
+			GFileInfo           **infos,
+			GError              **errors,
+			GCancellable         *cancellable)
+{
+  guint i;
+
+  /* Loads the client module if there is one */
+  g_vfs_get_default ();
+
+  if (client_ops != NULL && client_ops->query_info_multi != NULL)
+    {
+      client_ops->query_info_multi (files, n_files, attributes, flags,
+				    infos, errors, cancellable);
+      return;
+    }
+
+  for (i = 0; i < n_files; i++)
+    {
+      errors[i] = NULL;
+      infos[i] = g_file_query_info (files[i], attributes, flags,
+				    cancellable, &errors[i]);
+    }
+}
+
+/**
+ * g_vfs_enumerate_recursive:
+ * @file: the directory to list
+ * @attributes: an attribute query string
+ * @flags: a set of #GFileQueryInfoFlags
+ * @max_depth: how many levels to list, 0 for all
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @error: a #GError, or %NULL
+ *
+ * Lists the whole tree below @file with the walk done in the gvfs
+ * daemon. The name of each info is its path relative to @file.
+ * Subdirectories that are symlinks are not entered and those that
+ * can't be read are skipped.
+ *
+ * Returns: a #GFileEnumerator, or %NULL with %G_IO_ERROR_NOT_SUPPORTED
+ * when @file is not on a gvfs mount that can do this.
+ **/
+GFileEnumerator *
+g_vfs_enumerate_recursive (GFile               *file,
+			   const char          *attributes,
+			   GFileQueryInfoFlags  flags,
+			   guint                max_depth,
+			   GCancellable        *cancellable,
+			   GError             **error)
+{
+  g_vfs_get_default ();
+
+  if (client_ops == NULL || client_ops->enumerate_recursive == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			   "No gvfs client module");
+      return NULL;
+    }
+
+  return client_ops->enumerate_recursive (file, attributes, flags,
+					  max_depth, cancellable, error);
+}
@@ -0,0 +1,67 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_CLIENT_OPS_H__
+#define __G_VFS_CLIENT_OPS_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* Operations of the gvfs client module that GIO has no API for, so
+ * the gvfs tools can use them. The module registers them when it is
+ * loaded. */
+typedef struct {
+  void (*query_info_multi) (GFile               **files,
+			    guint                 n_files,
+			    const char           *attributes,
+			    GFileQueryInfoFlags   flags,
+			    GFileInfo           **infos,
+			    GError              **errors,
+			    GCancellable         *cancellable);
+  GFileEnumerator *(*enumerate_recursive) (GFile               *file,
+					   const char          *attributes,
+					   GFileQueryInfoFlags  flags,
+					   guint                max_depth,
+					   GCancellable        *cancellable,
+					   GError             **error);
+} GVfsClientOps;
+
+void g_vfs_client_ops_register (const GVfsClientOps  *ops);
+
+void g_vfs_query_info_multi    (GFile               **files,
+				guint                 n_files,
+				const char           *attributes,
+				GFileQueryInfoFlags   flags,
+				GFileInfo           **infos,
+				GError              **errors,
+				GCancellable         *cancellable);
+GFileEnumerator *g_vfs_enumerate_recursive (GFile               *file,
+					    const char          *attributes,
+					    GFileQueryInfoFlags  flags,
+					    guint                max_depth,
+					    GCancellable        *cancellable,
+					    GError             **error);
+
+G_END_DECLS
+
+#endif /* __G_VFS_CLIENT_OPS_H__ */
@@ -0,0 +1,436 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "gvfscopy.h"
+
+/* Files found by the listing but not yet being copied, per copy
+   thread. Listing waits when there are more. */
+#define PENDING_FILES_PER_THREAD 4
+
+#define LIST_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE
+
+typedef struct _CopyData CopyData;
+
+typedef struct {
+  CopyData *data;
+  GFile *source;
+  GFile *destination;
+  GFileCopyFlags flags;
+  goffset size;
+  goffset current;
+} CopyItem;
+
+/* The calling thread lists the tree and creates the directories,
+   max_parallel threads copy the files with the sync calls. */
+struct _CopyData {
+  GFileCopyFlags flags;
+  GCancellable *cancellable;
+  GFileProgressCallback progress_callback;
+  gpointer progress_callback_data;
+
+  GMutex lock;
+  GCond cond;
+  GQueue pending_files;  /* to be copied, at most max_pending */
+  guint max_pending;
+  gboolean listing_done;
+  GList *done_dirs;      /* attributes are set at the end, children first */
+  goffset bytes_done;
+  goffset bytes_in_flight;
+  goffset bytes_total;   /* of the files found so far */
+  GError *error;
+};
+
+static CopyItem *
+copy_item_new (CopyData       *data,
+	       GFile          *source,
+	       GFile          *destination,
+	       GFileCopyFlags  flags,
+	       goffset         size)
+{
+  CopyItem *item;
+
+  item = g_slice_new0 (CopyItem);
+  item->data = data;
+  item->source = g_object_ref (source);
+  item->destination = g_object_ref (destination);
+  item->flags = flags;
+  item->size = size;
+
+  return item;
+}
+
+static void
+copy_item_free (CopyItem *item)
+{
+  g_object_unref (item->source);
+  g_object_unref (item->destination);
+  g_slice_free (CopyItem, item);
+}
+
+/* Called with the lock held.
+ * Keeps the first error, nothing new is started after it */
+static void
+copy_data_take_error_unlocked (CopyData *data,
+			       GError   *error)
+{
+  CopyItem *item;
+
+  if (data->error != NULL)
+    {
+      g_error_free (error);
+      return;
+    }
+
+  data->error = error;
+  while ((item = g_queue_pop_head (&data->pending_files)) != NULL)
+    copy_item_free (item);
+  g_cond_broadcast (&data->cond);
+}
+
+static void
+copy_data_take_error (CopyData *data,
+		      GError   *error)
+{
+  g_mutex_lock (&data->lock);
+  copy_data_take_error_unlocked (data, error);
+  g_mutex_unlock (&data->lock);
+}
+
+static gboolean
+copy_data_failed (CopyData *data)
+{
+  gboolean res;
+
+  g_mutex_lock (&data->lock);
+  res = data->error != NULL;
+  g_mutex_unlock (&data->lock);
+
+  return res;
+}
+
+/* Called with the lock held, so the callback runs for one
+   thread at a time */
+static void
+report_progress_unlocked (CopyData *data)
+{
+  if (data->progress_callback)
+    data->progress_callback (data->bytes_done + data->bytes_in_flight,
+			     data->bytes_total,
+			     data->progress_callback_data);
+}
+
+static void
+file_progress_cb (goffset  current_num_bytes,
+		  goffset  total_num_bytes,
+		  gpointer user_data)
+{
+  CopyItem *item = user_data;
+  CopyData *data = item->data;
+
+  g_mutex_lock (&data->lock);
+  data->bytes_in_flight += current_num_bytes - item->current;
+  item->current = current_num_bytes;
+  report_progress_unlocked (data);
+  g_mutex_unlock (&data->lock);
+}
+
+/* Files go through g_file_copy, so daemon files get the backend's
+   copy, push or pull when it has them */
+static gpointer
+copy_thread (gpointer user_data)
+{
+  CopyData *data = user_data;
+  CopyItem *item;
+  GError *error;
+  gboolean res;
+
+  g_mutex_lock (&data->lock);
+  while (TRUE)
+    {
+      while (data->error == NULL &&
+	     !data->listing_done &&
+	     g_queue_is_empty (&data->pending_files))
+	g_cond_wait (&data->cond, &data->lock);
+
+      item = g_queue_pop_head (&data->pending_files);
+      if (item == NULL)
+	break;
+      /* There is room for the listing again */
+      g_cond_broadcast (&data->cond);
+      g_mutex_unlock (&data->lock);
+
+      error = NULL;
+      res = g_file_copy (item->source, item->destination,
+			 item->flags, data->cancellable,
+			 file_progress_cb, item, &error);
+
+      g_mutex_lock (&data->lock);
+      data->bytes_in_flight -= item->current;
+      if (res)
+	{
+	  data->bytes_done += item->size;
+	  report_progress_unlocked (data);
+	}
+      else
+	copy_data_take_error_unlocked (data, error);
+      copy_item_free (item);
+    }
+  g_mutex_unlock (&data->lock);
+
+  return NULL;
+}
+
+/* Waits while enough files are pending, so the listing doesn't
+   run far ahead of the copy */
+static void
+queue_file (CopyData *data,
+	    CopyItem *item)
+{
+  g_mutex_lock (&data->lock);
+  while (data->error == NULL &&
+	 g_queue_get_length (&data->pending_files) >= data->max_pending)
+    g_cond_wait (&data->cond, &data->lock);
+
+  if (data->error != NULL)
+    copy_item_free (item);
+  else
+    {
+      g_queue_push_tail (&data->pending_files, item);
+      data->bytes_total += item->size;
+      g_cond_signal (&data->cond);
+    }
+  g_mutex_unlock (&data->lock);
+}
+
+/* Copying into an existing directory merges them */
+static gboolean
+make_directory (GFile         *directory,
+		GCancellable  *cancellable,
+		GError       **error)
+{
+  GError *my_error;
+
+  my_error = NULL;
+  if (g_file_make_directory (directory, cancellable, &my_error))
+    return TRUE;
+
+  if (g_error_matches (my_error, G_IO_ERROR, G_IO_ERROR_EXISTS) &&
+      g_file_query_file_type (directory,
+			      G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+			      cancellable) == G_FILE_TYPE_DIRECTORY)
+    {
+      g_error_free (my_error);
+      return TRUE;
+    }
+
+  g_propagate_error (error, my_error);
+  return FALSE;
+}
+
+/* Files are handed to the copy threads while the listing goes on,
+   subdirectories are done after the directory is closed so only
+   one enumerator is open at a time */
+static void
+copy_dir (CopyData       *data,
+	  GFile          *source,
+	  GFile          *destination,
+	  GFileCopyFlags  flags)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo *info;
+  GFile *child_source, *child_destination;
+  GList *subdirs, *l;
+  GError *error;
+  const char *name;
+
+  error = NULL;
+  if (!make_directory (destination, data->cancellable, &error))
+    {
+      copy_data_take_error (data, error);
+      return;
+    }
+
+  enumerator = g_file_enumerate_children (source,
+					  LIST_ATTRIBUTES,
+					  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+					  data->cancellable,
+					  &error);
+  if (enumerator == NULL)
+    {
+      copy_data_take_error (data, error);
+      return;
+    }
+
+  /* Entries below the copied file are never followed, like cp -r */
+  subdirs = NULL;
+  while (!copy_data_failed (data) &&
+	 (info = g_file_enumerator_next_file (enumerator,
+					      data->cancellable,
+					      &error)) != NULL)
+    {
+      name = g_file_info_get_name (info);
+      child_source = g_file_get_child (source, name);
+      child_destination = g_file_get_child (destination, name);
+
+      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+	subdirs = g_list_prepend (subdirs,
+				  copy_item_new (data, child_source, child_destination,
+						 data->flags | G_FILE_COPY_NOFOLLOW_SYMLINKS,
+						 0));
+      else
+	queue_file (data,
+		    copy_item_new (data, child_source, child_destination,
+				   data->flags | G_FILE_COPY_NOFOLLOW_SYMLINKS,
+				   g_file_info_get_size (info)));
+
+      g_object_unref (child_source);
+      g_object_unref (child_destination);
+      g_object_unref (info);
+    }
+
+  if (error != NULL)
+    copy_data_take_error (data, error);
+
+  g_file_enumerator_close (enumerator, NULL, NULL);
+  g_object_unref (enumerator);
+
+  subdirs = g_list_reverse (subdirs);
+  for (l = subdirs; l != NULL; l = l->next)
+    {
+      CopyItem *item = l->data;
+
+      if (!copy_data_failed (data))
+	copy_dir (data, item->source, item->destination, item->flags);
+      copy_item_free (item);
+    }
+  g_list_free (subdirs);
+
+  g_mutex_lock (&data->lock);
+  data->done_dirs = g_list_prepend (data->done_dirs,
+				    copy_item_new (data, source, destination,
+						   flags, 0));
+  g_mutex_unlock (&data->lock);
+}
+
+/* Copies source to destination like g_file_copy(), and if source is a
+ * directory everything below it, like cp -r. Up to max_parallel files
+ * are copied at the same time by separate threads with the sync calls,
+ * overlapped with listing the directories in the calling thread. This
+ * hides most of the per-file round trips on remote mounts. Existing
+ * directories are merged. Symlinks below source are copied as symlinks.
+ * The first error stops the copy once the running copies are done.
+ * The progress callback is called from the copy threads, one at a
+ * time. */
+gboolean
+g_vfs_copy_recursive (GFile                  *source,
+		      GFile                  *destination,
+		      GFileCopyFlags          flags,
+		      guint                   max_parallel,
+		      GCancellable           *cancellable,
+		      GFileProgressCallback   progress_callback,
+		      gpointer                progress_callback_data,
+		      GError                **error)
+{
+  CopyData data = { 0 };
+  GThread **threads;
+  GFileInfo *info;
+  CopyItem *item;
+  GList *l;
+  guint i;
+
+  info = g_file_query_info (source,
+			    G_FILE_ATTRIBUTE_STANDARD_TYPE,
+			    (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS) ?
+			    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS : 0,
+			    cancellable, error);
+  if (info == NULL)
+    return FALSE;
+
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
+    {
+      g_object_unref (info);
+      return g_file_copy (source, destination, flags, cancellable,
+			  progress_callback, progress_callback_data, error);
+    }
+  g_object_unref (info);
+
+  if (max_parallel == 0)
+    max_parallel = G_VFS_COPY_DEFAULT_PARALLEL;
+
+  data.flags = flags;
+  data.cancellable = cancellable;
+  data.progress_callback = progress_callback;
+  data.progress_callback_data = progress_callback_data;
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+  g_queue_init (&data.pending_files);
+  data.max_pending = max_parallel * PENDING_FILES_PER_THREAD;
+
+  threads = g_new (GThread *, max_parallel);
+  for (i = 0; i < max_parallel; i++)
+    threads[i] = g_thread_new ("gvfs-copy", copy_thread, &data);
+
+  copy_dir (&data, source, destination, flags);
+
+  g_mutex_lock (&data.lock);
+  data.listing_done = TRUE;
+  g_cond_broadcast (&data.cond);
+  g_mutex_unlock (&data.lock);
+
+  for (i = 0; i < max_parallel; i++)
+    g_thread_join (threads[i]);
+  g_free (threads);
+
+  /* Writing the children changes the directories, so their attributes
+     are set in one go once everything is copied */
+  for (l = data.done_dirs; l != NULL; l = l->next)
+    {
+      item = l->data;
+
+      /* Like the generic copy, ignoring errors */
+      if (data.error == NULL &&
+	  !g_cancellable_is_cancelled (cancellable))
+	g_file_copy_attributes (item->source, item->destination,
+				item->flags, cancellable, NULL);
+      copy_item_free (item);
+    }
+  g_list_free (data.done_dirs);
+
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+
+  if (data.error != NULL)
+    {
+      g_propagate_error (error, data.error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
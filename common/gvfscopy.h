@@ -0,0 +1,44 @@
+/* GIO - GLib Input, Output and Streaming Library
+ * 
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_COPY_H__
+#define __G_VFS_COPY_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* Files copied at the same time unless asked otherwise */
+#define G_VFS_COPY_DEFAULT_PARALLEL 8
+
+gboolean g_vfs_copy_recursive (GFile                  *source,
+			       GFile                  *destination,
+			       GFileCopyFlags          flags,
+			       guint                   max_parallel,
+			       GCancellable           *cancellable,
+			       GFileProgressCallback   progress_callback,
+			       gpointer                progress_callback_data,
+			       GError                **error);
+
+G_END_DECLS
+
+#endif /* __G_VFS_COPY_H__ */
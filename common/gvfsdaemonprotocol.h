@@ -30,8 +30,11 @@ G_BEGIN_DECLS
 #define G_VFS_DBUS_MOUNT_OP_OPEN_FOR_READ "OpenForRead"
 #define G_VFS_DBUS_MOUNT_OP_OPEN_FOR_WRITE "OpenForWrite"
 #define G_VFS_DBUS_MOUNT_OP_QUERY_INFO "QueryInfo"
+#define G_VFS_DBUS_MOUNT_OP_QUERY_INFO_MULTI "QueryInfoMulti"
 #define G_VFS_DBUS_MOUNT_OP_QUERY_FILESYSTEM_INFO "QueryFilesystemInfo"
+#define G_VFS_DBUS_MOUNT_OP_QUERY_DISK_USAGE "QueryDiskUsage"
 #define G_VFS_DBUS_MOUNT_OP_ENUMERATE "Enumerate"
+#define G_VFS_DBUS_MOUNT_OP_ENUMERATE_RECURSIVE "EnumerateRecursive"
 #define G_VFS_DBUS_MOUNT_OP_CREATE_DIR_MONITOR "CreateDirectoryMonitor"
 #define G_VFS_DBUS_MOUNT_OP_CREATE_FILE_MONITOR "CreateFileMonitor"
 #define G_VFS_DBUS_MOUNT_OP_MOUNT_MOUNTABLE "MountMountable"
@@ -49,14 +52,20 @@ G_BEGIN_DECLS
 #define G_VFS_DBUS_MOUNT_OP_MOVE "Move"
 #define G_VFS_DBUS_MOUNT_OP_PUSH "Push"
 #define G_VFS_DBUS_MOUNT_OP_PULL "Pull"
+#define G_VFS_DBUS_MOUNT_OP_PUSH_FROM_CHANNEL "PushFromChannel"
 #define G_VFS_DBUS_MOUNT_OP_SET_ATTRIBUTE "SetAttribute"
 #define G_VFS_DBUS_MOUNT_OP_QUERY_SETTABLE_ATTRIBUTES "QuerySettableAttributes"
 #define G_VFS_DBUS_MOUNT_OP_QUERY_WRITABLE_NAMESPACES "QueryWritableNamespaces"
 #define G_VFS_DBUS_MOUNT_OP_OPEN_ICON_FOR_READ "OpenIconForRead"
 
-/* Progress callback interface for copy and move */
+/* Progress callback interface for copy, move and disk usage.
+   Progress takes the uint64 bytes done and total, followed by the
+   uint64 files done and total for operations on several files. The
+   daemon sends it at most every 100 msecs or so, and once more with
+   the final numbers before the reply. */
 #define G_VFS_DBUS_PROGRESS_INTERFACE "org.gtk.vfs.Progress"
 #define G_VFS_DBUS_PROGRESS_OP_PROGRESS "Progress"
+#define G_VFS_DBUS_PROGRESS_OP_DISK_USAGE "DiskUsageProgress"
 
 /* mount daemons that support mounting more mounts implement this,
    and set the dbus name in the mountable description file */
@@ -71,6 +80,123 @@ G_BEGIN_DECLS
 #define G_VFS_DBUS_DAEMON_PATH "/org/gtk/vfs/Daemon"
 #define G_VFS_DBUS_OP_GET_CONNECTION "GetConnection"
 #define G_VFS_DBUS_OP_CANCEL "Cancel"
+/* Flow control for enumerators. A client that passes a uint32 credit
+   after the uri arg of Enumerate gets at most that many infos ahead of
+   what it consumed. It then sends EnumeratorCredit with its enumerator
+   object path and the number of infos it consumed, on the connection
+   the infos came on. G_VFS_ENUMERATOR_CREDIT_UNLIMITED lifts the
+   limit, e.g. when the enumerator is closed early. */
+#define G_VFS_DBUS_OP_ENUMERATOR_CREDIT "EnumeratorCredit"
+#define G_VFS_ENUMERATOR_CREDIT_UNLIMITED 0xffffffff
+#define G_VFS_ENUMERATOR_DEFAULT_CREDIT 2000
+
+/* Optional uint32 flags for Enumerate, after the credit. With
+   G_VFS_ENUMERATE_FLAG_SOCKET the daemon may reply with a uint32 fd
+   id instead of sending GotInfo and Done. The fd is a socket that
+   carries one record per info: a uint32 size in network byte order
+   and the info marshalled with gvfs_file_info_marshal_with_dict()
+   using one dictionary for the whole enumeration. A record of size 0
+   ends the enumeration. */
+#define G_VFS_ENUMERATE_FLAG_SOCKET (1<<0)
+
+/* EnumerateRecursive takes the path, the enumerator object path, the
+   attributes, the flags, the uri, a uint32 max depth (0 for no
+   limit, 1 for just the directory itself) and optionally a uint32
+   credit like for Enumerate. The daemon walks the tree
+   and sends GotInfo and Done like for Enumerate, with the path below
+   the directory as standard::name of each info. Symlinks to
+   directories are not followed. */
+
+/* QueryDiskUsage takes the path, uint32 flags and the object path of
+   a progress callback ("/org/gtk/vfs/void" for none). It replies with
+   the uint64 size, allocated size, number of directories and number
+   of files of the path and everything below it, not following
+   symlinks. While it runs, DiskUsageProgress is called on the
+   callback now and then with the same four uint64 counts so far.
+   Unreadable directories are skipped unless
+   G_VFS_DISK_USAGE_FLAG_REPORT_ANY_ERROR is set. */
+#define G_VFS_DISK_USAGE_FLAG_REPORT_ANY_ERROR (1<<0)
+
+/* PushFromChannel copies between two mounts without the data passing
+   through the client. The client opens the source for reading and
+   sends the stream fd to the destination daemon on the fd passing
+   socket of the connection. The call takes the destination path, the
+   uint32 id of that fd, the uint64 size of the source (for progress),
+   the uint32 GFileCopyFlags, the object path of a progress callback
+   ("/org/gtk/vfs/void" for none) and the uint32 pid of the client.
+   The destination daemon reads the source with the read stream
+   protocol and writes it like an OpenForWrite stream. */
+
+/* Set on top of the GFileCopyFlags of Push and Pull to make the
+   transfer resumable. The daemon then keeps a checkpoint of how much
+   reached the destination, and if the same transfer was interrupted
+   before it continues from there instead of starting over, as long as
+   neither the source nor the partial destination changed since.
+   Backends that can't resume ignore it. */
+#define G_VFS_TRANSFER_FLAG_RESUME (1U<<31)
+
+/* Job statistics of a daemon, on G_VFS_DBUS_DAEMON_PATH.
+   GetStats returns an array of G_VFS_STATS_ENTRY_TYPE_AS_STRING, one
+   for each backend and operation: backend object path, backend
+   display name, operation, number of jobs, failed jobs, bytes
+   transferred, then the total usecs and a latency histogram for each
+   of the queued, running (until the backend replied) and replying
+   (until the reply was delivered) phases. Histogram bucket 0 counts
+   jobs under G_VFS_STATS_FIRST_BUCKET_USECS, each following bucket
+   doubles the limit and the last one counts everything above.
+   The second return value is a G_VFS_STATS_BUFFER_POOL_TYPE_AS_STRING
+   for the read buffers of the whole daemon: allocations served from
+   the pool, allocations that hit the heap, bytes held idle by the
+   pool and bytes handed out. */
+#define G_VFS_DBUS_STATS_INTERFACE "org.gtk.vfs.Stats"
+#define G_VFS_DBUS_STATS_OP_GET_STATS "GetStats"
+#define G_VFS_DBUS_STATS_OP_RESET_STATS "ResetStats"
+
+#define G_VFS_STATS_N_BUCKETS 24
+#define G_VFS_STATS_FIRST_BUCKET_USECS 16
+
+#define G_VFS_STATS_ENTRY_TYPE_AS_STRING      \
+  DBUS_STRUCT_BEGIN_CHAR_AS_STRING            \
+    DBUS_TYPE_STRING_AS_STRING                \
+    DBUS_TYPE_STRING_AS_STRING                \
+    DBUS_TYPE_STRING_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_ARRAY_AS_STRING DBUS_TYPE_UINT32_AS_STRING \
+    DBUS_TYPE_ARRAY_AS_STRING DBUS_TYPE_UINT32_AS_STRING \
+    DBUS_TYPE_ARRAY_AS_STRING DBUS_TYPE_UINT32_AS_STRING \
+  DBUS_STRUCT_END_CHAR_AS_STRING
+
+#define G_VFS_STATS_BUFFER_POOL_TYPE_AS_STRING \
+  DBUS_STRUCT_BEGIN_CHAR_AS_STRING            \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+    DBUS_TYPE_UINT64_AS_STRING                \
+  DBUS_STRUCT_END_CHAR_AS_STRING
+
+/* QueryInfoMulti takes an array of G_VFS_QUERY_INFO_MULTI_PATH_TYPE_AS_STRING
+   (path and uri, the uri may be empty), the attributes and the flags.
+   It returns an array of G_VFS_QUERY_INFO_MULTI_RESULT_TYPE_AS_STRING
+   in the same order: whether the path succeeded, a GIOErrorEnum code
+   and message if not, and the info (empty on errors). */
+#define G_VFS_QUERY_INFO_MULTI_PATH_TYPE_AS_STRING \
+  DBUS_STRUCT_BEGIN_CHAR_AS_STRING                  \
+    DBUS_TYPE_ARRAY_AS_STRING DBUS_TYPE_BYTE_AS_STRING \
+    DBUS_TYPE_STRING_AS_STRING                      \
+  DBUS_STRUCT_END_CHAR_AS_STRING
+
+#define G_VFS_QUERY_INFO_MULTI_RESULT_TYPE_AS_STRING \
+  DBUS_STRUCT_BEGIN_CHAR_AS_STRING                  \
+    DBUS_TYPE_BOOLEAN_AS_STRING                     \
+    DBUS_TYPE_UINT32_AS_STRING                      \
+    DBUS_TYPE_STRING_AS_STRING                      \
+    G_FILE_INFO_TYPE_AS_STRING                      \
+  DBUS_STRUCT_END_CHAR_AS_STRING
 
 /* Used by the dbus-proxying implementation of GMoutOperation */
 #define G_VFS_DBUS_MOUNT_OPERATION_INTERFACE "org.gtk.vfs.MountOperation"
@@ -128,6 +254,12 @@ typedef struct {
 #define G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SEEK_SET 4
 #define G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SEEK_END 5
 #define G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_QUERY_INFO 6
+/* Seek and read in one request. arg1 and arg2 are the low and high
+   32 bits of the offset, the data is the size to read as a 32bit
+   integer in network order. Replies like a read, and reads continue
+   from after the returned data. Backends that can't read at an offset
+   fail this with G_IO_ERROR_NOT_SUPPORTED. */
+#define G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_PREAD 7
 
 /*
 read, readahead reply:
@@ -142,6 +274,11 @@ type, code, size, data (size bytes, 2 strings: domain, message)
 info:
 type,    0, size, data 
 
+shm data (only if shared memory was negotiated at open):
+type, seek_generation, size
+The data is in the shared memory ring, right after the data of the
+previous shm data reply.
+
 */
 
 typedef struct {
@@ -159,6 +296,28 @@ typedef struct {
 #define G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_WRITTEN  3
 #define G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_CLOSED   4
 #define G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_INFO     5
+#define G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SHM_DATA 6
+
+/* Optional flags argument of OpenForRead. If the client asks for shared
+   memory and the daemon supports it, the reply has two extra arguments,
+   the fd id of a memfd and the size of its data ring. The memfd starts
+   with a GVfsDaemonShmHeader, the ring follows at offset
+   G_VFS_DAEMON_SHM_HEADER_SIZE. The daemon uses the ring only once the
+   client has mapped it and set mapped, a client that can't map it just
+   leaves it unset. The daemon then copies read data into the ring at
+   increasing positions (modulo the ring size) and sends shm data
+   replies, the client publishes how far it has consumed in read_pos.
+   Data that doesn't fit is sent over the socket as usual. */
+#define G_VFS_DAEMON_OPEN_FLAG_SHM (1<<0)
+
+#define G_VFS_DAEMON_SHM_HEADER_SIZE 4096
+/* Room for a few reads of the largest size */
+#define G_VFS_DAEMON_SHM_RING_SIZE (2*1024*1024)
+
+typedef struct {
+  volatile guint32 read_pos; /* Written by the client */
+  volatile guint32 mapped;   /* Written by the client */
+} GVfsDaemonShmHeader;
 
 #define G_FILE_INFO_INNER_TYPE_AS_STRING         \
   DBUS_TYPE_ARRAY_AS_STRING			 \
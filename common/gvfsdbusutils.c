@@ -570,6 +570,11 @@ _g_error_from_dbus (DBusError *derror,
       
       g_set_error_literal (error, domain, code, derror->message);
     }
+  /* Daemons that predate an operation, callers fall back like
+     for backends that don't implement it */
+  else if (dbus_error_has_name (derror, DBUS_ERROR_UNKNOWN_METHOD))
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		 "DBus error %s: %s", derror->name, derror->message);
   /* TODO: Special case other types, like DBUS_ERROR_NO_MEMORY etc? */
   else
     g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
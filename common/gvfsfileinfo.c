@@ -26,6 +26,14 @@
 #include <string.h>
 #include "gvfsfileinfo.h"
 
+/* When many infos are sent one after the other, each attribute name
+ * is only sent the first time. Both sides number the names in the
+ * order they first appear, and later infos use that number. */
+struct _GVfsFileInfoDict {
+  GHashTable *ids;    /* name -> id + 1, when marshalling */
+  GPtrArray *names;   /* id -> name */
+};
+
 static void
 put_string (GDataOutputStream *out,
 	    const char *str)
@@ -92,9 +100,85 @@ read_stringv (GDataInputStream *in)
   return strv;
 }
 
-char *
-gvfs_file_info_marshal (GFileInfo *info,
-			gsize     *size)
+GVfsFileInfoDict *
+gvfs_file_info_dict_new (void)
+{
+  GVfsFileInfoDict *dict;
+
+  dict = g_new0 (GVfsFileInfoDict, 1);
+  dict->ids = g_hash_table_new (g_str_hash, g_str_equal);
+  dict->names = g_ptr_array_new_with_free_func (g_free);
+
+  return dict;
+}
+
+void
+gvfs_file_info_dict_free (GVfsFileInfoDict *dict)
+{
+  g_hash_table_destroy (dict->ids);
+  g_ptr_array_free (dict->names, TRUE);
+  g_free (dict);
+}
+
+static void
+put_attribute_name (GDataOutputStream *out,
+		    GVfsFileInfoDict *dict,
+		    const char *attr)
+{
+  guint id;
+  char *name;
+
+  if (dict == NULL)
+    {
+      put_string (out, attr);
+      return;
+    }
+
+  id = GPOINTER_TO_UINT (g_hash_table_lookup (dict->ids, attr));
+  if (id != 0)
+    {
+      g_data_output_stream_put_uint16 (out, id - 1, NULL, NULL);
+      return;
+    }
+
+  /* A new name, id is the next free one and the name follows */
+  id = dict->names->len;
+  g_data_output_stream_put_uint16 (out, id, NULL, NULL);
+  put_string (out, attr);
+
+  if (id < G_MAXUINT16)
+    {
+      name = g_strdup (attr);
+      g_ptr_array_add (dict->names, name);
+      g_hash_table_insert (dict->ids, name, GUINT_TO_POINTER (id + 1));
+    }
+}
+
+static char *
+read_attribute_name (GDataInputStream *in,
+		     GVfsFileInfoDict *dict)
+{
+  guint id;
+  char *name;
+
+  if (dict == NULL)
+    return read_string (in);
+
+  id = g_data_input_stream_read_uint16 (in, NULL, NULL);
+  if (id < dict->names->len)
+    return g_strdup (g_ptr_array_index (dict->names, id));
+
+  name = read_string (in);
+  if (id == dict->names->len && id < G_MAXUINT16)
+    g_ptr_array_add (dict->names, g_strdup (name));
+
+  return name;
+}
+
+static char *
+marshal_info (GFileInfo *info,
+	      GVfsFileInfoDict *dict,
+	      gsize     *size)
 {
   GOutputStream *memstream;
   GDataOutputStream *out;
@@ -123,7 +207,7 @@ gvfs_file_info_marshal (GFileInfo *info,
       type = g_file_info_get_attribute_type  (info, attr);
       status = g_file_info_get_attribute_status  (info, attr);
       
-      put_string (out, attr);
+      put_attribute_name (out, dict, attr);
       g_data_output_stream_put_byte (out, type, 
 				     NULL, NULL);
       g_data_output_stream_put_byte (out, status, 
@@ -203,9 +287,27 @@ gvfs_file_info_marshal (GFileInfo *info,
   return data;
 }
 
-GFileInfo *
-gvfs_file_info_demarshal (char      *data,
-			  gsize      size)
+char *
+gvfs_file_info_marshal (GFileInfo *info,
+			gsize     *size)
+{
+  return marshal_info (info, NULL, size);
+}
+
+/* Like gvfs_file_info_marshal(), but the result must be demarshalled
+   with gvfs_file_info_demarshal_with_dict() in the same order */
+char *
+gvfs_file_info_marshal_with_dict (GFileInfo        *info,
+				  GVfsFileInfoDict *dict,
+				  gsize            *size)
+{
+  return marshal_info (info, dict, size);
+}
+
+static GFileInfo *
+demarshal_info (char      *data,
+		gsize      size,
+		GVfsFileInfoDict *dict)
 {
   guint32 num_attrs, i;
   GInputStream *memstream;
@@ -226,7 +328,7 @@ gvfs_file_info_demarshal (char      *data,
 
   for (i = 0; i < num_attrs; i++)
     {
-      attr = read_string (in);
+      attr = read_attribute_name (in, dict);
       type = g_data_input_stream_read_byte (in, NULL, NULL);
       status = g_data_input_stream_read_byte (in, NULL, NULL);
 
@@ -316,4 +418,17 @@ gvfs_file_info_demarshal (char      *data,
   return info;
 }
 
+GFileInfo *
+gvfs_file_info_demarshal (char      *data,
+			  gsize      size)
+{
+  return demarshal_info (data, size, NULL);
+}
 
+GFileInfo *
+gvfs_file_info_demarshal_with_dict (char             *data,
+				    gsize             size,
+				    GVfsFileInfoDict *dict)
+{
+  return demarshal_info (data, size, dict);
+}
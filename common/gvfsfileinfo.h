@@ -27,11 +27,22 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GVfsFileInfoDict GVfsFileInfoDict;
+
 char *     gvfs_file_info_marshal   (GFileInfo *info,
 				     gsize     *size);
 GFileInfo *gvfs_file_info_demarshal (char      *data,
 				     gsize      size);
 
+GVfsFileInfoDict *gvfs_file_info_dict_new             (void);
+void              gvfs_file_info_dict_free            (GVfsFileInfoDict *dict);
+char *            gvfs_file_info_marshal_with_dict   (GFileInfo        *info,
+						       GVfsFileInfoDict *dict,
+						       gsize            *size);
+GFileInfo *       gvfs_file_info_demarshal_with_dict (char             *data,
+						       gsize             size,
+						       GVfsFileInfoDict *dict);
+
 G_END_DECLS
 
 #endif /* __G_VFS_FILE_INFO_H__ */
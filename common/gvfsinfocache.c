@@ -0,0 +1,373 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "gvfsinfocache.h"
+
+/* Keeps the GFileInfos a backend returned for query_info and
+ * enumerate, so that repeated stats of the same file don't need to go
+ * to the backend. An info is only reused for the same attributes and
+ * flags, and only until its TTL runs out. Mutating jobs invalidate
+ * the file, everything below it and its parent directory, and bump
+ * the generation so that infos read before the change are not
+ * inserted afterwards. The least recently used infos are dropped when
+ * the estimated size exceeds the memory limit. */
+
+/* Rough cost of one attribute in a GFileInfo */
+#define ATTRIBUTE_SIZE 64
+
+typedef struct {
+  char *path;
+  char *attributes;
+  GFileQueryInfoFlags flags;
+  GFileInfo *info;
+  gint64 expire_time;
+  gsize size;
+  GList link;     /* in cache->lru, data is the item */
+} CacheItem;
+
+struct _GVfsInfoCache {
+  GMutex lock;
+  GHashTable *items;  /* path -> GList of CacheItem, one per attributes/flags */
+  GQueue lru;         /* most recently used first */
+  gsize bytes;
+  guint generation;
+
+  guint ttl_msecs;    /* 0 == disabled */
+  gsize max_bytes;
+};
+
+/* Backends get paths from the client that are already absolute and
+ * without "." or "..", but may have extra slashes */
+static char *
+canonical_path (const char *path)
+{
+  GString *s;
+  const char *p;
+
+  s = g_string_sized_new (strlen (path) + 1);
+  for (p = path; *p != 0; p++)
+    {
+      if (*p == '/' && s->len > 0 && s->str[s->len - 1] == '/')
+	continue;
+      g_string_append_c (s, *p);
+    }
+
+  if (s->len > 1 && s->str[s->len - 1] == '/')
+    g_string_truncate (s, s->len - 1);
+  if (s->len == 0)
+    g_string_append_c (s, '/');
+
+  return g_string_free (s, FALSE);
+}
+
+/* Called with the lock held, the item must be removed from items */
+static void
+item_free_unlocked (GVfsInfoCache *cache,
+		    CacheItem     *item)
+{
+  g_queue_unlink (&cache->lru, &item->link);
+  cache->bytes -= item->size;
+
+  g_free (item->path);
+  g_free (item->attributes);
+  g_object_unref (item->info);
+  g_slice_free (CacheItem, item);
+}
+
+/* Called with the lock held */
+static void
+remove_item_unlocked (GVfsInfoCache *cache,
+		      CacheItem     *item)
+{
+  GList *list;
+
+  list = g_hash_table_lookup (cache->items, item->path);
+  list = g_list_remove (list, item);
+  if (list == NULL)
+    g_hash_table_remove (cache->items, item->path);
+  else
+    g_hash_table_insert (cache->items, g_strdup (item->path), list);
+
+  item_free_unlocked (cache, item);
+}
+
+/* Called with the lock held */
+static CacheItem *
+find_item_unlocked (GVfsInfoCache       *cache,
+		    const char          *path,
+		    const char          *attributes,
+		    GFileQueryInfoFlags  flags)
+{
+  CacheItem *item;
+  GList *l;
+
+  for (l = g_hash_table_lookup (cache->items, path); l != NULL; l = l->next)
+    {
+      item = l->data;
+      if (item->flags == flags &&
+	  strcmp (item->attributes, attributes) == 0)
+	return item;
+    }
+
+  return NULL;
+}
+
+/* Called with the lock held */
+static void
+shrink_unlocked (GVfsInfoCache *cache,
+		 gsize          max_bytes)
+{
+  while (cache->bytes > max_bytes)
+    remove_item_unlocked (cache, g_queue_peek_tail (&cache->lru));
+}
+
+GVfsInfoCache *
+g_vfs_info_cache_new (void)
+{
+  GVfsInfoCache *cache;
+
+  cache = g_new0 (GVfsInfoCache, 1);
+  g_mutex_init (&cache->lock);
+  cache->items = g_hash_table_new_full (g_str_hash, g_str_equal,
+					g_free, NULL);
+  g_queue_init (&cache->lru);
+
+  return cache;
+}
+
+void
+g_vfs_info_cache_free (GVfsInfoCache *cache)
+{
+  shrink_unlocked (cache, 0);
+  g_hash_table_destroy (cache->items);
+  g_mutex_clear (&cache->lock);
+  g_free (cache);
+}
+
+/**
+ * g_vfs_info_cache_set_limits:
+ * @cache: a #GVfsInfoCache
+ * @ttl_msecs: how long an info may be reused, 0 disables the cache
+ * @max_bytes: estimated memory the cached infos may use
+ **/
+void
+g_vfs_info_cache_set_limits (GVfsInfoCache *cache,
+			     guint          ttl_msecs,
+			     gsize          max_bytes)
+{
+  g_mutex_lock (&cache->lock);
+  cache->ttl_msecs = ttl_msecs;
+  cache->max_bytes = max_bytes;
+  shrink_unlocked (cache, ttl_msecs == 0 ? 0 : max_bytes);
+  g_mutex_unlock (&cache->lock);
+}
+
+/**
+ * g_vfs_info_cache_get_generation:
+ * @cache: a #GVfsInfoCache
+ *
+ * Gets the current generation, to be passed to
+ * g_vfs_info_cache_insert() for an info that is read after this call.
+ * May be called from any thread.
+ **/
+guint
+g_vfs_info_cache_get_generation (GVfsInfoCache *cache)
+{
+  guint generation;
+
+  g_mutex_lock (&cache->lock);
+  generation = cache->generation;
+  g_mutex_unlock (&cache->lock);
+
+  return generation;
+}
+
+/**
+ * g_vfs_info_cache_lookup:
+ * @cache: a #GVfsInfoCache
+ * @path: the backend filename
+ * @attributes: the attributes that were asked for
+ * @flags: the query flags
+ *
+ * Looks for an info of @path that was read with exactly the same
+ * @attributes and @flags and did not expire yet. May be called from
+ * any thread.
+ *
+ * Returns: a copy of the cached info, or %NULL
+ **/
+GFileInfo *
+g_vfs_info_cache_lookup (GVfsInfoCache       *cache,
+			 const char          *path,
+			 const char          *attributes,
+			 GFileQueryInfoFlags  flags)
+{
+  CacheItem *item;
+  GFileInfo *info;
+  char *canonical;
+
+  canonical = canonical_path (path);
+  info = NULL;
+
+  g_mutex_lock (&cache->lock);
+  item = NULL;
+  if (cache->ttl_msecs != 0)
+    item = find_item_unlocked (cache, canonical, attributes, flags);
+  if (item != NULL)
+    {
+      if (g_get_monotonic_time () >= item->expire_time)
+	remove_item_unlocked (cache, item);
+      else
+	{
+	  g_queue_unlink (&cache->lru, &item->link);
+	  g_queue_push_head_link (&cache->lru, &item->link);
+	  info = g_file_info_dup (item->info);
+	}
+    }
+  g_mutex_unlock (&cache->lock);
+
+  g_free (canonical);
+
+  return info;
+}
+
+/**
+ * g_vfs_info_cache_insert:
+ * @cache: a #GVfsInfoCache
+ * @generation: the generation from before @info was read
+ * @path: the backend filename
+ * @attributes: the attributes that were asked for
+ * @flags: the query flags
+ * @info: the info the backend returned, it is copied
+ *
+ * Caches @info, unless something was invalidated since @generation.
+ * May be called from any thread.
+ **/
+void
+g_vfs_info_cache_insert (GVfsInfoCache       *cache,
+			 guint                generation,
+			 const char          *path,
+			 const char          *attributes,
+			 GFileQueryInfoFlags  flags,
+			 GFileInfo           *info)
+{
+  CacheItem *item, *old;
+  GList *list;
+  char **names;
+
+  item = g_slice_new0 (CacheItem);
+  item->path = canonical_path (path);
+  item->attributes = g_strdup (attributes);
+  item->flags = flags;
+  item->info = g_file_info_dup (info);
+  item->link.data = item;
+
+  names = g_file_info_list_attributes (info, NULL);
+  item->size = sizeof (CacheItem) + strlen (item->path) + strlen (attributes) +
+    g_strv_length (names) * ATTRIBUTE_SIZE;
+  g_strfreev (names);
+
+  g_mutex_lock (&cache->lock);
+
+  if (cache->ttl_msecs == 0 ||
+      generation != cache->generation ||
+      item->size > cache->max_bytes)
+    {
+      g_mutex_unlock (&cache->lock);
+      g_free (item->path);
+      g_free (item->attributes);
+      g_object_unref (item->info);
+      g_slice_free (CacheItem, item);
+      return;
+    }
+
+  old = find_item_unlocked (cache, item->path, attributes, flags);
+  if (old != NULL)
+    remove_item_unlocked (cache, old);
+
+  item->expire_time = g_get_monotonic_time () + (gint64)cache->ttl_msecs * 1000;
+
+  list = g_hash_table_lookup (cache->items, item->path);
+  g_hash_table_insert (cache->items, g_strdup (item->path),
+		       g_list_prepend (list, item));
+  g_queue_push_head_link (&cache->lru, &item->link);
+  cache->bytes += item->size;
+
+  shrink_unlocked (cache, cache->max_bytes);
+
+  g_mutex_unlock (&cache->lock);
+}
+
+/**
+ * g_vfs_info_cache_invalidate:
+ * @cache: a #GVfsInfoCache
+ * @path: the backend filename that is changed
+ *
+ * Forgets the infos of @path, of everything below it and of its
+ * parent directory, and makes infos read before this call not go into
+ * the cache. Call it before and after changing a file. May be called
+ * from any thread.
+ **/
+void
+g_vfs_info_cache_invalidate (GVfsInfoCache *cache,
+			     const char    *path)
+{
+  GHashTableIter iter;
+  const char *key;
+  GList *list, *l;
+  char *canonical, *parent;
+  gsize len;
+
+  canonical = canonical_path (path);
+  parent = g_path_get_dirname (canonical);
+  len = strlen (canonical);
+
+  g_mutex_lock (&cache->lock);
+
+  cache->generation++;
+
+  g_hash_table_iter_init (&iter, cache->items);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&list))
+    {
+      if (strcmp (key, canonical) == 0 ||
+	  strcmp (key, parent) == 0 ||
+	  strcmp (canonical, "/") == 0 ||
+	  (strncmp (key, canonical, len) == 0 && key[len] == '/'))
+	{
+	  for (l = list; l != NULL; l = l->next)
+	    item_free_unlocked (cache, l->data);
+	  g_list_free (list);
+	  g_hash_table_iter_remove (&iter);
+	}
+    }
+
+  g_mutex_unlock (&cache->lock);
+
+  g_free (canonical);
+  g_free (parent);
+}
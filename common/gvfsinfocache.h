@@ -0,0 +1,53 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_INFO_CACHE_H__
+#define __G_VFS_INFO_CACHE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GVfsInfoCache GVfsInfoCache;
+
+GVfsInfoCache *g_vfs_info_cache_new            (void);
+void           g_vfs_info_cache_free           (GVfsInfoCache       *cache);
+void           g_vfs_info_cache_set_limits     (GVfsInfoCache       *cache,
+						guint                ttl_msecs,
+						gsize                max_bytes);
+guint          g_vfs_info_cache_get_generation (GVfsInfoCache       *cache);
+GFileInfo *    g_vfs_info_cache_lookup         (GVfsInfoCache       *cache,
+						const char          *path,
+						const char          *attributes,
+						GFileQueryInfoFlags  flags);
+void           g_vfs_info_cache_insert         (GVfsInfoCache       *cache,
+						guint                generation,
+						const char          *path,
+						const char          *attributes,
+						GFileQueryInfoFlags  flags,
+						GFileInfo           *info);
+void           g_vfs_info_cache_invalidate     (GVfsInfoCache       *cache,
+						const char          *path);
+
+G_END_DECLS
+
+#endif /* __G_VFS_INFO_CACHE_H__ */
@@ -34,11 +34,15 @@
 #include "gvfsbackend.h"
 #include "gvfsjobsource.h"
 #include "gvfsdaemonprotocol.h"
+#include "gvfsthumbnailindex.h"
 #include <gvfsjobopenforread.h>
 #include <gvfsjobopeniconforread.h>
 #include <gvfsjobopenforwrite.h>
 #include <gvfsjobqueryinfo.h>
+#include <gvfsjobqueryinfomulti.h>
+#include <gvfsjobenumeraterecursive.h>
 #include <gvfsjobqueryfsinfo.h>
+#include <gvfsjobquerydiskusage.h>
 #include <gvfsjobsetdisplayname.h>
 #include <gvfsjobenumerate.h>
 #include <gvfsjobdelete.h>
@@ -56,6 +60,7 @@
 #include <gvfsjobmove.h>
 #include <gvfsjobpush.h>
 #include <gvfsjobpull.h>
+#include <gvfsjobpushfromchannel.h>
 #include <gvfsjobsetattribute.h>
 #include <gvfsjobqueryattributes.h>
 #include <gvfsdbusutils.h>
@@ -81,6 +86,10 @@ struct _GVfsBackendPrivate
   char *default_location;
   GMountSpec *mount_spec;
   gboolean block_requests;
+  guint max_job_threads;
+  guint channel_pipeline_depth;
+  gsize write_behind_size;
+  GVfsInfoCache *info_cache;
 };
 
 
@@ -158,6 +167,7 @@ g_vfs_backend_finalize (GObject *object)
   g_free (backend->priv->default_location);
   if (backend->priv->mount_spec)
     g_mount_spec_unref (backend->priv->mount_spec);
+  g_vfs_info_cache_free (backend->priv->info_cache);
   
   if (G_OBJECT_CLASS (g_vfs_backend_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_vfs_backend_parent_class)->finalize) (object);
@@ -208,6 +218,8 @@ g_vfs_backend_init (GVfsBackend *backend)
   backend->priv->stable_name = g_strdup ("");
   backend->priv->user_visible = TRUE;
   backend->priv->default_location = g_strdup ("");
+  backend->priv->channel_pipeline_depth = 1;
+  backend->priv->info_cache = g_vfs_info_cache_new ();
 }
 
 static void
@@ -400,6 +412,145 @@ g_vfs_backend_set_mount_spec (GVfsBackend *backend,
   backend->priv->mount_spec = g_mount_spec_ref (mount_spec);
 }
 
+/**
+ * g_vfs_backend_set_max_job_threads:
+ * @backend: backend
+ * @max_job_threads: the number of blocking jobs that may run in parallel,
+ *     or 0 for the daemon default
+ *
+ * Backends whose non-try_ calls are safe to run concurrently can use
+ * this to tell the daemon how many of them it may run at the same time,
+ * for instance the number of connections to the server. The daemon
+ * never uses more threads than set by g_vfs_daemon_set_max_threads().
+ *
+ * This may be called at any time, e.g. when the backend finds out
+ * that the server limits the number of connections. It takes the
+ * daemon lock, so don't hold backend locks while calling it.
+ **/
+void
+g_vfs_backend_set_max_job_threads (GVfsBackend *backend,
+				   guint        max_job_threads)
+{
+  backend->priv->max_job_threads = max_job_threads;
+  g_vfs_daemon_update_thread_limit (backend->priv->daemon);
+}
+
+guint
+g_vfs_backend_get_max_job_threads (GVfsBackend *backend)
+{
+  return backend->priv->max_job_threads;
+}
+
+/**
+ * g_vfs_backend_set_channel_pipeline_depth:
+ * @backend: backend
+ * @depth: the number of reads or writes that may be in progress at
+ *     the same time on a stream, at least 1
+ *
+ * By default a stream channel runs one request at a time. Backends
+ * that can have several reads or writes outstanding on a handle, like
+ * pipelined network protocols, can set a larger depth to hide the
+ * round-trip time. Such backends must apply the requests in the order
+ * they are started and keep track of the stream position themselves
+ * when a request is issued. Replies are always sent in request order,
+ * and seek, query info and close requests wait for all earlier
+ * requests to finish. If one fails, the later ones that are already
+ * running fail too, and further reads and writes fail until the
+ * client seeks.
+ **/
+void
+g_vfs_backend_set_channel_pipeline_depth (GVfsBackend *backend,
+					  guint        depth)
+{
+  backend->priv->channel_pipeline_depth = MAX (depth, 1);
+}
+
+guint
+g_vfs_backend_get_channel_pipeline_depth (GVfsBackend *backend)
+{
+  return backend->priv->channel_pipeline_depth;
+}
+
+/**
+ * g_vfs_backend_set_write_behind_size:
+ * @backend: backend
+ * @size: how many bytes a write stream may buffer, or 0 to disable
+ *
+ * Enables write-behind for write streams of the backend. Small writes
+ * are then acknowledged right away and collected into writes of up to
+ * @size bytes. The buffer is written out when it is full, when the
+ * stream is idle for a moment, and before seek, query info or close.
+ * A failed write is reported on the next request of the stream, and
+ * later writes fail until the stream is seeked.
+ *
+ * Only use this for backends where later errors are acceptable and
+ * writes are much cheaper in large chunks. The GVFS_WRITE_BEHIND_SIZE
+ * environment variable overrides the size.
+ **/
+void
+g_vfs_backend_set_write_behind_size (GVfsBackend *backend,
+				     gsize        size)
+{
+  const char *env;
+
+  env = g_getenv ("GVFS_WRITE_BEHIND_SIZE");
+  if (env != NULL)
+    size = g_ascii_strtoull (env, NULL, 10);
+
+  backend->priv->write_behind_size = size;
+}
+
+gsize
+g_vfs_backend_get_write_behind_size (GVfsBackend *backend)
+{
+  return backend->priv->write_behind_size;
+}
+
+/**
+ * g_vfs_backend_set_info_cache_limits:
+ * @backend: backend
+ * @ttl_msecs: how long a file info may be reused, or 0 to disable
+ * @max_bytes: estimated memory the cached infos may use
+ *
+ * Lets the daemon keep the infos returned by query_info and enumerate
+ * for a short while and answer identical queries from them. Jobs that
+ * change a file through the backend invalidate it, but changes made
+ * by others are only seen once the TTL passed. So the cache is off
+ * unless a backend turns it on, which only makes sense where a round
+ * trip costs much more than a slightly stale info. The
+ * GVFS_INFO_CACHE_TTL environment variable overrides the TTL of those
+ * backends, in milliseconds.
+ **/
+void
+g_vfs_backend_set_info_cache_limits (GVfsBackend *backend,
+				     guint        ttl_msecs,
+				     gsize        max_bytes)
+{
+  const char *env;
+
+  env = g_getenv ("GVFS_INFO_CACHE_TTL");
+  if (env != NULL && ttl_msecs != 0)
+    ttl_msecs = g_ascii_strtoull (env, NULL, 10);
+
+  g_vfs_info_cache_set_limits (backend->priv->info_cache,
+			       ttl_msecs, max_bytes);
+}
+
+GVfsInfoCache *
+g_vfs_backend_get_info_cache (GVfsBackend *backend)
+{
+  return backend->priv->info_cache;
+}
+
+/* Called by jobs that change filename, before and after the change.
+ * Might be called on an i/o thread. */
+void
+g_vfs_backend_invalidate_info (GVfsBackend *backend,
+			       const char  *filename)
+{
+  g_vfs_info_cache_invalidate (backend->priv->info_cache, filename);
+}
+
 const char *
 g_vfs_backend_get_backend_type (GVfsBackend *backend)
 {
@@ -444,42 +595,6 @@ g_vfs_backend_get_mount_spec (GVfsBackend *backend)
   return backend->priv->mount_spec;
 }
 
-static void
-get_thumbnail_attributes (const char *uri,
-                          GFileInfo  *info)
-{
-  GChecksum *checksum;
-  char *filename;
-  char *basename;
-
-  checksum = g_checksum_new (G_CHECKSUM_MD5);
-  g_checksum_update (checksum, (const guchar *) uri, strlen (uri));
-
-  basename = g_strconcat (g_checksum_get_string (checksum), ".png", NULL);
-  g_checksum_free (checksum);
-
-  filename = g_build_filename (g_get_home_dir (),
-                               ".thumbnails", "normal", basename,
-                               NULL);
-
-  if (g_file_test (filename, G_FILE_TEST_IS_REGULAR))
-    g_file_info_set_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH, filename);
-  else
-    {
-      g_free (filename);
-      filename = g_build_filename (g_get_home_dir (),
-                                   ".thumbnails", "fail",
-                                   "gnome-thumbnail-factory",
-                                   basename,
-                                   NULL);
-      
-      if (g_file_test (filename, G_FILE_TEST_IS_REGULAR))
-	g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_THUMBNAILING_FAILED, TRUE);
-    }
-  g_free (basename);
-  g_free (filename);
-}
-
 void
 g_vfs_backend_add_auto_info (GVfsBackend *backend,
 			     GFileAttributeMatcher *matcher,
@@ -506,7 +621,7 @@ g_vfs_backend_add_auto_info (GVfsBackend *backend,
   if (uri != NULL &&
       g_file_attribute_matcher_matches (matcher,
 					G_FILE_ATTRIBUTE_THUMBNAIL_PATH))
-    get_thumbnail_attributes (uri, info);
+    g_vfs_thumbnail_index_add_info (uri, info);
   
 }
 
@@ -568,14 +683,26 @@ backend_dbus_handler (DBusConnection  *connection,
 					G_VFS_DBUS_MOUNT_INTERFACE,
 					G_VFS_DBUS_MOUNT_OP_QUERY_INFO))
     job = g_vfs_job_query_info_new (connection, message, backend);
+  else if (dbus_message_is_method_call (message,
+					G_VFS_DBUS_MOUNT_INTERFACE,
+					G_VFS_DBUS_MOUNT_OP_QUERY_INFO_MULTI))
+    job = g_vfs_job_query_info_multi_new (connection, message, backend);
   else if (dbus_message_is_method_call (message,
 					G_VFS_DBUS_MOUNT_INTERFACE,
 					G_VFS_DBUS_MOUNT_OP_QUERY_FILESYSTEM_INFO))
     job = g_vfs_job_query_fs_info_new (connection, message, backend);
+  else if (dbus_message_is_method_call (message,
+					G_VFS_DBUS_MOUNT_INTERFACE,
+					G_VFS_DBUS_MOUNT_OP_QUERY_DISK_USAGE))
+    job = g_vfs_job_query_disk_usage_new (connection, message, backend);
   else if (dbus_message_is_method_call (message,
 					G_VFS_DBUS_MOUNT_INTERFACE,
 					G_VFS_DBUS_MOUNT_OP_ENUMERATE))
     job = g_vfs_job_enumerate_new (connection, message, backend);
+  else if (dbus_message_is_method_call (message,
+					G_VFS_DBUS_MOUNT_INTERFACE,
+					G_VFS_DBUS_MOUNT_OP_ENUMERATE_RECURSIVE))
+    job = g_vfs_job_enumerate_recursive_new (connection, message, backend);
   else if (dbus_message_is_method_call (message,
 					G_VFS_DBUS_MOUNT_INTERFACE,
 					G_VFS_DBUS_MOUNT_OP_OPEN_FOR_WRITE))
@@ -636,6 +763,10 @@ backend_dbus_handler (DBusConnection  *connection,
 					G_VFS_DBUS_MOUNT_INTERFACE,
 					G_VFS_DBUS_MOUNT_OP_PULL))
     job = g_vfs_job_pull_new (connection, message, backend);
+  else if (dbus_message_is_method_call (message,
+					G_VFS_DBUS_MOUNT_INTERFACE,
+					G_VFS_DBUS_MOUNT_OP_PUSH_FROM_CHANNEL))
+    job = g_vfs_job_push_from_channel_new (connection, message, backend);
   else if (dbus_message_is_method_call (message,
 					G_VFS_DBUS_MOUNT_INTERFACE,
 					G_VFS_DBUS_MOUNT_OP_MOVE))
@@ -27,6 +27,7 @@
 #include <gio/gio.h>
 #include <gvfsdaemon.h>
 #include <gvfsjob.h>
+#include <gvfsinfocache.h>
 #include <gmountspec.h>
 #include <gvfsdbusutils.h>
 
@@ -60,9 +61,11 @@ typedef struct _GVfsJobWrite            GVfsJobWrite;
 typedef struct _GVfsJobSeekWrite        GVfsJobSeekWrite;
 typedef struct _GVfsJobCloseWrite       GVfsJobCloseWrite;
 typedef struct _GVfsJobQueryInfo        GVfsJobQueryInfo;
+typedef struct _GVfsJobQueryInfoMulti   GVfsJobQueryInfoMulti;
 typedef struct _GVfsJobQueryInfoRead    GVfsJobQueryInfoRead;
 typedef struct _GVfsJobQueryInfoWrite   GVfsJobQueryInfoWrite;
 typedef struct _GVfsJobQueryFsInfo      GVfsJobQueryFsInfo;
+typedef struct _GVfsJobQueryDiskUsage   GVfsJobQueryDiskUsage;
 typedef struct _GVfsJobEnumerate        GVfsJobEnumerate;
 typedef struct _GVfsJobSetDisplayName   GVfsJobSetDisplayName;
 typedef struct _GVfsJobTrash            GVfsJobTrash;
@@ -184,6 +187,20 @@ struct _GVfsBackendClass
 				 GVfsBackendHandle handle,
 				 goffset    offset,
 				 GSeekType  type);
+  /* Like seek_on_read to offset followed by read, the handle is
+     left positioned after the data read. Optional. */
+  void     (*read_at)           (GVfsBackend *backend,
+				 GVfsJobRead *job,
+				 GVfsBackendHandle handle,
+				 goffset offset,
+				 char *buffer,
+				 gsize bytes_requested);
+  gboolean (*try_read_at)       (GVfsBackend *backend,
+				 GVfsJobRead *job,
+				 GVfsBackendHandle handle,
+				 goffset offset,
+				 char *buffer,
+				 gsize bytes_requested);
   gboolean (*try_create)        (GVfsBackend *backend,
 				 GVfsJobOpenForWrite *job,
 				 const char *filename,
@@ -250,6 +267,19 @@ struct _GVfsBackendClass
 				 GFileQueryInfoFlags flags,
 				 GFileInfo *info,
 				 GFileAttributeMatcher *attribute_matcher);
+  /* Optional, without them every path is a query_info job */
+  void     (*query_info_multi)  (GVfsBackend *backend,
+				 GVfsJobQueryInfoMulti *job,
+				 char **filenames,
+				 GFileQueryInfoFlags flags,
+				 GFileInfo **infos,
+				 GFileAttributeMatcher *attribute_matcher);
+  gboolean (*try_query_info_multi) (GVfsBackend *backend,
+				 GVfsJobQueryInfoMulti *job,
+				 char **filenames,
+				 GFileQueryInfoFlags flags,
+				 GFileInfo **infos,
+				 GFileAttributeMatcher *attribute_matcher);
   void     (*query_info_on_read)(GVfsBackend *backend,
 				 GVfsJobQueryInfoRead *job,
 				 GVfsBackendHandle handle,
@@ -280,6 +310,17 @@ struct _GVfsBackendClass
 				 const char *filename,
 				 GFileInfo *info,
 				 GFileAttributeMatcher *attribute_matcher);
+  /* Optional, without them the daemon walks the tree with
+     query_info and enumerate. Report the totals with
+     g_vfs_job_query_disk_usage_set_result(). */
+  void     (*query_disk_usage)  (GVfsBackend *backend,
+				 GVfsJobQueryDiskUsage *job,
+				 const char *filename,
+				 guint32 flags);
+  gboolean (*try_query_disk_usage) (GVfsBackend *backend,
+				 GVfsJobQueryDiskUsage *job,
+				 const char *filename,
+				 guint32 flags);
   void     (*enumerate)         (GVfsBackend *backend,
 				 GVfsJobEnumerate *job,
 				 const char *filename,
@@ -477,6 +518,15 @@ void        g_vfs_backend_set_default_location           (GVfsBackend        *ba
 							  const char         *location);
 void        g_vfs_backend_set_mount_spec                 (GVfsBackend        *backend,
 							  GMountSpec         *mount_spec);
+void        g_vfs_backend_set_max_job_threads            (GVfsBackend        *backend,
+							  guint               max_job_threads);
+void        g_vfs_backend_set_channel_pipeline_depth     (GVfsBackend        *backend,
+							  guint               depth);
+void        g_vfs_backend_set_write_behind_size          (GVfsBackend        *backend,
+							  gsize               size);
+void        g_vfs_backend_set_info_cache_limits          (GVfsBackend        *backend,
+							  guint               ttl_msecs,
+							  gsize               max_bytes);
 void        g_vfs_backend_register_mount                 (GVfsBackend        *backend,
 							  GAsyncDBusCallback  callback,
 							  gpointer            user_data);
@@ -490,6 +540,12 @@ char      **g_vfs_backend_get_x_content_types            (GVfsBackend        *ba
 GIcon      *g_vfs_backend_get_icon                       (GVfsBackend        *backend);
 const char *g_vfs_backend_get_default_location           (GVfsBackend        *backend);
 GMountSpec *g_vfs_backend_get_mount_spec                 (GVfsBackend        *backend);
+guint       g_vfs_backend_get_max_job_threads            (GVfsBackend        *backend);
+guint       g_vfs_backend_get_channel_pipeline_depth     (GVfsBackend        *backend);
+gsize       g_vfs_backend_get_write_behind_size          (GVfsBackend        *backend);
+GVfsInfoCache *g_vfs_backend_get_info_cache              (GVfsBackend        *backend);
+void        g_vfs_backend_invalidate_info                (GVfsBackend        *backend,
+							  const char         *filename);
 GVfsDaemon *g_vfs_backend_get_daemon                     (GVfsBackend        *backend);
 gboolean    g_vfs_backend_is_mounted                     (GVfsBackend        *backend);
 
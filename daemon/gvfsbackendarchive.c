@@ -46,6 +46,10 @@
 
 #define MOUNT_ICON_NAME "drive-removable-media"
 
+/* Jobs only read the file tree built at mount and open the archive
+   on their own, a few of them can decompress at once */
+#define ARCHIVE_MAX_JOB_THREADS 4
+
 /* #define PRINT_DEBUG  */
 
 #ifdef PRINT_DEBUG
@@ -594,6 +598,7 @@ do_mount (GVfsBackend *backend,
   g_vfs_backend_set_display_name (backend, g_file_info_get_display_name (info));
 
   g_vfs_backend_set_icon_name (backend, MOUNT_ICON_NAME);
+  g_vfs_backend_set_max_job_threads (backend, ARCHIVE_MAX_JOB_THREADS);
 
   create_root_file (archive);
   create_file_tree (archive, G_VFS_JOB (job));
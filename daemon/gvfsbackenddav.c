@@ -66,6 +66,9 @@
 #include "gvfsdnssdresolver.h"
 #endif
 
+/* Parallel requests to the server */
+#define DAV_MAX_JOB_THREADS 4
+
 typedef struct _MountAuthData MountAuthData;
 
 static void mount_auth_info_free (MountAuthData *info);
@@ -1900,6 +1903,13 @@ do_mount (GVfsBackend  *backend,
 
   g_vfs_backend_set_mount_spec (backend, mount_spec);
   g_vfs_backend_set_icon_name (backend, "folder-remote");
+
+  /* The sync session can be used from several job threads, give
+     each of them a connection */
+  g_object_set (G_VFS_BACKEND_HTTP (backend)->session,
+		SOUP_SESSION_MAX_CONNS_PER_HOST, DAV_MAX_JOB_THREADS,
+		NULL);
+  g_vfs_backend_set_max_job_threads (backend, DAV_MAX_JOB_THREADS);
   
   g_vfs_backend_dav_setup_display_name (backend);
   
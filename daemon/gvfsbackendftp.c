@@ -44,8 +44,10 @@
 #include "gvfsjobqueryfsinfo.h"
 #include "gvfsjobqueryattributes.h"
 #include "gvfsjobenumerate.h"
+#include "gvfsjobpull.h"
 #include "gvfsdaemonprotocol.h"
 #include "gvfsdaemonutils.h"
+#include "gvfstransfercheckpoint.h"
 #include "gvfskeyring.h"
 
 #include "ParseFTPList.h"
@@ -54,6 +56,9 @@
 #include "gvfsftpfile.h"
 #include "gvfsftptask.h"
 
+/* Parallel jobs until the server tells us how many connections it takes */
+#define FTP_MAX_JOB_THREADS 10
+
 /*** GTK DOC ***/
 
 /**
@@ -104,6 +109,7 @@ gvfs_backend_ftp_determine_features (GVfsFtpTask *task)
     { "UTF8", G_VFS_FTP_FEATURE_UTF8 },
     { "AUTH TLS", G_VFS_FTP_FEATURE_AUTH_TLS },
     { "AUTH SSL", G_VFS_FTP_FEATURE_AUTH_SSL },
+    { "REST STREAM", G_VFS_FTP_FEATURE_REST },
   };
   guint i, j;
   char **reply;
@@ -643,6 +649,10 @@ try_login:
   ftp->connections = 1;
   ftp->max_connections = G_MAXUINT;
   ftp->queue = g_queue_new ();
+
+  /* Each job thread uses its own connection, lowered once the
+     server limits them */
+  g_vfs_backend_set_max_job_threads (backend, FTP_MAX_JOB_THREADS);
  
   g_object_unref (addr);
   g_vfs_ftp_task_done (&task);
@@ -1568,6 +1578,90 @@ do_pull_improve_error_message (GVfsFtpTask *task,
     }
 }
 
+typedef struct {
+  GVfsTransferCheckpoint *checkpoint;
+  goffset offset;
+  GFileProgressCallback progress_callback;
+  gpointer progress_callback_data;
+} PullProgressData;
+
+static void
+pull_progress (goffset  current_num_bytes,
+               goffset  total_num_bytes,
+               gpointer user_data)
+{
+  PullProgressData *data = user_data;
+
+  g_vfs_transfer_checkpoint_update (data->checkpoint,
+                                    data->offset + current_num_bytes);
+  if (data->progress_callback)
+    data->progress_callback (data->offset + current_num_bytes,
+                             total_num_bytes,
+                             data->progress_callback_data);
+}
+
+/* Finds out where a resumable pull can continue, 0 means from the start */
+static goffset
+do_pull_find_resume_offset (GVfsFtpTask *            task,
+                            GVfsFtpFile *            src,
+                            const char *             source,
+                            const char *             local_path,
+                            GFile *                  dest,
+                            GVfsTransferCheckpoint **checkpoint)
+{
+  GFileInfo *info;
+  char *etag;
+  goffset offset;
+
+  info = g_vfs_ftp_dir_cache_lookup_file (task->backend->dir_cache, task, src, TRUE);
+  if (info == NULL)
+    return 0;
+  etag = g_vfs_transfer_checkpoint_make_etag (info);
+  g_object_unref (info);
+
+  *checkpoint = g_vfs_transfer_checkpoint_new (G_VFS_BACKEND (task->backend),
+                                               source, local_path, etag);
+  g_free (etag);
+
+  info = g_file_query_info (dest,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            G_FILE_ATTRIBUTE_ETAG_VALUE,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            task->cancellable, NULL);
+  if (info == NULL)
+    return 0;
+
+  offset = g_vfs_transfer_checkpoint_get_offset (*checkpoint,
+                                                 g_file_info_get_size (info),
+                                                 g_file_info_get_etag (info));
+  g_object_unref (info);
+
+  return offset;
+}
+
+/* Opens the partial destination and cuts it back to where we continue */
+static GFileIOStream *
+do_pull_open_for_resume (GFile *       dest,
+                         goffset       offset,
+                         GCancellable *cancellable,
+                         GError **     error)
+{
+  GFileIOStream *stream;
+
+  stream = g_file_open_readwrite (dest, cancellable, error);
+  if (stream == NULL)
+    return NULL;
+
+  if (!g_seekable_truncate (G_SEEKABLE (stream), offset, cancellable, error) ||
+      !g_seekable_seek (G_SEEKABLE (stream), offset, G_SEEK_SET, cancellable, error))
+    {
+      g_object_unref (stream);
+      return NULL;
+    }
+
+  return stream;
+}
+
 static void
 do_pull (GVfsBackend *         backend,
          GVfsJobPull *         job,
@@ -1587,7 +1681,12 @@ do_pull (GVfsBackend *         backend,
   GFile *dest;
   GInputStream *input;
   GOutputStream *output;
+  GFileIOStream *resume_stream = NULL;
+  GVfsTransferCheckpoint *checkpoint = NULL;
+  PullProgressData progress_data;
+  gboolean wrote = FALSE;
   goffset total_size = 0;
+  goffset offset = 0;
   
   src = g_vfs_ftp_file_new_from_gvfs (ftp, source);
   dest = g_file_new_for_path (local_path);
@@ -1602,7 +1701,14 @@ do_pull (GVfsBackend *         backend,
         }
     }
 
+  /* REST needs a server that restarts STREAM mode transfers */
+  if (job->resume && g_vfs_backend_ftp_has_feature (ftp, G_VFS_FTP_FEATURE_REST))
+    offset = do_pull_find_resume_offset (&task, src, source, local_path, dest, &checkpoint);
+
   g_vfs_ftp_task_setup_data_connection (&task);
+  if (offset > 0)
+    g_vfs_ftp_task_send (&task, G_VFS_FTP_PASS_300,
+                         "REST %" G_GOFFSET_FORMAT, offset);
   g_vfs_ftp_task_send_and_check (&task,
                                  G_VFS_FTP_PASS_100 | G_VFS_FTP_FAIL_200,
                                  open_read_handlers,
@@ -1616,7 +1722,12 @@ do_pull (GVfsBackend *         backend,
       goto out;
     }
 
-  if (flags & G_FILE_COPY_OVERWRITE)
+  if (offset > 0)
+    {
+      resume_stream = do_pull_open_for_resume (dest, offset, task.cancellable, &task.error);
+      output = resume_stream ? g_object_ref (g_io_stream_get_output_stream (G_IO_STREAM (resume_stream))) : NULL;
+    }
+  else if (flags & G_FILE_COPY_OVERWRITE)
     output = G_OUTPUT_STREAM (g_file_replace (dest,
                                               NULL,
                                               flags & G_FILE_COPY_BACKUP ? TRUE : FALSE,
@@ -1634,18 +1745,43 @@ do_pull (GVfsBackend *         backend,
       g_vfs_ftp_task_receive (&task, 0, NULL);
       goto out;
     }
+  wrote = TRUE;
 
   input = g_io_stream_get_input_stream (g_vfs_ftp_connection_get_data_stream (task.conn));
-  ftp_output_stream_splice (output,
-                            input,
-                            total_size,
-                            progress_callback,
-                            progress_callback_data,
-                            task.cancellable,
-                            &task.error);
+  if (checkpoint)
+    {
+      progress_data.checkpoint = checkpoint;
+      progress_data.offset = offset;
+      progress_data.progress_callback = progress_callback;
+      progress_data.progress_callback_data = progress_callback_data;
+      ftp_output_stream_splice (output,
+                                input,
+                                total_size,
+                                pull_progress,
+                                &progress_data,
+                                task.cancellable,
+                                &task.error);
+    }
+  else
+    ftp_output_stream_splice (output,
+                              input,
+                              total_size,
+                              progress_callback,
+                              progress_callback_data,
+                              task.cancellable,
+                              &task.error);
   g_vfs_ftp_task_close_data_connection (&task);
   g_vfs_ftp_task_receive (&task, 0, NULL);
   g_object_unref (output);
+  if (resume_stream)
+    g_object_unref (resume_stream);
+
+  if (checkpoint && !g_vfs_ftp_task_is_in_error (&task))
+    {
+      g_vfs_transfer_checkpoint_remove (checkpoint);
+      g_vfs_transfer_checkpoint_free (checkpoint);
+      checkpoint = NULL;
+    }
 
   if (remove_source)
     {
@@ -1655,6 +1791,27 @@ do_pull (GVfsBackend *         backend,
     }
 
 out:
+  if (checkpoint)
+    {
+      /* Local writes aren't buffered, so everything in the partial
+         file made it and the next try can continue after it */
+      if (wrote)
+        {
+          GFileInfo *info = g_file_query_info (dest,
+                                               G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                               G_FILE_ATTRIBUTE_ETAG_VALUE,
+                                               G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                               NULL, NULL);
+          if (info)
+            {
+              g_vfs_transfer_checkpoint_save (checkpoint,
+                                              g_file_info_get_size (info),
+                                              g_file_info_get_etag (info));
+              g_object_unref (info);
+            }
+        }
+      g_vfs_transfer_checkpoint_free (checkpoint);
+    }
   g_object_unref (dest);
   g_vfs_ftp_file_free (src);
   g_vfs_ftp_task_done (&task);
@@ -40,7 +40,8 @@ typedef enum {
   G_VFS_FTP_FEATURE_AUTH_TLS,
   G_VFS_FTP_FEATURE_AUTH_SSL,
   G_VFS_FTP_FEATURE_CHMOD,
-  G_VFS_FTP_FEATURE_CHGRP
+  G_VFS_FTP_FEATURE_CHGRP,
+  G_VFS_FTP_FEATURE_REST
 } GVfsFtpFeature;
 #define G_VFS_FTP_FEATURES_DEFAULT (0)
 
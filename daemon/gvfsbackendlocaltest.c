@@ -106,6 +106,25 @@ inject_error (GVfsBackend *backend,
   return TRUE;
 }
 
+/*  i/o reaching past fail_offset fails, if set  */
+static gboolean
+inject_io_error (GVfsJob *job,
+				 GSeekable *stream,
+				 gsize size,
+				 goffset fail_offset)
+{
+  if ((fail_offset >= 0) &&
+	  (g_seekable_tell (stream) + (goffset)size > fail_offset))
+  {
+	  g_print ("(II) inject_io_error: BANG! failing i/o at offset %ld \n", (long int)g_seekable_tell (stream));
+      g_vfs_job_failed (job,
+			G_IO_ERROR, G_IO_ERROR_FAILED,
+			"Injected i/o error");
+      return TRUE;
+  }
+  return FALSE;
+}
+
 
 
 
@@ -199,6 +218,29 @@ g_vfs_backend_localtest_init (GVfsBackendLocalTest *backend)
 		backend->inject_op_types = g_ascii_strtoll(c, NULL, 0);
 		g_print ("(II) g_vfs_backend_localtest_init: setting 'inject_op_types' to '%lu' \n", (unsigned long)backend->inject_op_types);
 	}
+
+	/*  short writes and failing i/o, see test/test-write-behind.c and test/test-read-errors.c  */
+	backend->write_limit = 0;
+	backend->write_fail_offset = -1;
+	backend->read_fail_offset = -1;
+
+	c = g_getenv("GVFS_LOCALTEST_WRITE_LIMIT");
+	if (c) {
+		backend->write_limit = g_ascii_strtoull(c, NULL, 0);
+		g_print ("(II) g_vfs_backend_localtest_init: setting 'write_limit' to '%lu' \n", (unsigned long)backend->write_limit);
+	}
+
+	c = g_getenv("GVFS_LOCALTEST_WRITE_FAIL_OFFSET");
+	if (c) {
+		backend->write_fail_offset = g_ascii_strtoll(c, NULL, 0);
+		g_print ("(II) g_vfs_backend_localtest_init: setting 'write_fail_offset' to '%ld' \n", (long int)backend->write_fail_offset);
+	}
+
+	c = g_getenv("GVFS_LOCALTEST_READ_FAIL_OFFSET");
+	if (c) {
+		backend->read_fail_offset = g_ascii_strtoll(c, NULL, 0);
+		g_print ("(II) g_vfs_backend_localtest_init: setting 'read_fail_offset' to '%ld' \n", (long int)backend->read_fail_offset);
+	}
 	
 	g_print ("(II) g_vfs_backend_localtest_init done.\n");
 }
@@ -248,6 +290,9 @@ do_mount (GVfsBackend *backend,
 
   g_vfs_backend_set_icon_name (backend, "folder-remote");
 
+  /*  off unless GVFS_WRITE_BEHIND_SIZE is set  */
+  g_vfs_backend_set_write_behind_size (backend, 0);
+
   inject_error (backend, G_VFS_JOB (job), GVFS_JOB_MOUNT);
 }
 
@@ -930,6 +975,7 @@ do_read (GVfsBackend *backend,
           char *buffer,
           gsize bytes_requested)
 {
+  GVfsBackendLocalTest *op_backend = G_VFS_BACKEND_LOCALTEST (backend);
   GError *error;
   GFileInputStream *stream = _handle;
   gssize s;
@@ -938,6 +984,9 @@ do_read (GVfsBackend *backend,
 		  (long int)_handle, (long int)buffer, (long int)bytes_requested);
 
   g_assert (stream != NULL);
+
+  if (inject_io_error (G_VFS_JOB (job), G_SEEKABLE (stream), bytes_requested, op_backend->read_fail_offset))
+	  return;
   
   error = NULL;
   s = g_input_stream_read (G_INPUT_STREAM (stream), buffer, bytes_requested, 
@@ -1128,6 +1177,7 @@ do_write (GVfsBackend *backend,
            char *buffer,
            gsize buffer_size)
 {
+  GVfsBackendLocalTest *op_backend = G_VFS_BACKEND_LOCALTEST (backend);
   GError *error;
   GFileOutputStream *stream = _handle;
   gssize s;
@@ -1136,6 +1186,12 @@ do_write (GVfsBackend *backend,
 		  (long int)_handle, (long int)buffer, (long int)buffer_size);
 
   g_assert (stream != NULL);
+
+  if ((op_backend->write_limit > 0) && (buffer_size > op_backend->write_limit))
+	  buffer_size = op_backend->write_limit;
+
+  if (inject_io_error (G_VFS_JOB (job), G_SEEKABLE (stream), buffer_size, op_backend->write_fail_offset))
+	  return;
   
   error = NULL;
   s = g_output_stream_write (G_OUTPUT_STREAM (stream), buffer, buffer_size, G_VFS_JOB (job)->cancellable, &error); 
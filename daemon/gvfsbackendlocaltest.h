@@ -80,6 +80,9 @@ struct _GVfsBackendLocalTest
 	  GMountSpec *mount_spec;
 	  int errorneous;
 	  GVfsJobType inject_op_types;
+	  gsize write_limit;
+	  goffset write_fail_offset;
+	  goffset read_fail_offset;
 };
 
 struct _GVfsBackendLocalTestClass
@@ -128,6 +128,7 @@ typedef struct {
 typedef struct {
   DataBuffer *raw_handle;
   goffset offset;
+  gsize write_in_flight; /* Written after offset, not yet acknowledged */
   char *filename;
   char *tempname;
   guint32 permissions;
@@ -282,6 +283,13 @@ static void
 g_vfs_backend_sftp_init (GVfsBackendSftp *backend)
 {
   backend->expected_replies = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)expected_reply_free);
+
+  /* Requests are handled in order by the server, so keep several
+     reads or writes in flight to hide the round-trip time */
+  g_vfs_backend_set_channel_pipeline_depth (G_VFS_BACKEND (backend), 8);
+  g_vfs_backend_set_write_behind_size (G_VFS_BACKEND (backend), 256 * 1024);
+  /* Every query is a round trip to the server */
+  g_vfs_backend_set_info_cache_limits (G_VFS_BACKEND (backend), 2000, 1024 * 1024);
 }
 
 static void
@@ -2452,6 +2460,16 @@ try_open_icon_for_read (GVfsBackend *backend,
   return TRUE;
 }
 
+typedef struct {
+  SftpHandle *handle;
+  goffset offset;
+  gsize bytes_read;
+} ReadRequest;
+
+static void queue_read_command (GVfsBackendSftp *backend,
+                                GVfsJobRead *job,
+                                ReadRequest *request);
+
 static void
 read_reply (GVfsBackendSftp *backend,
             int reply_type,
@@ -2460,14 +2478,28 @@ read_reply (GVfsBackendSftp *backend,
             GVfsJob *job,
             gpointer user_data)
 {
-  SftpHandle *handle;
+  GVfsJobRead *read_job;
+  ReadRequest *request;
   guint32 count;
+  guint32 code;
   
-  handle = user_data;
+  read_job = G_VFS_JOB_READ (job);
+  request = user_data;
   
   if (reply_type == SSH_FXP_STATUS)
     {
-      result_from_status (job, reply, -1, SSH_FX_EOF);
+      code = read_status_code (reply);
+      if (code != SSH_FX_EOF)
+        {
+          result_from_status_code (job, code, -1, -1);
+          return;
+        }
+
+      /* Reads issued past the end of the file moved the position too far */
+      request->handle->offset = MIN (request->handle->offset,
+                                     request->offset + request->bytes_read);
+      g_vfs_job_read_set_size (read_job, request->bytes_read);
+      g_vfs_job_succeeded (job);
       return;
     }
 
@@ -2480,8 +2512,9 @@ read_reply (GVfsBackendSftp *backend,
   
   count = g_data_input_stream_read_uint32 (reply, NULL, NULL);
 
-  if (!g_input_stream_read_all (G_INPUT_STREAM (reply),
-                                G_VFS_JOB_READ (job)->buffer, count,
+  if (count > read_job->bytes_requested - request->bytes_read ||
+      !g_input_stream_read_all (G_INPUT_STREAM (reply),
+                                read_job->buffer + request->bytes_read, count,
                                 NULL, NULL, NULL))
     {
       g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -2489,12 +2522,37 @@ read_reply (GVfsBackendSftp *backend,
       return;
     }
   
-  handle->offset += count;
+  request->bytes_read += count;
 
-  g_vfs_job_read_set_size (G_VFS_JOB_READ (job), count);
+  /* The server may return less than asked for. Later reads may already
+     be in flight for the following range, so fetch the rest rather than
+     leaving a hole in the stream. */
+  if (count > 0 && request->bytes_read < read_job->bytes_requested)
+    {
+      queue_read_command (backend, read_job, request);
+      return;
+    }
+
+  g_vfs_job_read_set_size (read_job, request->bytes_read);
   g_vfs_job_succeeded (job);
 }
 
+static void
+queue_read_command (GVfsBackendSftp *backend,
+                    GVfsJobRead *job,
+                    ReadRequest *request)
+{
+  GDataOutputStream *command;
+
+  command = new_command_stream (backend,
+                                SSH_FXP_READ);
+  put_data_buffer (command, request->handle->raw_handle);
+  g_data_output_stream_put_uint64 (command, request->offset + request->bytes_read, NULL, NULL);
+  g_data_output_stream_put_uint32 (command, job->bytes_requested - request->bytes_read, NULL, NULL);
+  
+  queue_command_stream_and_free (backend, command, read_reply, G_VFS_JOB (job), request);
+}
+
 static gboolean
 try_read (GVfsBackend *backend,
           GVfsJobRead *job,
@@ -2504,19 +2562,39 @@ try_read (GVfsBackend *backend,
 {
   SftpHandle *handle = _handle;
   GVfsBackendSftp *op_backend = G_VFS_BACKEND_SFTP (backend);
-  GDataOutputStream *command;
+  ReadRequest *request;
 
-  command = new_command_stream (op_backend,
-                                SSH_FXP_READ);
-  put_data_buffer (command, handle->raw_handle);
-  g_data_output_stream_put_uint64 (command, handle->offset, NULL, NULL);
-  g_data_output_stream_put_uint32 (command, bytes_requested, NULL, NULL);
-  
-  queue_command_stream_and_free (op_backend, command, read_reply, G_VFS_JOB (job), handle);
+  /* Several reads may be in flight on the handle (see
+     g_vfs_backend_set_channel_pipeline_depth), so each one reserves
+     its range of the file when it is issued */
+  request = g_new0 (ReadRequest, 1);
+  request->handle = handle;
+  request->offset = handle->offset;
+  handle->offset += bytes_requested;
+  g_vfs_job_set_backend_data (G_VFS_JOB (job), request, g_free);
+
+  queue_read_command (op_backend, job, request);
 
   return TRUE;
 }
 
+static gboolean
+try_read_at (GVfsBackend *backend,
+             GVfsJobRead *job,
+             GVfsBackendHandle _handle,
+             goffset offset,
+             char *buffer,
+             gsize bytes_requested)
+{
+  SftpHandle *handle = _handle;
+
+  /* SSH_FXP_READ takes an offset anyway, so this is just a seek
+     without the fstat */
+  handle->offset = offset;
+
+  return try_read (backend, job, _handle, buffer, bytes_requested);
+}
+
 static void
 seek_read_fstat_reply (GVfsBackendSftp *backend,
                        int reply_type,
@@ -2619,10 +2697,6 @@ close_moved_tempfile (GVfsBackendSftp *backend,
                       GVfsJob *job,
                       gpointer user_data)
 {
-  SftpHandle *handle;
-  
-  handle = user_data;
-
   if (reply_type == SSH_FXP_STATUS)
     result_from_status (job, reply, -1, -1);
   else
@@ -3544,16 +3618,16 @@ write_reply (GVfsBackendSftp *backend,
              GVfsJob *job,
              gpointer user_data)
 {
-  SftpHandle *handle;
-  
-  handle = user_data;
+  SftpHandle *handle = user_data;
+  gsize size;
+
+  size = G_VFS_JOB_WRITE (job)->data_size;
+  handle->write_in_flight -= size;
 
   if (reply_type == SSH_FXP_STATUS)
     {
       if (result_from_status (job, reply, -1, -1))
-        {
-          handle->offset += G_VFS_JOB_WRITE (job)->data_size;
-        }
+        handle->offset += size;
     }
   else
     g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -3574,8 +3648,11 @@ try_write (GVfsBackend *backend,
   command = new_command_stream (op_backend,
                                 SSH_FXP_WRITE);
   put_data_buffer (command, handle->raw_handle);
-  g_data_output_stream_put_uint64 (command, handle->offset, NULL, NULL);
+  /* Pipelined writes go to consecutive offsets, the position only
+     moves once the server accepted the data */
+  g_data_output_stream_put_uint64 (command, handle->offset + handle->write_in_flight, NULL, NULL);
   g_data_output_stream_put_uint32 (command, buffer_size, NULL, NULL);
+  handle->write_in_flight += buffer_size;
   /* Ideally we shouldn't do this copy, but doing the writes as multiple writes
      caused problems on the read side in openssh */
   g_output_stream_write_all (G_OUTPUT_STREAM (command),
@@ -4720,6 +4797,7 @@ g_vfs_backend_sftp_class_init (GVfsBackendSftpClass *klass)
   backend_class->try_open_for_read = try_open_for_read;
   backend_class->try_read = try_read;
   backend_class->try_seek_on_read = try_seek_on_read;
+  backend_class->try_read_at = try_read_at;
   backend_class->try_close_read = try_close_read;
   backend_class->try_close_write = try_close_write;
   backend_class->try_query_info = try_query_info;
@@ -567,6 +567,13 @@ do_mount (GVfsBackend *backend,
   g_vfs_backend_set_mount_spec (backend, smb_mount_spec);
   g_mount_spec_unref (smb_mount_spec);
 
+  /* All operations go through the one libsmbclient context,
+     which can't be used from several threads at once */
+  g_vfs_backend_set_max_job_threads (backend, 1);
+
+  /* Every write is a round trip, collect small ones */
+  g_vfs_backend_set_write_behind_size (backend, 256 * 1024);
+
   /* FIXME: we're stat()-ing user-specified path here, not the root. Ideally we
             would like to fallback to root when first mount attempt fails, though
             it would be tough to actually say if it was an authentication failure
@@ -759,6 +766,28 @@ do_read (GVfsBackend *backend,
     }
 }
 
+static void
+do_read_at (GVfsBackend *backend,
+	    GVfsJobRead *job,
+	    GVfsBackendHandle handle,
+	    goffset offset,
+	    char *buffer,
+	    gsize bytes_requested)
+{
+  GVfsBackendSmb *op_backend = G_VFS_BACKEND_SMB (backend);
+  smbc_lseek_fn smbc_lseek;
+
+  /* The seek is local to libsmbclient, only the read goes to the server */
+  smbc_lseek = smbc_getFunctionLseek (op_backend->smb_context);
+  if (smbc_lseek (op_backend->smb_context, (SMBCFILE *)handle, offset, SEEK_SET) == (off_t)-1)
+    {
+      g_vfs_job_failed_from_errno (G_VFS_JOB (job), errno);
+      return;
+    }
+
+  do_read (backend, job, handle, buffer, bytes_requested);
+}
+
 static void
 do_seek_on_read (GVfsBackend *backend,
 		 GVfsJobSeekRead *job,
@@ -2161,6 +2190,7 @@ g_vfs_backend_smb_class_init (GVfsBackendSmbClass *klass)
   backend_class->open_for_read = do_open_for_read;
   backend_class->read = do_read;
   backend_class->seek_on_read = do_seek_on_read;
+  backend_class->read_at = do_read_at;
   backend_class->query_info_on_read = do_query_info_on_read;
   backend_class->close_read = do_close_read;
   backend_class->create = do_create;
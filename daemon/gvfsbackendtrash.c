@@ -25,6 +25,8 @@
 #include "gvfsjobseekread.h"
 #include "gvfsjobread.h"
 
+#define TRASH_MAX_JOB_THREADS 10
+
 typedef GVfsBackendClass GVfsBackendTrashClass;
 
 struct OPAQUE_TYPE__GVfsBackendTrash
@@ -854,6 +856,8 @@ g_vfs_backend_trash_init (GVfsBackendTrash *backend)
   mount_spec = g_mount_spec_new ("trash");
   g_vfs_backend_set_mount_spec (vfs_backend, mount_spec);
   g_mount_spec_unref (mount_spec);
+
+  g_vfs_backend_set_max_job_threads (vfs_backend, TRASH_MAX_JOB_THREADS);
 }
 
 static void
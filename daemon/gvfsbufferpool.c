@@ -0,0 +1,179 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <glib.h>
+
+#include "gvfsbufferpool.h"
+
+/* Read buffers are big and short-lived, so streaming used to spend
+ * much of its time in malloc/free and page faults. Keep freed buffers
+ * around in power-of-two size classes from MIN_CLASS_SIZE up to
+ * MAX_CLASS_SIZE, bounded by the idle byte limit. Larger requests
+ * just use the heap. */
+
+#define MIN_CLASS_SHIFT 12 /* 4K */
+#define MAX_CLASS_SHIFT 22 /* 4M */
+#define N_CLASSES (MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1)
+
+/* Enough for a full read-ahead window */
+#define DEFAULT_MAX_IDLE_BYTES (8*1024*1024)
+
+static GMutex pool_lock;
+static GTrashStack *free_buffers[N_CLASSES];
+static gsize max_idle_bytes = DEFAULT_MAX_IDLE_BYTES;
+static GVfsBufferPoolStats pool_stats;
+
+/* Returns -1 if the size is not pooled */
+static int
+size_class (gsize size)
+{
+  int class;
+
+  if (size > ((gsize)1 << MAX_CLASS_SHIFT))
+    return -1;
+
+  class = 0;
+  while (((gsize)1 << (class + MIN_CLASS_SHIFT)) < size)
+    class++;
+
+  return class;
+}
+
+/**
+ * g_vfs_buffer_pool_alloc:
+ * @size: number of bytes needed
+ *
+ * Returns a buffer of at least @size bytes, reusing a pooled one if
+ * possible. Free it with g_vfs_buffer_pool_free() and the same @size.
+ * May be called from any thread.
+ **/
+gpointer
+g_vfs_buffer_pool_alloc (gsize size)
+{
+  gpointer buffer;
+  int class;
+
+  class = size_class (size);
+  if (class < 0)
+    return g_malloc (size);
+
+  g_mutex_lock (&pool_lock);
+  buffer = g_trash_stack_pop (&free_buffers[class]);
+  if (buffer)
+    {
+      pool_stats.hits++;
+      pool_stats.bytes_idle -= (gsize)1 << (class + MIN_CLASS_SHIFT);
+    }
+  else
+    pool_stats.misses++;
+  pool_stats.bytes_used += (gsize)1 << (class + MIN_CLASS_SHIFT);
+  g_mutex_unlock (&pool_lock);
+
+  if (buffer == NULL)
+    buffer = g_malloc ((gsize)1 << (class + MIN_CLASS_SHIFT));
+
+  return buffer;
+}
+
+void
+g_vfs_buffer_pool_free (gpointer buffer,
+			gsize size)
+{
+  gsize class_size;
+  int class;
+
+  if (buffer == NULL)
+    return;
+  
+  class = size_class (size);
+  if (class < 0)
+    {
+      g_free (buffer);
+      return;
+    }
+
+  class_size = (gsize)1 << (class + MIN_CLASS_SHIFT);
+
+  g_mutex_lock (&pool_lock);
+  pool_stats.bytes_used -= class_size;
+  if (pool_stats.bytes_idle + class_size <= max_idle_bytes)
+    {
+      g_trash_stack_push (&free_buffers[class], buffer);
+      pool_stats.bytes_idle += class_size;
+      buffer = NULL;
+    }
+  g_mutex_unlock (&pool_lock);
+
+  g_free (buffer);
+}
+
+/* Drops idle buffers until we're below the limit, largest first */
+static void
+trim_unlocked (void)
+{
+  gpointer buffer;
+  int class;
+
+  for (class = N_CLASSES - 1;
+       class >= 0 && pool_stats.bytes_idle > max_idle_bytes;
+       class--)
+    {
+      while (pool_stats.bytes_idle > max_idle_bytes &&
+	     (buffer = g_trash_stack_pop (&free_buffers[class])) != NULL)
+	{
+	  pool_stats.bytes_idle -= (gsize)1 << (class + MIN_CLASS_SHIFT);
+	  g_free (buffer);
+	}
+    }
+}
+
+/**
+ * g_vfs_buffer_pool_set_limit:
+ * @limit: how many bytes of unused buffers to keep, 0 disables
+ *     pooling
+ *
+ * Sets the memory bound of the pool, freeing idle buffers if needed.
+ **/
+void
+g_vfs_buffer_pool_set_limit (gsize limit)
+{
+  g_mutex_lock (&pool_lock);
+  max_idle_bytes = limit;
+  trim_unlocked ();
+  g_mutex_unlock (&pool_lock);
+}
+
+/**
+ * g_vfs_buffer_pool_get_stats:
+ * @stats: return location for the counters
+ *
+ * Gets how well the pool does, for the daemon statistics.
+ **/
+void
+g_vfs_buffer_pool_get_stats (GVfsBufferPoolStats *stats)
+{
+  g_mutex_lock (&pool_lock);
+  *stats = pool_stats;
+  g_mutex_unlock (&pool_lock);
+}
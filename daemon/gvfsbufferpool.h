@@ -0,0 +1,45 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_BUFFER_POOL_H__
+#define __G_VFS_BUFFER_POOL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct {
+  guint64 hits;       /* allocations served from the pool */
+  guint64 misses;     /* allocations that hit the heap */
+  gsize   bytes_idle; /* pooled buffers waiting for reuse */
+  gsize   bytes_used; /* pool-sized buffers currently handed out */
+} GVfsBufferPoolStats;
+
+gpointer g_vfs_buffer_pool_alloc     (gsize                size);
+void     g_vfs_buffer_pool_free      (gpointer             buffer,
+				      gsize                size);
+void     g_vfs_buffer_pool_set_limit (gsize                limit);
+void     g_vfs_buffer_pool_get_stats (GVfsBufferPoolStats *stats);
+
+G_END_DECLS
+
+#endif /* __G_VFS_BUFFER_POOL_H__ */
@@ -28,6 +28,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 
 #include <glib.h>
@@ -48,6 +49,12 @@ G_DEFINE_TYPE_WITH_CODE (GVfsChannel, g_vfs_channel, G_TYPE_OBJECT,
 			 G_IMPLEMENT_INTERFACE (G_VFS_TYPE_JOB_SOURCE,
 						g_vfs_channel_job_source_iface_init))
 
+/* Caps the memory used for shared memory rings, the memfd pages are
+   only allocated as the ring fills */
+#define MAX_SHM_CHANNELS 16
+
+static volatile gint n_shm_channels = 0;
+
 /* TODO: Real P_() */
 #define P_(_x) (_x)
 
@@ -80,6 +87,23 @@ typedef struct {
   gboolean cancelled;
 } Request;
 
+/* A started request (or one that failed to start, then job is NULL)
+   waiting for its reply to be sent */
+typedef struct {
+  GVfsJob *job;
+  guint32 command;
+  guint32 seq_nr;
+  gboolean internal; /* Started by the channel itself, reply not sent */
+
+  gboolean has_reply;
+  gboolean is_error;
+  gboolean has_reply_header;
+  GVfsDaemonSocketProtocolReply reply;
+  const char *data; /* Owned by job, or same as free_data */
+  gsize data_len;
+  gpointer free_data;
+} ActiveJob;
+
 struct _GVfsChannelPrivate
 {
   GVfsBackend *backend;
@@ -91,20 +115,37 @@ struct _GVfsChannelPrivate
   GPid actual_consumer;
   
   GVfsBackendHandle backend_handle;
-  GVfsJob *current_job;
-  guint32 current_job_seq_nr;
+
+  /* Started jobs in request order, replies are sent in the same order.
+     Normally there is only one, but backends that support it may get
+     several reads or writes at once, see
+     g_vfs_backend_set_channel_pipeline_depth().
+     Locked as jobs can send their replies from an i/o thread. */
+  GMutex lock;
+  GQueue active_jobs;
+  gboolean writing_reply;
+  /* A read or write failed while later ones were already running,
+     so the position is unknown until the client seeks */
+  gboolean pipeline_failed;
 
   GList *queued_requests;
   
   char reply_buffer[G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SIZE];
   int reply_buffer_pos;
   
-  const char *output_data; /* Owned by job */
+  const char *output_data; /* Owned by the head of active_jobs */
   gsize output_data_size;
   gsize output_data_pos;
+
+  /* Shared memory data ring, see G_VFS_DAEMON_OPEN_FLAG_SHM */
+  char *shm;
+  gsize shm_ring_size;
+  guint32 shm_write_pos;
 };
 
 static void start_request_reader       (GVfsChannel  *channel);
+static void write_next_reply           (GVfsChannel  *channel);
+static void finish_head_job            (GVfsChannel  *channel);
 static void g_vfs_channel_get_property (GObject      *object,
 					guint         prop_id,
 					GValue       *value,
@@ -115,6 +156,15 @@ static void g_vfs_channel_set_property (GObject      *object,
 					GParamSpec   *pspec);
 
 
+static void
+active_job_free (ActiveJob *active)
+{
+  if (active->job)
+    g_object_unref (active->job);
+  g_free (active->free_data);
+  g_free (active);
+}
+
 static void
 g_vfs_channel_finalize (GObject *object)
 {
@@ -122,9 +172,16 @@ g_vfs_channel_finalize (GObject *object)
 
   channel = G_VFS_CHANNEL (object);
 
-  if (channel->priv->current_job)
-    g_object_unref (channel->priv->current_job);
-  channel->priv->current_job = NULL;
+  g_queue_foreach (&channel->priv->active_jobs, (GFunc)active_job_free, NULL);
+  g_queue_clear (&channel->priv->active_jobs);
+  g_mutex_clear (&channel->priv->lock);
+
+  if (channel->priv->shm)
+    {
+      munmap (channel->priv->shm,
+	      G_VFS_DAEMON_SHM_HEADER_SIZE + channel->priv->shm_ring_size);
+      g_atomic_int_add (&n_shm_channels, -1);
+    }
   
   if (channel->priv->reply_stream)
     g_object_unref (channel->priv->reply_stream);
@@ -197,6 +254,8 @@ g_vfs_channel_init (GVfsChannel *channel)
 					       G_VFS_TYPE_CHANNEL,
 					       GVfsChannelPrivate);
   channel->priv->remote_fd = -1;
+  g_mutex_init (&channel->priv->lock);
+  g_queue_init (&channel->priv->active_jobs);
 
   ret = socketpair (AF_UNIX, SOCK_STREAM, 0, socket_fds);
   if (ret == -1) 
@@ -260,25 +319,203 @@ g_vfs_channel_get_property (GObject    *object,
     }
 }
 
+/* Ownership of job is passed */
 static void
-g_vfs_channel_connection_closed (GVfsChannel *channel)
+start_job_full (GVfsChannel *channel,
+		GVfsJob     *job,
+		guint32      command,
+		guint32      seq_nr,
+		gboolean     internal)
+{
+  ActiveJob *active;
+
+  active = g_new0 (ActiveJob, 1);
+  active->job = job;
+  active->command = command;
+  active->seq_nr = seq_nr;
+  active->internal = internal;
+
+  /* Add before starting, the job may reply right away */
+  g_mutex_lock (&channel->priv->lock);
+  g_queue_push_tail (&channel->priv->active_jobs, active);
+  g_mutex_unlock (&channel->priv->lock);
+
+  g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (channel), job);
+}
+
+static void
+start_job (GVfsChannel *channel,
+	   GVfsJob     *job,
+	   guint32      command,
+	   guint32      seq_nr)
+{
+  start_job_full (channel, job, command, seq_nr, FALSE);
+}
+
+/* Writes out data buffered by the channel class, if any.
+ * Unless force is set this only happens once enough is buffered.
+ * The flush waits for all earlier jobs and nothing else starts
+ * until it is done, see can_start_request_unlocked(). */
+static gboolean
+start_flush (GVfsChannel *channel,
+	     gboolean     force)
 {
   GVfsChannelClass *class;
+  GVfsJob *job;
+  gboolean idle;
+
+  class = G_VFS_CHANNEL_GET_CLASS (channel);
+  if (class->flush == NULL)
+    return FALSE;
+
+  g_mutex_lock (&channel->priv->lock);
+  idle = g_queue_is_empty (&channel->priv->active_jobs) &&
+    !channel->priv->pipeline_failed;
+  g_mutex_unlock (&channel->priv->lock);
+
+  if (!idle)
+    return FALSE;
+
+  job = class->flush (channel, force);
+  if (job == NULL)
+    return FALSE;
+
+  start_job_full (channel, job,
+		  G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_WRITE, 0, TRUE);
+  return TRUE;
+}
+
+/* Buffered data goes out before the close */
+static void
+start_close (GVfsChannel *channel)
+{
+  GVfsChannelClass *class;
+
+  if (start_flush (channel, TRUE))
+    return;
+
+  class = G_VFS_CHANNEL_GET_CLASS (channel);
+  start_job (channel, class->close (channel),
+	     G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_CLOSE, 0);
+}
+
+/* For requests that fail before they get a job */
+static void
+queue_error_reply (GVfsChannel *channel,
+		   guint32      command,
+		   guint32      seq_nr,
+		   GError      *error)
+{
+  ActiveJob *active;
+  gsize data_len;
+
+  active = g_new0 (ActiveJob, 1);
+  active->command = command;
+  active->seq_nr = seq_nr;
+  active->free_data = g_error_to_daemon_reply (error, seq_nr, &data_len);
+  active->data = active->free_data;
+  active->data_len = data_len;
+  active->has_reply = TRUE;
+  active->is_error = TRUE;
+
+  g_mutex_lock (&channel->priv->lock);
+  g_queue_push_tail (&channel->priv->active_jobs, active);
+  g_mutex_unlock (&channel->priv->lock);
+
+  write_next_reply (channel);
+}
+
+/* Called with the lock held */
+static ActiveJob *
+find_active_job_unlocked (GVfsChannel *channel,
+			  GVfsJob     *job)
+{
+  GList *l;
+
+  for (l = channel->priv->active_jobs.head; l != NULL; l = l->next)
+    {
+      ActiveJob *active = l->data;
+
+      if (active->job == job)
+	return active;
+    }
+
+  return NULL;
+}
+
+static gboolean
+is_pipelined_command (guint32 command)
+{
+  return
+    command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_READ ||
+    command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_WRITE;
+}
+
+/* Called with the lock held.
+ * Reads and writes may overlap with other requests of the same kind
+ * if the backend allows it, anything else (seek, close, query info)
+ * waits until all earlier requests are finished. Nothing overlaps
+ * a flush, a short or failed one changes what the next write does. */
+static gboolean
+can_start_request_unlocked (GVfsChannel *channel,
+			    guint32      command)
+{
+  GList *l;
+
+  if (channel->priv->pipeline_failed &&
+      is_pipelined_command (command))
+    return FALSE;
+
+  if (g_queue_is_empty (&channel->priv->active_jobs))
+    return TRUE;
+
+  if (!is_pipelined_command (command) ||
+      g_queue_get_length (&channel->priv->active_jobs) >=
+      g_vfs_backend_get_channel_pipeline_depth (channel->priv->backend))
+    return FALSE;
+
+  for (l = channel->priv->active_jobs.head; l != NULL; l = l->next)
+    {
+      ActiveJob *active = l->data;
+
+      if (active->internal ||
+	  active->command != command)
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+can_start_request (GVfsChannel *channel,
+		   guint32      command)
+{
+  gboolean res;
+
+  g_mutex_lock (&channel->priv->lock);
+  res = can_start_request_unlocked (channel, command);
+  g_mutex_unlock (&channel->priv->lock);
+
+  return res;
+}
+
+static void
+g_vfs_channel_connection_closed (GVfsChannel *channel)
+{
+  gboolean idle;
 
   if (channel->priv->connection_closed)
     return;
   channel->priv->connection_closed = TRUE;
+
+  g_mutex_lock (&channel->priv->lock);
+  idle = g_queue_is_empty (&channel->priv->active_jobs);
+  g_mutex_unlock (&channel->priv->lock);
   
-  if (channel->priv->current_job == NULL &&
+  if (idle &&
       channel->priv->backend_handle != NULL)
-    {
-      class = G_VFS_CHANNEL_GET_CLASS (channel);
-      
-      channel->priv->current_job = class->close (channel);
-      channel->priv->current_job_seq_nr = 0;
-      g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (channel), channel->priv->current_job);
-    }
-  /* Otherwise we'll close when current_job is finished */
+    start_close (channel);
+  /* Otherwise we'll close when the active jobs are finished */
 }
 
 static void
@@ -291,6 +528,25 @@ request_reader_free (RequestReader *reader)
   g_free (reader);
 }
 
+/* Reads and writes fail after a failed pipelined one, until the
+   client positions the stream again */
+static gboolean
+pipeline_failed (GVfsChannel *channel,
+		 guint32      command)
+{
+  gboolean res;
+
+  g_mutex_lock (&channel->priv->lock);
+  if (command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SEEK_SET ||
+      command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SEEK_END ||
+      command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_PREAD)
+    channel->priv->pipeline_failed = FALSE;
+  res = channel->priv->pipeline_failed && is_pipelined_command (command);
+  g_mutex_unlock (&channel->priv->lock);
+
+  return res;
+}
+
 static gboolean
 start_queued_request (GVfsChannel *channel)
 {
@@ -304,11 +560,37 @@ start_queued_request (GVfsChannel *channel)
   
   class = G_VFS_CHANNEL_GET_CLASS (channel);
   
-  while (channel->priv->current_job == NULL &&
-	 channel->priv->queued_requests != NULL)
+  while (channel->priv->queued_requests != NULL)
     {
       req = channel->priv->queued_requests->data;
 
+      if (pipeline_failed (channel, req->command))
+	{
+	  channel->priv->queued_requests =
+	    g_list_delete_link (channel->priv->queued_requests,
+				channel->priv->queued_requests);
+	  error =
+	    g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+				 _("An earlier read or write failed"));
+	  queue_error_reply (channel, req->command, req->seq_nr, error);
+	  g_error_free (error);
+	  g_free (req->data);
+	  g_free (req);
+	  continue;
+	}
+
+      if (!can_start_request (channel, req->command))
+	break;
+
+      /* Anything but another write needs buffered data written first,
+	 the request then waits for the flush to finish */
+      if (start_flush (channel,
+		       req->command != G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_WRITE))
+	{
+	  started_job = TRUE;
+	  continue;
+	}
+
       channel->priv->queued_requests =
 	g_list_delete_link (channel->priv->queued_requests,
 			    channel->priv->queued_requests);
@@ -334,14 +616,12 @@ start_queued_request (GVfsChannel *channel)
       
       if (job)
 	{
-	  channel->priv->current_job = job;
-	  channel->priv->current_job_seq_nr = req->seq_nr;
-	  g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (channel), channel->priv->current_job);
+	  start_job (channel, job, req->command, req->seq_nr);
 	  started_job = TRUE;
 	}
       else
 	{
-	  g_vfs_channel_send_error (channel, error);
+	  queue_error_reply (channel, req->command, req->seq_nr, error);
 	  g_error_free (error);
 	}
       
@@ -360,32 +640,45 @@ got_request (GVfsChannel *channel,
 {
   Request *req;
   guint32 command, arg1;
+  GVfsJob *job_to_cancel;
   GList *l;
 
+  command = g_ntohl (request->command);
+  arg1 = g_ntohl (request->arg1);
+
   if (g_vfs_backend_get_block_requests (channel->priv->backend))
     {
-      char   *data;
-      gsize   data_len;
       GError *err = NULL;
-      guint32 seq_nr;
 
       g_set_error_literal (&err, G_IO_ERROR, G_IO_ERROR_CLOSED,
 			   "Channel blocked");
-      seq_nr = g_ntohl (request->seq_nr);
-      data = g_error_to_daemon_reply (err, seq_nr, &data_len);
-      g_vfs_channel_send_reply (channel, NULL, data, data_len);
+      queue_error_reply (channel, command, g_ntohl (request->seq_nr), err);
       g_error_free (err);
+      g_free (data);
       return;
     }
 
-  command = g_ntohl (request->command);
-  arg1 = g_ntohl (request->arg1);
-
   if (command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_CANCEL)
     {
-      if (arg1 == channel->priv->current_job_seq_nr &&
-	  channel->priv->current_job != NULL)
-	g_vfs_job_cancel (channel->priv->current_job);
+      job_to_cancel = NULL;
+      g_mutex_lock (&channel->priv->lock);
+      for (l = channel->priv->active_jobs.head; l != NULL; l = l->next)
+	{
+	  ActiveJob *active = l->data;
+
+	  if (active->job != NULL && active->seq_nr == arg1)
+	    {
+	      job_to_cancel = g_object_ref (active->job);
+	      break;
+	    }
+	}
+      g_mutex_unlock (&channel->priv->lock);
+
+      if (job_to_cancel)
+	{
+	  g_vfs_job_cancel (job_to_cancel);
+	  g_object_unref (job_to_cancel);
+	}
       else
 	{
 	  for (l = channel->priv->queued_requests; l != NULL; l = l->next)
@@ -561,8 +854,6 @@ send_reply_cb (GObject *source_object,
   GOutputStream *output_stream = G_OUTPUT_STREAM (source_object);
   gssize bytes_written;
   GVfsChannel *channel = user_data;
-  GVfsChannelClass *class;
-  GVfsJob *job;
 
   bytes_written = g_output_stream_write_finish (output_stream, res, NULL);
   
@@ -608,14 +899,32 @@ send_reply_cb (GObject *source_object,
   /* Sent full reply */
   channel->priv->output_data = NULL;
 
-  job = channel->priv->current_job;
-  channel->priv->current_job = NULL;
-  g_vfs_job_emit_finished (job);
+  finish_head_job (channel);
+}
+
+static void
+finish_head_job (GVfsChannel *channel)
+{
+  GVfsChannelClass *class;
+  ActiveJob *active;
+  GVfsJob *job;
+  gboolean idle;
+
+  g_mutex_lock (&channel->priv->lock);
+  active = g_queue_pop_head (&channel->priv->active_jobs);
+  channel->priv->writing_reply = FALSE;
+  idle = g_queue_is_empty (&channel->priv->active_jobs);
+  g_mutex_unlock (&channel->priv->lock);
+
+  job = active->job;
+  if (job)
+    g_vfs_job_emit_finished (job);
 
   class = G_VFS_CHANNEL_GET_CLASS (channel);
   
-  if (G_VFS_IS_JOB_CLOSE_READ (job) ||
-      G_VFS_IS_JOB_CLOSE_WRITE (job))
+  if (job != NULL &&
+      (G_VFS_IS_JOB_CLOSE_READ (job) ||
+       G_VFS_IS_JOB_CLOSE_WRITE (job)))
     {
       /* Cancel the reader */
       g_cancellable_cancel (channel->priv->cancellable);
@@ -624,40 +933,168 @@ send_reply_cb (GObject *source_object,
     }
   else if (channel->priv->connection_closed)
     {
-
-      channel->priv->current_job = class->close (channel);
-      channel->priv->current_job_seq_nr = 0;
-      g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (channel), channel->priv->current_job);
+      if (idle && channel->priv->backend_handle != NULL)
+	start_close (channel);
     }
-  /* Start queued request or readahead */
+  /* Start queued request, flush or readahead */
   else if (!start_queued_request (channel) &&
-	   class->readahead)
+	   channel->priv->queued_requests == NULL &&
+	   job != NULL)
+    {
+      GVfsJob *readahead_job;
+      gboolean flushed;
+
+      /* No queued requests, write out buffered data if there is
+	 enough of it, or maybe we want to do readahead calls.
+	 If the backend pipelines reads there may be several. */
+      flushed =
+	can_start_request (channel, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_WRITE) &&
+	start_flush (channel, FALSE);
+
+      while (!flushed && class->readahead &&
+	     can_start_request (channel, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_READ) &&
+	     (readahead_job = class->readahead (channel, job)) != NULL)
+	start_job (channel, readahead_job,
+		   G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_READ, 0);
+    }
+
+  /* The next job may have replied while we were writing */
+  write_next_reply (channel);
+
+  active_job_free (active);
+}
+
+static gboolean
+finish_internal_job_cb (gpointer data)
+{
+  GVfsChannel *channel = data;
+
+  finish_head_job (channel);
+  return FALSE;
+}
+
+/* Copies data into the shared memory ring if the client mapped it
+ * and there is room. Only called by the reply writer, so replies and
+ * ring positions stay in the same order.
+ *
+ * The data is still copied here and again by the client, only the
+ * socket writes and reads and their kernel copies are saved. The
+ * backend can't read into the ring directly, as the slot is only
+ * known once the reply is next in line. Writes don't use the ring. */
+static gboolean
+shm_put (GVfsChannel *channel,
+	 const char *data,
+	 gsize len)
+{
+  GVfsDaemonShmHeader *header;
+  char *ring;
+  guint32 read_pos, used, pos;
+  gsize first;
+
+  header = (GVfsDaemonShmHeader *)channel->priv->shm;
+  ring = channel->priv->shm + G_VFS_DAEMON_SHM_HEADER_SIZE;
+
+  if (!g_atomic_int_get ((gint *)&header->mapped))
+    return FALSE;
+
+  read_pos = g_atomic_int_get ((gint *)&header->read_pos);
+  used = channel->priv->shm_write_pos - read_pos;
+  if (used > channel->priv->shm_ring_size ||
+      channel->priv->shm_ring_size - used < len)
+    return FALSE;
+
+  pos = channel->priv->shm_write_pos % channel->priv->shm_ring_size;
+  first = MIN (len, channel->priv->shm_ring_size - pos);
+  memcpy (ring + pos, data, first);
+  memcpy (ring, data + first, len - first);
+
+  channel->priv->shm_write_pos += len;
+
+  return TRUE;
+}
+
+/* Called with the lock held, for the head job when its reply goes out.
+ * If a read or write fails while later ones are already running their
+ * data would leave a hole or end up at the wrong offset, so they fail
+ * too. */
+static void
+check_pipeline_unlocked (GVfsChannel *channel,
+			 ActiveJob   *active)
+{
+  GError *error;
+  gsize data_len;
+
+  if (active->is_error)
     {
-      /* No queued requests, maybe we want to do a readahead call */
-      channel->priv->current_job = class->readahead (channel, job);
-      channel->priv->current_job_seq_nr = 0;
-      if (channel->priv->current_job)
-	g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (channel), channel->priv->current_job);
+      if (active->job != NULL &&
+	  g_queue_get_length (&channel->priv->active_jobs) > 1)
+	channel->priv->pipeline_failed = TRUE;
+      return;
     }
 
-  g_object_unref (job);
+  if (!channel->priv->pipeline_failed)
+    return;
+
+  error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+			       _("An earlier read or write failed"));
+  g_free (active->free_data);
+  active->free_data = g_error_to_daemon_reply (error, active->seq_nr, &data_len);
+  active->data = active->free_data;
+  active->data_len = data_len;
+  active->has_reply_header = FALSE;
+  active->is_error = TRUE;
+  g_error_free (error);
 }
 
 /* Might be called on an i/o thread */
-void
-g_vfs_channel_send_reply (GVfsChannel *channel,
-			  GVfsDaemonSocketProtocolReply *reply,
-			  const void *data,
-			  gsize data_len)
+static void
+write_next_reply (GVfsChannel *channel)
 {
-  
-  channel->priv->output_data = data;
-  channel->priv->output_data_size = data_len;
+  ActiveJob *active;
+
+  g_mutex_lock (&channel->priv->lock);
+  active = g_queue_peek_head (&channel->priv->active_jobs);
+  if (channel->priv->writing_reply ||
+      active == NULL ||
+      !active->has_reply)
+    {
+      g_mutex_unlock (&channel->priv->lock);
+      return;
+    }
+  channel->priv->writing_reply = TRUE;
+  if (!active->internal &&
+      is_pipelined_command (active->command))
+    check_pipeline_unlocked (channel, active);
+  g_mutex_unlock (&channel->priv->lock);
+
+  if (active->internal)
+    {
+      /* Nothing to send, but finish it on the main thread */
+      g_idle_add_full (G_PRIORITY_DEFAULT, finish_internal_job_cb,
+		       g_object_ref (channel), g_object_unref);
+      return;
+    }
+
+  /* Send data through shared memory when possible, the reply
+     then only says how much there is */
+  if (channel->priv->shm != NULL &&
+      active->has_reply_header &&
+      g_ntohl (active->reply.type) == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA &&
+      active->data_len > 0 &&
+      shm_put (channel, active->data, active->data_len))
+    {
+      active->reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SHM_DATA);
+      active->data = NULL;
+      active->data_len = 0;
+    }
+
+  channel->priv->output_data = active->data;
+  channel->priv->output_data_size = active->data_len;
   channel->priv->output_data_pos = 0;
 
-  if (reply != NULL)
+  if (active->has_reply_header)
     {
-      memcpy (channel->priv->reply_buffer, reply, sizeof (GVfsDaemonSocketProtocolReply));
+      memcpy (channel->priv->reply_buffer, &active->reply, sizeof (GVfsDaemonSocketProtocolReply));
       channel->priv->reply_buffer_pos = 0;
 
       g_output_stream_write_async (channel->priv->reply_stream,
@@ -677,23 +1114,75 @@ g_vfs_channel_send_reply (GVfsChannel *channel,
     }
 }
 
+/* Takes ownership of free_data */
+static void
+set_job_reply (GVfsChannel *channel,
+	       GVfsJob *job,
+	       GVfsDaemonSocketProtocolReply *reply,
+	       const void *data,
+	       gsize data_len,
+	       gpointer free_data,
+	       gboolean is_error)
+{
+  ActiveJob *active;
+
+  g_mutex_lock (&channel->priv->lock);
+  active = find_active_job_unlocked (channel, job);
+  if (active == NULL || active->has_reply)
+    {
+      g_mutex_unlock (&channel->priv->lock);
+      g_warning ("Reply for unknown job on channel");
+      g_free (free_data);
+      return;
+    }
+
+  if (reply != NULL)
+    {
+      active->reply = *reply;
+      active->has_reply_header = TRUE;
+    }
+  active->data = data;
+  active->data_len = data_len;
+  active->free_data = free_data;
+  active->has_reply = TRUE;
+  active->is_error = is_error;
+  g_mutex_unlock (&channel->priv->lock);
+
+  /* Replies go out in request order, this only writes if job is first */
+  write_next_reply (channel);
+}
+
+/* Might be called on an i/o thread
+ * data is owned by job and must stay valid until it is finished */
+void
+g_vfs_channel_send_reply (GVfsChannel *channel,
+			  GVfsJob *job,
+			  GVfsDaemonSocketProtocolReply *reply,
+			  const void *data,
+			  gsize data_len)
+{
+  set_job_reply (channel, job, reply, data, data_len, NULL, FALSE);
+}
+
 /* Might be called on an i/o thread
  */
 void
 g_vfs_channel_send_error (GVfsChannel *channel,
+			  GVfsJob *job,
 			  GError *error)
 {
   char *data;
   gsize data_len;
   
-  data = g_error_to_daemon_reply (error, channel->priv->current_job_seq_nr, &data_len);
-  g_vfs_channel_send_reply (channel, NULL, data, data_len);
+  data = g_error_to_daemon_reply (error, g_vfs_channel_get_job_seq_nr (channel, job), &data_len);
+  set_job_reply (channel, job, NULL, data, data_len, data, TRUE);
 }
 
 /* Might be called on an i/o thread
  */
 void
 g_vfs_channel_send_info (GVfsChannel *channel,
+			 GVfsJob *job,
 			 GFileInfo *info)
 {
   GVfsDaemonSocketProtocolReply reply;
@@ -703,11 +1192,70 @@ g_vfs_channel_send_info (GVfsChannel *channel,
   data = gvfs_file_info_marshal (info, &data_len);
 
   reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_INFO);
-  reply.seq_nr = g_htonl (g_vfs_channel_get_current_seq_nr (channel));
+  reply.seq_nr = g_htonl (g_vfs_channel_get_job_seq_nr (channel, job));
   reply.arg1 = 0;
   reply.arg2 = g_htonl (data_len);
 
-  g_vfs_channel_send_reply (channel, &reply, data, data_len);
+  set_job_reply (channel, job, &reply, data, data_len, data, FALSE);
+}
+
+/* Writes out data buffered by the channel class if the channel is idle,
+ * e.g. when no more writes came in for a while */
+void
+g_vfs_channel_flush (GVfsChannel *channel)
+{
+  gboolean idle;
+
+  g_mutex_lock (&channel->priv->lock);
+  idle = g_queue_is_empty (&channel->priv->active_jobs);
+  g_mutex_unlock (&channel->priv->lock);
+
+  if (idle &&
+      channel->priv->queued_requests == NULL &&
+      !channel->priv->connection_closed)
+    start_flush (channel, TRUE);
+}
+
+/**
+ * g_vfs_channel_set_shared_memory:
+ * @channel: channel
+ * @fd: a shared memory fd, as passed to the client
+ * @ring_size: size of the data ring, a power of two
+ *
+ * Maps the shared memory negotiated at open time. Once the client
+ * has mapped it too, data replies go through the ring when there is
+ * room. At most MAX_SHM_CHANNELS channels of a daemon have a ring.
+ *
+ * Returns: %TRUE if the memory could be mapped
+ **/
+gboolean
+g_vfs_channel_set_shared_memory (GVfsChannel *channel,
+				 int          fd,
+				 gsize        ring_size)
+{
+  void *shm;
+
+  g_return_val_if_fail (channel->priv->shm == NULL, FALSE);
+
+  if (g_atomic_int_add (&n_shm_channels, 1) >= MAX_SHM_CHANNELS)
+    {
+      g_atomic_int_add (&n_shm_channels, -1);
+      return FALSE;
+    }
+
+  shm = mmap (NULL, G_VFS_DAEMON_SHM_HEADER_SIZE + ring_size,
+	      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (shm == MAP_FAILED)
+    {
+      g_atomic_int_add (&n_shm_channels, -1);
+      return FALSE;
+    }
+
+  channel->priv->shm = shm;
+  channel->priv->shm_ring_size = ring_size;
+  channel->priv->shm_write_pos = 0;
+
+  return TRUE;
 }
 
 int
@@ -738,10 +1286,20 @@ g_vfs_channel_get_backend_handle (GVfsChannel *channel)
   return channel->priv->backend_handle;
 }
 
+/* Might be called on an i/o thread */
 guint32
-g_vfs_channel_get_current_seq_nr (GVfsChannel *channel)
+g_vfs_channel_get_job_seq_nr (GVfsChannel *channel,
+			      GVfsJob *job)
 {
-  return channel->priv->current_job_seq_nr;
+  ActiveJob *active;
+  guint32 seq_nr;
+
+  g_mutex_lock (&channel->priv->lock);
+  active = find_active_job_unlocked (channel, job);
+  seq_nr = active ? active->seq_nr : 0;
+  g_mutex_unlock (&channel->priv->lock);
+
+  return seq_nr;
 }
 
 GPid
@@ -762,17 +1320,27 @@ free_queued_requests (gpointer data)
 void
 g_vfs_channel_force_close (GVfsChannel *channel)
 {
-  GVfsJob *job;
+  GList   *jobs, *l;
   gint     fd;
 
   fd = g_unix_input_stream_get_fd (G_UNIX_INPUT_STREAM (channel->priv->command_stream));
 
   shutdown (fd, SHUT_RDWR);
 
-  job = channel->priv->current_job;
+  jobs = NULL;
+  g_mutex_lock (&channel->priv->lock);
+  for (l = channel->priv->active_jobs.head; l != NULL; l = l->next)
+    {
+      ActiveJob *active = l->data;
 
-  if (job)
-    g_vfs_job_cancel (job);
+      if (active->job)
+	jobs = g_list_prepend (jobs, g_object_ref (active->job));
+    }
+  g_mutex_unlock (&channel->priv->lock);
+
+  for (l = jobs; l != NULL; l = l->next)
+    g_vfs_job_cancel (l->data);
+  g_list_free_full (jobs, g_object_unref);
 
   g_list_free_full (channel->priv->queued_requests, free_queued_requests);
   channel->priv->queued_requests = NULL;
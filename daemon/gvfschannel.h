@@ -63,11 +63,16 @@ struct _GVfsChannelClass
 			      GError **error);
   GVfsJob *(*readahead)      (GVfsChannel *channel,
 			      GVfsJob *job);
+  GVfsJob *(*flush)          (GVfsChannel *channel,
+			      gboolean force);
 };
 
 GType g_vfs_channel_get_type (void) G_GNUC_CONST;
 
 int               g_vfs_channel_steal_remote_fd    (GVfsChannel                   *channel);
+gboolean          g_vfs_channel_set_shared_memory  (GVfsChannel                   *channel,
+						    int                            fd,
+						    gsize                          ring_size);
 GVfsBackend    *  g_vfs_channel_get_backend        (GVfsChannel                   *channel);
 GVfsBackendHandle g_vfs_channel_get_backend_handle (GVfsChannel                   *channel);
 void              g_vfs_channel_set_backend_handle (GVfsChannel                   *channel,
@@ -75,16 +80,21 @@ void              g_vfs_channel_set_backend_handle (GVfsChannel
 gboolean          g_vfs_channel_has_job            (GVfsChannel                   *channel);
 GVfsJob *         g_vfs_channel_get_job            (GVfsChannel                   *channel);
 void              g_vfs_channel_send_error         (GVfsChannel                   *channel,
+						    GVfsJob                       *job,
 						    GError                        *error);
 void              g_vfs_channel_send_info          (GVfsChannel                   *channel,
+						    GVfsJob                       *job,
 						    GFileInfo                     *info);
 void              g_vfs_channel_send_reply         (GVfsChannel                   *channel,
+						    GVfsJob                       *job,
 						    GVfsDaemonSocketProtocolReply *reply,
 						    const void                    *data,
 						    gsize                          data_len);
-guint32           g_vfs_channel_get_current_seq_nr (GVfsChannel                   *channel);
+guint32           g_vfs_channel_get_job_seq_nr     (GVfsChannel                   *channel,
+						    GVfsJob                       *job);
 GPid              g_vfs_channel_get_actual_consumer (GVfsChannel                  *channel);
 void              g_vfs_channel_force_close        (GVfsChannel                   *channel);
+void              g_vfs_channel_flush              (GVfsChannel                   *channel);
 /* TODO: i/o priority? */
 
 G_END_DECLS
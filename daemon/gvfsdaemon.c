@@ -42,12 +42,55 @@
 #include <gvfsjobmount.h>
 #include <gvfsjobopenforread.h>
 #include <gvfsjobopenforwrite.h>
+#include <gvfsjobqueryinfo.h>
+#include <gvfsjobqueryinforead.h>
+#include <gvfsjobqueryinfowrite.h>
+#include <gvfsjobqueryfsinfo.h>
+#include <gvfsjobqueryattributes.h>
+#include <gvfsjobenumerate.h>
+#include <gvfsjobread.h>
+#include <gvfsjobwrite.h>
+#include <gvfsjobcopy.h>
+#include <gvfsjobpush.h>
+#include <gvfsjobpull.h>
+#include <gvfsjobstats.h>
+#include <gvfschannel.h>
 #include <gvfsdbusutils.h>
 
 enum {
   PROP_0
 };
 
+/* The job thread pool starts with a single thread and grows towards
+ * thread_limit while jobs are queued behind slow ones. A job that would
+ * wait longer than this for a thread is considered stalled. */
+#define SLOW_JOB_USECS     (50 * 1000)
+/* Don't shrink the pool again until it has been quiet for a while */
+#define POOL_SHRINK_USECS  (2 * G_USEC_PER_SEC)
+
+/* Jobs waiting for a thread are dequeued in weighted fair order, so
+ * that latency sensitive metadata requests (e.g. from a file manager)
+ * overtake bulk transfers queued before them, while bulk transfers
+ * still get their share of the threads. */
+typedef enum {
+  JOB_LANE_INTERACTIVE,
+  JOB_LANE_NORMAL,
+  JOB_LANE_BULK,
+  N_JOB_LANES
+} JobLane;
+
+/* Virtual time a job in the lane costs, i.e. the inverse lane weight.
+ * With all lanes busy, 8 interactive and 4 normal jobs are
+ * started for every bulk job. */
+static const guint64 lane_cost[N_JOB_LANES] = { 1, 2, 8 };
+
+typedef struct {
+  GVfsJob *job;
+  guint64 finish_tag;
+  guint64 serial;
+  gboolean dropped;	/* failed to push, the job was failed instead */
+} QueuedJob;
+
 typedef struct {
   char *obj_path;
   DBusObjectPathMessageFunction callback;
@@ -62,16 +105,34 @@ struct _GVfsDaemon
   gboolean main_daemon;
 
   GThreadPool *thread_pool;
+  gint max_threads;      /* Ceiling from g_vfs_daemon_set_max_threads(), -1 == unlimited */
+  gint thread_limit;     /* max_threads further limited by the backends */
+  gint base_threads;     /* Pool size when idle, a finite max_threads or 1 */
+  gint pool_threads;     /* Current size of thread_pool */
+  guint pending_jobs;    /* Pushed to thread_pool, but not yet started */
+  GList *running_jobs;   /* RunningJob, one for each busy thread */
+  gint64 avg_job_time;   /* Exponentially weighted average run time */
+  gint64 last_resize_time;
+  guint grow_tag;
+  guint64 virtual_time;  /* finish_tag of the last started job */
+  guint64 lane_tag[N_JOB_LANES];
+  guint64 job_serial;
   DBusConnection *session_bus;
   GHashTable *registered_paths;
   GList *jobs;
   GList *job_sources;
+  GHashTable *inflight_jobs; /* singleflight key -> job doing the work */
 
   guint exit_tag;
   
   gint mount_counter;
 };
 
+typedef struct {
+  GVfsJob *job;
+  gint64 start_time;
+} RunningJob;
+
 typedef struct {
   GVfsDaemon *daemon;
   char *socket_dir;
@@ -119,6 +180,7 @@ g_vfs_daemon_finalize (GObject *object)
   g_assert (daemon->jobs == NULL);
 
   g_hash_table_destroy (daemon->registered_paths);
+  g_hash_table_destroy (daemon->inflight_jobs);
   g_mutex_clear (&daemon->lock);
 
   if (G_OBJECT_CLASS (g_vfs_daemon_parent_class)->finalize)
@@ -135,28 +197,260 @@ g_vfs_daemon_class_init (GVfsDaemonClass *klass)
   gobject_class->get_property = g_vfs_daemon_get_property;
 }
 
+/* Called with the lock held */
+static void
+daemon_resize_pool_unlocked (GVfsDaemon *daemon,
+			     gint        pool_threads)
+{
+  if (pool_threads == daemon->pool_threads)
+    return;
+
+  g_debug ("Resizing job thread pool from %d to %d threads\n",
+	   daemon->pool_threads, pool_threads);
+
+  daemon->pool_threads = pool_threads;
+  daemon->last_resize_time = g_get_monotonic_time ();
+  g_thread_pool_set_max_threads (daemon->thread_pool, pool_threads, NULL);
+}
+
+/* Called with the lock held.
+ * Returns TRUE if there are still jobs waiting for a thread that
+ * we could start more threads for later. */
+static gboolean
+daemon_maybe_grow_pool_unlocked (GVfsDaemon *daemon)
+{
+  gint64 now, busy_time;
+  GList *l;
+
+  if (daemon->pending_jobs == 0 ||
+      daemon->pool_threads >= daemon->thread_limit)
+    return FALSE;
+
+  /* There is a free thread for the queued jobs */
+  if ((gint) (g_list_length (daemon->running_jobs) + daemon->pending_jobs) <= daemon->pool_threads)
+    return FALSE;
+
+  /* Queued jobs have to wait for a running one, grow if that is
+   * likely to take long, either because jobs are generally slow or
+   * because one of the running jobs has been stuck for a while. */
+  now = g_get_monotonic_time ();
+  busy_time = daemon->avg_job_time;
+  for (l = daemon->running_jobs; l != NULL; l = l->next)
+    {
+      RunningJob *running = l->data;
+      busy_time = MAX (busy_time, now - running->start_time);
+    }
+
+  if (busy_time < SLOW_JOB_USECS)
+    return TRUE;
+
+  daemon_resize_pool_unlocked (daemon, daemon->pool_threads + 1);
+  return daemon->pool_threads < daemon->thread_limit;
+}
+
+static gboolean
+grow_pool_timeout (gpointer data)
+{
+  GVfsDaemon *daemon = data;
+  gboolean again;
+
+  g_mutex_lock (&daemon->lock);
+  again = daemon_maybe_grow_pool_unlocked (daemon);
+  if (!again)
+    daemon->grow_tag = 0;
+  g_mutex_unlock (&daemon->lock);
+
+  return again;
+}
+
+static JobLane
+job_get_lane (GVfsJob *job)
+{
+  if (G_VFS_IS_JOB_QUERY_INFO (job) ||
+      G_VFS_IS_JOB_QUERY_INFO_READ (job) ||
+      G_VFS_IS_JOB_QUERY_INFO_WRITE (job) ||
+      G_VFS_IS_JOB_QUERY_FS_INFO (job) ||
+      G_VFS_IS_JOB_QUERY_ATTRIBUTES (job) ||
+      G_VFS_IS_JOB_ENUMERATE (job))
+    return JOB_LANE_INTERACTIVE;
+
+  if (G_VFS_IS_JOB_READ (job) ||
+      G_VFS_IS_JOB_WRITE (job) ||
+      G_VFS_IS_JOB_PUSH (job) ||
+      G_VFS_IS_JOB_PULL (job) ||
+      G_VFS_IS_JOB_COPY (job))
+    return JOB_LANE_BULK;
+
+  return JOB_LANE_NORMAL;
+}
+
+/* Called by the thread pool with its queue locked */
+static gint
+queued_job_compare (gconstpointer a,
+		    gconstpointer b,
+		    gpointer      user_data)
+{
+  const QueuedJob *queued_a = a;
+  const QueuedJob *queued_b = b;
+
+  if (queued_a->finish_tag != queued_b->finish_tag)
+    return queued_a->finish_tag < queued_b->finish_tag ? -1 : 1;
+
+  /* FIFO within a lane */
+  if (queued_a->serial != queued_b->serial)
+    return queued_a->serial < queued_b->serial ? -1 : 1;
+
+  return 0;
+}
+
 static void
 job_handler_callback (gpointer       data,
 		      gpointer       user_data)
 {
-  GVfsJob *job = G_VFS_JOB (data);
+  GVfsDaemon *daemon = user_data;
+  QueuedJob *queued = data;
+  GVfsJob *job = queued->job;
+  RunningJob running;
+  gint64 now;
+  gint n_running;
+
+  running.job = job;
+  running.start_time = g_get_monotonic_time ();
+
+  g_mutex_lock (&daemon->lock);
+  if (queued->dropped)
+    {
+      g_mutex_unlock (&daemon->lock);
+      g_free (queued);
+      return;
+    }
+  daemon->virtual_time = MAX (daemon->virtual_time, queued->finish_tag);
+  daemon->pending_jobs--;
+  daemon->running_jobs = g_list_prepend (daemon->running_jobs, &running);
+  g_mutex_unlock (&daemon->lock);
 
   g_vfs_job_run (job);
+
+  now = g_get_monotonic_time ();
+
+  g_mutex_lock (&daemon->lock);
+  daemon->running_jobs = g_list_remove (daemon->running_jobs, &running);
+  daemon->avg_job_time = (daemon->avg_job_time * 7 + (now - running.start_time)) / 8;
+
+  /* Give back the threads we grew when the queue has drained */
+  n_running = g_list_length (daemon->running_jobs);
+  if (daemon->pending_jobs == 0 &&
+      daemon->pool_threads > MAX (n_running, MIN (daemon->base_threads, daemon->thread_limit)) &&
+      now - daemon->last_resize_time > POOL_SHRINK_USECS)
+    daemon_resize_pool_unlocked (daemon, daemon->pool_threads - 1);
+  g_mutex_unlock (&daemon->lock);
+
+  g_free (queued);
+}
+
+static void
+daemon_push_job (GVfsDaemon *daemon,
+		 GVfsJob    *job)
+{
+  QueuedJob *queued;
+  JobLane lane;
+  GError *error;
+
+  lane = job_get_lane (job);
+
+  queued = g_new (QueuedJob, 1);
+  queued->job = job;
+  queued->dropped = FALSE;
+
+  g_mutex_lock (&daemon->lock);
+  /* A lane that was idle starts at the current virtual time,
+     so it can't make up for the time it didn't use */
+  queued->finish_tag = MAX (daemon->lane_tag[lane], daemon->virtual_time) + lane_cost[lane];
+  queued->serial = daemon->job_serial++;
+  daemon->lane_tag[lane] = queued->finish_tag;
+  daemon->pending_jobs++;
+  if (daemon_maybe_grow_pool_unlocked (daemon) &&
+      daemon->grow_tag == 0)
+    daemon->grow_tag = g_timeout_add (SLOW_JOB_USECS / 1000,
+				      grow_pool_timeout, daemon);
+
+  /* Pushed with the lock held, so no thread can pick the job up
+     before we know whether it got queued properly. GThreadPool
+     keeps the data queued even when it fails to start a thread. */
+  error = NULL;
+  if (!g_thread_pool_push (daemon->thread_pool, queued, &error))
+    {
+      queued->dropped = TRUE;
+      daemon->pending_jobs--;
+    }
+  g_mutex_unlock (&daemon->lock);
+
+  if (error != NULL)
+    {
+      g_vfs_job_failed_from_error (job, error);
+      g_error_free (error);
+    }
+}
+
+/* Called with the lock held */
+static void
+daemon_update_thread_limit_unlocked (GVfsDaemon *daemon)
+{
+  gint limit, backend_limit;
+  gboolean have_backend;
+  GList *l;
+
+  limit = daemon->max_threads < 0 ? G_MAXINT : daemon->max_threads;
+
+  /* Backends that know how many requests they can handle in
+     parallel (e.g. the number of server connections) cap the pool,
+     the others get the daemon wide limit. */
+  have_backend = FALSE;
+  backend_limit = 1;
+  for (l = daemon->job_sources; l != NULL; l = l->next)
+    {
+      if (G_VFS_IS_BACKEND (l->data))
+	{
+	  guint max_job_threads;
+
+	  max_job_threads = g_vfs_backend_get_max_job_threads (l->data);
+	  have_backend = TRUE;
+	  backend_limit = MAX (backend_limit,
+			       max_job_threads > 0 ? (gint) MIN (max_job_threads, G_MAXINT) : limit);
+	}
+    }
+
+  if (have_backend)
+    limit = MIN (limit, backend_limit);
+
+  daemon->thread_limit = MAX (limit, 1);
+
+  if (daemon->pool_threads > daemon->thread_limit)
+    daemon_resize_pool_unlocked (daemon, daemon->thread_limit);
+  else if (daemon->pool_threads < MIN (daemon->base_threads, daemon->thread_limit))
+    daemon_resize_pool_unlocked (daemon, MIN (daemon->base_threads, daemon->thread_limit));
+  else
+    daemon_maybe_grow_pool_unlocked (daemon);
 }
 
 static void
 g_vfs_daemon_init (GVfsDaemon *daemon)
 {
-  gint max_threads = 1; /* TODO: handle max threads */
   DBusError error;
   
   daemon->session_bus = dbus_bus_get (DBUS_BUS_SESSION, NULL);
+  daemon->max_threads = 1;
+  daemon->thread_limit = 1;
+  daemon->base_threads = 1;
+  daemon->pool_threads = 1;
   daemon->thread_pool = g_thread_pool_new (job_handler_callback,
 					   daemon,
-					   max_threads,
+					   daemon->pool_threads,
 					   FALSE, NULL);
   /* TODO: verify thread_pool != NULL in a nicer way */
   g_assert (daemon->thread_pool != NULL);
+  g_thread_pool_set_sort_function (daemon->thread_pool,
+				   queued_job_compare, NULL);
 
   g_mutex_init (&daemon->lock);
 
@@ -166,6 +460,8 @@ g_vfs_daemon_init (GVfsDaemon *daemon)
   daemon->registered_paths =
     g_hash_table_new_full (g_str_hash, g_str_equal,
 			   NULL, (GDestroyNotify)registered_path_free);
+  daemon->inflight_jobs =
+    g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
   dbus_error_init (&error);
   dbus_bus_add_match (daemon->session_bus,
@@ -284,11 +580,87 @@ g_vfs_daemon_new (gboolean main_daemon, gboolean replace)
   return daemon;
 }
 
+/**
+ * g_vfs_daemon_set_max_threads:
+ * @daemon: A #GVfsDaemon.
+ * @max_threads: upper limit of job threads, or -1 for no limit
+ *
+ * Sets the maximum number of threads running blocking jobs. With a
+ * limit the pool keeps that many threads, as far as the backends
+ * allow (see g_vfs_backend_set_max_job_threads()). Without one the
+ * daemon starts with a single thread and only adds more when jobs
+ * queue up behind slow ones.
+ */
 void
 g_vfs_daemon_set_max_threads (GVfsDaemon                    *daemon,
 			      gint                           max_threads)
 {
-  g_thread_pool_set_max_threads (daemon->thread_pool, max_threads, NULL);
+  g_mutex_lock (&daemon->lock);
+  daemon->max_threads = max_threads;
+  daemon->base_threads = max_threads > 0 ? max_threads : 1;
+  daemon_update_thread_limit_unlocked (daemon);
+  g_mutex_unlock (&daemon->lock);
+}
+
+/**
+ * g_vfs_daemon_update_thread_limit:
+ * @daemon: A #GVfsDaemon.
+ *
+ * Recomputes the job thread limit after a backend changed
+ * its number of parallel jobs.
+ */
+void
+g_vfs_daemon_update_thread_limit (GVfsDaemon *daemon)
+{
+  g_mutex_lock (&daemon->lock);
+  daemon_update_thread_limit_unlocked (daemon);
+  g_mutex_unlock (&daemon->lock);
+}
+
+/**
+ * g_vfs_daemon_get_thread_limit:
+ * @daemon: A #GVfsDaemon.
+ *
+ * Gets how many jobs may run in threads at the same time, at most
+ * %G_MAXINT.
+ *
+ * Returns: the job thread limit.
+ */
+gint
+g_vfs_daemon_get_thread_limit (GVfsDaemon *daemon)
+{
+  gint limit;
+
+  g_mutex_lock (&daemon->lock);
+  limit = daemon->thread_limit;
+  g_mutex_unlock (&daemon->lock);
+
+  return limit;
+}
+
+/**
+ * g_vfs_daemon_has_stalled_jobs:
+ * @daemon: A #GVfsDaemon.
+ *
+ * Checks whether jobs are waiting for a thread that the pool can't
+ * provide until a running job finishes. A running job must not block
+ * on something a queued one might be needed for while this is true.
+ *
+ * Returns: %TRUE if queued jobs wait for running ones.
+ */
+gboolean
+g_vfs_daemon_has_stalled_jobs (GVfsDaemon *daemon)
+{
+  gboolean stalled;
+
+  g_mutex_lock (&daemon->lock);
+  stalled =
+    daemon->pending_jobs > 0 &&
+    daemon->pool_threads >= daemon->thread_limit &&
+    (gint) (g_list_length (daemon->running_jobs) + daemon->pending_jobs) > daemon->pool_threads;
+  g_mutex_unlock (&daemon->lock);
+
+  return stalled;
 }
 
 static gboolean
@@ -320,6 +692,19 @@ job_source_new_job_callback (GVfsJobSource *job_source,
 			     GVfsJob *job,
 			     GVfsDaemon *daemon)
 {
+  GVfsBackend *backend;
+
+  /* Remember whose job it is for the statistics */
+  backend = NULL;
+  if (G_VFS_IS_BACKEND (job_source))
+    backend = G_VFS_BACKEND (job_source);
+  else if (G_VFS_IS_CHANNEL (job_source))
+    backend = g_vfs_channel_get_backend (G_VFS_CHANNEL (job_source));
+
+  if (backend)
+    g_object_set_data_full (G_OBJECT (job), "g-vfs-job-stats-backend",
+			    g_object_ref (backend), g_object_unref);
+
   g_vfs_daemon_queue_job (daemon, job);
 }
 
@@ -339,6 +724,9 @@ job_source_closed_callback (GVfsJobSource *job_source,
 					(GCallback)job_source_closed_callback,
 					daemon);
   
+  if (G_VFS_IS_BACKEND (job_source))
+    daemon_update_thread_limit_unlocked (daemon);
+
   g_object_unref (job_source);
 
   if (daemon->job_sources == NULL)
@@ -387,6 +775,9 @@ g_vfs_daemon_add_job_source (GVfsDaemon *daemon,
 		    (GCallback)job_source_new_job_callback, daemon);
   g_signal_connect (job_source, "closed",
 		    (GCallback)job_source_closed_callback, daemon);
+
+  if (G_VFS_IS_BACKEND (job_source))
+    daemon_update_thread_limit_unlocked (daemon);
   
   g_mutex_unlock (&daemon->lock);
 }
@@ -430,6 +821,12 @@ static void
 job_finished_callback (GVfsJob *job, 
 		       GVfsDaemon *daemon)
 {
+  GVfsBackend *backend;
+  char *key;
+
+  backend = g_object_get_data (G_OBJECT (job), "g-vfs-job-stats-backend");
+  if (backend)
+    g_vfs_job_stats_record (backend, job);
 
   g_signal_handlers_disconnect_by_func (job,
 					(GCallback)job_new_source_callback,
@@ -438,10 +835,16 @@ job_finished_callback (GVfsJob *job,
 					(GCallback)job_finished_callback,
 					daemon);
 
+  key = g_vfs_job_get_singleflight_key (job);
+  
   g_mutex_lock (&daemon->lock);
   daemon->jobs = g_list_remove (daemon->jobs, job);
+  if (key != NULL &&
+      g_hash_table_lookup (daemon->inflight_jobs, key) == job)
+    g_hash_table_remove (daemon->inflight_jobs, key);
   g_mutex_unlock (&daemon->lock);
-  
+
+  g_free (key);
   g_object_unref (job);
 }
 
@@ -449,21 +852,41 @@ void
 g_vfs_daemon_queue_job (GVfsDaemon *daemon,
 			GVfsJob *job)
 {
+  GVfsJob *leader;
+  char *key;
+
   g_debug ("Queued new job %p (%s)\n", job, g_type_name_from_instance ((gpointer)job));
   
   g_object_ref (job);
   g_signal_connect (job, "finished", (GCallback)job_finished_callback, daemon);
   g_signal_connect (job, "new_source", (GCallback)job_new_source_callback, daemon);
+
+  key = g_vfs_job_get_singleflight_key (job);
   
   g_mutex_lock (&daemon->lock);
   daemon->jobs = g_list_prepend (daemon->jobs, job);
+
+  /* If an identical job is already in flight, wait for its result
+     instead of asking the backend again */
+  if (key != NULL)
+    {
+      leader = g_hash_table_lookup (daemon->inflight_jobs, key);
+      if (leader != NULL && g_vfs_job_add_follower (leader, job))
+	{
+	  g_mutex_unlock (&daemon->lock);
+	  g_debug ("Job %p waits for identical job %p\n", job, leader);
+	  g_free (key);
+	  return;
+	}
+      g_hash_table_replace (daemon->inflight_jobs, key, job);
+    }
   g_mutex_unlock (&daemon->lock);
   
   /* Can we start the job immediately / async */
   if (!g_vfs_job_try (job))
     {
       /* Couldn't finish / run async, queue worker thread */
-      g_thread_pool_push (daemon->thread_pool, job, NULL); /* TODO: Check error */
+      daemon_push_job (daemon, job);
     }
 }
 
@@ -885,6 +1308,63 @@ daemon_start_mount (GVfsDaemon *daemon,
     }
 }
 
+static void
+daemon_handle_get_stats (DBusConnection *conn,
+			 DBusMessage *message)
+{
+  DBusMessage *reply;
+  DBusMessageIter iter;
+
+  reply = dbus_message_new_method_return (message);
+  if (reply == NULL)
+    _g_dbus_oom ();
+
+  dbus_message_iter_init_append (reply, &iter);
+  g_vfs_job_stats_append (&iter);
+
+  dbus_connection_send (conn, reply, NULL);
+  dbus_message_unref (reply);
+}
+
+static void
+daemon_handle_enumerator_credit (DBusConnection *conn,
+				 DBusMessage *message,
+				 GVfsDaemon *daemon)
+{
+  GList *l;
+  const char *obj_path;
+  dbus_uint32_t credit;
+  GVfsJob *enumerate_job = NULL;
+
+  if (!dbus_message_get_args (message, NULL,
+			      DBUS_TYPE_STRING, &obj_path,
+			      DBUS_TYPE_UINT32, &credit,
+			      DBUS_TYPE_INVALID))
+    return;
+
+  g_mutex_lock (&daemon->lock);
+  for (l = daemon->jobs; l != NULL; l = l->next)
+    {
+      GVfsJob *job = l->data;
+
+      if (G_VFS_IS_JOB_ENUMERATE (job) &&
+	  g_vfs_job_enumerate_is_for (G_VFS_JOB_ENUMERATE (job),
+				      conn, obj_path))
+	{
+	  enumerate_job = g_object_ref (job);
+	  break;
+	}
+    }
+  g_mutex_unlock (&daemon->lock);
+
+  if (enumerate_job)
+    {
+      g_vfs_job_enumerate_add_credit (G_VFS_JOB_ENUMERATE (enumerate_job),
+				      credit);
+      g_object_unref (enumerate_job);
+    }
+}
+
 static DBusHandlerResult
 daemon_message_func (DBusConnection *conn,
 		     DBusMessage    *message,
@@ -976,6 +1456,40 @@ daemon_message_func (DBusConnection *conn,
       return DBUS_HANDLER_RESULT_HANDLED;
     }
 
+  if (dbus_message_is_method_call (message,
+				   G_VFS_DBUS_DAEMON_INTERFACE,
+				   G_VFS_DBUS_OP_ENUMERATOR_CREDIT))
+    {
+      daemon_handle_enumerator_credit (conn, message, daemon);
+      return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
+  if (strcmp (path, G_VFS_DBUS_DAEMON_PATH) == 0 &&
+      dbus_message_is_method_call (message,
+				   G_VFS_DBUS_STATS_INTERFACE,
+				   G_VFS_DBUS_STATS_OP_GET_STATS))
+    {
+      daemon_handle_get_stats (conn, message);
+      return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
+  if (strcmp (path, G_VFS_DBUS_DAEMON_PATH) == 0 &&
+      dbus_message_is_method_call (message,
+				   G_VFS_DBUS_STATS_INTERFACE,
+				   G_VFS_DBUS_STATS_OP_RESET_STATS))
+    {
+      DBusMessage *reply;
+
+      g_vfs_job_stats_reset ();
+
+      reply = dbus_message_new_method_return (message);
+      if (reply == NULL)
+	_g_dbus_oom ();
+      dbus_connection_send (conn, reply, NULL);
+      dbus_message_unref (reply);
+      return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
   if (strcmp (path, G_VFS_DBUS_MOUNTABLE_PATH) == 0 &&
       dbus_message_is_method_call (message,
 				   G_VFS_DBUS_MOUNTABLE_INTERFACE,
@@ -1118,7 +1632,7 @@ void
 g_vfs_daemon_run_job_in_thread (GVfsDaemon *daemon,
 				GVfsJob    *job)
 {
-  g_thread_pool_push (daemon->thread_pool, job, NULL); /* TODO: Check error */
+  daemon_push_job (daemon, job);
 }
 
 void
@@ -55,6 +55,9 @@ GVfsDaemon *g_vfs_daemon_new             (gboolean                       main_da
 					  gboolean                       replace);
 void        g_vfs_daemon_set_max_threads (GVfsDaemon                    *daemon,
 					  gint                           max_threads);
+void        g_vfs_daemon_update_thread_limit (GVfsDaemon                *daemon);
+gint        g_vfs_daemon_get_thread_limit (GVfsDaemon                   *daemon);
+gboolean    g_vfs_daemon_has_stalled_jobs (GVfsDaemon                   *daemon);
 void        g_vfs_daemon_add_job_source  (GVfsDaemon                    *daemon,
 					  GVfsJobSource                 *job_source);
 void        g_vfs_daemon_queue_job       (GVfsDaemon                    *daemon,
@@ -30,6 +30,8 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
+#include <poll.h>
 
 #include <glib.h>
 #include <glib/gi18n.h>
@@ -42,17 +44,34 @@
 
 static gint32 extra_fd_slot = -1;
 static GMutex extra_lock;
+/* Separate from extra_lock, receiving may wait for the client */
+static GMutex receive_lock;
 
 typedef struct {
   int extra_fd;
   int fd_count;
+  int received_fd_count;
+  GHashTable *received_fds; /* fd id -> fd, received but not asked for yet */
 } ConnectionExtra;
 
+static void
+close_received_fd (gpointer key,
+		   gpointer value,
+		   gpointer user_data)
+{
+  close (GPOINTER_TO_INT (value));
+}
+
 static void
 free_extra (gpointer p)
 {
   ConnectionExtra *extra = p;
   close (extra->extra_fd);
+  if (extra->received_fds)
+    {
+      g_hash_table_foreach (extra->received_fds, close_received_fd, NULL);
+      g_hash_table_destroy (extra->received_fds);
+    }
   g_free (extra);
 }
 
@@ -114,6 +133,151 @@ dbus_connection_send_fd (DBusConnection *connection,
   return TRUE;
 }
 
+/* Takes an fd the client sent with _g_dbus_connection_send_fd_sync().
+   Fds that arrive before it are kept for whoever asks for them, so
+   jobs can take their fds in any order. Waits at most timeout_msecs
+   for the fd to arrive, don't call it from the main thread. */
+int
+dbus_connection_receive_fd (DBusConnection *connection,
+			    int fd_id,
+			    int timeout_msecs,
+			    GError **error)
+{
+  ConnectionExtra *extra;
+  struct pollfd poll_fd;
+  gpointer stored;
+  int fd, res, errsv;
+
+  /* Calls over the session bus have no fd passing socket */
+  extra = NULL;
+  if (extra_fd_slot != -1)
+    extra = dbus_connection_get_data (connection, extra_fd_slot);
+
+  g_mutex_lock (&receive_lock);
+
+  if (extra == NULL || extra->extra_fd == -1)
+    {
+      g_set_error (error, G_IO_ERROR,
+		   G_IO_ERROR_FAILED,
+		   _("Internal Error (%s)"), "No such file descriptor");
+      g_mutex_unlock (&receive_lock);
+      return -1;
+    }
+
+  if (extra->received_fds == NULL)
+    extra->received_fds = g_hash_table_new (NULL, NULL);
+
+  if (g_hash_table_lookup_extended (extra->received_fds,
+				    GINT_TO_POINTER (fd_id),
+				    NULL, &stored))
+    {
+      g_hash_table_remove (extra->received_fds, GINT_TO_POINTER (fd_id));
+      g_mutex_unlock (&receive_lock);
+      return GPOINTER_TO_INT (stored);
+    }
+
+  if (fd_id < extra->received_fd_count)
+    {
+      g_set_error (error, G_IO_ERROR,
+		   G_IO_ERROR_FAILED,
+		   _("Internal Error (%s)"), "No such file descriptor");
+      g_mutex_unlock (&receive_lock);
+      return -1;
+    }
+
+  while (TRUE)
+    {
+      poll_fd.fd = extra->extra_fd;
+      poll_fd.events = POLLIN;
+      poll_fd.revents = 0;
+      res = poll (&poll_fd, 1, timeout_msecs);
+      if (res == -1 && errno == EINTR)
+	continue;
+
+      fd = -1;
+      errsv = ETIMEDOUT;
+      if (res == 1)
+	{
+	  /* Without an error set, the client closed the socket */
+	  errno = 0;
+	  fd = _g_socket_receive_fd (extra->extra_fd);
+	  errsv = errno != 0 ? errno : ECONNRESET;
+	}
+      else if (res == -1)
+	errsv = errno;
+
+      if (fd == -1)
+	{
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error receiving file descriptor: %s"),
+		       g_strerror (errsv));
+	  g_mutex_unlock (&receive_lock);
+	  return -1;
+	}
+
+      if (extra->received_fd_count == fd_id)
+	break;
+
+      g_hash_table_insert (extra->received_fds,
+			   GINT_TO_POINTER (extra->received_fd_count),
+			   GINT_TO_POINTER (fd));
+      extra->received_fd_count++;
+    }
+
+  extra->received_fd_count++;
+  g_mutex_unlock (&receive_lock);
+
+  return fd;
+}
+
+/**
+ * gvfs_create_shared_memory_fd:
+ * @size: size of the shared memory
+ * @error: return location for errors
+ *
+ * Creates an anonymous shared memory file of @size bytes that can be
+ * passed to a client with dbus_connection_send_fd() and mapped on both
+ * sides. Uses memfd_create() where available, otherwise an unlinked
+ * temporary file.
+ *
+ * Returns: the fd, or -1 on error
+ **/
+int
+gvfs_create_shared_memory_fd (gsize    size,
+			      GError **error)
+{
+  int fd, errsv;
+  char *path;
+
+  fd = -1;
+#ifdef HAVE_MEMFD_CREATE
+  fd = memfd_create ("gvfs-stream", MFD_CLOEXEC);
+#endif
+
+  if (fd == -1)
+    {
+      fd = g_file_open_tmp ("gvfs-stream-XXXXXX", &path, error);
+      if (fd == -1)
+	return -1;
+      unlink (path);
+      g_free (path);
+    }
+
+  if (ftruncate (fd, size) == -1)
+    {
+      errsv = errno;
+      g_set_error (error, G_IO_ERROR,
+		   g_io_error_from_errno (errsv),
+		   "Error creating shared memory: %s",
+		   g_strerror (errsv));
+      close (fd);
+      return -1;
+    }
+
+  return fd;
+}
+
 char *
 g_error_to_daemon_reply (GError *error, guint32 seq_nr, gsize *len_out)
 {
@@ -34,6 +34,12 @@ gboolean     dbus_connection_send_fd              (DBusConnection   *connection,
 						   int               fd,
 						   int              *fd_id,
 						   GError          **error);
+int          dbus_connection_receive_fd           (DBusConnection   *connection,
+						   int               fd_id,
+						   int               timeout_msecs,
+						   GError          **error);
+int          gvfs_create_shared_memory_fd         (gsize             size,
+						   GError          **error);
 char *       g_error_to_daemon_reply              (GError           *error,
 						   guint32           seq_nr,
 						   gsize            *len_out);
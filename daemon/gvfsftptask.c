@@ -215,6 +215,7 @@ g_vfs_ftp_task_acquire_connection (GVfsFtpTask *task)
            * This is necessary for threading reasons (connections can be
            * opened or closed while we are still in the opening process. */
           guint maybe_max_connections = ftp->connections;
+          guint max_connections;
 
           ftp->connections++;
           last_thread = g_thread_self ();
@@ -247,6 +248,12 @@ g_vfs_ftp_task_acquire_connection (GVfsFtpTask *task)
                   /* FIXME: shut down properly */
                   exit (0);
                 }
+              /* no use in having more job threads than connections,
+               * the daemon takes its own lock for that */
+              max_connections = ftp->max_connections;
+              g_mutex_unlock (&ftp->mutex);
+              g_vfs_backend_set_max_job_threads (G_VFS_BACKEND (ftp), max_connections);
+              g_mutex_lock (&ftp->mutex);
             }
 
           g_vfs_ftp_task_clear_error (task);
@@ -53,9 +53,23 @@ enum {
 
 struct _GVfsJobPrivate
 {
-  int dummy;
+  /* Monotonic times for the statistics */
+  gint64 create_time;
+  gint64 start_time;
+  gint64 reply_time;
+  guint64 bytes;
+
+  /* Identical jobs waiting for our result, protected by
+     followers_lock. No more can join once closed. */
+  GList *followers;
+  gboolean followers_closed;
+
+  /* Our client cancelled while followers still wanted the result */
+  gboolean reply_cancelled;
 };
 
+static GMutex followers_lock;
+
 static guint signals[LAST_SIGNAL] = { 0 };
 
 static void g_vfs_job_get_property (GObject    *object,
@@ -81,6 +95,8 @@ g_vfs_job_finalize (GObject *object)
     job->backend_data_destroy (job->backend_data);
 
   g_object_unref (job->cancellable);
+
+  g_list_free_full (job->priv->followers, g_object_unref);
   
   if (G_OBJECT_CLASS (g_vfs_job_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_vfs_job_parent_class)->finalize) (object);
@@ -137,7 +153,7 @@ g_vfs_job_init (GVfsJob *job)
   job->priv = G_TYPE_INSTANCE_GET_PRIVATE (job, G_VFS_TYPE_JOB, GVfsJobPrivate);
 
   job->cancellable = g_cancellable_new ();
-  
+  job->priv->create_time = g_get_monotonic_time ();
 }
 
 void
@@ -195,6 +211,7 @@ g_vfs_job_run (GVfsJob *job)
    */
   g_object_ref (job);
   
+  job->priv->start_time = g_get_monotonic_time ();
   class->run (job);
   
   g_object_unref (job);
@@ -213,6 +230,7 @@ g_vfs_job_try (GVfsJob *job)
    * we call g_vfs_job_succeed/fail()
    */
   g_object_ref (job);
+  job->priv->start_time = g_get_monotonic_time ();
   res = class->try (job);
   g_object_unref (job);
 
@@ -222,18 +240,61 @@ g_vfs_job_try (GVfsJob *job)
 void
 g_vfs_job_cancel (GVfsJob *job)
 {
+  gboolean shared;
+
   if (job->cancelled || job->sent_reply)
     return;
 
-  job->cancelled = TRUE;
+  /* Others are waiting for the result, so let it finish, but
+     answer our own client with G_IO_ERROR_CANCELLED */
+  g_mutex_lock (&followers_lock);
+  shared = job->priv->followers != NULL;
+  if (shared)
+    job->priv->reply_cancelled = TRUE;
+  else
+    job->cancelled = TRUE;
+  g_mutex_unlock (&followers_lock);
+  if (shared)
+    return;
+
   g_signal_emit (job, signals[CANCELLED], 0);
   g_cancellable_cancel (job->cancellable);
 }
 
+/* Might be called on an i/o thread */
+static void
+share_result (GVfsJob *job,
+	      GVfsJob *follower)
+{
+  GVfsJobClass *class;
+
+  class = G_VFS_JOB_GET_CLASS (job);
+
+  if (job->failed)
+    g_vfs_job_failed_from_error (follower, job->error);
+  else
+    class->share_result (job, follower);
+}
+
 static void 
 g_vfs_job_send_reply (GVfsJob *job)
 {
+  GList *l;
+
   job->sent_reply = TRUE;
+  job->priv->reply_time = g_get_monotonic_time ();
+
+  /* Before our own reply, which may add to the result */
+  for (l = g_vfs_job_get_followers (job); l != NULL; l = l->next)
+    share_result (job, l->data);
+
+  if (job->priv->reply_cancelled && !job->failed)
+    {
+      job->failed = TRUE;
+      job->error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+					_("Operation was cancelled"));
+    }
+
   g_signal_emit (job, signals[SEND_REPLY], 0);
 }
 
@@ -316,6 +377,88 @@ g_vfs_job_is_cancelled (GVfsJob *job)
   return job->cancelled;
 }
 
+/* Returns NULL if the job can't share its result */
+char *
+g_vfs_job_get_singleflight_key (GVfsJob *job)
+{
+  GVfsJobClass *class;
+
+  class = G_VFS_JOB_GET_CLASS (job);
+  if (class->get_singleflight_key == NULL ||
+      class->share_result == NULL)
+    return NULL;
+
+  return class->get_singleflight_key (job);
+}
+
+/* Makes follower, a job with the same singleflight key that was not
+ * started, complete with the result of job instead of running. Fails
+ * once job has started replying or was cancelled, the follower has to
+ * run by itself then. */
+gboolean
+g_vfs_job_add_follower (GVfsJob *job,
+			GVfsJob *follower)
+{
+  gboolean res;
+
+  g_mutex_lock (&followers_lock);
+  res = !job->priv->followers_closed &&
+    !job->cancelled && !job->priv->reply_cancelled;
+  if (res)
+    job->priv->followers = g_list_prepend (job->priv->followers,
+					   g_object_ref (follower));
+  g_mutex_unlock (&followers_lock);
+
+  return res;
+}
+
+/* Closes the job to new followers, so the list stays the same
+ * from here on. Might be called on an i/o thread. */
+GList *
+g_vfs_job_get_followers (GVfsJob *job)
+{
+  GList *followers;
+
+  g_mutex_lock (&followers_lock);
+  job->priv->followers_closed = TRUE;
+  followers = job->priv->followers;
+  g_mutex_unlock (&followers_lock);
+
+  return followers;
+}
+
+/* Might be called on an i/o thread */
+void
+g_vfs_job_add_bytes (GVfsJob *job,
+		     guint64  bytes)
+{
+  job->priv->bytes += bytes;
+}
+
+/* For the statistics. Splits the lifetime of a finished job into
+ * waiting to start, waiting for the backend to reply and waiting for
+ * the reply to be delivered. */
+void
+g_vfs_job_get_times (GVfsJob *job,
+		     gint64  *queue_usecs,
+		     gint64  *run_usecs,
+		     gint64  *reply_usecs,
+		     guint64 *bytes)
+{
+  GVfsJobPrivate *priv = job->priv;
+  gint64 start, reply;
+
+  /* Jobs that never started, e.g. cancelled ones, spent all their
+     time queued */
+  start = priv->start_time ? priv->start_time : g_get_monotonic_time ();
+  reply = priv->reply_time ? priv->reply_time : start;
+
+  *queue_usecs = MAX (start - priv->create_time, 0);
+  *run_usecs = MAX (reply - start, 0);
+  *reply_usecs = MAX (g_get_monotonic_time () - reply, 0);
+  *bytes = priv->bytes;
+}
+
 /* Might be called on an i/o thread */
 void
 g_vfs_job_emit_finished (GVfsJob *job)
@@ -75,6 +75,15 @@ struct _GVfsJobClass
 
   void     (*run)    (GVfsJob *job);
   gboolean (*try)    (GVfsJob *job);
+
+  /* Optional. Identical jobs queued while one is in flight wait for
+     it instead of running, see g_vfs_daemon_queue_job(). Returns a
+     key that is equal for jobs with the same result. */
+  char *   (*get_singleflight_key) (GVfsJob *job);
+  /* Gives a waiting job a copy of the successful result and makes
+     it succeed. Might be called on an i/o thread. */
+  void     (*share_result)         (GVfsJob *job,
+				    GVfsJob *follower);
 };
 
 GType g_vfs_job_get_type (void) G_GNUC_CONST;
@@ -88,6 +97,17 @@ void     g_vfs_job_cancel            (GVfsJob     *job);
 void     g_vfs_job_run               (GVfsJob     *job);
 gboolean g_vfs_job_try               (GVfsJob     *job);
 void     g_vfs_job_emit_finished     (GVfsJob     *job);
+char *   g_vfs_job_get_singleflight_key (GVfsJob *job);
+gboolean g_vfs_job_add_follower      (GVfsJob     *job,
+				      GVfsJob     *follower);
+GList *  g_vfs_job_get_followers     (GVfsJob     *job);
+void     g_vfs_job_add_bytes         (GVfsJob     *job,
+				      guint64      bytes);
+void     g_vfs_job_get_times         (GVfsJob     *job,
+				      gint64      *queue_usecs,
+				      gint64      *run_usecs,
+				      gint64      *reply_usecs,
+				      guint64     *bytes);
 void     g_vfs_job_failed            (GVfsJob     *job,
 				      GQuark       domain,
 				      gint         code,
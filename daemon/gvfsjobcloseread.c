@@ -95,9 +95,9 @@ send_reply (GVfsJob *job)
   g_debug ("job_close_read send reply\n");
 
   if (job->failed)
-    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job->error);
+    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job, job->error);
   else
-    g_vfs_read_channel_send_closed (op_job->channel);
+    g_vfs_read_channel_send_closed (op_job->channel, job);
 }
 
 static void
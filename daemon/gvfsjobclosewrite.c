@@ -99,13 +99,23 @@ static void
 send_reply (GVfsJob *job)
 {
   GVfsJobCloseWrite *op_job = G_VFS_JOB_CLOSE_WRITE (job);
+  GError *error;
   
   g_debug ("job_close_write send reply\n");
 
+  g_vfs_backend_invalidate_info (op_job->backend,
+				 g_vfs_write_channel_get_filename (op_job->channel));
+
   if (job->failed)
-    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job->error);
+    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job, job->error);
+  else if ((error = g_vfs_write_channel_take_error (op_job->channel)) != NULL)
+    {
+      /* A write-behind flush failed after the write was acknowledged */
+      g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job, error);
+      g_error_free (error);
+    }
   else
-    g_vfs_write_channel_send_closed (op_job->channel, op_job->etag ? op_job->etag : "");
+    g_vfs_write_channel_send_closed (op_job->channel, job, op_job->etag ? op_job->etag : "");
 }
 
 static void
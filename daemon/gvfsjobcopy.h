@@ -27,6 +27,7 @@
 #include <gvfsjob.h>
 #include <gvfsjobdbus.h>
 #include <gvfsbackend.h>
+#include <gvfsprogressreporter.h>
 
 G_BEGIN_DECLS
 
@@ -48,6 +49,7 @@ struct _GVfsJobCopy
   char *destination;
   GFileCopyFlags flags;
   char *callback_obj_path;
+  GVfsProgressReporter *progress;
   
 };
 
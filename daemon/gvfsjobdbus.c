@@ -159,6 +159,9 @@ send_reply (GVfsJob *job)
   g_debug ("send_reply(%p), failed=%d (%s)\n", job, job->failed, job->failed?job->error->message:"");
   
   class = G_VFS_JOB_DBUS_GET_CLASS (job);
+
+  if (class->invalidate_info)
+    class->invalidate_info (job);
   
   if (job->failed) 
     reply = _dbus_message_new_from_gerror (dbus_job->message, job->error);
@@ -55,6 +55,12 @@ struct _GVfsJobDBusClass
   DBusMessage * (*create_reply) (GVfsJob *job,
 				 DBusConnection *connection,
 				 DBusMessage *message);
+
+  /* Optional, drops the cached infos of the files the job changes.
+     Called before the reply, also when the job failed, since a failed
+     job may have changed them partially. Might be called on an i/o
+     thread. */
+  void          (*invalidate_info) (GVfsJob *job);
 };
 
 GType g_vfs_job_dbus_get_type (void) G_GNUC_CONST;
@@ -41,6 +41,7 @@ static gboolean     try          (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static void         invalidate_info (GVfsJob *job);
 
 static void
 g_vfs_job_delete_finalize (GObject *object)
@@ -66,6 +67,7 @@ g_vfs_job_delete_class_init (GVfsJobDeleteClass *klass)
   job_class->run = run;
   job_class->try = try;
   job_dbus_class->create_reply = create_reply;
+  job_dbus_class->invalidate_info = invalidate_info;
 }
 
 static void
@@ -107,6 +109,7 @@ g_vfs_job_delete_new (DBusConnection *connection,
 
   job->filename = g_strndup (path_data, path_len);
   job->backend = backend;
+  g_vfs_backend_invalidate_info (backend, job->filename);
   
   return G_VFS_JOB (job);
 }
@@ -143,12 +146,22 @@ try (GVfsJob *job)
 			    op_job->filename);
 }
 
+/* Might be called on an i/o thread */
+static void
+invalidate_info (GVfsJob *job)
+{
+  GVfsJobDelete *op_job = G_VFS_JOB_DELETE (job);
+
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->filename);
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
 	      DBusConnection *connection,
 	      DBusMessage *message)
 {
+  GVfsJobDelete *op_job = G_VFS_JOB_DELETE (job);
   DBusMessage *reply;
 
   reply = dbus_message_new_method_return (message);
@@ -23,6 +23,8 @@
 #include <config.h>
 
 #include <unistd.h>
+#include <string.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -30,9 +32,35 @@
 #include <glib.h>
 #include <dbus/dbus.h>
 #include <glib/gi18n.h>
+#include <gio/gunixoutputstream.h>
 #include "gvfsjobenumerate.h"
 #include "gvfsdbusutils.h"
 #include "gvfsdaemonprotocol.h"
+#include "gvfsdaemonutils.h"
+
+/* Infos are sent in batches. Without flow control a batch has
+ * MIN_BATCH_INFOS infos. With flow control batches grow while the
+ * client has plenty of credit left and shrink when it falls behind. */
+#define MIN_BATCH_INFOS 50
+#define MAX_BATCH_INFOS 1000
+#define MAX_BATCH_BYTES (256*1024)
+/* Rough size of one attribute on the wire */
+#define ATTRIBUTE_SIZE 48
+
+/* Stop throttling if the client doesn't grant credits for this long */
+#define CREDIT_TIMEOUT_MSECS (60*1000)
+/* How often a waiting producer checks for cancellation and for
+   jobs queued behind it */
+#define CREDIT_POLL_MSECS 100
+
+/* With the socket transport, block producers once this much is not
+   written yet */
+#define MAX_SOCKET_PENDING (1024*1024)
+
+typedef struct {
+  DBusMessage *message;
+  guint n_infos;
+} QueuedMessage;
 
 G_DEFINE_TYPE (GVfsJobEnumerate, g_vfs_job_enumerate, G_VFS_TYPE_JOB_DBUS)
 
@@ -42,14 +70,42 @@ static void         send_reply   (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static char *       get_singleflight_key (GVfsJob *job);
+static void         share_result (GVfsJob        *job,
+				  GVfsJob        *follower);
+static gboolean     flush_timeout (gpointer       data);
+
+static void
+queued_message_free (QueuedMessage *queued)
+{
+  dbus_message_unref (queued->message);
+  g_slice_free (QueuedMessage, queued);
+}
 
 static void
 g_vfs_job_enumerate_finalize (GObject *object)
 {
   GVfsJobEnumerate *job;
+  QueuedMessage *queued;
 
   job = G_VFS_JOB_ENUMERATE (object);
 
+  while ((queued = g_queue_pop_head (&job->queued_messages)) != NULL)
+    queued_message_free (queued);
+  if (job->remote_fd != -1)
+    close (job->remote_fd);
+  if (job->socket_stream)
+    g_object_unref (job->socket_stream);
+  if (job->dict)
+    gvfs_file_info_dict_free (job->dict);
+  if (job->socket_pending)
+    g_byte_array_free (job->socket_pending, TRUE);
+  if (job->socket_writing)
+    g_byte_array_free (job->socket_writing, TRUE);
+  g_mutex_clear (&job->credit_lock);
+  g_cond_clear (&job->credit_cond);
+  g_mutex_clear (&job->building_lock);
+
   g_free (job->filename);
   g_free (job->attributes);
   g_file_attribute_matcher_unref (job->attribute_matcher);
@@ -71,12 +127,39 @@ g_vfs_job_enumerate_class_init (GVfsJobEnumerateClass *klass)
   job_class->run = run;
   job_class->try = try;
   job_class->send_reply = send_reply;
+  job_class->get_singleflight_key = get_singleflight_key;
+  job_class->share_result = share_result;
   job_dbus_class->create_reply = create_reply;
 }
 
 static void
 g_vfs_job_enumerate_init (GVfsJobEnumerate *job)
 {
+  job->batch_size = MIN_BATCH_INFOS;
+  job->remote_fd = -1;
+  g_mutex_init (&job->credit_lock);
+  g_cond_init (&job->credit_cond);
+  g_mutex_init (&job->building_lock);
+  g_queue_init (&job->queued_messages);
+}
+
+/* Infos go to the client over a socket pair instead of D-Bus, see
+ * G_VFS_ENUMERATE_FLAG_SOCKET. Stays with D-Bus if that fails. */
+static void
+setup_socket (GVfsJobEnumerate *job)
+{
+  int socket_fds[2];
+
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, socket_fds) == -1)
+    {
+      g_warning ("Error creating socket pair: %d\n", errno);
+      return;
+    }
+
+  job->socket_stream = g_unix_output_stream_new (socket_fds[0], TRUE);
+  job->remote_fd = socket_fds[1];
+  job->dict = gvfs_file_info_dict_new ();
+  job->socket_pending = g_byte_array_new ();
 }
 
 GVfsJob *
@@ -91,7 +174,7 @@ g_vfs_job_enumerate_new (DBusConnection *connection,
   const char *obj_path;
   const char *path_data;
   char *attributes, *uri;
-  dbus_uint32_t flags;
+  dbus_uint32_t flags, credit, enumerate_flags = 0;
   DBusMessageIter iter;
   
   dbus_message_iter_init (message, &iter);
@@ -120,6 +203,17 @@ g_vfs_job_enumerate_new (DBusConnection *connection,
 				      0))
     uri = NULL;
 
+  /* Optional initial credit, see G_VFS_DBUS_OP_ENUMERATOR_CREDIT */
+  if (uri == NULL ||
+      !_g_dbus_message_iter_get_args (&iter, NULL,
+				      DBUS_TYPE_UINT32, &credit,
+				      0))
+    credit = G_VFS_ENUMERATOR_CREDIT_UNLIMITED;
+  else
+    _g_dbus_message_iter_get_args (&iter, NULL,
+				   DBUS_TYPE_UINT32, &enumerate_flags,
+				   0);
+
   job = g_object_new (G_VFS_TYPE_JOB_ENUMERATE,
 		      "message", message,
 		      "connection", connection,
@@ -132,21 +226,349 @@ g_vfs_job_enumerate_new (DBusConnection *connection,
   job->attribute_matcher = g_file_attribute_matcher_new (attributes);
   job->flags = flags;
   job->uri = g_strdup (uri);
+  if (enumerate_flags & G_VFS_ENUMERATE_FLAG_SOCKET)
+    setup_socket (job);
+  if (job->socket_stream == NULL)
+    g_vfs_job_enumerate_set_credit (job, credit);
+  job->cache_generation =
+    g_vfs_info_cache_get_generation (g_vfs_backend_get_info_cache (backend));
   
   return G_VFS_JOB (job);
 }
 
+/* A job for one directory of a larger request, e.g. EnumerateRecursive.
+   The infos go to info_func as the backend returned them and the end
+   to done_func. The reply is up to the caller. */
+GVfsJob *
+g_vfs_job_enumerate_new_for_path (DBusConnection           *connection,
+				  DBusMessage              *message,
+				  GVfsBackend              *backend,
+				  const char               *filename,
+				  const char               *attributes,
+				  GFileQueryInfoFlags       flags,
+				  GVfsJobEnumerateInfoFunc  info_func,
+				  GVfsJobEnumerateDoneFunc  done_func,
+				  gpointer                  func_data)
+{
+  GVfsJobEnumerate *job;
+
+  job = g_object_new (G_VFS_TYPE_JOB_ENUMERATE,
+		      "message", message,
+		      "connection", connection,
+		      NULL);
+
+  job->filename = g_strdup (filename);
+  job->backend = backend;
+  job->attributes = g_strdup (attributes);
+  job->attribute_matcher = g_file_attribute_matcher_new (attributes);
+  job->flags = flags;
+  job->info_func = info_func;
+  job->done_func = done_func;
+  job->func_data = func_data;
+
+  return G_VFS_JOB (job);
+}
+
+/* Sets the credit the client starts with, see
+   G_VFS_DBUS_OP_ENUMERATOR_CREDIT. Only before the job runs. */
+void
+g_vfs_job_enumerate_set_credit (GVfsJobEnumerate *job,
+				guint32           credit)
+{
+  if (credit == G_VFS_ENUMERATOR_CREDIT_UNLIMITED)
+    return;
+
+  job->flow_control = TRUE;
+  job->window = MAX (credit, 1);
+  job->credits = job->window;
+}
+
+/* Called with the credit lock held. Sends what the client has
+ * credit for, returns TRUE if nothing is left waiting. */
+static gboolean
+flush_queued_unlocked (GVfsJobEnumerate *job)
+{
+  QueuedMessage *queued;
+
+  while ((queued = g_queue_peek_head (&job->queued_messages)) != NULL)
+    {
+      /* A batch never needs more than the whole window */
+      if (job->flow_control && queued->n_infos > 0 &&
+	  job->credits < MIN (queued->n_infos, job->window))
+	break;
+
+      g_queue_pop_head (&job->queued_messages);
+      job->credits -= queued->n_infos;
+      job->n_queued_infos -= queued->n_infos;
+      dbus_connection_send (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+			    queued->message, NULL);
+      queued_message_free (queued);
+    }
+
+  g_cond_broadcast (&job->credit_cond);
+
+  return g_queue_is_empty (&job->queued_messages);
+}
+
+/* Takes over message and sends it once the client has credit for its
+ * n_infos infos, after all earlier messages. Returns TRUE if it was
+ * sent. */
+static gboolean
+queue_message (GVfsJobEnumerate *job,
+	       DBusMessage      *message,
+	       guint             n_infos)
+{
+  QueuedMessage *queued;
+  gboolean sent;
+
+  queued = g_slice_new (QueuedMessage);
+  queued->message = message;
+  queued->n_infos = n_infos;
+
+  g_mutex_lock (&job->credit_lock);
+  g_queue_push_tail (&job->queued_messages, queued);
+  job->n_queued_infos += n_infos;
+  sent = flush_queued_unlocked (job);
+
+  if (job->flow_control && n_infos > 0)
+    {
+      if (!sent)
+	/* The client falls behind, send it less at once */
+	job->batch_size = MAX (job->batch_size / 2, MIN_BATCH_INFOS);
+      else if (job->credits >= 2 * job->batch_size)
+	/* The client keeps up, save round trips */
+	job->batch_size = MIN (job->batch_size * 2, MAX_BATCH_INFOS);
+    }
+  g_mutex_unlock (&job->credit_lock);
+
+  return sent;
+}
+
 static void
 send_infos (GVfsJobEnumerate *job)
 {
   if (!dbus_message_iter_close_container (&job->building_iter, &job->building_array_iter))
     _g_dbus_oom ();
-  
-  dbus_connection_send (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
-			job->building_infos, NULL);
-  dbus_message_unref (job->building_infos);
+
+  queue_message (job, job->building_infos, job->n_building_infos);
   job->building_infos = NULL;
   job->n_building_infos = 0;
+  job->n_building_bytes = 0;
+}
+
+/* Called with the credit lock held */
+static gboolean
+client_is_behind_unlocked (GVfsJobEnumerate *job)
+{
+  if (job->socket_stream != NULL)
+    return !job->socket_failed &&
+      job->socket_pending->len >= MAX_SOCKET_PENDING;
+
+  return job->flow_control &&
+    job->n_queued_infos >= job->window;
+}
+
+/* Blocks a worker thread while the client is a whole window behind,
+ * or while too much is not written to the socket yet, so that the
+ * infos don't pile up in memory. The main loop never blocks, it has
+ * to deliver the credits and write the socket.
+ *
+ * A client often runs other requests on the same mount before it
+ * reads on, e.g. a query_info for an entry. With all job threads
+ * busy those would wait for this job, so the worker keeps going and
+ * buffers while jobs are queued behind it.
+ *
+ * Producers that don't go through g_vfs_job_enumerate_add_info()
+ * for a while, e.g. before starting more work, can call this too. */
+void
+g_vfs_job_enumerate_wait_for_client (GVfsJobEnumerate *job)
+{
+  GVfsDaemon *daemon;
+  gint64 end_time, now;
+
+  if (g_main_context_is_owner (g_main_context_default ()))
+    return;
+
+  daemon = g_vfs_backend_get_daemon (job->backend);
+
+  g_mutex_lock (&job->credit_lock);
+  end_time = g_get_monotonic_time () + CREDIT_TIMEOUT_MSECS * G_TIME_SPAN_MILLISECOND;
+  while (client_is_behind_unlocked (job) &&
+	 !g_vfs_daemon_has_stalled_jobs (daemon))
+    {
+      now = g_get_monotonic_time ();
+      if (now >= end_time || G_VFS_JOB (job)->cancelled)
+	{
+	  /* The client is gone or stuck, stop throttling. A socket
+	     is closed without the end record, so a client that is
+	     just slow gets an error instead of a short listing. */
+	  if (job->socket_stream != NULL)
+	    {
+	      job->socket_failed = TRUE;
+	      g_byte_array_set_size (job->socket_pending, 0);
+	    }
+	  job->flow_control = FALSE;
+	  flush_queued_unlocked (job);
+	  break;
+	}
+
+      /* Wake up now and then to notice cancellation and new jobs */
+      g_cond_wait_until (&job->credit_cond, &job->credit_lock,
+			 MIN (end_time, now + CREDIT_POLL_MSECS * G_TIME_SPAN_MILLISECOND));
+    }
+  g_mutex_unlock (&job->credit_lock);
+}
+
+static void write_socket_data (GVfsJobEnumerate *job);
+
+static void
+socket_write_cb (GObject      *source_object,
+		 GAsyncResult *res,
+		 gpointer      user_data)
+{
+  GVfsJobEnumerate *job = user_data;
+  GError *error;
+  gssize written;
+
+  error = NULL;
+  written = g_output_stream_write_finish (G_OUTPUT_STREAM (source_object),
+					  res, &error);
+  if (written == -1)
+    {
+      /* Most likely the client closed the enumerator, drop the rest */
+      g_debug ("Error writing enumerate socket: %s\n", error->message);
+      g_error_free (error);
+
+      g_mutex_lock (&job->credit_lock);
+      job->socket_failed = TRUE;
+      g_byte_array_set_size (job->socket_pending, 0);
+      g_cond_broadcast (&job->credit_cond);
+      g_mutex_unlock (&job->credit_lock);
+    }
+  else
+    {
+      job->socket_written += written;
+      if (job->socket_written < job->socket_writing->len)
+	{
+	  g_output_stream_write_async (job->socket_stream,
+				       job->socket_writing->data + job->socket_written,
+				       job->socket_writing->len - job->socket_written,
+				       G_PRIORITY_DEFAULT,
+				       NULL,
+				       socket_write_cb, job);
+	  return;
+	}
+    }
+
+  g_byte_array_free (job->socket_writing, TRUE);
+  job->socket_writing = NULL;
+
+  write_socket_data (job);
+  g_object_unref (job);
+}
+
+/* Called on the main thread. Writes what the producer added, and
+ * finishes the job once the end of the enumeration is written. */
+static void
+write_socket_data (GVfsJobEnumerate *job)
+{
+  gboolean finish;
+
+  if (job->socket_writing != NULL)
+    return; /* socket_write_cb() comes back here */
+
+  g_mutex_lock (&job->credit_lock);
+  job->socket_write_scheduled = FALSE;
+  if (job->socket_failed || job->socket_pending->len == 0)
+    {
+      finish = job->socket_done;
+      job->socket_done = FALSE;
+      g_mutex_unlock (&job->credit_lock);
+
+      if (finish)
+	{
+	  g_output_stream_close (job->socket_stream, NULL, NULL);
+	  g_vfs_job_emit_finished (G_VFS_JOB (job));
+	}
+      return;
+    }
+
+  job->socket_writing = job->socket_pending;
+  job->socket_pending = g_byte_array_new ();
+  job->socket_written = 0;
+  g_cond_broadcast (&job->credit_cond);
+  g_mutex_unlock (&job->credit_lock);
+
+  g_output_stream_write_async (job->socket_stream,
+			       job->socket_writing->data,
+			       job->socket_writing->len,
+			       G_PRIORITY_DEFAULT,
+			       NULL,
+			       socket_write_cb, g_object_ref (job));
+}
+
+static gboolean
+socket_write_idle (gpointer data)
+{
+  write_socket_data (data);
+  return FALSE;
+}
+
+/* Called with the credit lock held */
+static void
+schedule_socket_write_unlocked (GVfsJobEnumerate *job)
+{
+  if (job->socket_write_scheduled)
+    return;
+
+  job->socket_write_scheduled = TRUE;
+  g_idle_add_full (G_PRIORITY_DEFAULT, socket_write_idle,
+		   g_object_ref (job), g_object_unref);
+}
+
+/* Might be called on an i/o thread */
+static void
+add_socket_info (GVfsJobEnumerate *job,
+		 GFileInfo        *info)
+{
+  char *data;
+  gsize size;
+  guint32 header;
+
+  /* Only the producer uses the dictionary, the records are written in
+     the same order */
+  data = gvfs_file_info_marshal_with_dict (info, job->dict, &size);
+  header = g_htonl (size);
+
+  g_mutex_lock (&job->credit_lock);
+  if (!job->socket_failed)
+    {
+      g_byte_array_append (job->socket_pending, (guint8 *)&header, sizeof (header));
+      g_byte_array_append (job->socket_pending, (guint8 *)data, size);
+      schedule_socket_write_unlocked (job);
+    }
+  g_mutex_unlock (&job->credit_lock);
+
+  g_free (data);
+}
+
+/* Might be called on an i/o thread. Ends the enumeration with an
+ * empty record, the job is finished once that is written. After a
+ * failure the socket is just closed, which the client reports as
+ * an error. */
+static void
+finish_socket (GVfsJobEnumerate *job)
+{
+  guint32 header;
+
+  header = 0;
+
+  g_mutex_lock (&job->credit_lock);
+  if (!job->socket_failed)
+    g_byte_array_append (job->socket_pending, (guint8 *)&header, sizeof (header));
+  job->socket_done = TRUE;
+  schedule_socket_write_unlocked (job);
+  g_mutex_unlock (&job->credit_lock);
 }
 
 void
@@ -154,9 +576,52 @@ g_vfs_job_enumerate_add_info (GVfsJobEnumerate *job,
 			      GFileInfo *info)
 {
   DBusMessage *message, *orig_message;
-  char *uri, *escaped_name;
+  char *uri, *escaped_name, *path;
+  char **attributes;
+  const char *name;
+  GFileInfo *copy;
+  gboolean wait;
+  GList *l;
+
+  /* Identical enumerations waiting for this one get the same infos.
+     This also stops others from joining, they would miss these. */
+  for (l = g_vfs_job_get_followers (G_VFS_JOB (job)); l != NULL; l = l->next)
+    {
+      copy = g_file_info_dup (info);
+      g_vfs_job_enumerate_add_info (l->data, copy);
+      g_object_unref (copy);
+    }
+
+  /* Our client cancelled, only the followers still listen */
+  if (G_VFS_JOB (job)->failed)
+    return;
+
+  if (job->info_func != NULL)
+    {
+      job->info_func (job, info, job->func_data);
+      return;
+    }
+
+  /* Later stats of the children can be answered from the cache */
+  name = g_file_info_get_name (info);
+  if (name != NULL)
+    {
+      path = g_build_path ("/", job->filename, name, NULL);
+      g_vfs_info_cache_insert (g_vfs_backend_get_info_cache (job->backend),
+			       job->cache_generation,
+			       path,
+			       job->attributes,
+			       job->flags,
+			       info);
+      g_free (path);
+    }
+
+  /* The batch and the socket dictionary are shared by all producers,
+     but they wait for the client without the lock */
+  g_mutex_lock (&job->building_lock);
   
-  if (job->building_infos == NULL)
+  if (job->socket_stream == NULL &&
+      job->building_infos == NULL)
     {
       orig_message = g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job));
       
@@ -176,6 +641,7 @@ g_vfs_job_enumerate_add_info (GVfsJobEnumerate *job,
 
       job->building_infos = message;
       job->n_building_infos = 0;
+      job->n_building_bytes = 0;
     }
 
   
@@ -198,12 +664,33 @@ g_vfs_job_enumerate_add_info (GVfsJobEnumerate *job,
   g_free (uri);
 
   g_file_info_set_attribute_mask (info, job->attribute_matcher);
+
+  if (job->socket_stream != NULL)
+    {
+      add_socket_info (job, info);
+      g_mutex_unlock (&job->building_lock);
+      g_vfs_job_enumerate_wait_for_client (job);
+      return;
+    }
   
   _g_dbus_append_file_info (&job->building_array_iter, info);
   job->n_building_infos++;
 
-  if (job->n_building_infos == 50)
-    send_infos (job);
+  attributes = g_file_info_list_attributes (info, NULL);
+  job->n_building_bytes += g_strv_length (attributes) * ATTRIBUTE_SIZE;
+  g_strfreev (attributes);
+
+  wait = FALSE;
+  if (job->n_building_infos >= job->batch_size ||
+      job->n_building_bytes >= MAX_BATCH_BYTES)
+    {
+      send_infos (job);
+      wait = TRUE;
+    }
+  g_mutex_unlock (&job->building_lock);
+
+  if (wait)
+    g_vfs_job_enumerate_wait_for_client (job);
 }
 
 void
@@ -224,11 +711,32 @@ void
 g_vfs_job_enumerate_done (GVfsJobEnumerate *job)
 {
   DBusMessage *message, *orig_message;
-  
-  g_assert (!G_VFS_JOB (job)->failed);
+  GList *l;
+
+  for (l = g_vfs_job_get_followers (G_VFS_JOB (job)); l != NULL; l = l->next)
+    g_vfs_job_enumerate_done (l->data);
+
+  /* Already finished with the error if our client cancelled */
+  if (G_VFS_JOB (job)->failed)
+    return;
 
+  if (job->done_func != NULL)
+    {
+      job->done_func (job, job->func_data);
+      g_vfs_job_emit_finished (G_VFS_JOB (job));
+      return;
+    }
+
+  if (job->socket_stream != NULL)
+    {
+      finish_socket (job);
+      return;
+    }
+
+  g_mutex_lock (&job->building_lock);
   if (job->building_infos != NULL)
     send_infos (job);
+  g_mutex_unlock (&job->building_lock);
   
   orig_message = g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job));
   
@@ -238,11 +746,89 @@ g_vfs_job_enumerate_done (GVfsJobEnumerate *job)
 					  G_VFS_DBUS_ENUMERATOR_OP_DONE);
   dbus_message_set_no_reply (message, TRUE);
 
-  dbus_connection_send (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
-			message, NULL);
-  dbus_message_unref (message);
+  if (queue_message (job, message, 0))
+    {
+      g_vfs_job_emit_finished (G_VFS_JOB (job));
+      return;
+    }
+
+  /* Stay around for the credits until the client got everything */
+  g_mutex_lock (&job->credit_lock);
+  if (g_queue_is_empty (&job->queued_messages))
+    {
+      g_mutex_unlock (&job->credit_lock);
+      g_vfs_job_emit_finished (G_VFS_JOB (job));
+      return;
+    }
+  job->finish_when_sent = TRUE;
+  job->flush_timeout_tag =
+    g_timeout_add_full (G_PRIORITY_DEFAULT, CREDIT_TIMEOUT_MSECS,
+			flush_timeout, g_object_ref (job), g_object_unref);
+  g_mutex_unlock (&job->credit_lock);
+}
+
+/* Called on the main thread. Sends what is left after the client
+ * stopped granting credits. */
+static gboolean
+flush_timeout (gpointer data)
+{
+  GVfsJobEnumerate *job = data;
+  gboolean finish;
+
+  g_mutex_lock (&job->credit_lock);
+  job->flush_timeout_tag = 0;
+  job->flow_control = FALSE;
+  flush_queued_unlocked (job);
+  finish = job->finish_when_sent;
+  job->finish_when_sent = FALSE;
+  g_mutex_unlock (&job->credit_lock);
+
+  if (finish)
+    g_vfs_job_emit_finished (G_VFS_JOB (job));
+
+  return FALSE;
+}
+
+gboolean
+g_vfs_job_enumerate_is_for (GVfsJobEnumerate *job,
+			    DBusConnection   *connection,
+			    const char       *object_path)
+{
+  return
+    g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)) == connection &&
+    job->object_path != NULL &&
+    strcmp (job->object_path, object_path) == 0;
+}
+
+/* Called on the main thread when the client consumed credit infos,
+ * see G_VFS_DBUS_OP_ENUMERATOR_CREDIT */
+void
+g_vfs_job_enumerate_add_credit (GVfsJobEnumerate *job,
+				guint32           credit)
+{
+  gboolean finish;
+  guint tag;
+
+  g_mutex_lock (&job->credit_lock);
+  if (credit == G_VFS_ENUMERATOR_CREDIT_UNLIMITED)
+    job->flow_control = FALSE;
+  else
+    job->credits += credit;
+
+  finish = flush_queued_unlocked (job) && job->finish_when_sent;
+  tag = 0;
+  if (finish)
+    {
+      job->finish_when_sent = FALSE;
+      tag = job->flush_timeout_tag;
+      job->flush_timeout_tag = 0;
+    }
+  g_mutex_unlock (&job->credit_lock);
 
-  g_vfs_job_emit_finished (G_VFS_JOB (job));
+  if (tag != 0)
+    g_source_remove (tag);
+  if (finish)
+    g_vfs_job_emit_finished (G_VFS_JOB (job));
 }
 
 static void
@@ -307,15 +893,69 @@ send_reply (GVfsJob *job)
     g_vfs_job_emit_finished (job);
 }
 
+static char *
+get_singleflight_key (GVfsJob *job)
+{
+  GVfsJobEnumerate *op_job = G_VFS_JOB_ENUMERATE (job);
+
+  /* Jobs feeding the recursive enumeration don't talk to a client */
+  if (op_job->info_func != NULL)
+    return NULL;
+
+  /* Not the object path, that is per client. Followers are fed from
+     the leader, so they have to be delivered the same way. */
+  return g_strdup_printf ("Enumerate %p %u %s %s %u\n%s\n%s",
+			  op_job->backend, op_job->flags, op_job->attributes,
+			  op_job->socket_stream != NULL ? "socket" : "dbus",
+			  op_job->flow_control ? op_job->window : 0,
+			  op_job->uri ? op_job->uri : "", op_job->filename);
+}
+
+/* Might be called on an i/o thread. The infos follow through
+   g_vfs_job_enumerate_add_info(). */
+static void
+share_result (GVfsJob *job,
+	      GVfsJob *follower)
+{
+  g_vfs_job_succeeded (follower);
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
 	      DBusConnection *connection,
 	      DBusMessage *message)
 {
+  GVfsJobEnumerate *op_job = G_VFS_JOB_ENUMERATE (job);
   DBusMessage *reply;
+  GError *error;
+  int fd_id;
+
+  if (op_job->remote_fd == -1)
+    return dbus_message_new_method_return (message);
+
+  error = NULL;
+  if (!dbus_connection_send_fd (connection,
+				op_job->remote_fd,
+				&fd_id, &error))
+    {
+      reply = _dbus_message_new_from_gerror (message, error);
+      g_error_free (error);
+
+      /* Nobody will read what the backend sends */
+      g_mutex_lock (&op_job->credit_lock);
+      op_job->socket_failed = TRUE;
+      g_byte_array_set_size (op_job->socket_pending, 0);
+      g_mutex_unlock (&op_job->credit_lock);
+      return reply;
+    }
+  close (op_job->remote_fd);
+  op_job->remote_fd = -1;
 
   reply = dbus_message_new_method_return (message);
+  dbus_message_append_args (reply,
+			    DBUS_TYPE_UINT32, &fd_id,
+			    DBUS_TYPE_INVALID);
 
   return reply;
 }
@@ -27,6 +27,7 @@
 #include <gvfsjob.h>
 #include <gvfsjobdbus.h>
 #include <gvfsbackend.h>
+#include <gvfsfileinfo.h>
 
 G_BEGIN_DECLS
 
@@ -39,6 +40,14 @@ G_BEGIN_DECLS
 
 typedef struct _GVfsJobEnumerateClass   GVfsJobEnumerateClass;
 
+/* Take the results of a job made with g_vfs_job_enumerate_new_for_path().
+   Might be called on an i/o thread. */
+typedef void (*GVfsJobEnumerateInfoFunc) (GVfsJobEnumerate *job,
+					  GFileInfo        *info,
+					  gpointer          user_data);
+typedef void (*GVfsJobEnumerateDoneFunc) (GVfsJobEnumerate *job,
+					  gpointer          user_data);
+
 struct _GVfsJobEnumerate
 {
   GVfsJobDBus parent_instance;
@@ -50,11 +59,44 @@ struct _GVfsJobEnumerate
   GFileAttributeMatcher *attribute_matcher;
   GFileQueryInfoFlags flags;
   char *uri;
+  guint cache_generation;
 
+  /* Producers may call g_vfs_job_enumerate_add_info() from several
+     threads, e.g. EnumerateRecursive */
+  GMutex building_lock;
   DBusMessage *building_infos;
   DBusMessageIter building_iter;
   DBusMessageIter building_array_iter;
   int n_building_infos;
+  gsize n_building_bytes;
+  guint batch_size;
+
+  /* Flow control, see G_VFS_DBUS_OP_ENUMERATOR_CREDIT */
+  GMutex credit_lock;
+  GCond credit_cond;
+  gboolean flow_control;
+  guint window;            /* the credit the client started with */
+  gint64 credits;          /* infos the client can still take */
+  GQueue queued_messages;  /* waiting for credits */
+  guint n_queued_infos;
+  gboolean finish_when_sent;
+  guint flush_timeout_tag;
+
+  /* Binary transport, see G_VFS_ENUMERATE_FLAG_SOCKET */
+  GOutputStream *socket_stream;
+  int remote_fd;
+  GVfsFileInfoDict *dict;
+  GByteArray *socket_pending;     /* protected by credit_lock */
+  GByteArray *socket_writing;     /* only used on the main thread */
+  gsize socket_written;
+  gboolean socket_write_scheduled;
+  gboolean socket_done;
+  gboolean socket_failed;
+
+  /* Set for jobs that are part of a larger request */
+  GVfsJobEnumerateInfoFunc info_func;
+  GVfsJobEnumerateDoneFunc done_func;
+  gpointer func_data;
 };
 
 struct _GVfsJobEnumerateClass
@@ -67,11 +109,28 @@ GType g_vfs_job_enumerate_get_type (void) G_GNUC_CONST;
 GVfsJob *g_vfs_job_enumerate_new        (DBusConnection        *connection,
 					 DBusMessage           *message,
 					 GVfsBackend           *backend);
+GVfsJob *g_vfs_job_enumerate_new_for_path (DBusConnection           *connection,
+					   DBusMessage              *message,
+					   GVfsBackend              *backend,
+					   const char               *filename,
+					   const char               *attributes,
+					   GFileQueryInfoFlags       flags,
+					   GVfsJobEnumerateInfoFunc  info_func,
+					   GVfsJobEnumerateDoneFunc  done_func,
+					   gpointer                  func_data);
 void     g_vfs_job_enumerate_add_info   (GVfsJobEnumerate      *job,
 					 GFileInfo             *info);
 void     g_vfs_job_enumerate_add_infos  (GVfsJobEnumerate      *job,
 					 const GList           *info);
 void     g_vfs_job_enumerate_done       (GVfsJobEnumerate      *job);
+gboolean g_vfs_job_enumerate_is_for     (GVfsJobEnumerate      *job,
+					 DBusConnection        *connection,
+					 const char            *object_path);
+void     g_vfs_job_enumerate_add_credit (GVfsJobEnumerate      *job,
+					 guint32                credit);
+void     g_vfs_job_enumerate_set_credit (GVfsJobEnumerate      *job,
+					 guint32                credit);
+void     g_vfs_job_enumerate_wait_for_client (GVfsJobEnumerate *job);
 
 G_END_DECLS
 
@@ -0,0 +1,394 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <dbus/dbus.h>
+#include <glib/gi18n.h>
+#include "gvfsjobenumeraterecursive.h"
+#include "gvfsjobsource.h"
+#include "gvfsdbusutils.h"
+#include "gvfsdaemonprotocol.h"
+
+/* Directories listed at the same time, at most */
+#define MAX_DIR_JOBS 8
+
+/* Needed to find the subdirectories */
+#define WALK_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK
+
+#define DIR_KEY "g-vfs-enumerate-recursive-dir"
+
+typedef struct {
+  char *path;   /* below the walked directory, "" for itself */
+  guint depth;
+} Dir;
+
+G_DEFINE_TYPE (GVfsJobEnumerateRecursive, g_vfs_job_enumerate_recursive, G_VFS_TYPE_JOB_ENUMERATE)
+
+static void         run          (GVfsJob        *job);
+static gboolean     try          (GVfsJob        *job);
+
+static Dir *
+dir_new (char  *path,
+	 guint  depth)
+{
+  Dir *dir;
+
+  dir = g_slice_new (Dir);
+  dir->path = path;
+  dir->depth = depth;
+
+  return dir;
+}
+
+static void
+dir_free (Dir *dir)
+{
+  g_free (dir->path);
+  g_slice_free (Dir, dir);
+}
+
+static void
+g_vfs_job_enumerate_recursive_finalize (GObject *object)
+{
+  GVfsJobEnumerateRecursive *job;
+  Dir *dir;
+
+  job = G_VFS_JOB_ENUMERATE_RECURSIVE (object);
+
+  while ((dir = g_queue_pop_head (&job->pending_dirs)) != NULL)
+    dir_free (dir);
+  g_free (job->walk_attributes);
+  g_mutex_clear (&job->lock);
+  
+  if (G_OBJECT_CLASS (g_vfs_job_enumerate_recursive_parent_class)->finalize)
+    (*G_OBJECT_CLASS (g_vfs_job_enumerate_recursive_parent_class)->finalize) (object);
+}
+
+static void
+g_vfs_job_enumerate_recursive_class_init (GVfsJobEnumerateRecursiveClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GVfsJobClass *job_class = G_VFS_JOB_CLASS (klass);
+  
+  gobject_class->finalize = g_vfs_job_enumerate_recursive_finalize;
+  job_class->run = run;
+  job_class->try = try;
+  /* The directory jobs are shared with identical ones instead */
+  job_class->get_singleflight_key = NULL;
+}
+
+static void
+g_vfs_job_enumerate_recursive_init (GVfsJobEnumerateRecursive *job)
+{
+  g_mutex_init (&job->lock);
+  g_queue_init (&job->pending_dirs);
+}
+
+GVfsJob *
+g_vfs_job_enumerate_recursive_new (DBusConnection *connection,
+				   DBusMessage *message,
+				   GVfsBackend *backend)
+{
+  GVfsJobEnumerateRecursive *job;
+  GVfsJobEnumerate *enumerate_job;
+  DBusMessage *reply;
+  DBusError derror;
+  int path_len;
+  const char *obj_path;
+  const char *path_data;
+  char *attributes, *uri;
+  dbus_uint32_t flags, max_depth, credit;
+  DBusMessageIter iter;
+  
+  dbus_message_iter_init (message, &iter);
+  dbus_error_init (&derror);
+  if (!_g_dbus_message_iter_get_args (&iter, &derror, 
+				      DBUS_TYPE_ARRAY, DBUS_TYPE_BYTE,
+				      &path_data, &path_len,
+				      DBUS_TYPE_STRING, &obj_path,
+				      DBUS_TYPE_STRING, &attributes,
+				      DBUS_TYPE_UINT32, &flags,
+				      DBUS_TYPE_STRING, &uri,
+				      DBUS_TYPE_UINT32, &max_depth,
+				      0))
+    {
+      reply = dbus_message_new_error (message,
+				      derror.name,
+                                      derror.message);
+      dbus_error_free (&derror);
+
+      dbus_connection_send (connection, reply, NULL);
+      dbus_message_unref (reply);
+      return NULL;
+    }
+
+  /* Optional initial credit, like for Enumerate */
+  if (!_g_dbus_message_iter_get_args (&iter, NULL,
+				      DBUS_TYPE_UINT32, &credit,
+				      0))
+    credit = G_VFS_ENUMERATOR_CREDIT_UNLIMITED;
+
+  job = g_object_new (G_VFS_TYPE_JOB_ENUMERATE_RECURSIVE,
+		      "message", message,
+		      "connection", connection,
+		      NULL);
+
+  enumerate_job = G_VFS_JOB_ENUMERATE (job);
+  enumerate_job->object_path = g_strdup (obj_path);
+  enumerate_job->filename = g_strndup (path_data, path_len);
+  enumerate_job->backend = backend;
+  enumerate_job->attributes = g_strdup (attributes);
+  enumerate_job->attribute_matcher = g_file_attribute_matcher_new (attributes);
+  enumerate_job->flags = flags;
+  enumerate_job->uri = *uri != 0 ? g_strdup (uri) : NULL;
+  enumerate_job->cache_generation =
+    g_vfs_info_cache_get_generation (g_vfs_backend_get_info_cache (backend));
+  g_vfs_job_enumerate_set_credit (enumerate_job, credit);
+
+  job->max_depth = max_depth;
+  if (*attributes != 0)
+    job->walk_attributes = g_strconcat (attributes, ",", WALK_ATTRIBUTES, NULL);
+  else
+    job->walk_attributes = g_strdup (WALK_ATTRIBUTES);
+  
+  return G_VFS_JOB (job);
+}
+
+/* Might be called on an i/o thread */
+static void
+dir_got_info (GVfsJobEnumerate *dir_job,
+	      GFileInfo        *info,
+	      gpointer          user_data)
+{
+  GVfsJobEnumerateRecursive *job = user_data;
+  Dir *dir;
+  const char *name;
+  char *path;
+
+  dir = g_object_get_data (G_OBJECT (dir_job), DIR_KEY);
+  name = g_file_info_get_name (info);
+  if (name == NULL)
+    return;
+
+  if (*dir->path == 0)
+    path = g_strdup (name);
+  else
+    path = g_build_path ("/", dir->path, name, NULL);
+
+  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY &&
+      !g_file_info_get_is_symlink (info) &&
+      (job->max_depth == 0 || dir->depth + 1 < job->max_depth))
+    {
+      g_mutex_lock (&job->lock);
+      g_queue_push_tail (&job->pending_dirs,
+			 dir_new (g_strdup (path), dir->depth + 1));
+      g_mutex_unlock (&job->lock);
+    }
+
+  /* The client gets the path below the walked directory as name */
+  g_file_info_set_name (info, path);
+  g_free (path);
+
+  /* Blocks this directory while the client is behind */
+  g_vfs_job_enumerate_add_info (G_VFS_JOB_ENUMERATE (job), info);
+}
+
+static void start_dir_jobs (GVfsJobEnumerateRecursive *job);
+
+static gboolean
+start_dir_jobs_idle (gpointer data)
+{
+  start_dir_jobs (data);
+  return FALSE;
+}
+
+/* Might be called on an i/o thread. A directory is listed, or could
+   not be. */
+static void
+dir_finished (GVfsJobEnumerateRecursive *job)
+{
+  gboolean all_done, start_more;
+
+  g_mutex_lock (&job->lock);
+  job->n_running--;
+  all_done = job->n_running == 0 && g_queue_is_empty (&job->pending_dirs);
+  g_mutex_unlock (&job->lock);
+
+  /* Don't list more directories than the client has room for */
+  if (!all_done)
+    g_vfs_job_enumerate_wait_for_client (G_VFS_JOB_ENUMERATE (job));
+
+  g_mutex_lock (&job->lock);
+  start_more = !g_queue_is_empty (&job->pending_dirs) && !job->start_scheduled;
+  if (start_more)
+    job->start_scheduled = TRUE;
+  g_mutex_unlock (&job->lock);
+
+  /* Jobs are queued on the main thread */
+  if (start_more)
+    g_idle_add_full (G_PRIORITY_DEFAULT, start_dir_jobs_idle,
+		     g_object_ref (job), g_object_unref);
+
+  if (all_done)
+    g_vfs_job_enumerate_done (G_VFS_JOB_ENUMERATE (job));
+}
+
+/* Might be called on an i/o thread */
+static void
+dir_done (GVfsJobEnumerate *dir_job,
+	  gpointer          user_data)
+{
+  dir_finished (user_data);
+}
+
+/* Might be called on an i/o thread. The walk replies like the
+   listing of its directory, the others don't reply at all. */
+static void
+dir_job_send_reply (GVfsJob *dir_job,
+		    gpointer user_data)
+{
+  GVfsJobEnumerateRecursive *job = user_data;
+  Dir *dir;
+
+  dir = g_object_get_data (G_OBJECT (dir_job), DIR_KEY);
+
+  g_signal_stop_emission_by_name (dir_job, "send-reply");
+
+  if (dir->depth == 0)
+    {
+      if (dir_job->failed)
+	g_vfs_job_failed_from_error (G_VFS_JOB (job), dir_job->error);
+      else
+	g_vfs_job_succeeded (G_VFS_JOB (job));
+    }
+
+  if (dir_job->failed)
+    {
+      g_vfs_job_emit_finished (dir_job);
+
+      /* Unreadable subdirectories are skipped */
+      if (dir->depth > 0)
+	{
+	  g_debug ("Skipping %s: %s\n", dir->path, dir_job->error->message);
+	  dir_finished (job);
+	}
+    }
+}
+
+/* Called on the main thread */
+static void
+start_dir_jobs (GVfsJobEnumerateRecursive *job)
+{
+  GVfsJobEnumerate *enumerate_job = G_VFS_JOB_ENUMERATE (job);
+  GVfsJob *dir_job;
+  gboolean all_done;
+  char *filename;
+  Dir *dir;
+
+  all_done = FALSE;
+
+  g_mutex_lock (&job->lock);
+  job->start_scheduled = FALSE;
+
+  /* Directories queued before Cancel are cancelled with us, the rest
+     are not listed */
+  if (G_VFS_JOB (job)->cancelled)
+    {
+      while ((dir = g_queue_pop_head (&job->pending_dirs)) != NULL)
+	dir_free (dir);
+      all_done = job->n_running == 0;
+    }
+
+  while (job->n_running < job->max_dir_jobs &&
+	 (dir = g_queue_pop_head (&job->pending_dirs)) != NULL)
+    {
+      job->n_running++;
+      g_mutex_unlock (&job->lock);
+
+      filename = g_build_path ("/", enumerate_job->filename, dir->path, NULL);
+      dir_job = g_vfs_job_enumerate_new_for_path (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+						  g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job)),
+						  enumerate_job->backend,
+						  filename,
+						  job->walk_attributes,
+						  enumerate_job->flags,
+						  dir_got_info,
+						  dir_done,
+						  job);
+      g_free (filename);
+
+      g_object_set_data_full (G_OBJECT (dir_job), DIR_KEY,
+			      dir, (GDestroyNotify)dir_free);
+      g_signal_connect_data (dir_job, "send-reply",
+			     (GCallback)dir_job_send_reply,
+			     g_object_ref (job),
+			     (GClosureNotify)g_object_unref, 0);
+      g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (enumerate_job->backend), dir_job);
+      g_object_unref (dir_job);
+
+      g_mutex_lock (&job->lock);
+    }
+  g_mutex_unlock (&job->lock);
+
+  if (all_done)
+    g_vfs_job_enumerate_done (enumerate_job);
+}
+
+/* Never called, try() always takes the job */
+static void
+run (GVfsJob *job)
+{
+  g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		    _("Operation not supported by backend"));
+}
+
+static gboolean
+try (GVfsJob *job)
+{
+  GVfsJobEnumerateRecursive *op_job = G_VFS_JOB_ENUMERATE_RECURSIVE (job);
+  GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (G_VFS_JOB_ENUMERATE (job)->backend);
+
+  if (class->enumerate == NULL && class->try_enumerate == NULL)
+    {
+      g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			_("Operation not supported by backend"));
+      return TRUE;
+    }
+
+  /* Directory jobs that run in threads block theirs while the client
+     is behind, so they must leave threads for the other jobs */
+  op_job->max_dir_jobs = MAX_DIR_JOBS;
+  if (class->try_enumerate == NULL)
+    op_job->max_dir_jobs =
+      CLAMP (g_vfs_daemon_get_thread_limit (g_vfs_backend_get_daemon (G_VFS_JOB_ENUMERATE (job)->backend)) - 1,
+	     1, MAX_DIR_JOBS);
+
+  g_queue_push_tail (&op_job->pending_dirs, dir_new (g_strdup (""), 0));
+  start_dir_jobs (op_job);
+
+  return TRUE;
+}
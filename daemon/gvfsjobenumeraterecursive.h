@@ -0,0 +1,71 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_JOB_ENUMERATE_RECURSIVE_H__
+#define __G_VFS_JOB_ENUMERATE_RECURSIVE_H__
+
+#include <gio/gio.h>
+#include <gvfsjobenumerate.h>
+
+G_BEGIN_DECLS
+
+#define G_VFS_TYPE_JOB_ENUMERATE_RECURSIVE         (g_vfs_job_enumerate_recursive_get_type ())
+#define G_VFS_JOB_ENUMERATE_RECURSIVE(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), G_VFS_TYPE_JOB_ENUMERATE_RECURSIVE, GVfsJobEnumerateRecursive))
+#define G_VFS_JOB_ENUMERATE_RECURSIVE_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), G_VFS_TYPE_JOB_ENUMERATE_RECURSIVE, GVfsJobEnumerateRecursiveClass))
+#define G_VFS_IS_JOB_ENUMERATE_RECURSIVE(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), G_VFS_TYPE_JOB_ENUMERATE_RECURSIVE))
+#define G_VFS_IS_JOB_ENUMERATE_RECURSIVE_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), G_VFS_TYPE_JOB_ENUMERATE_RECURSIVE))
+#define G_VFS_JOB_ENUMERATE_RECURSIVE_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), G_VFS_TYPE_JOB_ENUMERATE_RECURSIVE, GVfsJobEnumerateRecursiveClass))
+
+typedef struct _GVfsJobEnumerateRecursive        GVfsJobEnumerateRecursive;
+typedef struct _GVfsJobEnumerateRecursiveClass   GVfsJobEnumerateRecursiveClass;
+
+/* Walks a tree with one enumerate job per directory and sends the
+   infos like an enumerate job would */
+struct _GVfsJobEnumerateRecursive
+{
+  GVfsJobEnumerate parent_instance;
+
+  guint max_depth;
+  char *walk_attributes;  /* the attributes plus what the walk needs */
+
+  guint max_dir_jobs;
+
+  GMutex lock;
+  GQueue pending_dirs;
+  guint n_running;
+  gboolean start_scheduled;
+};
+
+struct _GVfsJobEnumerateRecursiveClass
+{
+  GVfsJobEnumerateClass parent_class;
+};
+
+GType g_vfs_job_enumerate_recursive_get_type (void) G_GNUC_CONST;
+
+GVfsJob *g_vfs_job_enumerate_recursive_new (DBusConnection *connection,
+					    DBusMessage    *message,
+					    GVfsBackend    *backend);
+
+G_END_DECLS
+
+#endif /* __G_VFS_JOB_ENUMERATE_RECURSIVE_H__ */
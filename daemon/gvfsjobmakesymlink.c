@@ -41,6 +41,7 @@ static gboolean     try          (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static void         invalidate_info (GVfsJob *job);
 
 static void
 g_vfs_job_make_symlink_finalize (GObject *object)
@@ -67,6 +68,7 @@ g_vfs_job_make_symlink_class_init (GVfsJobMakeSymlinkClass *klass)
   job_class->run = run;
   job_class->try = try;
   job_dbus_class->create_reply = create_reply;
+  job_dbus_class->invalidate_info = invalidate_info;
 }
 
 static void
@@ -111,6 +113,7 @@ g_vfs_job_make_symlink_new (DBusConnection *connection,
   job->filename = g_strndup (path_data, path_len);
   job->symlink_value = g_strndup (symlink_data, symlink_len);
   job->backend = backend;
+  g_vfs_backend_invalidate_info (backend, job->filename);
   
   return G_VFS_JOB (job);
 }
@@ -149,12 +152,22 @@ try (GVfsJob *job)
 				  op_job->symlink_value);
 }
 
+/* Might be called on an i/o thread */
+static void
+invalidate_info (GVfsJob *job)
+{
+  GVfsJobMakeSymlink *op_job = G_VFS_JOB_MAKE_SYMLINK (job);
+
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->filename);
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
 	      DBusConnection *connection,
 	      DBusMessage *message)
 {
+  GVfsJobMakeSymlink *op_job = G_VFS_JOB_MAKE_SYMLINK (job);
   DBusMessage *reply;
 
   reply = dbus_message_new_method_return (message);
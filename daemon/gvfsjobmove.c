@@ -42,6 +42,7 @@ static gboolean     try          (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static void         invalidate_info (GVfsJob *job);
 
 static void
 g_vfs_job_move_finalize (GObject *object)
@@ -53,6 +54,8 @@ g_vfs_job_move_finalize (GObject *object)
   g_free (job->source);
   g_free (job->destination);
   g_free (job->callback_obj_path);
+  if (job->progress)
+    g_vfs_progress_reporter_free (job->progress);
   
   if (G_OBJECT_CLASS (g_vfs_job_move_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_vfs_job_move_parent_class)->finalize) (object);
@@ -69,6 +72,7 @@ g_vfs_job_move_class_init (GVfsJobMoveClass *klass)
   job_class->run = run;
   job_class->try = try;
   job_dbus_class->create_reply = create_reply;
+  job_dbus_class->invalidate_info = invalidate_info;
 }
 
 static void
@@ -119,6 +123,10 @@ g_vfs_job_move_new (DBusConnection *connection,
   job->flags = flags;
   if (strcmp (callback_obj_path, "/org/gtk/vfs/void") != 0)
     job->callback_obj_path = g_strdup (callback_obj_path);
+  job->progress = g_vfs_progress_reporter_new (G_VFS_JOB_DBUS (job),
+					       job->callback_obj_path);
+  g_vfs_backend_invalidate_info (backend, job->source);
+  g_vfs_backend_invalidate_info (backend, job->destination);
   
   return G_VFS_JOB (job);
 }
@@ -128,33 +136,11 @@ g_vfs_job_move_progress_callback (goffset current_num_bytes,
 				  goffset total_num_bytes,
 				  GVfsJob *job)
 {
-  GVfsJobDBus *dbus_job = G_VFS_JOB_DBUS (job);
   GVfsJobMove *op_job = G_VFS_JOB_MOVE (job);
-  dbus_uint64_t current_dbus, total_dbus;
-  DBusMessage *message;
 
   g_debug ("progress_callback %" G_GOFFSET_FORMAT "/%" G_GOFFSET_FORMAT "\n", current_num_bytes, total_num_bytes);
 
-  if (op_job->callback_obj_path == NULL)
-    return;
-
-  message =
-    dbus_message_new_method_call (dbus_message_get_sender (dbus_job->message),
-				  op_job->callback_obj_path,
-				  G_VFS_DBUS_PROGRESS_INTERFACE,
-				  G_VFS_DBUS_PROGRESS_OP_PROGRESS);
-  dbus_message_set_no_reply (message, TRUE);
-
-  current_dbus = current_num_bytes;
-  total_dbus = total_num_bytes;
-  dbus_message_append_args (message,
-			    DBUS_TYPE_UINT64, &current_dbus,
-			    DBUS_TYPE_UINT64, &total_dbus,
-			    0);
-
-  /* Queues reply (threadsafely), actually sends it in mainloop */
-  dbus_connection_send (dbus_job->connection, message, NULL);
-  dbus_message_unref (message);
+  g_vfs_progress_reporter_update (op_job->progress, current_num_bytes, total_num_bytes);
 }
 
 static void
@@ -197,14 +183,27 @@ try (GVfsJob *job)
 			  job);
 }
 
+/* Might be called on an i/o thread */
+static void
+invalidate_info (GVfsJob *job)
+{
+  GVfsJobMove *op_job = G_VFS_JOB_MOVE (job);
+
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->source);
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->destination);
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
 	      DBusConnection *connection,
 	      DBusMessage *message)
 {
+  GVfsJobMove *op_job = G_VFS_JOB_MOVE (job);
   DBusMessage *reply;
 
+  g_vfs_progress_reporter_flush (op_job->progress);
+
   reply = dbus_message_new_method_return (message);
   
   return reply;
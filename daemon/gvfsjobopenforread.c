@@ -88,10 +88,12 @@ g_vfs_job_open_for_read_new (DBusConnection *connection,
 {
   GVfsJobOpenForRead *job;
   DBusMessage *reply;
+  DBusMessageIter iter;
   DBusError derror;
   int path_len;
   const char *path_data;
   guint32 pid;
+  guint32 flags;
   
   dbus_error_init (&derror);
   if (!dbus_message_get_args (message, &derror, 
@@ -110,6 +112,14 @@ g_vfs_job_open_for_read_new (DBusConnection *connection,
       return NULL;
     }
 
+  /* Older clients don't send the flags */
+  flags = 0;
+  dbus_message_iter_init (message, &iter);
+  if (dbus_message_iter_next (&iter) &&
+      dbus_message_iter_next (&iter) &&
+      dbus_message_iter_get_arg_type (&iter) == DBUS_TYPE_UINT32)
+    dbus_message_iter_get_basic (&iter, &flags);
+
   job = g_object_new (G_VFS_TYPE_JOB_OPEN_FOR_READ,
 		      "message", message,
 		      "connection", connection,
@@ -118,6 +128,7 @@ g_vfs_job_open_for_read_new (DBusConnection *connection,
   job->filename = g_strndup (path_data, path_len);
   job->backend = backend;
   job->pid = pid;
+  job->flags = flags;
   
   return G_VFS_JOB (job);
 }
@@ -170,6 +181,34 @@ g_vfs_job_open_for_read_set_can_seek (GVfsJobOpenForRead *job,
 }
 
 /* Might be called on an i/o thread */
+/* Shared memory is an optimization, on failure the client just gets
+   all data over the socket */
+static void
+setup_shared_memory (GVfsReadChannel *channel,
+		     DBusConnection *connection,
+		     DBusMessage *reply)
+{
+  guint32 ring_size;
+  int shm_fd;
+  int fd_id;
+
+  ring_size = G_VFS_DAEMON_SHM_RING_SIZE;
+  shm_fd = gvfs_create_shared_memory_fd (G_VFS_DAEMON_SHM_HEADER_SIZE + ring_size, NULL);
+  if (shm_fd == -1)
+    return;
+
+  /* The client only uses the fd if it's in the reply, and the channel
+     only uses the ring once the client mapped it */
+  if (g_vfs_channel_set_shared_memory (G_VFS_CHANNEL (channel), shm_fd, ring_size) &&
+      dbus_connection_send_fd (connection, shm_fd, &fd_id, NULL))
+    dbus_message_append_args (reply,
+			      DBUS_TYPE_UINT32, &fd_id,
+			      DBUS_TYPE_UINT32, &ring_size,
+			      DBUS_TYPE_INVALID);
+
+  close (shm_fd);
+}
+
 static DBusMessage *
 create_reply (GVfsJob *job,
 	      DBusConnection *connection,
@@ -209,6 +248,9 @@ create_reply (GVfsJob *job,
 			    DBUS_TYPE_BOOLEAN, &can_seek,
 			    DBUS_TYPE_INVALID);
 
+  if (open_job->flags & G_VFS_DAEMON_OPEN_FLAG_SHM)
+    setup_shared_memory (channel, connection, reply);
+
   g_vfs_channel_set_backend_handle (G_VFS_CHANNEL (channel), open_job->backend_handle);
   open_job->backend_handle = NULL;
   open_job->read_channel = channel;
@@ -50,6 +50,7 @@ struct _GVfsJobOpenForRead
   GVfsReadChannel *read_channel;
 
   GPid pid;
+  guint32 flags;
 };
 
 struct _GVfsJobOpenForReadClass
@@ -43,6 +43,7 @@ static void         finished     (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static void         invalidate_info (GVfsJob *job);
 
 static void
 g_vfs_job_open_for_write_finalize (GObject *object)
@@ -75,6 +76,7 @@ g_vfs_job_open_for_write_class_init (GVfsJobOpenForWriteClass *klass)
   job_class->try = try;
   job_class->finished = finished;
   job_dbus_class->create_reply = create_reply;
+  job_dbus_class->invalidate_info = invalidate_info;
 }
 
 static void
@@ -87,7 +89,7 @@ g_vfs_job_open_for_write_new (DBusConnection *connection,
 			      DBusMessage *message,
 			      GVfsBackend *backend)
 {
-  GVfsJobOpenForWrite *job;
+  GVfsJob *job;
   DBusMessageIter iter;
   DBusMessage *reply;
   DBusError derror;
@@ -121,19 +123,44 @@ g_vfs_job_open_for_write_new (DBusConnection *connection,
       return NULL;
     }
   
+  job = g_vfs_job_open_for_write_new_for_path (connection, message, backend,
+					       path, mode, etag, make_backup,
+					       flags, pid);
+  g_free (path);
+
+  return job;
+}
+
+/* A job for writing a file as part of a larger request, e.g.
+   PushFromChannel. The reply is up to the caller, the opened handle
+   is left in backend_handle. */
+GVfsJob *
+g_vfs_job_open_for_write_new_for_path (DBusConnection          *connection,
+				       DBusMessage             *message,
+				       GVfsBackend             *backend,
+				       const char              *filename,
+				       GVfsJobOpenForWriteMode  mode,
+				       const char              *etag,
+				       gboolean                 make_backup,
+				       GFileCreateFlags         flags,
+				       GPid                     pid)
+{
+  GVfsJobOpenForWrite *job;
+
   job = g_object_new (G_VFS_TYPE_JOB_OPEN_FOR_WRITE,
 		      "message", message,
 		      "connection", connection,
 		      NULL);
 
-  job->filename = path;
+  job->filename = g_strdup (filename);
   job->mode = mode;
-  if (*etag != 0)
+  if (etag != NULL && *etag != 0)
     job->etag = g_strdup (etag);
   job->make_backup = make_backup;
   job->flags = flags;
   job->backend = backend;
   job->pid = pid;
+  g_vfs_backend_invalidate_info (backend, job->filename);
   
   return G_VFS_JOB (job);
 }
@@ -259,6 +286,15 @@ g_vfs_job_open_for_write_set_initial_offset (GVfsJobOpenForWrite *job,
   job->initial_offset = initial_offset;
 }
 
+/* Might be called on an i/o thread */
+static void
+invalidate_info (GVfsJob *job)
+{
+  GVfsJobOpenForWrite *op_job = G_VFS_JOB_OPEN_FOR_WRITE (job);
+
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->filename);
+}
+
 /* Might be called on an i/o thwrite */
 static DBusMessage *
 create_reply (GVfsJob *job,
@@ -277,7 +313,9 @@ create_reply (GVfsJob *job,
   g_assert (open_job->backend_handle != NULL);
 
   error = NULL;
+
   channel = g_vfs_write_channel_new (open_job->backend,
+                                     open_job->filename,
                                      open_job->pid);
 
   remote_fd = g_vfs_channel_steal_remote_fd (G_VFS_CHANNEL (channel));
@@ -75,6 +75,15 @@ GType g_vfs_job_open_for_write_get_type (void) G_GNUC_CONST;
 GVfsJob *g_vfs_job_open_for_write_new                (DBusConnection      *connection,
 						      DBusMessage         *message,
 						      GVfsBackend         *backend);
+GVfsJob *g_vfs_job_open_for_write_new_for_path       (DBusConnection          *connection,
+						      DBusMessage             *message,
+						      GVfsBackend             *backend,
+						      const char              *filename,
+						      GVfsJobOpenForWriteMode  mode,
+						      const char              *etag,
+						      gboolean                 make_backup,
+						      GFileCreateFlags         flags,
+						      GPid                     pid);
 void     g_vfs_job_open_for_write_set_handle         (GVfsJobOpenForWrite *job,
 						      GVfsBackendHandle    handle);
 void     g_vfs_job_open_for_write_set_can_seek       (GVfsJobOpenForWrite *job,
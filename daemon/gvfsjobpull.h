@@ -27,6 +27,7 @@
 #include <gvfsjob.h>
 #include <gvfsjobdbus.h>
 #include <gvfsbackend.h>
+#include <gvfsprogressreporter.h>
 
 G_BEGIN_DECLS
 
@@ -48,8 +49,10 @@ struct _GVfsJobPull
   char *local_path;
   GFileCopyFlags flags;
   char *callback_obj_path;
+  GVfsProgressReporter *progress;
   gboolean remove_source;
   gboolean send_progress;
+  gboolean resume;
 };
 
 struct _GVfsJobPullClass
@@ -27,6 +27,7 @@
 #include <gvfsjob.h>
 #include <gvfsjobdbus.h>
 #include <gvfsbackend.h>
+#include <gvfsprogressreporter.h>
 
 G_BEGIN_DECLS
 
@@ -48,8 +49,10 @@ struct _GVfsJobPush
   char *local_path;
   GFileCopyFlags flags;
   char *callback_obj_path;
+  GVfsProgressReporter *progress;
   gboolean send_progress;
   gboolean remove_source;
+  gboolean resume;
 };
 
 struct _GVfsJobPushClass
@@ -0,0 +1,562 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <glib.h>
+#include <dbus/dbus.h>
+#include <glib/gi18n.h>
+#include "gvfsjobpushfromchannel.h"
+#include "gvfsjobopenforwrite.h"
+#include "gvfswritechannel.h"
+#include "gvfsjobsource.h"
+#include "gvfsdaemonutils.h"
+#include "gvfsdbusutils.h"
+#include "gvfsdaemonprotocol.h"
+
+/* Size asked for in each read request. The source daemon reads ahead
+   on its own, so this doesn't need to be large. */
+#define READ_REQUEST_SIZE (64*1024)
+
+/* The client sends the source fd right before the call */
+#define RECEIVE_FD_TIMEOUT_MSECS (30*1000)
+
+G_DEFINE_TYPE (GVfsJobPushFromChannel, g_vfs_job_push_from_channel, G_VFS_TYPE_JOB_DBUS)
+
+static void         run          (GVfsJob        *job);
+static gboolean     try          (GVfsJob        *job);
+static void         cancelled    (GVfsJob        *job);
+static DBusMessage *create_reply (GVfsJob        *job,
+				  DBusConnection *connection,
+				  DBusMessage    *message);
+static void         invalidate_info (GVfsJob *job);
+
+static void
+g_vfs_job_push_from_channel_finalize (GObject *object)
+{
+  GVfsJobPushFromChannel *job;
+
+  job = G_VFS_JOB_PUSH_FROM_CHANNEL (object);
+
+  if (job->source_fd != -1)
+    close (job->source_fd);
+  if (job->destination_fd != -1)
+    close (job->destination_fd);
+  g_mutex_clear (&job->source_lock);
+  g_free (job->filename);
+  g_free (job->callback_obj_path);
+  if (job->progress)
+    g_vfs_progress_reporter_free (job->progress);
+  
+  if (G_OBJECT_CLASS (g_vfs_job_push_from_channel_parent_class)->finalize)
+    (*G_OBJECT_CLASS (g_vfs_job_push_from_channel_parent_class)->finalize) (object);
+}
+
+static void
+g_vfs_job_push_from_channel_class_init (GVfsJobPushFromChannelClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GVfsJobClass *job_class = G_VFS_JOB_CLASS (klass);
+  GVfsJobDBusClass *job_dbus_class = G_VFS_JOB_DBUS_CLASS (klass);
+  
+  gobject_class->finalize = g_vfs_job_push_from_channel_finalize;
+  job_class->run = run;
+  job_class->try = try;
+  job_class->cancelled = cancelled;
+  job_dbus_class->create_reply = create_reply;
+  job_dbus_class->invalidate_info = invalidate_info;
+}
+
+static void
+g_vfs_job_push_from_channel_init (GVfsJobPushFromChannel *job)
+{
+  job->source_fd = -1;
+  job->destination_fd = -1;
+  g_mutex_init (&job->source_lock);
+}
+
+GVfsJob *
+g_vfs_job_push_from_channel_new (DBusConnection *connection,
+				 DBusMessage *message,
+				 GVfsBackend *backend)
+{
+  GVfsJobPushFromChannel *job;
+  DBusMessage *reply;
+  DBusError derror;
+  int path_len;
+  const char *path_data, *callback_obj_path;
+  dbus_uint32_t fd_id, flags, pid;
+  dbus_uint64_t total_size;
+  
+  dbus_error_init (&derror);
+  if (!dbus_message_get_args (message, &derror, 
+			      DBUS_TYPE_ARRAY, DBUS_TYPE_BYTE,
+			      &path_data, &path_len,
+			      DBUS_TYPE_UINT32, &fd_id,
+			      DBUS_TYPE_UINT64, &total_size,
+			      DBUS_TYPE_UINT32, &flags,
+			      DBUS_TYPE_OBJECT_PATH, &callback_obj_path,
+			      DBUS_TYPE_UINT32, &pid,
+			      0))
+    {
+      reply = dbus_message_new_error (message,
+				      derror.name,
+                                      derror.message);
+      dbus_error_free (&derror);
+
+      dbus_connection_send (connection, reply, NULL);
+      dbus_message_unref (reply);
+      return NULL;
+    }
+
+  job = g_object_new (G_VFS_TYPE_JOB_PUSH_FROM_CHANNEL,
+		      "message", message,
+		      "connection", connection,
+		      NULL);
+
+  job->filename = g_strndup (path_data, path_len);
+  job->backend = backend;
+  job->flags = flags;
+  job->total_size = total_size;
+  job->pid = pid;
+  job->source_fd_id = fd_id;
+  if (strcmp (callback_obj_path, "/org/gtk/vfs/void") != 0)
+    job->callback_obj_path = g_strdup (callback_obj_path);
+  job->progress = g_vfs_progress_reporter_new (G_VFS_JOB_DBUS (job),
+					       job->callback_obj_path);
+  g_vfs_backend_invalidate_info (backend, job->filename);
+  
+  return G_VFS_JOB (job);
+}
+
+static gboolean
+write_all (int            fd,
+	   gconstpointer  data,
+	   gsize          len,
+	   GError       **error)
+{
+  gssize res;
+  int errsv;
+
+  while (len > 0)
+    {
+      res = write (fd, data, len);
+      if (res == -1)
+	{
+	  errsv = errno;
+	  if (errsv == EINTR)
+	    continue;
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error in stream protocol: %s"),
+		       g_strerror (errsv));
+	  return FALSE;
+	}
+      data = (const char *)data + res;
+      len -= res;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+read_all (int       fd,
+	  gpointer  data,
+	  gsize     len,
+	  GError  **error)
+{
+  gssize res;
+  int errsv;
+
+  while (len > 0)
+    {
+      res = read (fd, data, len);
+      if (res == -1)
+	{
+	  errsv = errno;
+	  if (errsv == EINTR)
+	    continue;
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error in stream protocol: %s"),
+		       g_strerror (errsv));
+	  return FALSE;
+	}
+      if (res == 0)
+	{
+	  g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		       _("Internal Error (%s)"), "Stream closed");
+	  return FALSE;
+	}
+      data = (char *)data + res;
+      len -= res;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+send_request (int            fd,
+	      guint32        command,
+	      guint32        seq_nr,
+	      guint32        arg1,
+	      gconstpointer  data,
+	      gsize          data_len,
+	      GError       **error)
+{
+  GVfsDaemonSocketProtocolRequest request;
+
+  request.command = g_htonl (command);
+  request.seq_nr = g_htonl (seq_nr);
+  request.arg1 = g_htonl (arg1);
+  request.arg2 = 0;
+  request.data_len = g_htonl (data_len);
+
+  return write_all (fd, &request, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SIZE, error) &&
+    write_all (fd, data, data_len, error);
+}
+
+/* Reads the header of the next reply and the extra data of the types
+   that have it. Data replies are followed by arg1 bytes for the
+   caller to read. An error reply fails with its error. */
+static gboolean
+read_reply (int                            fd,
+	    GVfsDaemonSocketProtocolReply *reply,
+	    GError                       **error)
+{
+  char *data;
+
+  if (!read_all (fd, reply, G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SIZE, error))
+    return FALSE;
+
+  reply->type = g_ntohl (reply->type);
+  reply->seq_nr = g_ntohl (reply->seq_nr);
+  reply->arg1 = g_ntohl (reply->arg1);
+  reply->arg2 = g_ntohl (reply->arg2);
+
+  if (reply->type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_ERROR &&
+      reply->type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_CLOSED &&
+      reply->type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_INFO)
+    return TRUE;
+
+  data = g_malloc (reply->arg2 + 1);
+  if (!read_all (fd, data, reply->arg2, error))
+    {
+      g_free (data);
+      return FALSE;
+    }
+  data[reply->arg2] = 0;
+
+  if (reply->type == G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_ERROR)
+    {
+      /* domain and message, both nul terminated */
+      if (strlen (data) + 1 < reply->arg2)
+	g_set_error_literal (error, g_quark_from_string (data), reply->arg1,
+			     data + strlen (data) + 1);
+      else
+	g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		     _("Internal Error (%s)"), "Invalid error reply");
+      g_free (data);
+      return FALSE;
+    }
+
+  g_free (data);
+  return TRUE;
+}
+
+/* Called on the pump thread. Reads the source stream block by block
+   and writes each block to the destination channel. */
+static gboolean
+pump (GVfsJobPushFromChannel *job,
+      GError                **error)
+{
+  GVfsDaemonSocketProtocolReply reply;
+  guint32 source_seq_nr, destination_seq_nr;
+  gsize buffer_size;
+  goffset current;
+  char *buffer;
+  gboolean need_read, res;
+
+  buffer_size = READ_REQUEST_SIZE;
+  buffer = g_malloc (buffer_size);
+  source_seq_nr = destination_seq_nr = 1;
+  current = 0;
+  need_read = TRUE;
+  res = FALSE;
+
+  while (TRUE)
+    {
+      if (G_VFS_JOB (job)->cancelled)
+	{
+	  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+			       _("Operation was cancelled"));
+	  goto out;
+	}
+
+      /* One request per block, readahead may send more on its own */
+      if (need_read &&
+	  !send_request (job->source_fd, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_READ,
+			 source_seq_nr++, READ_REQUEST_SIZE, NULL, 0, error))
+	goto out;
+      need_read = FALSE;
+
+      if (!read_reply (job->source_fd, &reply, error))
+	goto out;
+      if (reply.type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA)
+	continue;
+
+      need_read = TRUE;
+      if (reply.arg1 == 0)
+	break; /* End of file */
+
+      if (reply.arg1 > buffer_size)
+	{
+	  buffer_size = reply.arg1;
+	  buffer = g_realloc (buffer, buffer_size);
+	}
+
+      if (!read_all (job->source_fd, buffer, reply.arg1, error) ||
+	  !send_request (job->destination_fd, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_WRITE,
+			 destination_seq_nr++, reply.arg1, buffer, reply.arg1, error) ||
+	  !read_reply (job->destination_fd, &reply, error))
+	goto out;
+
+      if (reply.type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_WRITTEN)
+	{
+	  g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		       _("Internal Error (%s)"), "Unexpected reply");
+	  goto out;
+	}
+
+      current += reply.arg1;
+      g_vfs_progress_reporter_update (job->progress, current, job->total_size);
+    }
+
+  /* Closing the destination reports the errors of writing it out */
+  if (!send_request (job->destination_fd, G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_CLOSE,
+		     destination_seq_nr++, 0, NULL, 0, error))
+    goto out;
+  do
+    {
+      if (!read_reply (job->destination_fd, &reply, error))
+	goto out;
+    }
+  while (reply.type != G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_CLOSED);
+
+  res = TRUE;
+
+ out:
+  g_free (buffer);
+  return res;
+}
+
+static void
+set_blocking (int fd)
+{
+  int flags;
+
+  flags = fcntl (fd, F_GETFL);
+  if (flags != -1 && (flags & O_NONBLOCK))
+    fcntl (fd, F_SETFL, flags & ~O_NONBLOCK);
+}
+
+/* Called on the pump thread, receiving may wait for the client */
+static gboolean
+receive_source (GVfsJobPushFromChannel *job,
+		GError                **error)
+{
+  int fd;
+
+  fd = dbus_connection_receive_fd (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+				   job->source_fd_id,
+				   RECEIVE_FD_TIMEOUT_MSECS,
+				   error);
+  if (fd == -1)
+    return FALSE;
+
+  set_blocking (fd);
+
+  g_mutex_lock (&job->source_lock);
+  job->source_fd = fd;
+  if (G_VFS_JOB (job)->cancelled)
+    shutdown (fd, SHUT_RDWR);
+  g_mutex_unlock (&job->source_lock);
+
+  return TRUE;
+}
+
+static gpointer
+pump_thread (gpointer data)
+{
+  GVfsJobPushFromChannel *job = data;
+  GError *error;
+
+  error = NULL;
+  if (receive_source (job, &error) &&
+      pump (job, &error))
+    g_vfs_job_succeeded (G_VFS_JOB (job));
+  else
+    {
+      /* cancelled() broke the source stream */
+      if (G_VFS_JOB (job)->cancelled)
+	{
+	  g_clear_error (&error);
+	  g_set_error_literal (&error, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+			       _("Operation was cancelled"));
+	}
+      g_vfs_job_failed_from_error (G_VFS_JOB (job), error);
+      g_error_free (error);
+    }
+
+  /* The fds are closed with the job, which closes the file in the
+     source daemon. Without a close request the destination channel
+     closes its file too, leaving what was written so far. */
+  g_object_unref (job);
+  return NULL;
+}
+
+/* Might be called on an i/o thread. Once the destination is open its
+   write channel is set up like for OpenForWrite, with the other end
+   kept here instead of sent to the client. */
+static void
+open_job_send_reply (GVfsJob *open_job,
+		     gpointer user_data)
+{
+  GVfsJobPushFromChannel *job = user_data;
+  GVfsJobOpenForWrite *op_open_job = G_VFS_JOB_OPEN_FOR_WRITE (open_job);
+  GVfsWriteChannel *channel;
+  GThread *thread;
+
+  g_signal_stop_emission_by_name (open_job, "send-reply");
+
+  if (open_job->failed)
+    {
+      g_vfs_job_failed_from_error (G_VFS_JOB (job), open_job->error);
+      g_vfs_job_emit_finished (open_job);
+      return;
+    }
+
+  channel = g_vfs_write_channel_new (job->backend,
+				     job->filename,
+				     job->pid);
+  job->destination_fd = g_vfs_channel_steal_remote_fd (G_VFS_CHANNEL (channel));
+  g_vfs_channel_set_backend_handle (G_VFS_CHANNEL (channel), op_open_job->backend_handle);
+  op_open_job->backend_handle = NULL;
+  op_open_job->write_channel = channel;
+
+  g_signal_emit_by_name (open_job, "new-source", channel);
+  g_vfs_job_emit_finished (open_job);
+
+  set_blocking (job->destination_fd);
+
+  thread = g_thread_new ("gvfs-push-from-channel", pump_thread, g_object_ref (job));
+  g_thread_unref (thread);
+}
+
+/* Wakes up the pump if it waits for the source */
+static void
+cancelled (GVfsJob *job)
+{
+  GVfsJobPushFromChannel *op_job = G_VFS_JOB_PUSH_FROM_CHANNEL (job);
+
+  g_mutex_lock (&op_job->source_lock);
+  if (op_job->source_fd != -1)
+    shutdown (op_job->source_fd, SHUT_RDWR);
+  g_mutex_unlock (&op_job->source_lock);
+}
+
+/* Never called, try() always takes the job */
+static void
+run (GVfsJob *job)
+{
+  g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		    _("Operation not supported by backend"));
+}
+
+static gboolean
+try (GVfsJob *job)
+{
+  GVfsJobPushFromChannel *op_job = G_VFS_JOB_PUSH_FROM_CHANNEL (job);
+  GVfsJob *open_job;
+
+  /* Opens it like the client would for a copy */
+  if (op_job->flags & G_FILE_COPY_OVERWRITE)
+    open_job = g_vfs_job_open_for_write_new_for_path (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+						      g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job)),
+						      op_job->backend,
+						      op_job->filename,
+						      OPEN_FOR_WRITE_REPLACE,
+						      NULL,
+						      (op_job->flags & G_FILE_COPY_BACKUP) != 0,
+						      G_FILE_CREATE_REPLACE_DESTINATION,
+						      op_job->pid);
+  else
+    open_job = g_vfs_job_open_for_write_new_for_path (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+						      g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job)),
+						      op_job->backend,
+						      op_job->filename,
+						      OPEN_FOR_WRITE_CREATE,
+						      NULL,
+						      FALSE,
+						      G_FILE_CREATE_NONE,
+						      op_job->pid);
+
+  g_signal_connect_data (open_job, "send-reply",
+			 (GCallback)open_job_send_reply,
+			 g_object_ref (job),
+			 (GClosureNotify)g_object_unref, 0);
+  g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (op_job->backend), open_job);
+  g_object_unref (open_job);
+
+  return TRUE;
+}
+
+/* Might be called on an i/o thread */
+static void
+invalidate_info (GVfsJob *job)
+{
+  GVfsJobPushFromChannel *op_job = G_VFS_JOB_PUSH_FROM_CHANNEL (job);
+
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->filename);
+}
+
+/* Might be called on an i/o thread */
+static DBusMessage *
+create_reply (GVfsJob *job,
+	      DBusConnection *connection,
+	      DBusMessage *message)
+{
+  GVfsJobPushFromChannel *op_job = G_VFS_JOB_PUSH_FROM_CHANNEL (job);
+  DBusMessage *reply;
+
+  g_vfs_progress_reporter_flush (op_job->progress);
+
+  reply = dbus_message_new_method_return (message);
+  
+  return reply;
+}
@@ -0,0 +1,76 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_JOB_PUSH_FROM_CHANNEL_H__
+#define __G_VFS_JOB_PUSH_FROM_CHANNEL_H__
+
+#include <gio/gio.h>
+#include <gvfsjob.h>
+#include <gvfsjobdbus.h>
+#include <gvfsbackend.h>
+#include <gvfsprogressreporter.h>
+
+G_BEGIN_DECLS
+
+#define G_VFS_TYPE_JOB_PUSH_FROM_CHANNEL         (g_vfs_job_push_from_channel_get_type ())
+#define G_VFS_JOB_PUSH_FROM_CHANNEL(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), G_VFS_TYPE_JOB_PUSH_FROM_CHANNEL, GVfsJobPushFromChannel))
+#define G_VFS_JOB_PUSH_FROM_CHANNEL_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), G_VFS_TYPE_JOB_PUSH_FROM_CHANNEL, GVfsJobPushFromChannelClass))
+#define G_VFS_IS_JOB_PUSH_FROM_CHANNEL(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), G_VFS_TYPE_JOB_PUSH_FROM_CHANNEL))
+#define G_VFS_IS_JOB_PUSH_FROM_CHANNEL_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), G_VFS_TYPE_JOB_PUSH_FROM_CHANNEL))
+#define G_VFS_JOB_PUSH_FROM_CHANNEL_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), G_VFS_TYPE_JOB_PUSH_FROM_CHANNEL, GVfsJobPushFromChannelClass))
+
+typedef struct _GVfsJobPushFromChannel        GVfsJobPushFromChannel;
+typedef struct _GVfsJobPushFromChannelClass   GVfsJobPushFromChannelClass;
+
+/* Writes a file with the data of a read stream of another daemon */
+struct _GVfsJobPushFromChannel
+{
+  GVfsJobDBus parent_instance;
+
+  GVfsBackend *backend;
+  char *filename;
+  GFileCopyFlags flags;
+  char *callback_obj_path;
+  GVfsProgressReporter *progress;
+  goffset total_size;
+  GPid pid;
+
+  guint32 source_fd_id; /* received on the pump thread */
+  GMutex source_lock;   /* protects source_fd against cancelled() */
+  int source_fd;        /* the read stream of the source daemon */
+  int destination_fd;  /* our write channel for filename */
+};
+
+struct _GVfsJobPushFromChannelClass
+{
+  GVfsJobDBusClass parent_class;
+};
+
+GType g_vfs_job_push_from_channel_get_type (void) G_GNUC_CONST;
+
+GVfsJob *g_vfs_job_push_from_channel_new (DBusConnection *connection,
+					  DBusMessage    *message,
+					  GVfsBackend    *backend);
+
+G_END_DECLS
+
+#endif /* __G_VFS_JOB_PUSH_FROM_CHANNEL_H__ */
@@ -0,0 +1,519 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+#include <dbus/dbus.h>
+#include <glib/gi18n.h>
+#include "gvfsjobquerydiskusage.h"
+#include "gvfsjobqueryinfo.h"
+#include "gvfsjobenumerate.h"
+#include "gvfsjobsource.h"
+#include "gvfsdbusutils.h"
+#include "gvfsdaemonprotocol.h"
+
+/* Directories listed at the same time during the walk */
+#define MAX_DIR_JOBS 8
+
+/* At most one progress call per this many msecs */
+#define PROGRESS_MSECS 250
+
+#define WALK_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK "," \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+  G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE
+
+#define DIR_KEY "g-vfs-query-disk-usage-dir"
+
+G_DEFINE_TYPE (GVfsJobQueryDiskUsage, g_vfs_job_query_disk_usage, G_VFS_TYPE_JOB_DBUS)
+
+static void         run          (GVfsJob        *job);
+static gboolean     try          (GVfsJob        *job);
+static DBusMessage *create_reply (GVfsJob        *job,
+				  DBusConnection *connection,
+				  DBusMessage    *message);
+
+static void
+g_vfs_job_query_disk_usage_finalize (GObject *object)
+{
+  GVfsJobQueryDiskUsage *job;
+
+  job = G_VFS_JOB_QUERY_DISK_USAGE (object);
+
+  while (!g_queue_is_empty (&job->pending_dirs))
+    g_free (g_queue_pop_head (&job->pending_dirs));
+  if (job->walk_error)
+    g_error_free (job->walk_error);
+  g_mutex_clear (&job->lock);
+  g_free (job->filename);
+  g_free (job->callback_obj_path);
+  
+  if (G_OBJECT_CLASS (g_vfs_job_query_disk_usage_parent_class)->finalize)
+    (*G_OBJECT_CLASS (g_vfs_job_query_disk_usage_parent_class)->finalize) (object);
+}
+
+static void
+g_vfs_job_query_disk_usage_class_init (GVfsJobQueryDiskUsageClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GVfsJobClass *job_class = G_VFS_JOB_CLASS (klass);
+  GVfsJobDBusClass *job_dbus_class = G_VFS_JOB_DBUS_CLASS (klass);
+  
+  gobject_class->finalize = g_vfs_job_query_disk_usage_finalize;
+  job_class->run = run;
+  job_class->try = try;
+  job_dbus_class->create_reply = create_reply;
+}
+
+static void
+g_vfs_job_query_disk_usage_init (GVfsJobQueryDiskUsage *job)
+{
+  g_mutex_init (&job->lock);
+  g_queue_init (&job->pending_dirs);
+}
+
+GVfsJob *
+g_vfs_job_query_disk_usage_new (DBusConnection *connection,
+				DBusMessage *message,
+				GVfsBackend *backend)
+{
+  GVfsJobQueryDiskUsage *job;
+  DBusMessage *reply;
+  DBusError derror;
+  int path_len;
+  const char *path_data, *callback_obj_path;
+  dbus_uint32_t flags;
+  
+  dbus_error_init (&derror);
+  if (!dbus_message_get_args (message, &derror, 
+			      DBUS_TYPE_ARRAY, DBUS_TYPE_BYTE,
+			      &path_data, &path_len,
+			      DBUS_TYPE_UINT32, &flags,
+			      DBUS_TYPE_OBJECT_PATH, &callback_obj_path,
+			      0))
+    {
+      reply = dbus_message_new_error (message,
+				      derror.name,
+                                      derror.message);
+      dbus_error_free (&derror);
+
+      dbus_connection_send (connection, reply, NULL);
+      dbus_message_unref (reply);
+      return NULL;
+    }
+
+  job = g_object_new (G_VFS_TYPE_JOB_QUERY_DISK_USAGE,
+		      "message", message,
+		      "connection", connection,
+		      NULL);
+
+  job->filename = g_strndup (path_data, path_len);
+  job->backend = backend;
+  job->flags = flags;
+  if (strcmp (callback_obj_path, "/org/gtk/vfs/void") != 0)
+    job->callback_obj_path = g_strdup (callback_obj_path);
+  
+  return G_VFS_JOB (job);
+}
+
+void
+g_vfs_job_query_disk_usage_set_result (GVfsJobQueryDiskUsage *job,
+				       guint64 size,
+				       guint64 allocated_size,
+				       guint64 n_dirs,
+				       guint64 n_files)
+{
+  job->size = size;
+  job->allocated_size = allocated_size;
+  job->n_dirs = n_dirs;
+  job->n_files = n_files;
+}
+
+/* Might be called on an i/o thread, but only from one thread at a
+   time. Calls more often than PROGRESS_MSECS are dropped. */
+void
+g_vfs_job_query_disk_usage_progress (GVfsJobQueryDiskUsage *job,
+				     guint64 size,
+				     guint64 allocated_size,
+				     guint64 n_dirs,
+				     guint64 n_files)
+{
+  GVfsJobDBus *dbus_job = G_VFS_JOB_DBUS (job);
+  dbus_uint64_t size_dbus, allocated_size_dbus, n_dirs_dbus, n_files_dbus;
+  DBusMessage *message;
+  gint64 now;
+
+  if (job->callback_obj_path == NULL)
+    return;
+
+  now = g_get_monotonic_time ();
+  if (job->last_progress != 0 &&
+      now - job->last_progress < PROGRESS_MSECS * 1000)
+    return;
+  job->last_progress = now;
+
+  message =
+    dbus_message_new_method_call (dbus_message_get_sender (dbus_job->message),
+				  job->callback_obj_path,
+				  G_VFS_DBUS_PROGRESS_INTERFACE,
+				  G_VFS_DBUS_PROGRESS_OP_DISK_USAGE);
+  dbus_message_set_no_reply (message, TRUE);
+
+  size_dbus = size;
+  allocated_size_dbus = allocated_size;
+  n_dirs_dbus = n_dirs;
+  n_files_dbus = n_files;
+  dbus_message_append_args (message,
+			    DBUS_TYPE_UINT64, &size_dbus,
+			    DBUS_TYPE_UINT64, &allocated_size_dbus,
+			    DBUS_TYPE_UINT64, &n_dirs_dbus,
+			    DBUS_TYPE_UINT64, &n_files_dbus,
+			    0);
+
+  /* Queues message (threadsafely), actually sends it in mainloop */
+  dbus_connection_send (dbus_job->connection, message, NULL);
+  dbus_message_unref (message);
+}
+
+/* Called with the lock held. Returns TRUE for a directory to list. */
+static gboolean
+count_info (GVfsJobQueryDiskUsage *job,
+	    GFileInfo             *info)
+{
+  gboolean is_dir;
+
+  is_dir = g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY &&
+    !g_file_info_get_is_symlink (info);
+
+  job->size += g_file_info_get_size (info);
+  job->allocated_size +=
+    g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE);
+  if (is_dir)
+    job->n_dirs++;
+  else
+    job->n_files++;
+
+  g_vfs_job_query_disk_usage_progress (job,
+				       job->size, job->allocated_size,
+				       job->n_dirs, job->n_files);
+
+  return is_dir;
+}
+
+/* Might be called on an i/o thread */
+static void
+finish_walk (GVfsJobQueryDiskUsage *job)
+{
+  if (job->walk_error)
+    g_vfs_job_failed_from_error (G_VFS_JOB (job), job->walk_error);
+  else if (G_VFS_JOB (job)->cancelled)
+    g_vfs_job_failed (G_VFS_JOB (job), G_IO_ERROR, G_IO_ERROR_CANCELLED,
+		      _("Operation was cancelled"));
+  else
+    g_vfs_job_succeeded (G_VFS_JOB (job));
+}
+
+/* Might be called on an i/o thread */
+static void
+dir_got_info (GVfsJobEnumerate *dir_job,
+	      GFileInfo        *info,
+	      gpointer          user_data)
+{
+  GVfsJobQueryDiskUsage *job = user_data;
+  const char *dir, *name;
+
+  name = g_file_info_get_name (info);
+  if (name == NULL)
+    return;
+
+  dir = g_object_get_data (G_OBJECT (dir_job), DIR_KEY);
+
+  g_mutex_lock (&job->lock);
+  if (count_info (job, info))
+    g_queue_push_tail (&job->pending_dirs,
+		       g_build_path ("/", dir, name, NULL));
+  g_mutex_unlock (&job->lock);
+}
+
+static void start_dir_jobs (GVfsJobQueryDiskUsage *job);
+
+static gboolean
+start_dir_jobs_idle (gpointer data)
+{
+  start_dir_jobs (data);
+  return FALSE;
+}
+
+/* Might be called on an i/o thread. A directory is listed, or could
+   not be. */
+static void
+dir_finished (GVfsJobQueryDiskUsage *job)
+{
+  gboolean all_done, start_more;
+
+  g_mutex_lock (&job->lock);
+  job->n_running--;
+  all_done = job->n_running == 0 && g_queue_is_empty (&job->pending_dirs);
+  start_more = !g_queue_is_empty (&job->pending_dirs) && !job->start_scheduled;
+  if (start_more)
+    job->start_scheduled = TRUE;
+  g_mutex_unlock (&job->lock);
+
+  /* Jobs are queued on the main thread */
+  if (start_more)
+    g_idle_add_full (G_PRIORITY_DEFAULT, start_dir_jobs_idle,
+		     g_object_ref (job), g_object_unref);
+
+  if (all_done)
+    finish_walk (job);
+}
+
+/* Might be called on an i/o thread */
+static void
+dir_done (GVfsJobEnumerate *dir_job,
+	  gpointer          user_data)
+{
+  dir_finished (user_data);
+}
+
+/* Might be called on an i/o thread. Listed directories end in
+   dir_done(), this only handles the failed ones. */
+static void
+dir_job_send_reply (GVfsJob *dir_job,
+		    gpointer user_data)
+{
+  GVfsJobQueryDiskUsage *job = user_data;
+
+  g_signal_stop_emission_by_name (dir_job, "send-reply");
+
+  if (!dir_job->failed)
+    return;
+
+  g_vfs_job_emit_finished (dir_job);
+
+  /* Unreadable directories are skipped unless asked otherwise */
+  if ((job->flags & G_VFS_DISK_USAGE_FLAG_REPORT_ANY_ERROR) ||
+      g_error_matches (dir_job->error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_mutex_lock (&job->lock);
+      if (job->walk_error == NULL)
+	job->walk_error = g_error_copy (dir_job->error);
+      g_mutex_unlock (&job->lock);
+    }
+  else
+    g_debug ("Skipping %s: %s\n",
+	     (char *)g_object_get_data (G_OBJECT (dir_job), DIR_KEY),
+	     dir_job->error->message);
+
+  dir_finished (job);
+}
+
+/* Called on the main thread */
+static void
+start_dir_jobs (GVfsJobQueryDiskUsage *job)
+{
+  GVfsJob *dir_job;
+  gboolean all_done;
+  char *dir;
+
+  all_done = FALSE;
+
+  g_mutex_lock (&job->lock);
+  job->start_scheduled = FALSE;
+
+  /* Directories queued before Cancel or an error end with us, the
+     rest are not listed */
+  if (G_VFS_JOB (job)->cancelled || job->walk_error != NULL)
+    {
+      while ((dir = g_queue_pop_head (&job->pending_dirs)) != NULL)
+	g_free (dir);
+      all_done = job->n_running == 0;
+    }
+
+  while (job->n_running < MAX_DIR_JOBS &&
+	 (dir = g_queue_pop_head (&job->pending_dirs)) != NULL)
+    {
+      job->n_running++;
+      g_mutex_unlock (&job->lock);
+
+      dir_job = g_vfs_job_enumerate_new_for_path (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+						  g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job)),
+						  job->backend,
+						  dir,
+						  WALK_ATTRIBUTES,
+						  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+						  dir_got_info,
+						  dir_done,
+						  job);
+      g_object_set_data_full (G_OBJECT (dir_job), DIR_KEY, dir, g_free);
+      g_signal_connect_data (dir_job, "send-reply",
+			     (GCallback)dir_job_send_reply,
+			     g_object_ref (job),
+			     (GClosureNotify)g_object_unref, 0);
+      g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (job->backend), dir_job);
+      g_object_unref (dir_job);
+
+      g_mutex_lock (&job->lock);
+    }
+  g_mutex_unlock (&job->lock);
+
+  if (all_done)
+    finish_walk (job);
+}
+
+/* Might be called on an i/o thread. The walked path itself decides
+   if the job fails, and if there is anything below it. */
+static void
+root_job_send_reply (GVfsJob *root_job,
+		     gpointer user_data)
+{
+  GVfsJobQueryDiskUsage *job = user_data;
+  gboolean is_dir;
+
+  g_signal_stop_emission_by_name (root_job, "send-reply");
+
+  if (root_job->failed)
+    {
+      g_vfs_job_failed_from_error (G_VFS_JOB (job), root_job->error);
+      g_vfs_job_emit_finished (root_job);
+      return;
+    }
+
+  g_mutex_lock (&job->lock);
+  is_dir = count_info (job, g_vfs_job_query_info_get_result (G_VFS_JOB_QUERY_INFO (root_job)));
+  if (is_dir)
+    {
+      g_queue_push_tail (&job->pending_dirs, g_strdup (job->filename));
+      job->start_scheduled = TRUE;
+    }
+  g_mutex_unlock (&job->lock);
+
+  g_vfs_job_emit_finished (root_job);
+
+  /* Jobs are queued on the main thread */
+  if (is_dir)
+    g_idle_add_full (G_PRIORITY_DEFAULT, start_dir_jobs_idle,
+		     g_object_ref (job), g_object_unref);
+  else
+    g_vfs_job_succeeded (G_VFS_JOB (job));
+}
+
+/* Called on the main thread. Walks the tree with the backend's
+   query_info and enumerate, one job per directory, so the walk gets
+   the info cache and try/run like any other job. */
+static void
+start_walk (GVfsJobQueryDiskUsage *job)
+{
+  GVfsJob *root_job;
+
+  root_job = g_vfs_job_query_info_new_for_path (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+						g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job)),
+						job->backend,
+						job->filename,
+						WALK_ATTRIBUTES,
+						G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+						NULL);
+  g_signal_connect_data (root_job, "send-reply",
+			 (GCallback)root_job_send_reply,
+			 g_object_ref (job),
+			 (GClosureNotify)g_object_unref, 0);
+  g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (job->backend), root_job);
+  g_object_unref (root_job);
+}
+
+static void
+run (GVfsJob *job)
+{
+  GVfsJobQueryDiskUsage *op_job = G_VFS_JOB_QUERY_DISK_USAGE (job);
+  GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (op_job->backend);
+
+  if (class->query_disk_usage == NULL)
+    {
+      g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			_("Operation not supported by backend"));
+      return;
+    }
+  
+  class->query_disk_usage (op_job->backend,
+			   op_job,
+			   op_job->filename,
+			   op_job->flags);
+}
+
+static gboolean
+try (GVfsJob *job)
+{
+  GVfsJobQueryDiskUsage *op_job = G_VFS_JOB_QUERY_DISK_USAGE (job);
+  GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (op_job->backend);
+
+  if (class->try_query_disk_usage != NULL &&
+      class->try_query_disk_usage (op_job->backend,
+				   op_job,
+				   op_job->filename,
+				   op_job->flags))
+    return TRUE;
+
+  if (class->query_disk_usage != NULL)
+    return FALSE;
+
+  if ((class->enumerate == NULL && class->try_enumerate == NULL) ||
+      (class->query_info == NULL && class->try_query_info == NULL))
+    {
+      g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			_("Operation not supported by backend"));
+      return TRUE;
+    }
+
+  start_walk (op_job);
+  return TRUE;
+}
+
+/* Might be called on an i/o thread */
+static DBusMessage *
+create_reply (GVfsJob *job,
+	      DBusConnection *connection,
+	      DBusMessage *message)
+{
+  GVfsJobQueryDiskUsage *op_job = G_VFS_JOB_QUERY_DISK_USAGE (job);
+  dbus_uint64_t size, allocated_size, n_dirs, n_files;
+  DBusMessage *reply;
+
+  size = op_job->size;
+  allocated_size = op_job->allocated_size;
+  n_dirs = op_job->n_dirs;
+  n_files = op_job->n_files;
+
+  reply = dbus_message_new_method_return (message);
+  dbus_message_append_args (reply,
+			    DBUS_TYPE_UINT64, &size,
+			    DBUS_TYPE_UINT64, &allocated_size,
+			    DBUS_TYPE_UINT64, &n_dirs,
+			    DBUS_TYPE_UINT64, &n_files,
+			    0);
+  
+  return reply;
+}
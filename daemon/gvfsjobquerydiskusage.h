@@ -0,0 +1,88 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_JOB_QUERY_DISK_USAGE_H__
+#define __G_VFS_JOB_QUERY_DISK_USAGE_H__
+
+#include <gio/gio.h>
+#include <gvfsjob.h>
+#include <gvfsjobdbus.h>
+#include <gvfsbackend.h>
+
+G_BEGIN_DECLS
+
+#define G_VFS_TYPE_JOB_QUERY_DISK_USAGE         (g_vfs_job_query_disk_usage_get_type ())
+#define G_VFS_JOB_QUERY_DISK_USAGE(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), G_VFS_TYPE_JOB_QUERY_DISK_USAGE, GVfsJobQueryDiskUsage))
+#define G_VFS_JOB_QUERY_DISK_USAGE_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), G_VFS_TYPE_JOB_QUERY_DISK_USAGE, GVfsJobQueryDiskUsageClass))
+#define G_VFS_IS_JOB_QUERY_DISK_USAGE(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), G_VFS_TYPE_JOB_QUERY_DISK_USAGE))
+#define G_VFS_IS_JOB_QUERY_DISK_USAGE_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), G_VFS_TYPE_JOB_QUERY_DISK_USAGE))
+#define G_VFS_JOB_QUERY_DISK_USAGE_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), G_VFS_TYPE_JOB_QUERY_DISK_USAGE, GVfsJobQueryDiskUsageClass))
+
+typedef struct _GVfsJobQueryDiskUsageClass   GVfsJobQueryDiskUsageClass;
+
+struct _GVfsJobQueryDiskUsage
+{
+  GVfsJobDBus parent_instance;
+
+  GVfsBackend *backend;
+  char *filename;
+  guint32 flags;
+  char *callback_obj_path;
+
+  guint64 size;
+  guint64 allocated_size;
+  guint64 n_dirs;
+  guint64 n_files;
+  gint64 last_progress;
+
+  /* The walk, for backends without query_disk_usage */
+  GMutex lock;
+  GQueue pending_dirs;
+  guint n_running;
+  gboolean start_scheduled;
+  GError *walk_error;
+};
+
+struct _GVfsJobQueryDiskUsageClass
+{
+  GVfsJobDBusClass parent_class;
+};
+
+GType g_vfs_job_query_disk_usage_get_type (void) G_GNUC_CONST;
+
+GVfsJob *g_vfs_job_query_disk_usage_new        (DBusConnection        *connection,
+						DBusMessage           *message,
+						GVfsBackend           *backend);
+void     g_vfs_job_query_disk_usage_set_result (GVfsJobQueryDiskUsage *job,
+						guint64                size,
+						guint64                allocated_size,
+						guint64                n_dirs,
+						guint64                n_files);
+void     g_vfs_job_query_disk_usage_progress   (GVfsJobQueryDiskUsage *job,
+						guint64                size,
+						guint64                allocated_size,
+						guint64                n_dirs,
+						guint64                n_files);
+
+G_END_DECLS
+
+#endif /* __G_VFS_JOB_QUERY_DISK_USAGE_H__ */
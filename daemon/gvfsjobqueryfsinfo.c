@@ -41,6 +41,9 @@ static gboolean     try          (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static char *       get_singleflight_key (GVfsJob *job);
+static void         share_result (GVfsJob        *job,
+				  GVfsJob        *follower);
 
 static void
 g_vfs_job_query_fs_info_finalize (GObject *object)
@@ -52,6 +55,7 @@ g_vfs_job_query_fs_info_finalize (GObject *object)
   g_object_unref (job->file_info);
   
   g_free (job->filename);
+  g_free (job->attributes);
   g_file_attribute_matcher_unref (job->attribute_matcher);
   
   if (G_OBJECT_CLASS (g_vfs_job_query_fs_info_parent_class)->finalize)
@@ -68,6 +72,8 @@ g_vfs_job_query_fs_info_class_init (GVfsJobQueryFsInfoClass *klass)
   gobject_class->finalize = g_vfs_job_query_fs_info_finalize;
   job_class->run = run;
   job_class->try = try;
+  job_class->get_singleflight_key = get_singleflight_key;
+  job_class->share_result = share_result;
   job_dbus_class->create_reply = create_reply;
 }
 
@@ -112,6 +118,7 @@ g_vfs_job_query_fs_info_new (DBusConnection *connection,
 
   job->filename = g_strndup (path_data, path_len);
   job->backend = backend;
+  job->attributes = g_strdup (attributes);
   job->attribute_matcher = g_file_attribute_matcher_new (attributes);
   
   job->file_info = g_file_info_new ();
@@ -156,6 +163,27 @@ try (GVfsJob *job)
 				 op_job->attribute_matcher);
 }
 
+static char *
+get_singleflight_key (GVfsJob *job)
+{
+  GVfsJobQueryFsInfo *op_job = G_VFS_JOB_QUERY_FS_INFO (job);
+
+  return g_strdup_printf ("QueryFsInfo %p %s\n%s",
+			  op_job->backend, op_job->attributes, op_job->filename);
+}
+
+/* Might be called on an i/o thread */
+static void
+share_result (GVfsJob *job,
+	      GVfsJob *follower)
+{
+  GVfsJobQueryFsInfo *op_job = G_VFS_JOB_QUERY_FS_INFO (job);
+  GVfsJobQueryFsInfo *op_follower = G_VFS_JOB_QUERY_FS_INFO (follower);
+
+  g_file_info_copy_into (op_job->file_info, op_follower->file_info);
+  g_vfs_job_succeeded (follower);
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
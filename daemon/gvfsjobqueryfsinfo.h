@@ -45,6 +45,7 @@ struct _GVfsJobQueryFsInfo
 
   GVfsBackend *backend;
   char *filename;
+  char *attributes;
   GFileAttributeMatcher *attribute_matcher;
 
   GFileInfo *file_info;
@@ -42,6 +42,9 @@ static gboolean     try          (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static char *       get_singleflight_key (GVfsJob *job);
+static void         share_result (GVfsJob        *job,
+				  GVfsJob        *follower);
 
 static void
 g_vfs_job_query_info_finalize (GObject *object)
@@ -71,6 +74,8 @@ g_vfs_job_query_info_class_init (GVfsJobQueryInfoClass *klass)
   gobject_class->finalize = g_vfs_job_query_info_finalize;
   job_class->run = run;
   job_class->try = try;
+  job_class->get_singleflight_key = get_singleflight_key;
+  job_class->share_result = share_result;
   job_dbus_class->create_reply = create_reply;
 }
 
@@ -84,13 +89,13 @@ g_vfs_job_query_info_new (DBusConnection *connection,
 			  DBusMessage *message,
 			  GVfsBackend *backend)
 {
-  GVfsJobQueryInfo *job;
+  GVfsJob *job;
   DBusMessage *reply;
   DBusError derror;
   int path_len;
   const char *path_data;
   char *attributes;
-  char *uri;
+  char *uri, *filename;
   dbus_uint32_t flags;
   DBusMessageIter iter;
 
@@ -119,18 +124,41 @@ g_vfs_job_query_info_new (DBusConnection *connection,
 				      DBUS_TYPE_STRING, &uri,
 				      0))
     uri = NULL;
-  
+
+  filename = g_strndup (path_data, path_len);
+  job = g_vfs_job_query_info_new_for_path (connection, message, backend,
+					   filename, attributes, flags, uri);
+  g_free (filename);
+
+  return job;
+}
+
+/* A job for one path of a larger request, e.g. QueryInfoMulti. The
+   reply is up to the caller, see g_vfs_job_query_info_get_result(). */
+GVfsJob *
+g_vfs_job_query_info_new_for_path (DBusConnection      *connection,
+				   DBusMessage         *message,
+				   GVfsBackend         *backend,
+				   const char          *filename,
+				   const char          *attributes,
+				   GFileQueryInfoFlags  flags,
+				   const char          *uri)
+{
+  GVfsJobQueryInfo *job;
+
   job = g_object_new (G_VFS_TYPE_JOB_QUERY_INFO,
 		      "message", message,
 		      "connection", connection,
 		      NULL);
 
-  job->filename = g_strndup (path_data, path_len);
+  job->filename = g_strdup (filename);
   job->backend = backend;
   job->attributes = g_strdup (attributes);
   job->attribute_matcher = g_file_attribute_matcher_new (attributes);
   job->flags = flags;
   job->uri = g_strdup (uri);
+  job->cache_generation =
+    g_vfs_info_cache_get_generation (g_vfs_backend_get_info_cache (backend));
 
   job->file_info = g_file_info_new ();
   g_file_info_set_attribute_mask (job->file_info, job->attribute_matcher);
@@ -164,6 +192,21 @@ try (GVfsJob *job)
 {
   GVfsJobQueryInfo *op_job = G_VFS_JOB_QUERY_INFO (job);
   GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (op_job->backend);
+  GFileInfo *info;
+
+  info = g_vfs_info_cache_lookup (g_vfs_backend_get_info_cache (op_job->backend),
+				  op_job->filename,
+				  op_job->attributes,
+				  op_job->flags);
+  if (info != NULL)
+    {
+      g_file_info_copy_into (info, op_job->file_info);
+      g_file_info_set_attribute_mask (op_job->file_info, op_job->attribute_matcher);
+      g_object_unref (info);
+      op_job->from_cache = TRUE;
+      g_vfs_job_succeeded (job);
+      return TRUE;
+    }
 
   if (class->try_query_info == NULL)
     return FALSE;
@@ -176,6 +219,53 @@ try (GVfsJob *job)
 				op_job->attribute_matcher);
 }
 
+static char *
+get_singleflight_key (GVfsJob *job)
+{
+  GVfsJobQueryInfo *op_job = G_VFS_JOB_QUERY_INFO (job);
+
+  /* The filename goes last, it is the only part that may contain
+     newlines */
+  return g_strdup_printf ("QueryInfo %p %u %s\n%s\n%s",
+			  op_job->backend, op_job->flags, op_job->attributes,
+			  op_job->uri ? op_job->uri : "", op_job->filename);
+}
+
+/* Might be called on an i/o thread */
+static void
+share_result (GVfsJob *job,
+	      GVfsJob *follower)
+{
+  GVfsJobQueryInfo *op_job = G_VFS_JOB_QUERY_INFO (job);
+  GVfsJobQueryInfo *op_follower = G_VFS_JOB_QUERY_INFO (follower);
+
+  g_file_info_copy_into (op_job->file_info, op_follower->file_info);
+  g_vfs_job_succeeded (follower);
+}
+
+/* Might be called on an i/o thread. Caches the info the backend
+   returned and adds the automatic attributes. Call once, after the
+   job succeeded. */
+GFileInfo *
+g_vfs_job_query_info_get_result (GVfsJobQueryInfo *job)
+{
+  /* Cache what the backend returned, the auto info depends on uri */
+  if (!job->from_cache)
+    g_vfs_info_cache_insert (g_vfs_backend_get_info_cache (job->backend),
+			     job->cache_generation,
+			     job->filename,
+			     job->attributes,
+			     job->flags,
+			     job->file_info);
+
+  g_vfs_backend_add_auto_info (job->backend,
+			       job->attribute_matcher,
+			       job->file_info,
+			       job->uri);
+
+  return job->file_info;
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
@@ -189,14 +279,9 @@ create_reply (GVfsJob *job,
   reply = dbus_message_new_method_return (message);
 
   dbus_message_iter_init_append (reply, &iter);
-
-  g_vfs_backend_add_auto_info (op_job->backend,
-			       op_job->attribute_matcher,
-			       op_job->file_info,
-			       op_job->uri);
   
   _g_dbus_append_file_info (&iter, 
-			    op_job->file_info);
+			    g_vfs_job_query_info_get_result (op_job));
   
   return reply;
 }
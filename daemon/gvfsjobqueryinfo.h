@@ -51,6 +51,8 @@ struct _GVfsJobQueryInfo
   char *uri;
 
   GFileInfo *file_info;
+  guint cache_generation;
+  gboolean from_cache;
 };
 
 struct _GVfsJobQueryInfoClass
@@ -63,6 +65,14 @@ GType g_vfs_job_query_info_get_type (void) G_GNUC_CONST;
 GVfsJob *g_vfs_job_query_info_new (DBusConnection        *connection,
 				   DBusMessage           *message,
 				   GVfsBackend           *backend);
+GVfsJob *g_vfs_job_query_info_new_for_path (DBusConnection      *connection,
+					    DBusMessage         *message,
+					    GVfsBackend         *backend,
+					    const char          *filename,
+					    const char          *attributes,
+					    GFileQueryInfoFlags  flags,
+					    const char          *uri);
+GFileInfo *g_vfs_job_query_info_get_result (GVfsJobQueryInfo *job);
 
 G_END_DECLS
 
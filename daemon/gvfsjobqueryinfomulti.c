@@ -0,0 +1,456 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <glib.h>
+#include <dbus/dbus.h>
+#include <glib/gi18n.h>
+#include "gvfsjobqueryinfomulti.h"
+#include "gvfsjobqueryinfo.h"
+#include "gvfsjobsource.h"
+#include "gvfsdbusutils.h"
+#include "gvfsdaemonprotocol.h"
+
+/* Paths queried at the same time when the backend has no
+   query_info_multi. Enough to keep pipelining backends busy without
+   flooding the thread pool. */
+#define MAX_PATH_JOBS 16
+
+G_DEFINE_TYPE (GVfsJobQueryInfoMulti, g_vfs_job_query_info_multi, G_VFS_TYPE_JOB_DBUS)
+
+static void         run          (GVfsJob        *job);
+static gboolean     try          (GVfsJob        *job);
+static DBusMessage *create_reply (GVfsJob        *job,
+				  DBusConnection *connection,
+				  DBusMessage    *message);
+
+static void
+g_vfs_job_query_info_multi_finalize (GObject *object)
+{
+  GVfsJobQueryInfoMulti *job;
+  guint i;
+
+  job = G_VFS_JOB_QUERY_INFO_MULTI (object);
+
+  for (i = 0; i < job->n_files; i++)
+    {
+      g_free (job->uris[i]);
+      g_object_unref (job->infos[i]);
+      if (job->errors[i])
+	g_error_free (job->errors[i]);
+    }
+  g_free (job->uris);
+  g_free (job->infos);
+  g_free (job->errors);
+  g_strfreev (job->filenames);
+
+  g_free (job->attributes);
+  g_file_attribute_matcher_unref (job->attribute_matcher);
+  g_mutex_clear (&job->lock);
+  
+  if (G_OBJECT_CLASS (g_vfs_job_query_info_multi_parent_class)->finalize)
+    (*G_OBJECT_CLASS (g_vfs_job_query_info_multi_parent_class)->finalize) (object);
+}
+
+static void
+g_vfs_job_query_info_multi_class_init (GVfsJobQueryInfoMultiClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GVfsJobClass *job_class = G_VFS_JOB_CLASS (klass);
+  GVfsJobDBusClass *job_dbus_class = G_VFS_JOB_DBUS_CLASS (klass);
+  
+  gobject_class->finalize = g_vfs_job_query_info_multi_finalize;
+  job_class->run = run;
+  job_class->try = try;
+  job_dbus_class->create_reply = create_reply;
+}
+
+static void
+g_vfs_job_query_info_multi_init (GVfsJobQueryInfoMulti *job)
+{
+  g_mutex_init (&job->lock);
+}
+
+GVfsJob *
+g_vfs_job_query_info_multi_new (DBusConnection *connection,
+				DBusMessage *message,
+				GVfsBackend *backend)
+{
+  GVfsJobQueryInfoMulti *job;
+  DBusMessage *reply;
+  DBusError derror;
+  DBusMessageIter iter, array_iter, struct_iter;
+  GPtrArray *filenames, *uris;
+  char *attributes, *path, *uri;
+  dbus_uint32_t flags;
+  guint i;
+
+  filenames = g_ptr_array_new ();
+  uris = g_ptr_array_new ();
+
+  dbus_message_iter_init (message, &iter);
+  dbus_error_init (&derror);
+
+  if (dbus_message_iter_get_arg_type (&iter) != DBUS_TYPE_ARRAY ||
+      dbus_message_iter_get_element_type (&iter) != DBUS_TYPE_STRUCT)
+    {
+      dbus_set_error (&derror, DBUS_ERROR_INVALID_ARGS,
+		      "Argument 0 is not an array of paths");
+      goto error;
+    }
+
+  dbus_message_iter_recurse (&iter, &array_iter);
+  while (dbus_message_iter_get_arg_type (&array_iter) == DBUS_TYPE_STRUCT)
+    {
+      dbus_message_iter_recurse (&array_iter, &struct_iter);
+      if (!_g_dbus_message_iter_get_args (&struct_iter, &derror,
+					  G_DBUS_TYPE_CSTRING, &path,
+					  DBUS_TYPE_STRING, &uri,
+					  0))
+	goto error;
+
+      g_ptr_array_add (filenames, path);
+      g_ptr_array_add (uris, *uri != 0 ? g_strdup (uri) : NULL);
+      dbus_message_iter_next (&array_iter);
+    }
+  dbus_message_iter_next (&iter);
+  
+  if (!_g_dbus_message_iter_get_args (&iter, &derror, 
+				      DBUS_TYPE_STRING, &attributes,
+				      DBUS_TYPE_UINT32, &flags,
+				      0))
+    goto error;
+  
+  job = g_object_new (G_VFS_TYPE_JOB_QUERY_INFO_MULTI,
+		      "message", message,
+		      "connection", connection,
+		      NULL);
+
+  job->n_files = filenames->len;
+  g_ptr_array_add (filenames, NULL);
+  job->filenames = (char **)g_ptr_array_free (filenames, FALSE);
+  job->uris = (char **)g_ptr_array_free (uris, FALSE);
+  job->backend = backend;
+  job->attributes = g_strdup (attributes);
+  job->attribute_matcher = g_file_attribute_matcher_new (attributes);
+  job->flags = flags;
+  job->cache_generation =
+    g_vfs_info_cache_get_generation (g_vfs_backend_get_info_cache (backend));
+
+  job->infos = g_new (GFileInfo *, job->n_files);
+  job->errors = g_new0 (GError *, job->n_files);
+  for (i = 0; i < job->n_files; i++)
+    {
+      job->infos[i] = g_file_info_new ();
+      g_file_info_set_attribute_mask (job->infos[i], job->attribute_matcher);
+    }
+  
+  return G_VFS_JOB (job);
+
+ error:
+  reply = dbus_message_new_error (message,
+				  derror.name,
+				  derror.message);
+  dbus_error_free (&derror);
+
+  dbus_connection_send (connection, reply, NULL);
+  dbus_message_unref (reply);
+
+  for (i = 0; i < filenames->len; i++)
+    {
+      g_free (g_ptr_array_index (filenames, i));
+      g_free (g_ptr_array_index (uris, i));
+    }
+  g_ptr_array_free (filenames, TRUE);
+  g_ptr_array_free (uris, TRUE);
+  return NULL;
+}
+
+/* Might be called on an i/o thread. Fails the path at index, the
+   others may still succeed. Use g_vfs_job_failed() to fail them all. */
+void
+g_vfs_job_query_info_multi_set_error (GVfsJobQueryInfoMulti *job,
+				      guint                  index,
+				      const GError          *error)
+{
+  g_return_if_fail (index < job->n_files);
+
+  if (job->errors[index] == NULL)
+    job->errors[index] = g_error_copy (error);
+}
+
+static void
+run (GVfsJob *job)
+{
+  GVfsJobQueryInfoMulti *op_job = G_VFS_JOB_QUERY_INFO_MULTI (job);
+  GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (op_job->backend);
+
+  if (class->query_info_multi == NULL)
+    {
+      g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			_("Operation not supported by backend"));
+      return;
+    }
+  
+  class->query_info_multi (op_job->backend,
+			   op_job,
+			   op_job->filenames,
+			   op_job->flags,
+			   op_job->infos,
+			   op_job->attribute_matcher);
+}
+
+/* Called with the lock held. Returns TRUE if that was the last path. */
+static gboolean
+path_done_unlocked (GVfsJobQueryInfoMulti *job)
+{
+  job->n_done++;
+  return job->n_done == job->n_files;
+}
+
+static void start_path_jobs (GVfsJobQueryInfoMulti *job);
+
+static gboolean
+start_path_jobs_idle (gpointer data)
+{
+  start_path_jobs (data);
+  return FALSE;
+}
+
+/* Might be called on an i/o thread. Takes the result of the QueryInfo
+   job for one path instead of letting it reply. */
+static void
+path_job_send_reply (GVfsJob *path_job,
+		     gpointer user_data)
+{
+  GVfsJobQueryInfoMulti *job = user_data;
+  gboolean all_done, start_more;
+  guint index;
+
+  index = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (path_job),
+					       "g-vfs-query-info-multi-index"));
+
+  if (path_job->failed)
+    g_vfs_job_query_info_multi_set_error (job, index, path_job->error);
+  else
+    g_file_info_copy_into (g_vfs_job_query_info_get_result (G_VFS_JOB_QUERY_INFO (path_job)),
+			   job->infos[index]);
+
+  g_signal_stop_emission_by_name (path_job, "send-reply");
+  g_vfs_job_emit_finished (path_job);
+
+  g_mutex_lock (&job->lock);
+  job->n_running--;
+  all_done = path_done_unlocked (job);
+  start_more = job->next_file < job->n_files && !job->start_scheduled;
+  if (start_more)
+    job->start_scheduled = TRUE;
+  g_mutex_unlock (&job->lock);
+
+  /* Jobs are queued on the main thread */
+  if (start_more)
+    g_idle_add_full (G_PRIORITY_DEFAULT, start_path_jobs_idle,
+		     g_object_ref (job), g_object_unref);
+
+  if (all_done)
+    g_vfs_job_succeeded (G_VFS_JOB (job));
+}
+
+/* Called on the main thread. Queues QueryInfo jobs for the next paths,
+   so they get the info cache, identical job sharing and try/run like
+   any other. */
+static void
+start_path_jobs (GVfsJobQueryInfoMulti *job)
+{
+  GVfsJob *path_job;
+  GError *error;
+  gboolean all_done;
+  guint index;
+
+  all_done = FALSE;
+
+  g_mutex_lock (&job->lock);
+  job->start_scheduled = FALSE;
+  while (job->n_running < MAX_PATH_JOBS &&
+	 job->next_file < job->n_files)
+    {
+      index = job->next_file++;
+
+      /* Jobs queued before Cancel are cancelled with us, later ones
+	 are not started */
+      if (G_VFS_JOB (job)->cancelled)
+	{
+	  error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+				       _("Operation was cancelled"));
+	  g_vfs_job_query_info_multi_set_error (job, index, error);
+	  g_error_free (error);
+	  all_done = path_done_unlocked (job);
+	  continue;
+	}
+
+      job->n_running++;
+      g_mutex_unlock (&job->lock);
+
+      path_job = g_vfs_job_query_info_new_for_path (g_vfs_job_dbus_get_connection (G_VFS_JOB_DBUS (job)),
+						    g_vfs_job_dbus_get_message (G_VFS_JOB_DBUS (job)),
+						    job->backend,
+						    job->filenames[index],
+						    job->attributes,
+						    job->flags,
+						    job->uris[index]);
+      g_object_set_data (G_OBJECT (path_job), "g-vfs-query-info-multi-index",
+			 GUINT_TO_POINTER (index));
+      g_signal_connect_data (path_job, "send-reply",
+			     (GCallback)path_job_send_reply,
+			     g_object_ref (job),
+			     (GClosureNotify)g_object_unref, 0);
+      g_vfs_job_source_new_job (G_VFS_JOB_SOURCE (job->backend), path_job);
+      g_object_unref (path_job);
+
+      g_mutex_lock (&job->lock);
+    }
+  g_mutex_unlock (&job->lock);
+
+  if (all_done)
+    g_vfs_job_succeeded (G_VFS_JOB (job));
+}
+
+static gboolean
+try (GVfsJob *job)
+{
+  GVfsJobQueryInfoMulti *op_job = G_VFS_JOB_QUERY_INFO_MULTI (job);
+  GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (op_job->backend);
+
+  if (class->try_query_info_multi != NULL &&
+      class->try_query_info_multi (op_job->backend,
+				   op_job,
+				   op_job->filenames,
+				   op_job->flags,
+				   op_job->infos,
+				   op_job->attribute_matcher))
+    return TRUE;
+
+  if (class->query_info_multi != NULL)
+    return FALSE;
+
+  /* No backend support, one QueryInfo job per path */
+  if (class->query_info == NULL && class->try_query_info == NULL)
+    {
+      g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			_("Operation not supported by backend"));
+      return TRUE;
+    }
+
+  op_job->per_path = TRUE;
+  if (op_job->n_files == 0)
+    g_vfs_job_succeeded (job);
+  else
+    start_path_jobs (op_job);
+
+  return TRUE;
+}
+
+/* Might be called on an i/o thread */
+static DBusMessage *
+create_reply (GVfsJob *job,
+	      DBusConnection *connection,
+	      DBusMessage *message)
+{
+  GVfsJobQueryInfoMulti *op_job = G_VFS_JOB_QUERY_INFO_MULTI (job);
+  DBusMessage *reply;
+  DBusMessageIter iter, array_iter, struct_iter;
+  GFileInfo *info, *empty_info;
+  GError *error;
+  dbus_bool_t ok;
+  dbus_uint32_t code;
+  const char *error_message;
+  guint i;
+
+  reply = dbus_message_new_method_return (message);
+
+  dbus_message_iter_init_append (reply, &iter);
+  if (!dbus_message_iter_open_container (&iter,
+					 DBUS_TYPE_ARRAY,
+					 G_VFS_QUERY_INFO_MULTI_RESULT_TYPE_AS_STRING,
+					 &array_iter))
+    _g_dbus_oom ();
+
+  empty_info = g_file_info_new ();
+  for (i = 0; i < op_job->n_files; i++)
+    {
+      error = op_job->errors[i];
+      info = op_job->infos[i];
+
+      ok = error == NULL;
+      code = G_IO_ERROR_FAILED;
+      error_message = "";
+      if (error != NULL)
+	{
+	  if (error->domain == G_IO_ERROR)
+	    code = error->code;
+	  error_message = error->message;
+	  info = empty_info;
+	}
+      else if (!op_job->per_path)
+	{
+	  /* The QueryInfo jobs did this already */
+	  g_vfs_info_cache_insert (g_vfs_backend_get_info_cache (op_job->backend),
+				   op_job->cache_generation,
+				   op_job->filenames[i],
+				   op_job->attributes,
+				   op_job->flags,
+				   info);
+	  g_vfs_backend_add_auto_info (op_job->backend,
+				       op_job->attribute_matcher,
+				       info,
+				       op_job->uris[i]);
+	}
+
+      if (!dbus_message_iter_open_container (&array_iter,
+					     DBUS_TYPE_STRUCT,
+					     NULL,
+					     &struct_iter))
+	_g_dbus_oom ();
+
+      if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_BOOLEAN, &ok) ||
+	  !dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_UINT32, &code) ||
+	  !dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_STRING, &error_message))
+	_g_dbus_oom ();
+
+      _g_dbus_append_file_info (&struct_iter, info);
+
+      if (!dbus_message_iter_close_container (&array_iter, &struct_iter))
+	_g_dbus_oom ();
+    }
+  g_object_unref (empty_info);
+
+  if (!dbus_message_iter_close_container (&iter, &array_iter))
+    _g_dbus_oom ();
+  
+  return reply;
+}
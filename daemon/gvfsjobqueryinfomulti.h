@@ -0,0 +1,83 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_JOB_QUERY_INFO_MULTI_H__
+#define __G_VFS_JOB_QUERY_INFO_MULTI_H__
+
+#include <gio/gio.h>
+#include <gvfsjob.h>
+#include <gvfsjobdbus.h>
+#include <gvfsbackend.h>
+
+G_BEGIN_DECLS
+
+#define G_VFS_TYPE_JOB_QUERY_INFO_MULTI         (g_vfs_job_query_info_multi_get_type ())
+#define G_VFS_JOB_QUERY_INFO_MULTI(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), G_VFS_TYPE_JOB_QUERY_INFO_MULTI, GVfsJobQueryInfoMulti))
+#define G_VFS_JOB_QUERY_INFO_MULTI_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), G_VFS_TYPE_JOB_QUERY_INFO_MULTI, GVfsJobQueryInfoMultiClass))
+#define G_VFS_IS_JOB_QUERY_INFO_MULTI(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), G_VFS_TYPE_JOB_QUERY_INFO_MULTI))
+#define G_VFS_IS_JOB_QUERY_INFO_MULTI_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), G_VFS_TYPE_JOB_QUERY_INFO_MULTI))
+#define G_VFS_JOB_QUERY_INFO_MULTI_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), G_VFS_TYPE_JOB_QUERY_INFO_MULTI, GVfsJobQueryInfoMultiClass))
+
+typedef struct _GVfsJobQueryInfoMultiClass   GVfsJobQueryInfoMultiClass;
+
+struct _GVfsJobQueryInfoMulti
+{
+  GVfsJobDBus parent_instance;
+
+  GVfsBackend *backend;
+  char **filenames;
+  char **uris;     /* NULL entries if the client sent none */
+  guint n_files;
+  char *attributes;
+  GFileAttributeMatcher *attribute_matcher;
+  GFileQueryInfoFlags flags;
+
+  GFileInfo **infos;
+  GError **errors;
+  guint cache_generation;
+
+  /* Without backend support each path is a QueryInfo job */
+  gboolean per_path;
+  GMutex lock;
+  guint next_file;
+  guint n_running;
+  guint n_done;
+  gboolean start_scheduled;
+};
+
+struct _GVfsJobQueryInfoMultiClass
+{
+  GVfsJobDBusClass parent_class;
+};
+
+GType g_vfs_job_query_info_multi_get_type (void) G_GNUC_CONST;
+
+GVfsJob *g_vfs_job_query_info_multi_new       (DBusConnection        *connection,
+					       DBusMessage           *message,
+					       GVfsBackend           *backend);
+void     g_vfs_job_query_info_multi_set_error (GVfsJobQueryInfoMulti *job,
+					       guint                  index,
+					       const GError          *error);
+
+G_END_DECLS
+
+#endif /* __G_VFS_JOB_QUERY_INFO_MULTI_H__ */
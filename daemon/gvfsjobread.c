@@ -32,6 +32,7 @@
 #include "gvfsreadchannel.h"
 #include "gvfsjobread.h"
 #include "gvfsdaemonutils.h"
+#include "gvfsbufferpool.h"
 
 G_DEFINE_TYPE (GVfsJobRead, g_vfs_job_read, G_VFS_TYPE_JOB)
 
@@ -47,7 +48,7 @@ g_vfs_job_read_finalize (GObject *object)
   job = G_VFS_JOB_READ (object);
 
   g_object_unref (job->channel);
-  g_free (job->buffer);
+  g_vfs_buffer_pool_free (job->buffer, job->bytes_requested);
   
   if (G_OBJECT_CLASS (g_vfs_job_read_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_vfs_job_read_parent_class)->finalize) (object);
@@ -85,12 +86,29 @@ g_vfs_job_read_new (GVfsReadChannel *channel,
   job->backend = backend;
   job->channel = g_object_ref (channel);
   job->handle = handle;
-  job->buffer = g_malloc (bytes_requested);
+  job->buffer = g_vfs_buffer_pool_alloc (bytes_requested);
   job->bytes_requested = bytes_requested;
   
   return G_VFS_JOB (job);
 }
 
+GVfsJob *
+g_vfs_job_read_new_at (GVfsReadChannel *channel,
+		       GVfsBackendHandle handle,
+		       goffset offset,
+		       gsize bytes_requested,
+		       GVfsBackend *backend)
+{
+  GVfsJobRead *job;
+
+  job = G_VFS_JOB_READ (g_vfs_job_read_new (channel, handle,
+					    bytes_requested, backend));
+  job->positional = TRUE;
+  job->offset = offset;
+
+  return G_VFS_JOB (job);
+}
+
 /* Might be called on an i/o thread */
 static void
 send_reply (GVfsJob *job)
@@ -98,11 +116,15 @@ send_reply (GVfsJob *job)
   GVfsJobRead *op_job = G_VFS_JOB_READ (job);
   g_debug ("job_read send reply, %"G_GSIZE_FORMAT" bytes\n", op_job->data_count);
 
+  op_job->reply_time = g_get_monotonic_time ();
+
   if (job->failed)
-    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job->error);
+    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job, job->error);
   else
     {
+      g_vfs_job_add_bytes (job, op_job->data_count);
       g_vfs_read_channel_send_data (op_job->channel,
+				    job,
 				    op_job->buffer,
 				    op_job->data_count);
     }
@@ -114,6 +136,26 @@ run (GVfsJob *job)
   GVfsJobRead *op_job = G_VFS_JOB_READ (job);
   GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (op_job->backend);
 
+  op_job->start_time = g_get_monotonic_time ();
+
+  if (op_job->positional)
+    {
+      if (class->read_at == NULL)
+	{
+	  g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			    _("Operation not supported by backend"));
+	  return;
+	}
+
+      class->read_at (op_job->backend,
+		      op_job,
+		      op_job->handle,
+		      op_job->offset,
+		      op_job->buffer,
+		      op_job->bytes_requested);
+      return;
+    }
+
   if (class->read == NULL)
     {
       g_vfs_job_failed (job, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
@@ -134,6 +176,21 @@ try (GVfsJob *job)
   GVfsJobRead *op_job = G_VFS_JOB_READ (job);
   GVfsBackendClass *class = G_VFS_BACKEND_GET_CLASS (op_job->backend);
 
+  op_job->start_time = g_get_monotonic_time ();
+
+  if (op_job->positional)
+    {
+      if (class->try_read_at == NULL)
+	return FALSE;
+
+      return class->try_read_at (op_job->backend,
+				 op_job,
+				 op_job->handle,
+				 op_job->offset,
+				 op_job->buffer,
+				 op_job->bytes_requested);
+    }
+
   if (class->try_read == NULL)
     return FALSE;
 
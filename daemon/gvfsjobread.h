@@ -48,6 +48,15 @@ struct _GVfsJobRead
   gsize bytes_requested;
   char *buffer;
   gsize data_count;
+
+  /* Read at offset rather than the current position */
+  gboolean positional;
+  goffset offset;
+
+  /* Monotonic times the backend started and replied, for the
+     latency estimate of the channel */
+  gint64 start_time;
+  gint64 reply_time;
 };
 
 struct _GVfsJobReadClass
@@ -61,6 +70,11 @@ GVfsJob *g_vfs_job_read_new        (GVfsReadChannel   *channel,
 				    GVfsBackendHandle  handle,
 				    gsize              bytes_requested,
 				    GVfsBackend       *backend);
+GVfsJob *g_vfs_job_read_new_at     (GVfsReadChannel   *channel,
+				    GVfsBackendHandle  handle,
+				    goffset            offset,
+				    gsize              bytes_requested,
+				    GVfsBackend       *backend);
 void     g_vfs_job_read_set_size   (GVfsJobRead       *job,
 				    gsize              data_size);
 
@@ -99,10 +99,11 @@ send_reply (GVfsJob *job)
   g_debug ("job_seek_write send reply, pos %d\n", (int)op_job->final_offset);
 
   if (job->failed)
-    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job->error);
+    g_vfs_channel_send_error (G_VFS_CHANNEL (op_job->channel), job, job->error);
   else
     {
       g_vfs_write_channel_send_seek_offset (op_job->channel,
+					   job,
 					   op_job->final_offset);
     }
 }
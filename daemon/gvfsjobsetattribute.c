@@ -42,6 +42,7 @@ static gboolean     try          (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static void         invalidate_info (GVfsJob *job);
 
 static void
 g_vfs_job_set_attribute_finalize (GObject *object)
@@ -70,6 +71,7 @@ g_vfs_job_set_attribute_class_init (GVfsJobSetAttributeClass *klass)
   job_class->run = run;
   job_class->try = try;
   job_dbus_class->create_reply = create_reply;
+  job_dbus_class->invalidate_info = invalidate_info;
 }
 
 static void
@@ -135,6 +137,7 @@ g_vfs_job_set_attribute_new (DBusConnection *connection,
   job->value = value;
   job->type = type;
   job->flags = flags;
+  g_vfs_backend_invalidate_info (backend, job->filename);
 
   return G_VFS_JOB (job);
 }
@@ -179,12 +182,22 @@ try (GVfsJob *job)
 				   op_job->flags);
 }
 
+/* Might be called on an i/o thread */
+static void
+invalidate_info (GVfsJob *job)
+{
+  GVfsJobSetAttribute *op_job = G_VFS_JOB_SET_ATTRIBUTE (job);
+
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->filename);
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
 	      DBusConnection *connection,
 	      DBusMessage *message)
 {
+  GVfsJobSetAttribute *op_job = G_VFS_JOB_SET_ATTRIBUTE (job);
   DBusMessage *reply;
 
   reply = dbus_message_new_method_return (message);
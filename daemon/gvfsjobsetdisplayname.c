@@ -41,6 +41,7 @@ static gboolean     try          (GVfsJob        *job);
 static DBusMessage *create_reply (GVfsJob        *job,
 				  DBusConnection *connection,
 				  DBusMessage    *message);
+static void         invalidate_info (GVfsJob *job);
 
 static void
 g_vfs_job_set_display_name_finalize (GObject *object)
@@ -68,6 +69,7 @@ g_vfs_job_set_display_name_class_init (GVfsJobSetDisplayNameClass *klass)
   job_class->run = run;
   job_class->try = try;
   job_dbus_class->create_reply = create_reply;
+  job_dbus_class->invalidate_info = invalidate_info;
 }
 
 static void
@@ -112,6 +114,7 @@ g_vfs_job_set_display_name_new (DBusConnection *connection,
   job->filename = g_strndup (path_data, path_len);
   job->backend = backend;
   job->display_name = g_strdup (display_name);
+  g_vfs_backend_invalidate_info (backend, job->filename);
   
   return G_VFS_JOB (job);
 }
@@ -157,6 +160,17 @@ g_vfs_job_set_display_name_set_new_path (GVfsJobSetDisplayName *job,
   job->new_path = g_strdup (new_path);
 }
 
+/* Might be called on an i/o thread */
+static void
+invalidate_info (GVfsJob *job)
+{
+  GVfsJobSetDisplayName *op_job = G_VFS_JOB_SET_DISPLAY_NAME (job);
+
+  g_vfs_backend_invalidate_info (op_job->backend, op_job->filename);
+  if (op_job->new_path != NULL)
+    g_vfs_backend_invalidate_info (op_job->backend, op_job->new_path);
+}
+
 /* Might be called on an i/o thread */
 static DBusMessage *
 create_reply (GVfsJob *job,
@@ -172,7 +186,7 @@ create_reply (GVfsJob *job,
   dbus_message_iter_init_append (reply, &iter);
 
   g_assert (op_job->new_path != NULL);
-  
+
   _g_dbus_message_iter_append_cstring (&iter, op_job->new_path);
   
   return reply;
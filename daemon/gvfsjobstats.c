@@ -0,0 +1,309 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+#include <dbus/dbus.h>
+
+#include "gvfsjobstats.h"
+#include "gvfsbufferpool.h"
+#include "gvfsdaemonprotocol.h"
+#include "gvfsdbusutils.h"
+
+/* Per backend and operation totals and latency histograms of all
+ * finished jobs, so one can see where the time of a slow mount goes.
+ * See G_VFS_DBUS_STATS_INTERFACE for how they are reported. */
+
+enum {
+  PHASE_QUEUED,
+  PHASE_RUNNING,
+  PHASE_REPLYING,
+  N_PHASES
+};
+
+typedef struct {
+  char *backend;
+  char *display_name;
+  char *operation;
+
+  guint64 count;
+  guint64 failed;
+  guint64 bytes;
+  guint64 total_usecs[N_PHASES];
+  guint32 histogram[N_PHASES][G_VFS_STATS_N_BUCKETS];
+} OpStats;
+
+static GMutex stats_lock;
+static GHashTable *op_stats; /* "backend operation" -> OpStats */
+
+static void
+op_stats_free (OpStats *stats)
+{
+  g_free (stats->backend);
+  g_free (stats->display_name);
+  g_free (stats->operation);
+  g_free (stats);
+}
+
+static int
+histogram_bucket (gint64 usecs)
+{
+  gint64 limit;
+  int bucket;
+
+  limit = G_VFS_STATS_FIRST_BUCKET_USECS;
+  for (bucket = 0; bucket < G_VFS_STATS_N_BUCKETS - 1; bucket++)
+    {
+      if (usecs < limit)
+	break;
+      limit *= 2;
+    }
+
+  return bucket;
+}
+
+/* "GVfsJobQueryInfo" -> "QueryInfo" */
+static const char *
+job_operation (GVfsJob *job)
+{
+  const char *name;
+
+  name = g_type_name_from_instance ((GTypeInstance *)job);
+  if (g_str_has_prefix (name, "GVfsJob"))
+    name += strlen ("GVfsJob");
+
+  return name;
+}
+
+/* Might be called on an i/o thread */
+void
+g_vfs_job_stats_record (GVfsBackend *backend,
+			GVfsJob *job)
+{
+  OpStats *stats;
+  char *object_path, *key;
+  const char *operation;
+  gint64 usecs[N_PHASES];
+  guint64 bytes;
+  int i;
+
+  g_vfs_job_get_times (job,
+		       &usecs[PHASE_QUEUED],
+		       &usecs[PHASE_RUNNING],
+		       &usecs[PHASE_REPLYING],
+		       &bytes);
+
+  operation = job_operation (job);
+  g_object_get (backend, "object-path", &object_path, NULL);
+  key = g_strconcat (object_path ? object_path : "", " ", operation, NULL);
+
+  g_mutex_lock (&stats_lock);
+
+  if (op_stats == NULL)
+    op_stats = g_hash_table_new_full (g_str_hash, g_str_equal,
+				      g_free, (GDestroyNotify)op_stats_free);
+
+  stats = g_hash_table_lookup (op_stats, key);
+  if (stats == NULL)
+    {
+      stats = g_new0 (OpStats, 1);
+      stats->backend = g_strdup (object_path ? object_path : "");
+      stats->display_name = g_strdup (g_vfs_backend_get_display_name (backend));
+      stats->operation = g_strdup (operation);
+      g_hash_table_insert (op_stats, key, stats);
+      key = NULL;
+    }
+
+  stats->count++;
+  if (job->failed)
+    stats->failed++;
+  stats->bytes += bytes;
+  for (i = 0; i < N_PHASES; i++)
+    {
+      stats->total_usecs[i] += usecs[i];
+      stats->histogram[i][histogram_bucket (usecs[i])]++;
+    }
+
+  g_mutex_unlock (&stats_lock);
+
+  g_free (key);
+  g_free (object_path);
+}
+
+static gint
+op_stats_compare (gconstpointer a,
+		  gconstpointer b)
+{
+  const OpStats *stats_a = a;
+  const OpStats *stats_b = b;
+  int res;
+
+  res = strcmp (stats_a->backend, stats_b->backend);
+  if (res == 0)
+    res = strcmp (stats_a->operation, stats_b->operation);
+
+  return res;
+}
+
+static void
+append_histogram (DBusMessageIter *iter,
+		  guint32 *histogram)
+{
+  DBusMessageIter array_iter;
+
+  if (!dbus_message_iter_open_container (iter,
+					 DBUS_TYPE_ARRAY,
+					 DBUS_TYPE_UINT32_AS_STRING,
+					 &array_iter))
+    _g_dbus_oom ();
+
+  if (!dbus_message_iter_append_fixed_array (&array_iter,
+					     DBUS_TYPE_UINT32,
+					     &histogram, G_VFS_STATS_N_BUCKETS))
+    _g_dbus_oom ();
+
+  if (!dbus_message_iter_close_container (iter, &array_iter))
+    _g_dbus_oom ();
+}
+
+static void
+append_op_stats (DBusMessageIter *iter,
+		 OpStats *stats)
+{
+  DBusMessageIter struct_iter;
+  dbus_uint64_t value;
+  int i;
+
+  if (!dbus_message_iter_open_container (iter,
+					 DBUS_TYPE_STRUCT,
+					 NULL,
+					 &struct_iter))
+    _g_dbus_oom ();
+
+  if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_STRING, &stats->backend) ||
+      !dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_STRING, &stats->display_name) ||
+      !dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_STRING, &stats->operation))
+    _g_dbus_oom ();
+
+  value = stats->count;
+  if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_UINT64, &value))
+    _g_dbus_oom ();
+  value = stats->failed;
+  if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_UINT64, &value))
+    _g_dbus_oom ();
+  value = stats->bytes;
+  if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_UINT64, &value))
+    _g_dbus_oom ();
+
+  for (i = 0; i < N_PHASES; i++)
+    {
+      value = stats->total_usecs[i];
+      if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_UINT64, &value))
+	_g_dbus_oom ();
+    }
+
+  for (i = 0; i < N_PHASES; i++)
+    append_histogram (&struct_iter, stats->histogram[i]);
+
+  if (!dbus_message_iter_close_container (iter, &struct_iter))
+    _g_dbus_oom ();
+}
+
+static void
+append_buffer_pool_stats (DBusMessageIter *iter)
+{
+  DBusMessageIter struct_iter;
+  GVfsBufferPoolStats pool_stats;
+  dbus_uint64_t values[4];
+  guint i;
+
+  g_vfs_buffer_pool_get_stats (&pool_stats);
+  values[0] = pool_stats.hits;
+  values[1] = pool_stats.misses;
+  values[2] = pool_stats.bytes_idle;
+  values[3] = pool_stats.bytes_used;
+
+  if (!dbus_message_iter_open_container (iter,
+					 DBUS_TYPE_STRUCT,
+					 NULL,
+					 &struct_iter))
+    _g_dbus_oom ();
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++)
+    if (!dbus_message_iter_append_basic (&struct_iter, DBUS_TYPE_UINT64, &values[i]))
+      _g_dbus_oom ();
+
+  if (!dbus_message_iter_close_container (iter, &struct_iter))
+    _g_dbus_oom ();
+}
+
+/**
+ * g_vfs_job_stats_append:
+ * @iter: iterator of the message to append to
+ *
+ * Appends the statistics of all backends in the process as an array
+ * of G_VFS_STATS_ENTRY_TYPE_AS_STRING, followed by those of the read
+ * buffer pool as a G_VFS_STATS_BUFFER_POOL_TYPE_AS_STRING.
+ **/
+void
+g_vfs_job_stats_append (DBusMessageIter *iter)
+{
+  DBusMessageIter array_iter;
+  GList *entries, *l;
+
+  if (!dbus_message_iter_open_container (iter,
+					 DBUS_TYPE_ARRAY,
+					 G_VFS_STATS_ENTRY_TYPE_AS_STRING,
+					 &array_iter))
+    _g_dbus_oom ();
+
+  g_mutex_lock (&stats_lock);
+
+  entries = NULL;
+  if (op_stats)
+    entries = g_list_sort (g_hash_table_get_values (op_stats),
+			   op_stats_compare);
+
+  for (l = entries; l != NULL; l = l->next)
+    append_op_stats (&array_iter, l->data);
+
+  g_mutex_unlock (&stats_lock);
+
+  g_list_free (entries);
+
+  if (!dbus_message_iter_close_container (iter, &array_iter))
+    _g_dbus_oom ();
+
+  append_buffer_pool_stats (iter);
+}
+
+void
+g_vfs_job_stats_reset (void)
+{
+  g_mutex_lock (&stats_lock);
+  if (op_stats)
+    g_hash_table_remove_all (op_stats);
+  g_mutex_unlock (&stats_lock);
+}
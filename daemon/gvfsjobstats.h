@@ -0,0 +1,39 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_JOB_STATS_H__
+#define __G_VFS_JOB_STATS_H__
+
+#include <dbus/dbus.h>
+#include <gvfsjob.h>
+#include <gvfsbackend.h>
+
+G_BEGIN_DECLS
+
+void g_vfs_job_stats_record (GVfsBackend     *backend,
+			     GVfsJob         *job);
+void g_vfs_job_stats_append (DBusMessageIter *iter);
+void g_vfs_job_stats_reset  (void);
+
+G_END_DECLS
+
+#endif /* __G_VFS_JOB_STATS_H__ */
@@ -0,0 +1,201 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <dbus/dbus.h>
+
+#include "gvfsprogressreporter.h"
+#include "gvfsdaemonprotocol.h"
+
+/* Backends call the progress callback for every block they move,
+ * which on a fast copy is far more often than anyone can look at.
+ * The reporter sends the newest numbers at most once per interval and
+ * keeps the rest until the next message is due or the job replies,
+ * so the client always ends up with the final numbers. Without a
+ * callback object path nothing is sent at all. */
+struct _GVfsProgressReporter
+{
+  GVfsJobDBus *job;
+  char *callback_obj_path;
+  gint64 interval;
+
+  GMutex lock;
+  gint64 last_sent;
+  gboolean pending;
+  goffset current;
+  goffset total;
+  gboolean has_files;
+  guint64 n_files_done;
+  guint64 n_files_total;
+};
+
+static gint64
+get_interval (void)
+{
+  static gsize interval = 0;
+  const char *env;
+  gsize msecs;
+
+  if (g_once_init_enter (&interval))
+    {
+      msecs = G_VFS_PROGRESS_DEFAULT_INTERVAL_MSECS;
+      env = g_getenv ("GVFS_PROGRESS_INTERVAL");
+      if (env != NULL)
+	msecs = g_ascii_strtoull (env, NULL, 10);
+      /* +1 so that 0 is a valid value too */
+      g_once_init_leave (&interval, msecs + 1);
+    }
+
+  return (gint64)(interval - 1) * 1000;
+}
+
+/* The job must outlive the reporter, callback_obj_path may be NULL */
+GVfsProgressReporter *
+g_vfs_progress_reporter_new (GVfsJobDBus *job,
+			     const char  *callback_obj_path)
+{
+  GVfsProgressReporter *reporter;
+
+  reporter = g_new0 (GVfsProgressReporter, 1);
+  reporter->job = job;
+  reporter->callback_obj_path = g_strdup (callback_obj_path);
+  reporter->interval = get_interval ();
+  g_mutex_init (&reporter->lock);
+
+  return reporter;
+}
+
+void
+g_vfs_progress_reporter_free (GVfsProgressReporter *reporter)
+{
+  g_mutex_clear (&reporter->lock);
+  g_free (reporter->callback_obj_path);
+  g_free (reporter);
+}
+
+/* Whether anybody listens, so callers can skip work that only
+   feeds the progress */
+gboolean
+g_vfs_progress_reporter_is_active (GVfsProgressReporter *reporter)
+{
+  return reporter->callback_obj_path != NULL;
+}
+
+/* Called with the lock held */
+static void
+send_progress (GVfsProgressReporter *reporter)
+{
+  dbus_uint64_t current_dbus, total_dbus, n_files_done_dbus, n_files_total_dbus;
+  DBusMessage *message;
+
+  message =
+    dbus_message_new_method_call (dbus_message_get_sender (reporter->job->message),
+				  reporter->callback_obj_path,
+				  G_VFS_DBUS_PROGRESS_INTERFACE,
+				  G_VFS_DBUS_PROGRESS_OP_PROGRESS);
+  dbus_message_set_no_reply (message, TRUE);
+
+  current_dbus = reporter->current;
+  total_dbus = reporter->total;
+  dbus_message_append_args (message,
+			    DBUS_TYPE_UINT64, &current_dbus,
+			    DBUS_TYPE_UINT64, &total_dbus,
+			    0);
+  if (reporter->has_files)
+    {
+      n_files_done_dbus = reporter->n_files_done;
+      n_files_total_dbus = reporter->n_files_total;
+      dbus_message_append_args (message,
+				DBUS_TYPE_UINT64, &n_files_done_dbus,
+				DBUS_TYPE_UINT64, &n_files_total_dbus,
+				0);
+    }
+
+  /* Queues message (threadsafely), actually sends it in mainloop */
+  dbus_connection_send (reporter->job->connection, message, NULL);
+  dbus_message_unref (message);
+
+  reporter->pending = FALSE;
+  reporter->last_sent = g_get_monotonic_time ();
+}
+
+/* Only sends when the last message is long enough ago, or the
+   transfer just completed.
+   Might be called on an i/o thread */
+void
+g_vfs_progress_reporter_update (GVfsProgressReporter *reporter,
+				goffset               current_num_bytes,
+				goffset               total_num_bytes)
+{
+  if (reporter->callback_obj_path == NULL)
+    return;
+
+  g_mutex_lock (&reporter->lock);
+
+  reporter->current = current_num_bytes;
+  reporter->total = total_num_bytes;
+  reporter->pending = TRUE;
+
+  if (reporter->last_sent == 0 ||
+      current_num_bytes == total_num_bytes ||
+      g_get_monotonic_time () - reporter->last_sent >= reporter->interval)
+    send_progress (reporter);
+
+  g_mutex_unlock (&reporter->lock);
+}
+
+/* For operations on several files. Once set, Progress carries the
+   number of files done and the total after the byte counts. The
+   counts go out with the next byte update.
+   Might be called on an i/o thread */
+void
+g_vfs_progress_reporter_set_files (GVfsProgressReporter *reporter,
+				   guint64               n_files_done,
+				   guint64               n_files_total)
+{
+  if (reporter->callback_obj_path == NULL)
+    return;
+
+  g_mutex_lock (&reporter->lock);
+  reporter->has_files = TRUE;
+  reporter->n_files_done = n_files_done;
+  reporter->n_files_total = n_files_total;
+  reporter->pending = TRUE;
+  g_mutex_unlock (&reporter->lock);
+}
+
+/* Sends what is held back. Call before the job replies, so the final
+   numbers arrive before the reply.
+   Might be called on an i/o thread */
+void
+g_vfs_progress_reporter_flush (GVfsProgressReporter *reporter)
+{
+  if (reporter->callback_obj_path == NULL)
+    return;
+
+  g_mutex_lock (&reporter->lock);
+  if (reporter->pending)
+    send_progress (reporter);
+  g_mutex_unlock (&reporter->lock);
+}
@@ -0,0 +1,51 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_PROGRESS_REPORTER_H__
+#define __G_VFS_PROGRESS_REPORTER_H__
+
+#include <glib.h>
+#include <gvfsjobdbus.h>
+
+G_BEGIN_DECLS
+
+/* Progress messages sent at most this often, unless overridden by the
+   GVFS_PROGRESS_INTERVAL environment variable (in msecs) */
+#define G_VFS_PROGRESS_DEFAULT_INTERVAL_MSECS 100
+
+typedef struct _GVfsProgressReporter GVfsProgressReporter;
+
+GVfsProgressReporter *g_vfs_progress_reporter_new       (GVfsJobDBus          *job,
+							 const char           *callback_obj_path);
+void                  g_vfs_progress_reporter_free      (GVfsProgressReporter *reporter);
+gboolean              g_vfs_progress_reporter_is_active (GVfsProgressReporter *reporter);
+void                  g_vfs_progress_reporter_update    (GVfsProgressReporter *reporter,
+							 goffset               current_num_bytes,
+							 goffset               total_num_bytes);
+void                  g_vfs_progress_reporter_set_files (GVfsProgressReporter *reporter,
+							 guint64               n_files_done,
+							 guint64               n_files_total);
+void                  g_vfs_progress_reporter_flush     (GVfsProgressReporter *reporter);
+
+G_END_DECLS
+
+#endif /* __G_VFS_PROGRESS_REPORTER_H__ */
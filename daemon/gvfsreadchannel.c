@@ -41,12 +41,41 @@
 #include <gvfsjobcloseread.h>
 #include <gvfsfileinfo.h>
 
+/* Read sizes for sequential reads start small and double up to
+   MAX_READ_SIZE. Readahead keeps up to the bandwidth-delay product of
+   the backend in flight, between MIN_WINDOW and MAX_WINDOW. */
+#define INITIAL_READ_SIZE (16*1024)
+#define MAX_READ_SIZE (512*1024)
+#define MIN_WINDOW (64*1024)
+#define MAX_WINDOW (8*1024*1024)
+
+/* Throughput and latency estimates, shared by all read channels of a
+   backend so new streams start with a good window. Only used on the
+   main thread. */
+typedef struct {
+  gdouble throughput; /* bytes per second */
+  gdouble latency; /* usecs until the first byte */
+
+  /* Decaying sums for fitting the run time of a read as
+     latency + size / bandwidth, see update_latency() */
+  gdouble n, sum_x, sum_y, sum_xx, sum_xy;
+} ReadRate;
+
+typedef struct {
+  GVfsReadChannel *channel;
+  gint64 start_time;
+} ReadJobInfo;
+
 struct _GVfsReadChannel
 {
   GVfsChannel parent_instance;
 
   guint read_count;
   int seek_generation;
+
+  gsize read_size;
+  gsize bytes_in_flight;
+  gint64 last_finish_time;
 };
 
 G_DEFINE_TYPE (GVfsReadChannel, g_vfs_read_channel, G_VFS_TYPE_CHANNEL)
@@ -95,32 +124,180 @@ read_channel_close (GVfsChannel *channel)
 				   g_vfs_channel_get_backend (channel));
 } 
 
+static ReadRate *
+get_read_rate (GVfsReadChannel *channel)
+{
+  static GQuark rate_quark = 0;
+  GVfsBackend *backend;
+  ReadRate *rate;
+
+  if (rate_quark == 0)
+    rate_quark = g_quark_from_static_string ("g-vfs-read-channel-rate");
+
+  backend = g_vfs_channel_get_backend (G_VFS_CHANNEL (channel));
+  rate = g_object_get_qdata (G_OBJECT (backend), rate_quark);
+  if (rate == NULL)
+    {
+      rate = g_new0 (ReadRate, 1);
+      g_object_set_qdata_full (G_OBJECT (backend), rate_quark, rate, g_free);
+    }
+
+  return rate;
+}
+
+/* How many bytes we want in flight to keep the link busy */
+static gsize
+readahead_window (GVfsReadChannel *channel)
+{
+  ReadRate *rate;
+  gdouble bdp;
+
+  rate = get_read_rate (channel);
+  bdp = rate->throughput * rate->latency / G_USEC_PER_SEC;
+
+  return CLAMP (bdp, MIN_WINDOW, MAX_WINDOW);
+}
+
+/* Backends that run one job at a time never overlap reads, so the
+   latency can't be taken from the gaps between them. Instead the
+   time a read ran in the backend is fitted against its size, the
+   run time of an empty read is the time to the first byte. The read
+   sizes vary enough for that while they double up. */
+static void
+update_latency (ReadRate *rate,
+		gsize size,
+		gint64 run_usecs)
+{
+  gdouble x = size, y = run_usecs;
+  gdouble var, slope;
+
+  rate->n = 7 * rate->n / 8 + 1;
+  rate->sum_x = 7 * rate->sum_x / 8 + x;
+  rate->sum_y = 7 * rate->sum_y / 8 + y;
+  rate->sum_xx = 7 * rate->sum_xx / 8 + x * x;
+  rate->sum_xy = 7 * rate->sum_xy / 8 + x * y;
+
+  /* All reads the same size, keep the old estimate */
+  var = rate->n * rate->sum_xx - rate->sum_x * rate->sum_x;
+  if (var <= rate->sum_x * rate->sum_x / 100)
+    return;
+
+  slope = (rate->n * rate->sum_xy - rate->sum_x * rate->sum_y) / var;
+  if (slope <= 0)
+    return;
+
+  rate->latency = MAX ((rate->sum_y - slope * rate->sum_x) / rate->n, 0);
+}
+
+static void
+read_job_finished (GVfsJob *job,
+		   ReadJobInfo *info)
+{
+  GVfsReadChannel *channel = info->channel;
+  GVfsJobRead *read_job = G_VFS_JOB_READ (job);
+  ReadRate *rate;
+  gint64 now, busy;
+  gdouble sample;
+
+  channel->bytes_in_flight -= read_job->bytes_requested;
+
+  now = g_get_monotonic_time ();
+  /* With several reads in flight they overlap, only count the time
+     since the previous one finished */
+  busy = now - MAX (info->start_time, channel->last_finish_time);
+  channel->last_finish_time = now;
+
+  if (job->failed || read_job->data_count == 0 || busy <= 0)
+    return;
+
+  rate = get_read_rate (channel);
+
+  sample = (gdouble)read_job->data_count * G_USEC_PER_SEC / busy;
+  if (rate->throughput == 0)
+    rate->throughput = sample;
+  else
+    rate->throughput = (7 * rate->throughput + sample) / 8;
+
+  if (read_job->reply_time > read_job->start_time)
+    update_latency (rate, read_job->data_count,
+		    read_job->reply_time - read_job->start_time);
+}
+
+/* While reads are sequential the size doubles, up to what the link
+   can use */
+static gsize
+next_read_size (GVfsReadChannel *channel)
+{
+  gsize limit;
+
+  limit = MIN (readahead_window (channel), MAX_READ_SIZE);
+
+  if (channel->read_size == 0)
+    return INITIAL_READ_SIZE;
+  else if (channel->read_size < limit)
+    return MIN (channel->read_size * 2, limit);
+  return channel->read_size;
+}
+
 /* Always request large chunks. Its very inefficient
    to do network requests for smaller chunks. */
 static guint32
 modify_read_size (GVfsReadChannel *channel,
 		  guint32 requested_size)
 {
-  guint32 real_size;
-  
-  if (channel->read_count <= 1)
-    real_size = 16*1024;
-  else if (channel->read_count <= 2)
-    real_size = 32*1024;
-  else
-    real_size = 64*1024;
+  gsize real_size;
+
+  channel->read_size = next_read_size (channel);
+  real_size = channel->read_size;
   
   if (requested_size > real_size)
     real_size = requested_size;
 
   /* Don't do ridicoulously large requests as this
      is just stupid on the network */
-  if (real_size > 512 * 1024)
-    real_size = 512 * 1024;
+  if (real_size > MAX_READ_SIZE)
+    real_size = MAX_READ_SIZE;
 
   return real_size;
 }
 
+/* offset is -1 to read at the current position */
+static GVfsJob *
+new_read_job (GVfsReadChannel *read_channel,
+	      goffset offset,
+	      guint32 requested_size)
+{
+  GVfsChannel *channel = G_VFS_CHANNEL (read_channel);
+  ReadJobInfo *info;
+  GVfsJob *job;
+  gsize size;
+
+  read_channel->read_count++;
+  size = modify_read_size (read_channel, requested_size);
+  if (offset == -1)
+    job = g_vfs_job_read_new (read_channel,
+			      g_vfs_channel_get_backend_handle (channel),
+			      size,
+			      g_vfs_channel_get_backend (channel));
+  else
+    job = g_vfs_job_read_new_at (read_channel,
+				 g_vfs_channel_get_backend_handle (channel),
+				 offset,
+				 size,
+				 g_vfs_channel_get_backend (channel));
+
+  read_channel->bytes_in_flight += size;
+
+  info = g_new (ReadJobInfo, 1);
+  info->channel = read_channel;
+  info->start_time = g_get_monotonic_time ();
+  g_signal_connect_data (job, "finished",
+			 G_CALLBACK (read_job_finished), info,
+			 (GClosureNotify)g_free, 0);
+
+  return job;
+}
+
 static GVfsJob *
 read_channel_handle_request (GVfsChannel *channel,
 			     guint32 command,
@@ -136,6 +313,7 @@ read_channel_handle_request (GVfsChannel *channel,
   GVfsBackendHandle backend_handle;
   GVfsBackend *backend;
   GVfsReadChannel *read_channel;
+  GVfsBackendClass *backend_class;
   char *attrs;
 
   read_channel = G_VFS_READ_CHANNEL (channel);
@@ -146,11 +324,31 @@ read_channel_handle_request (GVfsChannel *channel,
   switch (command)
     {
     case G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_READ:
-      read_channel->read_count++;
-      job = g_vfs_job_read_new (read_channel,
-				backend_handle,
-				modify_read_size (read_channel, arg1),
-				backend);
+      job = new_read_job (read_channel, -1, arg1);
+      break;
+    case G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_PREAD:
+      backend_class = G_VFS_BACKEND_GET_CLASS (backend);
+      if (backend_class->read_at == NULL &&
+	  backend_class->try_read_at == NULL)
+	{
+	  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			       _("Operation not supported by backend"));
+	  break;
+	}
+      if (data_len != 4)
+	{
+	  g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+		       "Invalid stream command %"G_GUINT32_FORMAT, command);
+	  break;
+	}
+
+      /* Moves the position like a seek does */
+      read_channel->read_count = 0;
+      read_channel->read_size = 0;
+      read_channel->seek_generation++;
+      job = new_read_job (read_channel,
+			  ((goffset)arg1) | (((goffset)arg2) << 32),
+			  g_ntohl (*(guint32 *)data));
       break;
     case G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_CLOSE:
       job = g_vfs_job_close_read_new (read_channel,
@@ -163,7 +361,9 @@ read_channel_handle_request (GVfsChannel *channel,
       if (command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SEEK_END)
 	seek_type = G_SEEK_END;
       
+      /* Not sequential anymore, start over with small reads */
       read_channel->read_count = 0;
+      read_channel->read_size = 0;
       read_channel->seek_generation++;
       job = g_vfs_job_seek_read_new (read_channel,
 				     backend_handle,
@@ -209,14 +409,12 @@ read_channel_readahead (GVfsChannel  *channel,
       read_job = G_VFS_JOB_READ (job);
       read_channel = G_VFS_READ_CHANNEL (channel);
 
-      if (read_job->data_count != 0)
-	{
-	  read_channel->read_count++;
-	  readahead_job = g_vfs_job_read_new (read_channel,
-					      g_vfs_channel_get_backend_handle (channel),
-					      modify_read_size (read_channel, 8192),
-					      g_vfs_channel_get_backend (channel));
-	}
+      /* Called again as long as the channel can take more reads,
+	 keep issuing until the window is covered */
+      if (read_job->data_count != 0 &&
+	  (read_channel->bytes_in_flight == 0 ||
+	   read_channel->bytes_in_flight + next_read_size (read_channel) <= readahead_window (read_channel)))
+	readahead_job = new_read_job (read_channel, -1, 8192);
     }
   
   return readahead_job;
@@ -227,6 +425,7 @@ read_channel_readahead (GVfsChannel  *channel,
  */
 void
 g_vfs_read_channel_send_seek_offset (GVfsReadChannel *read_channel,
+				     GVfsJob *job,
 				     goffset offset)
 {
   GVfsDaemonSocketProtocolReply reply;
@@ -235,17 +434,18 @@ g_vfs_read_channel_send_seek_offset (GVfsReadChannel *read_channel,
   channel = G_VFS_CHANNEL (read_channel);
   
   reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SEEK_POS);
-  reply.seq_nr = g_htonl (g_vfs_channel_get_current_seq_nr (channel));
+  reply.seq_nr = g_htonl (g_vfs_channel_get_job_seq_nr (channel, job));
   reply.arg1 = g_htonl (offset & 0xffffffff);
   reply.arg2 = g_htonl (offset >> 32);
 
-  g_vfs_channel_send_reply (channel, &reply, NULL, 0);
+  g_vfs_channel_send_reply (channel, job, &reply, NULL, 0);
 }
 
 /* Might be called on an i/o thread
  */
 void
-g_vfs_read_channel_send_closed (GVfsReadChannel *read_channel)
+g_vfs_read_channel_send_closed (GVfsReadChannel *read_channel,
+				GVfsJob *job)
 {
   GVfsDaemonSocketProtocolReply reply;
   GVfsChannel *channel;
@@ -253,17 +453,18 @@ g_vfs_read_channel_send_closed (GVfsReadChannel *read_channel)
   channel = G_VFS_CHANNEL (read_channel);
   
   reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_CLOSED);
-  reply.seq_nr = g_htonl (g_vfs_channel_get_current_seq_nr (channel));
+  reply.seq_nr = g_htonl (g_vfs_channel_get_job_seq_nr (channel, job));
   reply.arg1 = g_htonl (0);
   reply.arg2 = g_htonl (0);
 
-  g_vfs_channel_send_reply (channel, &reply, NULL, 0);
+  g_vfs_channel_send_reply (channel, job, &reply, NULL, 0);
 }
 
 /* Might be called on an i/o thread
  */
 void
 g_vfs_read_channel_send_data (GVfsReadChannel  *read_channel,
+			      GVfsJob         *job,
 			      char            *buffer,
 			      gsize            count)
 {
@@ -273,11 +474,11 @@ g_vfs_read_channel_send_data (GVfsReadChannel  *read_channel,
   channel = G_VFS_CHANNEL (read_channel);
 
   reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_DATA);
-  reply.seq_nr = g_htonl (g_vfs_channel_get_current_seq_nr (channel));
+  reply.seq_nr = g_htonl (g_vfs_channel_get_job_seq_nr (channel, job));
   reply.arg1 = g_htonl (count);
   reply.arg2 = g_htonl (read_channel->seek_generation);
 
-  g_vfs_channel_send_reply (channel, &reply, buffer, count);
+  g_vfs_channel_send_reply (channel, job, &reply, buffer, count);
 }
 
 
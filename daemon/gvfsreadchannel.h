@@ -50,11 +50,14 @@ GType g_vfs_read_channel_get_type (void) G_GNUC_CONST;
 GVfsReadChannel *g_vfs_read_channel_new                (GVfsBackend        *backend,
                                                         GPid                actual_consumer);
 void            g_vfs_read_channel_send_data          (GVfsReadChannel     *read_channel,
+						       GVfsJob            *job,
 						       char               *buffer,
 						       gsize               count);
-void            g_vfs_read_channel_send_closed        (GVfsReadChannel     *read_channel);
+void            g_vfs_read_channel_send_closed        (GVfsReadChannel     *read_channel,
+						       GVfsJob            *job);
 void            g_vfs_read_channel_send_seek_offset   (GVfsReadChannel     *read_channel,
-						      goffset             offset);
+						       GVfsJob            *job,
+						       goffset             offset);
 
 G_END_DECLS
 
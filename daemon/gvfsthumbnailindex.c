@@ -0,0 +1,198 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "gvfsthumbnailindex.h"
+
+/* Looking up the thumbnail of a file used to cost up to two stats in
+ * ~/.thumbnails, which dominated enumerating large directories. Instead
+ * keep the names in the thumbnail directories in hash tables, read
+ * once on first use and kept up to date by file monitors. If a
+ * directory can't be monitored we fall back to stat. */
+
+typedef struct {
+  const char *subdir;
+  char *path;
+  GHashTable *names;      /* basename -> basename, NULL if not indexed */
+  GFileMonitor *monitor;
+} ThumbnailDir;
+
+static GMutex index_lock;
+static gboolean index_loaded;
+static ThumbnailDir thumbnail_dirs[] = {
+  { "normal" },
+  { "fail" G_DIR_SEPARATOR_S "gnome-thumbnail-factory" },
+};
+
+enum {
+  DIR_NORMAL,
+  DIR_FAIL
+};
+
+/* Called on the main thread */
+static void
+dir_changed (GFileMonitor      *monitor,
+	     GFile             *child,
+	     GFile             *other_file,
+	     GFileMonitorEvent  event_type,
+	     ThumbnailDir      *dir)
+{
+  char *path, *name;
+
+  if (event_type != G_FILE_MONITOR_EVENT_CREATED &&
+      event_type != G_FILE_MONITOR_EVENT_DELETED)
+    return;
+
+  path = g_file_get_path (child);
+  name = g_file_get_basename (child);
+
+  g_mutex_lock (&index_lock);
+  if (path != NULL && strcmp (path, dir->path) == 0)
+    {
+      /* The directory itself went away or came back */
+      g_hash_table_remove_all (dir->names);
+      g_free (name);
+    }
+  else if (event_type == G_FILE_MONITOR_EVENT_CREATED)
+    g_hash_table_replace (dir->names, name, name);
+  else
+    {
+      g_hash_table_remove (dir->names, name);
+      g_free (name);
+    }
+  g_mutex_unlock (&index_lock);
+
+  g_free (path);
+}
+
+/* Called with the lock held */
+static void
+load_dir_unlocked (ThumbnailDir *dir)
+{
+  GFile *file;
+  GDir *gdir;
+  const char *name;
+  char *copy;
+
+  dir->path = g_build_filename (g_get_home_dir (),
+				".thumbnails", dir->subdir,
+				NULL);
+
+  /* Monitor before listing so no change is missed */
+  file = g_file_new_for_path (dir->path);
+  dir->monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE,
+					   NULL, NULL);
+  g_object_unref (file);
+
+  if (dir->monitor == NULL)
+    return;
+
+  dir->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_signal_connect (dir->monitor, "changed", G_CALLBACK (dir_changed), dir);
+
+  gdir = g_dir_open (dir->path, 0, NULL);
+  if (gdir == NULL)
+    return;
+
+  while ((name = g_dir_read_name (gdir)) != NULL)
+    {
+      copy = g_strdup (name);
+      g_hash_table_replace (dir->names, copy, copy);
+    }
+  g_dir_close (gdir);
+}
+
+static gboolean
+dir_has_file (ThumbnailDir *dir,
+	      const char   *basename,
+	      char        **filename_out)
+{
+  gboolean indexed, found;
+  char *filename;
+  guint i;
+
+  g_mutex_lock (&index_lock);
+  if (!index_loaded)
+    {
+      for (i = 0; i < G_N_ELEMENTS (thumbnail_dirs); i++)
+	load_dir_unlocked (&thumbnail_dirs[i]);
+      index_loaded = TRUE;
+    }
+
+  indexed = dir->names != NULL;
+  found = indexed && g_hash_table_lookup (dir->names, basename) != NULL;
+  g_mutex_unlock (&index_lock);
+
+  if (indexed && !found)
+    return FALSE;
+
+  filename = g_build_filename (dir->path, basename, NULL);
+  if (!indexed)
+    found = g_file_test (filename, G_FILE_TEST_IS_REGULAR);
+
+  if (found && filename_out)
+    *filename_out = filename;
+  else
+    g_free (filename);
+
+  return found;
+}
+
+/**
+ * g_vfs_thumbnail_index_add_info:
+ * @uri: the uri of the file
+ * @info: the info of the file
+ *
+ * Sets the thumbnail path or the thumbnailing failed attribute of
+ * @info if there is a thumbnail or a failed thumbnail for @uri. May
+ * be called from any thread, but the index is only updated when the
+ * main loop runs.
+ **/
+void
+g_vfs_thumbnail_index_add_info (const char *uri,
+				GFileInfo  *info)
+{
+  GChecksum *checksum;
+  char *basename, *filename;
+
+  checksum = g_checksum_new (G_CHECKSUM_MD5);
+  g_checksum_update (checksum, (const guchar *) uri, strlen (uri));
+
+  basename = g_strconcat (g_checksum_get_string (checksum), ".png", NULL);
+  g_checksum_free (checksum);
+
+  if (dir_has_file (&thumbnail_dirs[DIR_NORMAL], basename, &filename))
+    {
+      g_file_info_set_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH, filename);
+      g_free (filename);
+    }
+  else if (dir_has_file (&thumbnail_dirs[DIR_FAIL], basename, NULL))
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_THUMBNAILING_FAILED, TRUE);
+
+  g_free (basename);
+}
@@ -0,0 +1,196 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <glib/gstdio.h>
+
+#include "gvfstransfercheckpoint.h"
+
+/* Checkpoints are written at most this often while data flows */
+#define CHECKPOINT_INTERVAL_USEC (5 * G_USEC_PER_SEC)
+
+#define CHECKPOINT_GROUP "Transfer"
+
+/* A checkpoint remembers how much of a push or pull reached the
+ * destination, so a later transfer of the same file with
+ * G_VFS_TRANSFER_FLAG_RESUME can continue from there. It lives in a
+ * small key file in the user's cache directory, named after the mount
+ * and both paths, so it survives the connection and the daemon going
+ * away. The source etag and the destination size and etag are kept
+ * with it, a partial file that changed since is never continued. */
+struct _GVfsTransferCheckpoint
+{
+  char *filename;
+  char *source_etag;
+  gint64 last_save;
+};
+
+GVfsTransferCheckpoint *
+g_vfs_transfer_checkpoint_new (GVfsBackend *backend,
+			       const char  *path,
+			       const char  *local_path,
+			       const char  *source_etag)
+{
+  GVfsTransferCheckpoint *checkpoint;
+  GString *key;
+  char *spec, *checksum;
+
+  spec = g_mount_spec_to_string (g_vfs_backend_get_mount_spec (backend));
+  key = g_string_new (spec);
+  g_string_append_c (key, '\n');
+  g_string_append (key, path);
+  g_string_append_c (key, '\n');
+  g_string_append (key, local_path);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key->str, key->len);
+
+  checkpoint = g_new0 (GVfsTransferCheckpoint, 1);
+  checkpoint->filename = g_build_filename (g_get_user_cache_dir (),
+					   "gvfs-transfers", checksum, NULL);
+  checkpoint->source_etag = g_strdup (source_etag);
+
+  g_free (checksum);
+  g_string_free (key, TRUE);
+  g_free (spec);
+
+  return checkpoint;
+}
+
+void
+g_vfs_transfer_checkpoint_free (GVfsTransferCheckpoint *checkpoint)
+{
+  g_free (checkpoint->filename);
+  g_free (checkpoint->source_etag);
+  g_free (checkpoint);
+}
+
+/* Returns where the transfer can continue, or 0 if it has to start
+ * over because there is no checkpoint or something changed since */
+goffset
+g_vfs_transfer_checkpoint_get_offset (GVfsTransferCheckpoint *checkpoint,
+				      goffset                 destination_size,
+				      const char             *destination_etag)
+{
+  GKeyFile *key_file;
+  char *source_etag, *saved_destination_etag;
+  goffset offset;
+
+  key_file = g_key_file_new ();
+  if (!g_key_file_load_from_file (key_file, checkpoint->filename, 0, NULL))
+    {
+      g_key_file_free (key_file);
+      return 0;
+    }
+
+  offset = g_key_file_get_int64 (key_file, CHECKPOINT_GROUP, "offset", NULL);
+  source_etag = g_key_file_get_string (key_file, CHECKPOINT_GROUP, "source-etag", NULL);
+  saved_destination_etag = g_key_file_get_string (key_file, CHECKPOINT_GROUP,
+						  "destination-etag", NULL);
+
+  /* The destination etag is only known when the transfer failed
+     cleanly, after a crash the size check has to do */
+  if (g_strcmp0 (source_etag, checkpoint->source_etag) != 0 ||
+      checkpoint->source_etag == NULL ||
+      destination_size < offset ||
+      (saved_destination_etag != NULL &&
+       g_strcmp0 (saved_destination_etag, destination_etag) != 0))
+    offset = 0;
+
+  g_debug ("checkpoint %s: resume at %" G_GOFFSET_FORMAT "\n",
+	   checkpoint->filename, offset);
+
+  g_free (source_etag);
+  g_free (saved_destination_etag);
+  g_key_file_free (key_file);
+
+  return MAX (offset, 0);
+}
+
+/* Might be called on an i/o thread */
+void
+g_vfs_transfer_checkpoint_save (GVfsTransferCheckpoint *checkpoint,
+				goffset                 offset,
+				const char             *destination_etag)
+{
+  GKeyFile *key_file;
+  char *dirname, *data;
+  gsize len;
+
+  if (checkpoint->source_etag == NULL)
+    return;
+
+  dirname = g_path_get_dirname (checkpoint->filename);
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  key_file = g_key_file_new ();
+  g_key_file_set_string (key_file, CHECKPOINT_GROUP, "source-etag",
+			 checkpoint->source_etag);
+  g_key_file_set_int64 (key_file, CHECKPOINT_GROUP, "offset", offset);
+  if (destination_etag)
+    g_key_file_set_string (key_file, CHECKPOINT_GROUP, "destination-etag",
+			   destination_etag);
+
+  data = g_key_file_to_data (key_file, &len, NULL);
+  g_file_set_contents (checkpoint->filename, data, len, NULL);
+  g_free (data);
+  g_key_file_free (key_file);
+
+  checkpoint->last_save = g_get_monotonic_time ();
+}
+
+/* Call with the bytes known to be in the destination as the transfer
+   goes on. Only writes the checkpoint every few seconds. */
+void
+g_vfs_transfer_checkpoint_update (GVfsTransferCheckpoint *checkpoint,
+				  goffset                 offset)
+{
+  if (g_get_monotonic_time () - checkpoint->last_save < CHECKPOINT_INTERVAL_USEC)
+    return;
+
+  g_vfs_transfer_checkpoint_save (checkpoint, offset, NULL);
+}
+
+/* The transfer is done, nothing to resume */
+void
+g_vfs_transfer_checkpoint_remove (GVfsTransferCheckpoint *checkpoint)
+{
+  g_unlink (checkpoint->filename);
+}
+
+/* An etag for info, falling back to size and mtime for backends that
+   have no etags */
+char *
+g_vfs_transfer_checkpoint_make_etag (GFileInfo *info)
+{
+  GTimeVal mtime;
+
+  if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_ETAG_VALUE))
+    return g_strdup (g_file_info_get_etag (info));
+
+  if (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+    return NULL;
+
+  g_file_info_get_modification_time (info, &mtime);
+  return g_strdup_printf ("%" G_GOFFSET_FORMAT ":%ld",
+			  g_file_info_get_size (info), (long) mtime.tv_sec);
+}
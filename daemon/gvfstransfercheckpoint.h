@@ -0,0 +1,52 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef __G_VFS_TRANSFER_CHECKPOINT_H__
+#define __G_VFS_TRANSFER_CHECKPOINT_H__
+
+#include <gio/gio.h>
+#include <gvfsbackend.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GVfsTransferCheckpoint GVfsTransferCheckpoint;
+
+GVfsTransferCheckpoint *g_vfs_transfer_checkpoint_new        (GVfsBackend            *backend,
+							      const char             *path,
+							      const char             *local_path,
+							      const char             *source_etag);
+goffset                 g_vfs_transfer_checkpoint_get_offset (GVfsTransferCheckpoint *checkpoint,
+							      goffset                 destination_size,
+							      const char             *destination_etag);
+void                    g_vfs_transfer_checkpoint_update     (GVfsTransferCheckpoint *checkpoint,
+							      goffset                 offset);
+void                    g_vfs_transfer_checkpoint_save       (GVfsTransferCheckpoint *checkpoint,
+							      goffset                 offset,
+							      const char             *destination_etag);
+void                    g_vfs_transfer_checkpoint_remove     (GVfsTransferCheckpoint *checkpoint);
+void                    g_vfs_transfer_checkpoint_free       (GVfsTransferCheckpoint *checkpoint);
+
+char *                  g_vfs_transfer_checkpoint_make_etag  (GFileInfo              *info);
+
+G_END_DECLS
+
+#endif /* __G_VFS_TRANSFER_CHECKPOINT_H__ */
@@ -41,9 +41,21 @@
 #include <gvfsjobclosewrite.h>
 #include <gvfsjobqueryinfowrite.h>
 
+/* Write out buffered data if no more writes come in for this long */
+#define WRITE_BEHIND_IDLE_MSECS 500
+
 struct _GVfsWriteChannel
 {
   GVfsChannel parent_instance;
+
+  char *filename;
+
+  /* Write-behind, see g_vfs_backend_set_write_behind_size() */
+  GByteArray *pending;
+  gboolean flushing;
+  GError *write_error; /* Not yet reported */
+  gboolean need_seek; /* Buffered data was lost, writes fail until a seek */
+  guint idle_flush_id;
 };
 
 G_DEFINE_TYPE (GVfsWriteChannel, g_vfs_write_channel, G_VFS_TYPE_CHANNEL)
@@ -57,10 +69,21 @@ static GVfsJob *write_channel_handle_request (GVfsChannel  *channel,
 					      gpointer      data,
 					      gsize         data_len,
 					      GError      **error);
+static GVfsJob *write_channel_flush          (GVfsChannel  *channel,
+					      gboolean      force);
   
 static void
 g_vfs_write_channel_finalize (GObject *object)
 {
+  GVfsWriteChannel *write_channel = G_VFS_WRITE_CHANNEL (object);
+
+  if (write_channel->idle_flush_id != 0)
+    g_source_remove (write_channel->idle_flush_id);
+  if (write_channel->pending)
+    g_byte_array_free (write_channel->pending, TRUE);
+  g_clear_error (&write_channel->write_error);
+  g_free (write_channel->filename);
+
   if (G_OBJECT_CLASS (g_vfs_write_channel_parent_class)->finalize)
     (*G_OBJECT_CLASS (g_vfs_write_channel_parent_class)->finalize) (object);
 }
@@ -74,6 +97,7 @@ g_vfs_write_channel_class_init (GVfsWriteChannelClass *klass)
   gobject_class->finalize = g_vfs_write_channel_finalize;
   channel_class->close = write_channel_close;
   channel_class->handle_request = write_channel_handle_request;
+  channel_class->flush = write_channel_flush;
 }
 
 static void
@@ -89,6 +113,125 @@ write_channel_close (GVfsChannel *channel)
 				    g_vfs_channel_get_backend (channel));
 } 
 
+static gboolean idle_flush_cb (gpointer data);
+
+/* Nothing else runs on the channel while a flush is active, so
+   pending only has data buffered before it started */
+static void
+flush_job_finished (GVfsJob *job,
+		    GVfsWriteChannel *write_channel)
+{
+  GVfsJobWrite *write_job = G_VFS_JOB_WRITE (job);
+
+  write_channel->flushing = FALSE;
+
+  if (job->failed || write_job->written_size == 0)
+    {
+      /* Later data would end up at the wrong place, drop it */
+      if (write_channel->write_error == NULL)
+	{
+	  if (job->failed)
+	    write_channel->write_error = g_error_copy (job->error);
+	  else
+	    write_channel->write_error =
+	      g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+				   _("Error writing file"));
+	}
+      write_channel->need_seek = TRUE;
+      g_byte_array_set_size (write_channel->pending, 0);
+    }
+  else if (write_job->written_size < write_job->data_size)
+    {
+      /* Short write, the rest goes out with the next flush */
+      g_byte_array_prepend (write_channel->pending,
+			    (guint8 *)write_job->data + write_job->written_size,
+			    write_job->data_size - write_job->written_size);
+      if (write_channel->idle_flush_id == 0)
+	write_channel->idle_flush_id =
+	  g_timeout_add (WRITE_BEHIND_IDLE_MSECS, idle_flush_cb, write_channel);
+    }
+}
+
+static GVfsJob *
+write_channel_flush (GVfsChannel *channel,
+		     gboolean force)
+{
+  GVfsWriteChannel *write_channel = G_VFS_WRITE_CHANNEL (channel);
+  GVfsJob *job;
+  gsize size;
+  char *data;
+
+  if (write_channel->pending == NULL ||
+      write_channel->pending->len == 0 ||
+      write_channel->flushing)
+    return NULL;
+
+  if (!force &&
+      write_channel->pending->len < g_vfs_backend_get_write_behind_size (g_vfs_channel_get_backend (channel)))
+    return NULL;
+
+  if (write_channel->idle_flush_id != 0)
+    {
+      g_source_remove (write_channel->idle_flush_id);
+      write_channel->idle_flush_id = 0;
+    }
+
+  size = write_channel->pending->len;
+  data = (char *)g_byte_array_free (write_channel->pending, FALSE);
+  write_channel->pending = g_byte_array_new ();
+
+  job = g_vfs_job_write_new (write_channel,
+			     g_vfs_channel_get_backend_handle (channel),
+			     data, size,
+			     g_vfs_channel_get_backend (channel));
+  g_signal_connect (job, "finished", G_CALLBACK (flush_job_finished), write_channel);
+  write_channel->flushing = TRUE;
+
+  return job;
+}
+
+static gboolean
+idle_flush_cb (gpointer data)
+{
+  GVfsWriteChannel *write_channel = data;
+
+  write_channel->idle_flush_id = 0;
+  g_vfs_channel_flush (G_VFS_CHANNEL (write_channel));
+
+  return FALSE;
+}
+
+/* Returns TRUE if the data was buffered for write-behind */
+static gboolean
+buffer_write (GVfsWriteChannel *write_channel,
+	      gpointer data,
+	      gsize data_len)
+{
+  gsize write_behind_size;
+
+  write_behind_size =
+    g_vfs_backend_get_write_behind_size (g_vfs_channel_get_backend (G_VFS_CHANNEL (write_channel)));
+  if (write_behind_size == 0)
+    return FALSE;
+
+  if (write_channel->pending == NULL)
+    write_channel->pending = g_byte_array_new ();
+
+  /* Large writes go straight to the backend if nothing is buffered */
+  if (write_channel->pending->len == 0 &&
+      data_len >= write_behind_size)
+    return FALSE;
+
+  g_byte_array_append (write_channel->pending, data, data_len);
+
+  if (write_channel->idle_flush_id != 0)
+    g_source_remove (write_channel->idle_flush_id);
+  write_channel->idle_flush_id =
+    g_timeout_add (WRITE_BEHIND_IDLE_MSECS, idle_flush_cb, write_channel);
+
+  return TRUE;
+}
+
 static GVfsJob *
 write_channel_handle_request (GVfsChannel *channel,
 			      guint32 command,
@@ -110,15 +253,43 @@ write_channel_handle_request (GVfsChannel *channel,
   backend_handle = g_vfs_channel_get_backend_handle (channel);
   backend = g_vfs_channel_get_backend (channel);
   
+  /* Report a failed write-behind flush on the next request,
+     close does it itself after closing the handle */
+  if (write_channel->write_error != NULL &&
+      command != G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_CLOSE)
+    {
+      g_propagate_error (error, write_channel->write_error);
+      write_channel->write_error = NULL;
+      g_free (data);
+      return NULL;
+    }
+
+  /* The file position no longer matches what the client wrote */
+  if (write_channel->need_seek &&
+      command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_WRITE)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+			   _("Error writing file"));
+      g_free (data);
+      return NULL;
+    }
+
   job = NULL;
   switch (command)
     {
     case G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_WRITE:
-      job = g_vfs_job_write_new (write_channel,
-				 backend_handle,
-				 data, data_len,
-				 backend);
-      data = NULL; /* Pass ownership */
+      if (buffer_write (write_channel, data, data_len))
+	job = g_vfs_job_write_new_buffered (write_channel,
+					    data_len,
+					    backend);
+      else
+	{
+	  job = g_vfs_job_write_new (write_channel,
+				     backend_handle,
+				     data, data_len,
+				     backend);
+	  data = NULL; /* Pass ownership */
+	}
       break;
     case G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_CLOSE:
       job = g_vfs_job_close_write_new (write_channel,
@@ -131,6 +302,11 @@ write_channel_handle_request (GVfsChannel *channel,
       if (command == G_VFS_DAEMON_SOCKET_PROTOCOL_REQUEST_SEEK_END)
 	seek_type = G_SEEK_END;
       
+      /* Buffered data is always flushed before a seek, unless it
+	 followed a failed pipelined write. Then it is lost too. */
+      if (write_channel->pending)
+	g_byte_array_set_size (write_channel->pending, 0);
+      write_channel->need_seek = FALSE;
       job = g_vfs_job_seek_write_new (write_channel,
 				      backend_handle,
 				      seek_type,
@@ -159,11 +335,24 @@ write_channel_handle_request (GVfsChannel *channel,
   return job;
 }
 
+/* Returns the error of a failed write-behind flush, if any */
+GError *
+g_vfs_write_channel_take_error (GVfsWriteChannel *write_channel)
+{
+  GError *error;
+
+  error = write_channel->write_error;
+  write_channel->write_error = NULL;
+
+  return error;
+}
+
 /* Might be called on an i/o thread
  */
 void
 g_vfs_write_channel_send_seek_offset (GVfsWriteChannel *write_channel,
-				     goffset offset)
+				      GVfsJob *job,
+				      goffset offset)
 {
   GVfsDaemonSocketProtocolReply reply;
   GVfsChannel *channel;
@@ -171,17 +360,18 @@ g_vfs_write_channel_send_seek_offset (GVfsWriteChannel *write_channel,
   channel = G_VFS_CHANNEL (write_channel);
   
   reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_SEEK_POS);
-  reply.seq_nr = g_htonl (g_vfs_channel_get_current_seq_nr (channel));
+  reply.seq_nr = g_htonl (g_vfs_channel_get_job_seq_nr (channel, job));
   reply.arg1 = g_htonl (offset & 0xffffffff);
   reply.arg2 = g_htonl (offset >> 32);
 
-  g_vfs_channel_send_reply (channel, &reply, NULL, 0);
+  g_vfs_channel_send_reply (channel, job, &reply, NULL, 0);
 }
 
 /* Might be called on an i/o thread
  */
 void
 g_vfs_write_channel_send_closed (GVfsWriteChannel *write_channel,
+				 GVfsJob          *job,
 				 const char       *etag)
 {
   GVfsDaemonSocketProtocolReply reply;
@@ -190,17 +380,18 @@ g_vfs_write_channel_send_closed (GVfsWriteChannel *write_channel,
   channel = G_VFS_CHANNEL (write_channel);
   
   reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_CLOSED);
-  reply.seq_nr = g_htonl (g_vfs_channel_get_current_seq_nr (channel));
+  reply.seq_nr = g_htonl (g_vfs_channel_get_job_seq_nr (channel, job));
   reply.arg1 = g_htonl (0);
   reply.arg2 = g_htonl (strlen (etag));
 
-  g_vfs_channel_send_reply (channel, &reply, etag, strlen (etag));
+  g_vfs_channel_send_reply (channel, job, &reply, etag, strlen (etag));
 }
 
 /* Might be called on an i/o thread
  */
 void
 g_vfs_write_channel_send_written (GVfsWriteChannel  *write_channel,
+				  GVfsJob *job,
 				  gsize bytes_written)
 {
   GVfsDaemonSocketProtocolReply reply;
@@ -209,20 +400,33 @@ g_vfs_write_channel_send_written (GVfsWriteChannel  *write_channel,
   channel = G_VFS_CHANNEL (write_channel);
 
   reply.type = g_htonl (G_VFS_DAEMON_SOCKET_PROTOCOL_REPLY_WRITTEN);
-  reply.seq_nr = g_htonl (g_vfs_channel_get_current_seq_nr (channel));
+  reply.seq_nr = g_htonl (g_vfs_channel_get_job_seq_nr (channel, job));
   reply.arg1 = g_htonl (bytes_written);
   reply.arg2 = 0;
 
-  g_vfs_channel_send_reply (channel, &reply, NULL, 0);
+  g_vfs_channel_send_reply (channel, job, &reply, NULL, 0);
 }
 
 
 GVfsWriteChannel *
 g_vfs_write_channel_new (GVfsBackend *backend,
+                         const char  *filename,
                          GPid         actual_consumer)
 {
-  return g_object_new (G_VFS_TYPE_WRITE_CHANNEL,
-		       "backend", backend,
-                       "actual-consumer", actual_consumer,
-		       NULL);
+  GVfsWriteChannel *write_channel;
+
+  write_channel = g_object_new (G_VFS_TYPE_WRITE_CHANNEL,
+				"backend", backend,
+				"actual-consumer", actual_consumer,
+				NULL);
+  write_channel->filename = g_strdup (filename);
+
+  return write_channel;
+}
+
+/* The backend filename the channel writes to */
+const char *
+g_vfs_write_channel_get_filename (GVfsWriteChannel *write_channel)
+{
+  return write_channel->filename;
 }
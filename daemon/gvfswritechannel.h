@@ -48,12 +48,18 @@ struct _GVfsWriteChannelClass
 GType g_vfs_write_channel_get_type (void) G_GNUC_CONST;
 
 GVfsWriteChannel *g_vfs_write_channel_new              (GVfsBackend      *backend,
+                                                        const char       *filename,
                                                         GPid              actual_consumer);
+const char *      g_vfs_write_channel_get_filename     (GVfsWriteChannel *write_channel);
 void              g_vfs_write_channel_send_written     (GVfsWriteChannel *write_channel,
+							GVfsJob          *job,
 							gsize             bytes_written);
 void              g_vfs_write_channel_send_closed      (GVfsWriteChannel *write_channel,
+							GVfsJob          *job,
 							const char       *etag);
+GError *         g_vfs_write_channel_take_error       (GVfsWriteChannel *write_channel);
 void              g_vfs_write_channel_send_seek_offset (GVfsWriteChannel *write_channel,
+							GVfsJob          *job,
 							goffset           offset);
 
 G_END_DECLS
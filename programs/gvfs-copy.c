@@ -32,12 +32,16 @@
 #include <glib/gi18n.h>
 #include <gio/gio.h>
 
+#include "gvfscopy.h"
+
 static gboolean progress = FALSE;
 static gboolean interactive = FALSE;
 static gboolean no_dereference = FALSE;
 static gboolean backup = FALSE;
 static gboolean preserve = FALSE;
 static gboolean no_target_directory = FALSE;
+static gboolean recursive = FALSE;
+static int jobs = G_VFS_COPY_DEFAULT_PARALLEL;
 
 static GOptionEntry entries[] =
 {
@@ -47,6 +51,8 @@ static GOptionEntry entries[] =
   { "preserve", 'p', 0, G_OPTION_ARG_NONE, &preserve, N_("preserve all attributes"), NULL },
   { "backup", 'b', 0, G_OPTION_ARG_NONE, &backup, N_("backup existing destination files"), NULL },
   { "no-dereference", 'P', 0, G_OPTION_ARG_NONE, &no_dereference, N_("never follow symbolic links"), NULL },
+  { "recursive", 'r', 0, G_OPTION_ARG_NONE, &recursive, N_("copy directories recursively"), NULL },
+  { "jobs", 'j', 0, G_OPTION_ARG_INT, &jobs, N_("number of files to copy at the same time"), N_("N") },
   { NULL }
 };
 
@@ -81,6 +87,20 @@ show_progress (goffset current_num_bytes,
   g_free (size);
 }
 
+static gboolean
+copy (GFile                  *source,
+      GFile                  *target,
+      GFileCopyFlags          flags,
+      GFileProgressCallback   progress_callback,
+      GError                **error)
+{
+  if (recursive)
+    return g_vfs_copy_recursive (source, target, flags, MAX (jobs, 1), NULL,
+				 progress_callback, NULL, error);
+
+  return g_file_copy (source, target, flags, NULL, progress_callback, NULL, error);
+}
+
 static void
 show_help (GOptionContext *context, const char *error)
 {
@@ -180,7 +200,7 @@ main (int argc, char *argv[])
 
       error = NULL;
       g_get_current_time (&start_time);
-      if (!g_file_copy (source, target, flags, NULL, progress?show_progress:NULL, NULL, &error))
+      if (!copy (source, target, flags, progress?show_progress:NULL, &error))
 	{
 	  if (interactive && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_EXISTS))
 	    {
@@ -197,7 +217,7 @@ main (int argc, char *argv[])
 		  line[0] == 'y')
 		{
 		  flags |= G_FILE_COPY_OVERWRITE;
-		  if (!g_file_copy (source, target, flags, NULL, NULL, NULL, &error))
+		  if (!copy (source, target, flags, NULL, &error))
 		    goto copy_failed;
 		}
 	    }
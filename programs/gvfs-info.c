@@ -27,6 +27,8 @@
 #include <glib/gi18n.h>
 #include <gio/gio.h>
 
+#include "gvfsclientops.h"
+
 static char *attributes = NULL;
 static gboolean nofollow_symlinks = FALSE;
 static gboolean filesystem = FALSE;
@@ -223,6 +225,46 @@ query_info (GFile *file)
   g_object_unref (info);
 }
 
+/* Several files are queried together, gvfs mounts answer them with
+   one call */
+static void
+query_infos (GFile **files,
+	     int     n_files)
+{
+  GFileQueryInfoFlags flags;
+  GFileInfo **infos;
+  GError **errors;
+  int i;
+
+  if (attributes == NULL)
+    attributes = "*";
+
+  flags = 0;
+  if (nofollow_symlinks)
+    flags |= G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS;
+
+  infos = g_new (GFileInfo *, n_files);
+  errors = g_new (GError *, n_files);
+  g_vfs_query_info_multi (files, n_files, attributes, flags,
+			  infos, errors, NULL);
+
+  for (i = 0; i < n_files; i++)
+    {
+      if (infos[i] == NULL)
+	{
+	  g_printerr ("Error getting info: %s\n", errors[i]->message);
+	  g_error_free (errors[i]);
+	  continue;
+	}
+
+      show_info (infos[i]);
+      g_object_unref (infos[i]);
+    }
+
+  g_free (errors);
+  g_free (infos);
+}
+
 static char *
 attribute_type_to_string (GFileAttributeType type)
 {
@@ -375,7 +417,20 @@ main (int argc, char *argv[])
       return 1;
     }
 
-  if (argc > 1)
+  if (argc > 2 && !writable && !filesystem)
+    {
+      GFile **files;
+      int i;
+
+      files = g_new (GFile *, argc - 1);
+      for (i = 1; i < argc; i++)
+	files[i - 1] = g_file_new_for_commandline_arg (argv[i]);
+      query_infos (files, argc - 1);
+      for (i = 1; i < argc; i++)
+	g_object_unref (files[i - 1]);
+      g_free (files);
+    }
+  else if (argc > 1)
     {
       int i;
 
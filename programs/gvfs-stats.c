@@ -0,0 +1,366 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <locale.h>
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <gio/gio.h>
+#include <dbus/dbus.h>
+
+#include <gvfsdaemonprotocol.h>
+
+static gboolean reset = FALSE;
+static gboolean show_histograms = FALSE;
+
+static GOptionEntry entries[] =
+{
+  { "reset", 'r', 0, G_OPTION_ARG_NONE, &reset, N_("Reset the statistics after showing them"), NULL },
+  { "histograms", 'H', 0, G_OPTION_ARG_NONE, &show_histograms, N_("Show latency histograms"), NULL },
+  { NULL }
+};
+
+static const char *phase_names[] = {
+  N_("queued"),
+  N_("running"),
+  N_("replying")
+};
+
+static DBusMessage *
+call (DBusConnection *connection,
+      const char *destination,
+      const char *path,
+      const char *interface,
+      const char *method)
+{
+  DBusMessage *message, *reply;
+  DBusError derror;
+
+  message = dbus_message_new_method_call (destination, path, interface, method);
+  if (message == NULL)
+    return NULL;
+
+  dbus_error_init (&derror);
+  reply = dbus_connection_send_with_reply_and_block (connection, message,
+						     G_VFS_DBUS_TIMEOUT_MSECS,
+						     &derror);
+  dbus_message_unref (message);
+
+  if (reply == NULL)
+    {
+      g_printerr (_("Error calling %s: %s\n"), method, derror.message);
+      dbus_error_free (&derror);
+    }
+
+  return reply;
+}
+
+static char *
+format_histogram (const guint32 *histogram,
+		  int n_buckets)
+{
+  GString *str;
+  guint64 limit;
+  int i;
+
+  str = g_string_new (NULL);
+  limit = G_VFS_STATS_FIRST_BUCKET_USECS;
+  for (i = 0; i < n_buckets; i++, limit *= 2)
+    {
+      if (histogram[i] == 0)
+	continue;
+
+      if (i == n_buckets - 1)
+	g_string_append_printf (str, " >=%"G_GUINT64_FORMAT"us:%u",
+				limit / 2, histogram[i]);
+      else
+	g_string_append_printf (str, " <%"G_GUINT64_FORMAT"us:%u",
+				limit, histogram[i]);
+    }
+
+  return g_string_free (str, FALSE);
+}
+
+static void
+print_entry (DBusMessageIter *struct_iter)
+{
+  const char *backend, *display_name, *operation;
+  dbus_uint64_t count, failed, bytes, total[3];
+  DBusMessageIter array_iter;
+  const guint32 *histogram;
+  int i, n_buckets;
+  char *str;
+
+  dbus_message_iter_get_basic (struct_iter, &backend);
+  dbus_message_iter_next (struct_iter);
+  dbus_message_iter_get_basic (struct_iter, &display_name);
+  dbus_message_iter_next (struct_iter);
+  dbus_message_iter_get_basic (struct_iter, &operation);
+  dbus_message_iter_next (struct_iter);
+  dbus_message_iter_get_basic (struct_iter, &count);
+  dbus_message_iter_next (struct_iter);
+  dbus_message_iter_get_basic (struct_iter, &failed);
+  dbus_message_iter_next (struct_iter);
+  dbus_message_iter_get_basic (struct_iter, &bytes);
+  dbus_message_iter_next (struct_iter);
+  for (i = 0; i < 3; i++)
+    {
+      dbus_message_iter_get_basic (struct_iter, &total[i]);
+      dbus_message_iter_next (struct_iter);
+    }
+
+  g_print ("  %-20s %8"G_GUINT64_FORMAT" %6"G_GUINT64_FORMAT" %12"G_GUINT64_FORMAT,
+	   operation, count, failed, bytes);
+  for (i = 0; i < 3; i++)
+    g_print (" %10.2f", count ? total[i] / 1000.0 / count : 0.0);
+  g_print ("\n");
+
+  if (!show_histograms)
+    return;
+
+  for (i = 0; i < 3; i++)
+    {
+      dbus_message_iter_recurse (struct_iter, &array_iter);
+      dbus_message_iter_get_fixed_array (&array_iter, &histogram, &n_buckets);
+      dbus_message_iter_next (struct_iter);
+
+      str = format_histogram (histogram, n_buckets);
+      g_print ("    %-10s%s\n", _(phase_names[i]), str);
+      g_free (str);
+    }
+}
+
+/* The read buffers are shared by all backends of the daemon */
+static void
+print_buffer_pool_stats (DBusMessageIter *iter)
+{
+  DBusMessageIter struct_iter;
+  dbus_uint64_t hits, misses, bytes_idle, bytes_used;
+
+  if (dbus_message_iter_get_arg_type (iter) != DBUS_TYPE_STRUCT)
+    return;
+
+  dbus_message_iter_recurse (iter, &struct_iter);
+  dbus_message_iter_get_basic (&struct_iter, &hits);
+  dbus_message_iter_next (&struct_iter);
+  dbus_message_iter_get_basic (&struct_iter, &misses);
+  dbus_message_iter_next (&struct_iter);
+  dbus_message_iter_get_basic (&struct_iter, &bytes_idle);
+  dbus_message_iter_next (&struct_iter);
+  dbus_message_iter_get_basic (&struct_iter, &bytes_used);
+
+  g_print (_("  buffer pool: %"G_GUINT64_FORMAT" hits, %"G_GUINT64_FORMAT" misses, "
+	     "%"G_GUINT64_FORMAT" bytes idle, %"G_GUINT64_FORMAT" bytes in use\n"),
+	   hits, misses, bytes_idle, bytes_used);
+}
+
+/* Prints the statistics of the backend at obj_path, from the GetStats
+   reply of its daemon */
+static void
+print_backend_stats (DBusMessage *stats,
+		     const char *display_name,
+		     const char *obj_path)
+{
+  DBusMessageIter iter, array_iter, struct_iter;
+  const char *backend;
+  gboolean printed_header;
+
+  printed_header = FALSE;
+
+  dbus_message_iter_init (stats, &iter);
+  if (dbus_message_iter_get_arg_type (&iter) != DBUS_TYPE_ARRAY)
+    return;
+
+  dbus_message_iter_recurse (&iter, &array_iter);
+  while (dbus_message_iter_get_arg_type (&array_iter) == DBUS_TYPE_STRUCT)
+    {
+      dbus_message_iter_recurse (&array_iter, &struct_iter);
+      dbus_message_iter_get_basic (&struct_iter, &backend);
+
+      if (strcmp (backend, obj_path) == 0)
+	{
+	  if (!printed_header)
+	    {
+	      g_print ("%s:\n", display_name);
+	      g_print ("  %-20s %8s %6s %12s %10s %10s %10s\n",
+		       _("operation"), _("jobs"), _("failed"), _("bytes"),
+		       _("queued ms"), _("running ms"), _("reply ms"));
+	      printed_header = TRUE;
+	    }
+	  print_entry (&struct_iter);
+	}
+
+      dbus_message_iter_next (&array_iter);
+    }
+
+  if (printed_header && dbus_message_iter_next (&iter))
+    print_buffer_pool_stats (&iter);
+}
+
+static gboolean
+mount_matches (const char *display_name,
+	       char **names)
+{
+  int i;
+
+  if (names == NULL)
+    return TRUE;
+
+  for (i = 0; names[i] != NULL; i++)
+    if (strcmp (names[i], display_name) == 0)
+      return TRUE;
+
+  return FALSE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error;
+  GOptionContext *context;
+  DBusConnection *connection;
+  DBusMessage *mounts, *stats;
+  DBusMessageIter iter, array_iter, struct_iter;
+  GHashTable *daemon_stats;
+  const char *dbus_id, *obj_path, *display_name;
+  char **names;
+  GFile *file;
+  GMount *mount;
+  int i;
+
+  setlocale (LC_ALL, "");
+
+  g_type_init ();
+
+  error = NULL;
+  context = g_option_context_new (_("[LOCATION...] - show backend job statistics"));
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+  g_option_context_parse (context, &argc, &argv, &error);
+  g_option_context_free (context);
+
+  if (error != NULL)
+    {
+      g_printerr (_("Error parsing commandline options: %s\n"), error->message);
+      g_printerr ("\n");
+      g_printerr (_("Try \"%s --help\" for more information."),
+		  g_get_prgname ());
+      g_printerr ("\n");
+      g_error_free (error);
+      return 1;
+    }
+
+  /* Only show the mounts of the given locations */
+  names = NULL;
+  if (argc > 1)
+    {
+      names = g_new0 (char *, argc);
+      for (i = 1; i < argc; i++)
+	{
+	  file = g_file_new_for_commandline_arg (argv[i]);
+	  mount = g_file_find_enclosing_mount (file, NULL, &error);
+	  if (mount == NULL)
+	    {
+	      g_printerr (_("Error finding enclosing mount: %s\n"), error->message);
+	      g_error_free (error);
+	      return 1;
+	    }
+	  names[i - 1] = g_mount_get_name (mount);
+	  g_object_unref (mount);
+	  g_object_unref (file);
+	}
+    }
+
+  connection = dbus_bus_get (DBUS_BUS_SESSION, NULL);
+  if (connection == NULL)
+    {
+      g_printerr (_("Failed to connect to the D-BUS daemon\n"));
+      return 1;
+    }
+
+  mounts = call (connection,
+		 G_VFS_DBUS_DAEMON_NAME,
+		 G_VFS_DBUS_MOUNTTRACKER_PATH,
+		 G_VFS_DBUS_MOUNTTRACKER_INTERFACE,
+		 G_VFS_DBUS_MOUNTTRACKER_OP_LIST_MOUNTS);
+  if (mounts == NULL)
+    return 1;
+
+  /* Several mounts may live in the same daemon, ask each only once */
+  daemon_stats = g_hash_table_new_full (g_str_hash, g_str_equal,
+					g_free, (GDestroyNotify)dbus_message_unref);
+
+  dbus_message_iter_init (mounts, &iter);
+  dbus_message_iter_recurse (&iter, &array_iter);
+  while (dbus_message_iter_get_arg_type (&array_iter) == DBUS_TYPE_STRUCT)
+    {
+      dbus_message_iter_recurse (&array_iter, &struct_iter);
+      dbus_message_iter_get_basic (&struct_iter, &dbus_id);
+      dbus_message_iter_next (&struct_iter);
+      dbus_message_iter_get_basic (&struct_iter, &obj_path);
+      dbus_message_iter_next (&struct_iter);
+      dbus_message_iter_get_basic (&struct_iter, &display_name);
+
+      if (mount_matches (display_name, names))
+	{
+	  stats = g_hash_table_lookup (daemon_stats, dbus_id);
+	  if (stats == NULL)
+	    {
+	      stats = call (connection, dbus_id,
+			    G_VFS_DBUS_DAEMON_PATH,
+			    G_VFS_DBUS_STATS_INTERFACE,
+			    G_VFS_DBUS_STATS_OP_GET_STATS);
+	      if (stats != NULL)
+		{
+		  g_hash_table_insert (daemon_stats, g_strdup (dbus_id), stats);
+
+		  if (reset)
+		    {
+		      DBusMessage *reply;
+
+		      reply = call (connection, dbus_id,
+				    G_VFS_DBUS_DAEMON_PATH,
+				    G_VFS_DBUS_STATS_INTERFACE,
+				    G_VFS_DBUS_STATS_OP_RESET_STATS);
+		      if (reply)
+			dbus_message_unref (reply);
+		    }
+		}
+	    }
+
+	  if (stats)
+	    print_backend_stats (stats, display_name, obj_path);
+	}
+
+      dbus_message_iter_next (&array_iter);
+    }
+
+  g_hash_table_destroy (daemon_stats);
+  dbus_message_unref (mounts);
+  dbus_connection_unref (connection);
+  g_strfreev (names);
+
+  return 0;
+}
@@ -28,6 +28,16 @@
 #include <glib/gi18n.h>
 #include <gio/gio.h>
 
+#include "gvfsclientops.h"
+
+#define LIST_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK "," \
+  G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET "," \
+  G_FILE_ATTRIBUTE_STANDARD_TARGET_URI
+
 static gboolean show_hidden = FALSE;
 static gboolean follow_symlinks = FALSE;
 
@@ -55,13 +65,64 @@ sort_info_by_name (GFileInfo *a, GFileInfo *b)
 }
 
 static void
-do_tree (GFile *f, int level, guint64 pattern)
+print_prefix (int level, guint64 pattern)
 {
-  GFileEnumerator *enumerator;
-  GError *error = NULL;
   unsigned int n;
+
+  for (n = 0; n < level; n++)
+    {
+      if (pattern & (1<<n))
+	{
+	  g_print ("|   ");
+	}
+      else
+	{
+	  g_print ("    ");
+	}
+    }
+}
+
+static void
+print_entry (GFileInfo *info, const char *name, int level, guint64 pattern, gboolean is_last_item)
+{
+  const char *target_uri;
+
+  print_prefix (level, pattern);
+
+  if (is_last_item)
+    {
+      g_print ("`-- %s", name);
+    }
+  else
+    {
+      g_print ("|-- %s", name);
+    }
+
+  target_uri = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+  if (target_uri != NULL)
+    {
+      g_print (" -> %s", target_uri);
+    }
+  else
+    {
+      if (g_file_info_get_is_symlink (info))
+	{
+	  const char *target;
+	  target = g_file_info_get_symlink_target (info);
+	  g_print (" -> %s", target);
+	}
+    }
+
+  g_print ("\n");
+}
+
+static gboolean
+is_mountable (GFile *f)
+{
   GFileInfo *info;
+  gboolean res;
 
+  res = FALSE;
   info = g_file_query_info (f,
 			    G_FILE_ATTRIBUTE_STANDARD_TYPE ","
 			    G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
@@ -69,22 +130,26 @@ do_tree (GFile *f, int level, guint64 pattern)
 			    NULL, NULL);
   if (info != NULL)
     {
-      if (g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_STANDARD_TYPE) == G_FILE_TYPE_MOUNTABLE)
-	{
-	  /* don't process mountables; we avoid these by getting the target_uri below */
-	  g_object_unref (info);
-	  return;
-	}
+      res = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_STANDARD_TYPE) == G_FILE_TYPE_MOUNTABLE;
       g_object_unref (info);
     }
 
+  return res;
+}
+
+static void
+do_tree (GFile *f, int level, guint64 pattern)
+{
+  GFileEnumerator *enumerator;
+  GError *error = NULL;
+  GFileInfo *info;
+
+  /* don't process mountables; we avoid these by getting the target_uri below */
+  if (is_mountable (f))
+    return;
+
   enumerator = g_file_enumerate_children (f,
-					  G_FILE_ATTRIBUTE_STANDARD_NAME ","
-					  G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-					  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
-					  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK ","
-					  G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET ","
-					  G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
+					  LIST_ATTRIBUTES,
 					  0,
 					  NULL,
 					  &error);
@@ -123,45 +188,9 @@ do_tree (GFile *f, int level, guint64 pattern)
 	  type = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_STANDARD_TYPE);
 	  if (name != NULL)
 	    {
-
-	      for (n = 0; n < level; n++)
-		{
-		  if (pattern & (1<<n))
-		    {
-		      g_print ("|   ");
-		    }
-		  else
-		    {
-		      g_print ("    ");
-		    }
-		}
-
-	      if (is_last_item)
-		{
-		  g_print ("`-- %s", name);
-		}
-	      else
-		{
-		  g_print ("|-- %s", name);
-		}
+	      print_entry (info, name, level, pattern, is_last_item);
 
 	      target_uri = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
-	      if (target_uri != NULL)
-		{
-		  g_print (" -> %s", target_uri);
-		}
-	      else
-		{
-		  if (g_file_info_get_is_symlink (info))
-		    {
-		      const char *target;
-		      target = g_file_info_get_symlink_target (info);
-		      g_print (" -> %s", target);
-		    }
-		}
-
-	      g_print ("\n");
-
 	      if ((type & G_FILE_TYPE_DIRECTORY) &&
 		  (follow_symlinks || !g_file_info_get_is_symlink (info)))
 		{
@@ -197,17 +226,7 @@ do_tree (GFile *f, int level, guint64 pattern)
     }
   else
     {
-      for (n = 0; n < level; n++)
-	{
-	  if (pattern & (1<<n))
-	    {
-	      g_print ("|   ");
-	    }
-	  else
-	    {
-	      g_print ("    ");
-	    }
-	}
+      print_prefix (level, pattern);
 
       g_print ("    [%s]\n", error->message);
 
@@ -215,16 +234,125 @@ do_tree (GFile *f, int level, guint64 pattern)
     }
 }
 
+static gint
+sort_listed_infos (gconstpointer a, gconstpointer b)
+{
+  return sort_info_by_name (*(GFileInfo **)a, *(GFileInfo **)b);
+}
+
+/* Lists the whole tree with one call to the gvfs daemon. Returns the
+   infos by the path of their directory, or NULL if the location
+   can't be listed that way. */
+static GHashTable *
+list_tree (GFile *f)
+{
+  GFileEnumerator *enumerator;
+  GHashTable *children;
+  GPtrArray *infos;
+  GFileInfo *info;
+  const char *name, *slash;
+  char *parent;
+
+  enumerator = g_vfs_enumerate_recursive (f, LIST_ATTRIBUTES, 0, 0, NULL, NULL);
+  if (enumerator == NULL)
+    return NULL;
+
+  children = g_hash_table_new_full (g_str_hash, g_str_equal,
+				    g_free, (GDestroyNotify) g_ptr_array_unref);
+
+  while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)) != NULL)
+    {
+      name = g_file_info_get_name (info);
+      if (name == NULL ||
+	  (g_file_info_get_is_hidden (info) && !show_hidden))
+	{
+	  g_object_unref (info);
+	  continue;
+	}
+
+      slash = strrchr (name, '/');
+      parent = slash ? g_strndup (name, slash - name) : g_strdup ("");
+      infos = g_hash_table_lookup (children, parent);
+      if (infos == NULL)
+	{
+	  infos = g_ptr_array_new_with_free_func (g_object_unref);
+	  g_hash_table_insert (children, parent, infos);
+	}
+      else
+	g_free (parent);
+
+      g_ptr_array_add (infos, info);
+    }
+  g_file_enumerator_close (enumerator, NULL, NULL);
+  g_object_unref (enumerator);
+
+  return children;
+}
+
+/* Like do_tree(), from what list_tree() got. Subdirectories that
+   couldn't be read are just empty. */
+static void
+do_listed_tree (GHashTable *children, const char *path, int level, guint64 pattern)
+{
+  GPtrArray *infos;
+  GFileInfo *info;
+  const char *name, *slash;
+  gboolean is_last_item;
+  guint64 new_pattern;
+  guint i;
+
+  infos = g_hash_table_lookup (children, path);
+  if (infos == NULL)
+    return;
+
+  g_ptr_array_sort (infos, sort_listed_infos);
+
+  for (i = 0; i < infos->len; i++)
+    {
+      info = g_ptr_array_index (infos, i);
+      is_last_item = (i == infos->len - 1);
+
+      /* The name is the path below the listed directory */
+      name = g_file_info_get_name (info);
+      slash = strrchr (name, '/');
+      print_entry (info, slash ? slash + 1 : name, level, pattern, is_last_item);
+
+      if ((g_file_info_get_file_type (info) & G_FILE_TYPE_DIRECTORY) &&
+	  !g_file_info_get_is_symlink (info) &&
+	  g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI) == NULL)
+	{
+	  if (is_last_item)
+	    new_pattern = pattern;
+	  else
+	    new_pattern = pattern | (1<<level);
+
+	  do_listed_tree (children, name, level + 1, new_pattern);
+	}
+    }
+}
+
 static void
 tree (GFile *f)
 {
+  GHashTable *children;
   char *uri;
 
   uri = g_file_get_uri (f);
   g_print ("%s\n", uri);
   g_free (uri);
 
-  do_tree (f, 0, 0);
+  /* Following links needs a walk on our side */
+  children = NULL;
+  if (!follow_symlinks && !is_mountable (f))
+    children = list_tree (f);
+
+  if (children != NULL)
+    {
+      do_listed_tree (children, "", 0, 0);
+      g_hash_table_destroy (children);
+    }
+  else
+    do_tree (f, 0, 0);
 }
 
 int
@@ -0,0 +1,96 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Helpers shared by the test programs */
+
+#include <config.h>
+
+#include <stdlib.h>
+
+#include "test-common.h"
+
+/* Returns size bytes of test data, as found at the start of a file */
+guchar *
+allocate_block (gsize size)
+{
+  guchar *data;
+  gsize i;
+  guchar d;
+
+  data = g_malloc (size);
+  d = 0;
+  for (i = 0; i < size; i++)
+    {
+      data[i] = d;
+      d++;
+      if (d >= DATA_MODULO)
+	d = 0;
+    }
+  return data;
+}
+
+/* Checks that data is the test data at offset in the file */
+gboolean
+verify_block (guchar *data, goffset offset, gsize size)
+{
+  guchar d;
+  gsize i;
+
+  d = offset % DATA_MODULO;
+  for (i = 0; i < size; i++)
+    {
+      if (data[i] != d)
+	return FALSE;
+
+      d++;
+      if (d >= DATA_MODULO)
+	d = 0;
+    }
+
+  return TRUE;
+}
+
+/* Replaces file with size bytes of test data, exits on errors */
+void
+create_file (GFile *file, gsize size)
+{
+  GFileOutputStream *out;
+  guchar *data;
+  GError *error;
+
+  data = allocate_block (size);
+
+  error = NULL;
+  out = g_file_replace (file, NULL, FALSE, 0, NULL, &error);
+  if (out == NULL ||
+      !g_output_stream_write_all (G_OUTPUT_STREAM (out),
+				  data, size, NULL,
+				  NULL, &error) ||
+      !g_output_stream_close (G_OUTPUT_STREAM (out), NULL, &error))
+    {
+      g_print ("error creating file: %s\n", error->message);
+      exit (1);
+    }
+
+  g_object_unref (out);
+  g_free (data);
+}
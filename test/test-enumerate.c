@@ -0,0 +1,181 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Checks that a slow reader of a large directory gets the whole
+ * listing, also when it queries every entry between next_file()
+ * calls, which needs a job thread while the enumeration is still
+ * running. Run it against a mount of a backend that runs one job at
+ * a time, e.g. sftp. With "-c <n>" the directory is filled with
+ * n files first.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+/* Long names make the listing big enough to fill the flow control
+   window and the socket buffer */
+#define NAME_PADDING 200
+
+/* Much shorter than the daemon's credit timeout */
+#define MAX_QUERY_SECONDS 10
+
+static char *
+file_name (int i)
+{
+  return g_strdup_printf ("%0*d", NAME_PADDING, i);
+}
+
+static void
+create_files (GFile *dir, int n_files)
+{
+  GFileOutputStream *out;
+  GFile *file;
+  GError *error;
+  char *name;
+  int i;
+
+  error = NULL;
+  if (!g_file_make_directory (dir, NULL, &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_EXISTS))
+	{
+	  g_print ("error creating directory: %s\n", error->message);
+	  exit (1);
+	}
+      g_clear_error (&error);
+    }
+
+  for (i = 0; i < n_files; i++)
+    {
+      name = file_name (i);
+      file = g_file_get_child (dir, name);
+      out = g_file_replace (file, NULL, FALSE, 0, NULL, &error);
+      if (out == NULL ||
+	  !g_output_stream_close (G_OUTPUT_STREAM (out), NULL, &error))
+	{
+	  g_print ("error creating %s: %s\n", name, error->message);
+	  exit (1);
+	}
+      g_object_unref (out);
+      g_object_unref (file);
+      g_free (name);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  GFileEnumerator *enumerator;
+  GFileInfo *info, *child_info;
+  GFile *dir, *child;
+  GTimer *timer;
+  GError *error;
+  int n_files, count;
+
+  g_type_init ();
+
+  n_files = 0;
+  if (argc > 2 && strcmp (argv[1], "-c") == 0)
+    {
+      n_files = atoi (argv[2]);
+      argc -= 2;
+      argv += 2;
+    }
+
+  if (argc != 2)
+    {
+      g_print ("need dir arg");
+      return 1;
+    }
+
+  dir = g_file_new_for_commandline_arg (argv[1]);
+  if (n_files > 0)
+    create_files (dir, n_files);
+
+  error = NULL;
+  enumerator = g_file_enumerate_children (dir, "standard::*",
+					  0, NULL, &error);
+  if (enumerator == NULL)
+    {
+      g_print ("error enumerating: %s\n", error->message);
+      return 1;
+    }
+
+  /* Let the daemon run ahead until it has to wait for us */
+  sleep (2);
+
+  timer = g_timer_new ();
+  count = 0;
+  while ((info = g_file_enumerator_next_file (enumerator, NULL, &error)) != NULL)
+    {
+      child = g_file_get_child (dir, g_file_info_get_name (info));
+
+      g_timer_start (timer);
+      child_info = g_file_query_info (child, "standard::size",
+				      0, NULL, &error);
+      if (child_info == NULL)
+	{
+	  g_print ("error querying %s: %s\n",
+		   g_file_info_get_name (info), error->message);
+	  return 1;
+	}
+      if (g_timer_elapsed (timer, NULL) > MAX_QUERY_SECONDS)
+	{
+	  g_print ("query waited for the enumeration\n");
+	  return 1;
+	}
+
+      g_object_unref (child_info);
+      g_object_unref (child);
+      g_object_unref (info);
+      count++;
+    }
+
+  if (error != NULL)
+    {
+      g_print ("error after %d files: %s\n", count, error->message);
+      return 1;
+    }
+
+  if (n_files > 0 && count < n_files)
+    {
+      g_print ("short listing, %d of %d files\n", count, n_files);
+      return 1;
+    }
+
+  g_file_enumerator_close (enumerator, NULL, NULL);
+  g_object_unref (enumerator);
+  g_timer_destroy (timer);
+  g_object_unref (dir);
+
+  g_print ("%d files\n", count);
+  g_print ("ALL OK\n");
+  return 0;
+}
@@ -33,58 +33,10 @@
 #include <glib.h>
 #include <gio/gio.h>
 
-/* Fill test data with 0..200, repeadedly.
- * This is not a power of two to avoid possible
- * effects with base-2 i/o buffer sizes that could
- * hide bugs */
-#define DATA_MODULO 200
+#include "test-common.h"
 
 static GMainLoop *main_loop;
 
-static gboolean
-verify_block (guchar *data, guchar *start, gsize size)
-{
-  guchar d;
-  gsize i;
-
-  d = 0;
-  if (start)
-    d = *start;
-  for (i = 0; i < size; i++)
-    {
-      if (data[i] != d)
-	return FALSE;
-      
-      d++;
-      if (d >= DATA_MODULO)
-	d = 0;
-    }
-
-  if (start)
-    *start = d;
-  
-  return TRUE;
-}
-
-static guchar *
-allocate_block (gsize size)
-{
-  guchar *data;
-  gsize i;
-  guchar d;
-
-  data = g_malloc (size);
-  d = 0;
-  for (i = 0; i < size; i++)
-    {
-      data[i] = d;
-      d++;
-      if (d >= DATA_MODULO)
-	d = 0;
-    }
-  return data;
-}
-
 static void
 check_query_info_res (GFileInfo *info,
 		      GError *error,
@@ -125,7 +77,7 @@ check_query_info_out (GFileOutputStream *out, gsize expected_size)
 }
 
 static void
-create_file (GFile *file, gsize size)
+create_file_checking_info (GFile *file, gsize size)
 {
   GFileOutputStream *out;
   guchar *data;
@@ -205,7 +157,6 @@ main (int argc, char *argv[])
   gssize res;
   gsize read_size;
   guchar *buffer;
-  guchar start;
   gboolean do_create_file;
   
   g_type_init ();
@@ -231,7 +182,7 @@ main (int argc, char *argv[])
   file = g_file_new_for_commandline_arg (argv[1]);
 
   if (do_create_file)
-    create_file (file, 100*1000);
+    create_file_checking_info (file, 100*1000);
 
   error = NULL;
   
@@ -246,7 +197,6 @@ main (int argc, char *argv[])
 
   buffer = malloc (100*1000);
 
-  start = 0;
   read_size = 0;
   do
     {
@@ -263,7 +213,7 @@ main (int argc, char *argv[])
 	  exit (1);
 	}
 
-      if (!verify_block (buffer, &start, res))
+      if (!verify_block (buffer, read_size, res))
 	{
 	  g_print ("error in block starting at %d\n", (int)read_size);
 	  exit (1);
@@ -0,0 +1,172 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Checks that a failed read in the middle of a file is reported and
+ * never silently skipped, also with several reads in flight.
+ * Run it against a localtest mount, with the daemon started as
+ *
+ *   GVFS_LOCALTEST_READ_FAIL_OFFSET=<offset>
+ *
+ * passing the same offset. With -c the file is created first.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "test-common.h"
+
+#define FILE_SIZE (4*1024*1024)
+
+/* Small enough that the stream keeps several reads in flight */
+#define BLOCK_SIZE 4096
+
+/* Reads until the first error, returns the offset it happened at */
+static goffset
+read_until_error (GInputStream *in, goffset pos, guchar *buffer)
+{
+  gssize res;
+  GError *error;
+
+  error = NULL;
+  while ((res = g_input_stream_read (in, buffer, BLOCK_SIZE,
+				     NULL, &error)) > 0)
+    {
+      if (!verify_block (buffer, pos, res))
+	{
+	  g_print ("wrong data at %d\n", (int)pos);
+	  exit (1);
+	}
+      pos += res;
+    }
+
+  if (res == 0)
+    {
+      g_print ("read error was not reported\n");
+      exit (1);
+    }
+
+  g_print ("read at %d failed: %s\n", (int)pos, error->message);
+  g_error_free (error);
+
+  return pos;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GFile *file;
+  GFileInputStream *in;
+  GError *error;
+  guchar *buffer;
+  goffset fail_offset, pos;
+  gssize res;
+  gboolean do_create_file;
+  int i;
+
+  g_type_init ();
+
+  do_create_file = FALSE;
+
+  if (argc > 1 && strcmp (argv[1], "-c") == 0)
+    {
+      do_create_file = TRUE;
+      argc--;
+      argv++;
+    }
+
+  if (argc != 3)
+    {
+      g_print ("need offset and file arg");
+      return 1;
+    }
+
+  fail_offset = strtoll (argv[1], NULL, 10);
+  file = g_file_new_for_commandline_arg (argv[2]);
+  buffer = g_malloc (BLOCK_SIZE);
+
+  if (do_create_file)
+    create_file (file, FILE_SIZE);
+
+  error = NULL;
+  in = g_file_read (file, NULL, &error);
+  if (in == NULL)
+    {
+      g_print ("error reading file: %s\n", error->message);
+      return 1;
+    }
+
+  pos = read_until_error (G_INPUT_STREAM (in), 0, buffer);
+  if (pos > fail_offset)
+    {
+      g_print ("read past the failure\n");
+      return 1;
+    }
+
+  /* Data of reads that were in flight must not show up as if
+     it came right after what was read so far */
+  for (i = 0; i < 3; i++)
+    {
+      res = g_input_stream_read (G_INPUT_STREAM (in), buffer, BLOCK_SIZE,
+				 NULL, &error);
+      if (res < 0)
+	{
+	  g_clear_error (&error);
+	  continue;
+	}
+      if (!verify_block (buffer, pos, res))
+	{
+	  g_print ("hole after failed read at %d\n", (int)pos);
+	  return 1;
+	}
+      pos += res;
+    }
+
+  /* Positioning again must recover */
+  if (g_seekable_can_seek (G_SEEKABLE (in)))
+    {
+      if (!g_seekable_seek (G_SEEKABLE (in), 0, G_SEEK_SET, NULL, &error))
+	{
+	  g_print ("error seeking: %s\n", error->message);
+	  return 1;
+	}
+      if (read_until_error (G_INPUT_STREAM (in), 0, buffer) > fail_offset)
+	{
+	  g_print ("read past the failure after seek\n");
+	  return 1;
+	}
+    }
+
+  g_input_stream_close (G_INPUT_STREAM (in), NULL, NULL);
+  g_object_unref (in);
+  g_free (buffer);
+
+  g_print ("ALL OK\n");
+  return 0;
+}
@@ -0,0 +1,166 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Reads the same file through many streams at once, interleaving
+ * the reads. The file is larger than the shared memory ring, so
+ * the ring wraps around, and there are more streams than the daemon
+ * gives a ring to, so some get all data over the socket. With -c the
+ * file is created first.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "test-common.h"
+
+#define FILE_SIZE (5*1024*1024 + 123)
+#define N_STREAMS 24
+
+static void
+read_async_cb (GObject      *source_object,
+	       GAsyncResult *res,
+	       gpointer      user_data)
+{
+  GAsyncResult **result = user_data;
+
+  *result = g_object_ref (res);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GFile *file;
+  GFileInputStream *in[N_STREAMS];
+  goffset pos[N_STREAMS];
+  GError *error;
+  guchar *buffer;
+  gboolean do_create_file;
+  gsize size;
+  gssize res;
+  int i, n_open;
+
+  g_type_init ();
+
+  do_create_file = FALSE;
+
+  if (argc > 1 && strcmp (argv[1], "-c") == 0)
+    {
+      do_create_file = TRUE;
+      argc--;
+      argv++;
+    }
+
+  if (argc != 2)
+    {
+      g_print ("need file arg");
+      return 1;
+    }
+
+  file = g_file_new_for_commandline_arg (argv[1]);
+  buffer = g_malloc (FILE_SIZE);
+
+  if (do_create_file)
+    create_file (file, FILE_SIZE);
+
+  error = NULL;
+  for (i = 0; i < N_STREAMS; i++)
+    {
+      /* Half of them async, that takes another path to the ring */
+      if (i % 2)
+	in[i] = g_file_read (file, NULL, &error);
+      else
+	{
+	  GAsyncResult *result;
+	  GMainContext *context;
+
+	  result = NULL;
+	  context = g_main_context_default ();
+	  g_file_read_async (file, 0, NULL, read_async_cb, &result);
+	  while (result == NULL)
+	    g_main_context_iteration (context, TRUE);
+	  in[i] = g_file_read_finish (file, result, &error);
+	  g_object_unref (result);
+	}
+
+      if (in[i] == NULL)
+	{
+	  g_print ("error opening stream %d: %s\n", i, error->message);
+	  return 1;
+	}
+      pos[i] = 0;
+    }
+
+  /* Different read sizes per stream, so the streams get out of step */
+  n_open = N_STREAMS;
+  while (n_open > 0)
+    {
+      for (i = 0; i < N_STREAMS; i++)
+	{
+	  if (in[i] == NULL)
+	    continue;
+
+	  size = 1000 + i * 7919;
+	  res = g_input_stream_read (G_INPUT_STREAM (in[i]),
+				     buffer, size, NULL, &error);
+	  if (res < 0)
+	    {
+	      g_print ("stream %d: read at %d failed: %s\n",
+		       i, (int)pos[i], error->message);
+	      return 1;
+	    }
+
+	  if (!verify_block (buffer, pos[i], res))
+	    {
+	      g_print ("stream %d: wrong data at %d\n", i, (int)pos[i]);
+	      return 1;
+	    }
+	  pos[i] += res;
+
+	  if (res == 0)
+	    {
+	      if (pos[i] != FILE_SIZE)
+		{
+		  g_print ("stream %d: short read, %d bytes\n", i, (int)pos[i]);
+		  return 1;
+		}
+	      g_input_stream_close (G_INPUT_STREAM (in[i]), NULL, NULL);
+	      g_object_unref (in[i]);
+	      in[i] = NULL;
+	      n_open--;
+	    }
+	}
+    }
+
+  g_free (buffer);
+  g_object_unref (file);
+
+  g_print ("ALL OK\n");
+  return 0;
+}
@@ -0,0 +1,193 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Checks random reads, where every seek is sent together with the
+ * following read. Run it against backends with and without read_at
+ * (e.g. sftp and localtest), so both the combined request and the
+ * fallback to separate seeks are covered. With -c the file is
+ * created first.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "test-common.h"
+
+#define FILE_SIZE (1024*1024)
+#define BLOCK_SIZE 10000
+#define N_READS 500
+
+static void
+seek_or_die (GSeekable *seekable, goffset offset, GSeekType type)
+{
+  GError *error;
+
+  error = NULL;
+  if (!g_seekable_seek (seekable, offset, type, NULL, &error))
+    {
+      g_print ("error seeking: %s\n", error->message);
+      exit (1);
+    }
+}
+
+/* Reads at the current position and checks the data, returns how
+   much was read */
+static gssize
+read_and_verify (GInputStream *in, guchar *buffer, gsize size)
+{
+  goffset pos;
+  gssize res;
+  GError *error;
+
+  pos = g_seekable_tell (G_SEEKABLE (in));
+
+  error = NULL;
+  res = g_input_stream_read (in, buffer, size, NULL, &error);
+  if (res < 0)
+    {
+      g_print ("read at %d failed: %s\n", (int)pos, error->message);
+      exit (1);
+    }
+
+  if (!verify_block (buffer, pos, res))
+    {
+      g_print ("wrong data at %d\n", (int)pos);
+      exit (1);
+    }
+
+  if (g_seekable_tell (G_SEEKABLE (in)) != pos + res)
+    {
+      g_print ("wrong position after read at %d\n", (int)pos);
+      exit (1);
+    }
+
+  return res;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GFile *file;
+  GFileInputStream *in;
+  GSeekable *seekable;
+  GError *error;
+  guchar *buffer;
+  goffset offset;
+  gboolean do_create_file;
+  int i;
+
+  g_type_init ();
+
+  do_create_file = FALSE;
+
+  if (argc > 1 && strcmp (argv[1], "-c") == 0)
+    {
+      do_create_file = TRUE;
+      argc--;
+      argv++;
+    }
+
+  if (argc != 2)
+    {
+      g_print ("need file arg");
+      return 1;
+    }
+
+  file = g_file_new_for_commandline_arg (argv[1]);
+  buffer = g_malloc (BLOCK_SIZE);
+
+  if (do_create_file)
+    create_file (file, FILE_SIZE);
+
+  error = NULL;
+  in = g_file_read (file, NULL, &error);
+  if (in == NULL)
+    {
+      g_print ("error reading file: %s\n", error->message);
+      return 1;
+    }
+  seekable = G_SEEKABLE (in);
+
+  /* The same seed each run, so failures can be reproduced */
+  srand (42);
+  for (i = 0; i < N_READS; i++)
+    {
+      offset = ((goffset)rand () * 4096 + rand ()) % FILE_SIZE;
+
+      switch (i % 3)
+	{
+	case 0:
+	  seek_or_die (seekable, offset, G_SEEK_SET);
+	  break;
+	case 1:
+	  seek_or_die (seekable, offset - g_seekable_tell (seekable), G_SEEK_CUR);
+	  break;
+	case 2:
+	  /* Several seeks before one read, only the last counts */
+	  seek_or_die (seekable, 0, G_SEEK_END);
+	  seek_or_die (seekable, offset, G_SEEK_SET);
+	  break;
+	}
+
+      if (g_seekable_tell (seekable) != offset)
+	{
+	  g_print ("wrong position after seek to %d\n", (int)offset);
+	  return 1;
+	}
+
+      read_and_verify (G_INPUT_STREAM (in), buffer, BLOCK_SIZE);
+      /* Sequential reads go on from where the positioned one ended */
+      read_and_verify (G_INPUT_STREAM (in), buffer, BLOCK_SIZE);
+    }
+
+  /* Seeking to a negative offset fails right away */
+  if (g_seekable_seek (seekable, -1, G_SEEK_SET, NULL, &error))
+    {
+      g_print ("seek to a negative offset succeeded\n");
+      return 1;
+    }
+  g_clear_error (&error);
+
+  /* Reading at the end gives no data */
+  seek_or_die (seekable, FILE_SIZE, G_SEEK_SET);
+  if (g_input_stream_read (G_INPUT_STREAM (in), buffer, BLOCK_SIZE,
+			   NULL, &error) != 0)
+    {
+      g_print ("read at the end returned data or failed\n");
+      return 1;
+    }
+
+  g_input_stream_close (G_INPUT_STREAM (in), NULL, NULL);
+  g_object_unref (in);
+  g_free (buffer);
+
+  g_print ("ALL OK\n");
+  return 0;
+}
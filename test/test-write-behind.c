@@ -0,0 +1,225 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Checks that write-behind never reorders or silently drops data.
+ * Run it against a localtest mount, with the daemon started as
+ *
+ *   GVFS_WRITE_BEHIND_SIZE=65536 GVFS_LOCALTEST_WRITE_LIMIT=10000
+ *
+ * so every flush is a short write, and again with
+ *
+ *   GVFS_WRITE_BEHIND_SIZE=65536 GVFS_LOCALTEST_WRITE_FAIL_OFFSET=<offset>
+ *
+ * passing "-f <offset>", so a flush fails part way through the file.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "test-common.h"
+
+#define FILE_SIZE (1024*1024)
+
+/* Small writes get buffered, the large one goes straight
+   to the backend unless something is buffered already */
+static const gsize chunk_sizes[] = { 100, 7, 5000, 300000, 1, 12345 };
+
+/* Returns the number of bytes acknowledged, and whether
+   any write or the close failed */
+static gsize
+write_file (GFile *file, gboolean *failed)
+{
+  GFileOutputStream *out;
+  guchar *data;
+  gsize pos, size;
+  gssize res;
+  GError *error;
+  int i;
+
+  data = allocate_block (FILE_SIZE);
+  *failed = FALSE;
+
+  error = NULL;
+  out = g_file_replace (file, NULL, FALSE, 0, NULL, &error);
+  if (out == NULL)
+    {
+      g_print ("error creating file: %s\n", error->message);
+      exit (1);
+    }
+
+  pos = 0;
+  i = 0;
+  while (pos < FILE_SIZE)
+    {
+      size = MIN (chunk_sizes[i++ % G_N_ELEMENTS (chunk_sizes)], FILE_SIZE - pos);
+
+      res = g_output_stream_write (G_OUTPUT_STREAM (out),
+				   data + pos, size,
+				   NULL, &error);
+      if (res < 0)
+	{
+	  g_print ("write at %d failed: %s\n", (int)pos, error->message);
+	  g_clear_error (&error);
+	  *failed = TRUE;
+
+	  /* The buffered data that was lost is gone, so later writes
+	     can't just continue */
+	  res = g_output_stream_write (G_OUTPUT_STREAM (out),
+				       data + pos, size,
+				       NULL, &error);
+	  if (res >= 0)
+	    {
+	      g_print ("write after failed write succeeded\n");
+	      exit (1);
+	    }
+	  g_clear_error (&error);
+	  break;
+	}
+      pos += res;
+    }
+
+  if (!g_output_stream_close (G_OUTPUT_STREAM (out), NULL, &error))
+    {
+      g_print ("close failed: %s\n", error->message);
+      g_clear_error (&error);
+      *failed = TRUE;
+    }
+
+  g_object_unref (out);
+  g_free (data);
+
+  return pos;
+}
+
+/* Returns the size of the file, exits if the content is wrong */
+static gsize
+verify_file (GFile *file)
+{
+  GFileInputStream *in;
+  guchar *buffer;
+  gsize read_size;
+  gssize res;
+  GError *error;
+
+  error = NULL;
+  in = g_file_read (file, NULL, &error);
+  if (in == NULL)
+    {
+      g_print ("error reading file: %s\n", error->message);
+      exit (1);
+    }
+
+  buffer = g_malloc (65536);
+  read_size = 0;
+  while ((res = g_input_stream_read (G_INPUT_STREAM (in),
+				     buffer, 65536,
+				     NULL, &error)) > 0)
+    {
+      if (!verify_block (buffer, read_size, res))
+	{
+	  g_print ("error in block starting at %d\n", (int)read_size);
+	  exit (1);
+	}
+      read_size += res;
+    }
+
+  if (res < 0)
+    {
+      g_print ("error reading: %s\n", error->message);
+      exit (1);
+    }
+
+  g_input_stream_close (G_INPUT_STREAM (in), NULL, NULL);
+  g_object_unref (in);
+  g_free (buffer);
+
+  return read_size;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GFile *file;
+  gsize written, file_size;
+  gsize fail_offset;
+  gboolean expect_failure;
+  gboolean failed;
+
+  g_type_init ();
+
+  expect_failure = FALSE;
+  fail_offset = 0;
+
+  if (argc > 2 && strcmp (argv[1], "-f") == 0)
+    {
+      expect_failure = TRUE;
+      fail_offset = strtoul (argv[2], NULL, 10);
+      argc -= 2;
+      argv += 2;
+    }
+
+  if (argc != 2)
+    {
+      g_print ("need file arg");
+      return 1;
+    }
+
+  file = g_file_new_for_commandline_arg (argv[1]);
+
+  written = write_file (file, &failed);
+  file_size = verify_file (file);
+
+  if (expect_failure)
+    {
+      if (!failed)
+	{
+	  g_print ("failed flush was not reported\n");
+	  return 1;
+	}
+      if (file_size > fail_offset)
+	{
+	  g_print ("data written past the failure\n");
+	  return 1;
+	}
+    }
+  else
+    {
+      if (failed)
+	return 1;
+      if (written != FILE_SIZE || file_size != FILE_SIZE)
+	{
+	  g_print ("wrong file size %d\n", (int)file_size);
+	  return 1;
+	}
+    }
+
+  g_print ("ALL OK\n");
+  return 0;
+}